@@ -0,0 +1,58 @@
+# Copyright 2020-2022 F4PGA Authors
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+# SPDX-License-Identifier: Apache-2.0
+
+# Utility functions to be used in benchmarks, see bench.py.
+
+# Return the peak resident set size of the process in KiB.
+proc bench_peak_rss {} {
+    set fh [open /proc/self/status r]
+    set status [read $fh]
+    close $fh
+    if {[regexp {VmHWM:\s+(\d+)} $status -> peak_rss]} {
+        return $peak_rss
+    }
+    return 0
+}
+
+# Run the command and append its wall time and the peak resident set size
+# of the process after it to the results file as a JSON line.
+proc bench_pass { name args } {
+    set start [clock microseconds]
+    uplevel 1 $args
+    set seconds [expr {([clock microseconds] - $start) / 1e6}]
+    set fh [open $::env(BENCH_RESULTS) a]
+    puts $fh [format {{"benchmark": "%s", "pass": "%s", "seconds": %.6f, "peak_rss_kb": %d}} \
+        $::env(BENCH_NAME) $name $seconds [bench_peak_rss]]
+    close $fh
+}
+
+# Append the time and peak resident set size of the given phases of a
+# read_systemverilog -profile report to the results file, as passes named
+# <name>/<phase>.
+proc bench_profile_phases { name profile phases } {
+    set fh [open $profile r]
+    set report [read $fh]
+    close $fh
+    set out [open $::env(BENCH_RESULTS) a]
+    foreach phase $phases {
+        if {[regexp "\"name\": \"$phase\", \"parent\": \"\[^\"\]*\", \"count\": \\d+, \"seconds\": (\[0-9.\]+), \"peak_rss_kb\": (\\d+)" \
+                $report -> seconds peak_rss]} {
+            puts $out [format {{"benchmark": "%s", "pass": "%s/%s", "seconds": %.6f, "peak_rss_kb": %d}} \
+                $::env(BENCH_NAME) $name $phase $seconds $peak_rss]
+        }
+    }
+    close $out
+}
@@ -0,0 +1,443 @@
+#!/usr/bin/env python3
+#
+# Copyright 2020-2022 F4PGA Authors
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+# SPDX-License-Identifier: Apache-2.0
+"""Runs the plugin benchmarks and compares them with a stored baseline.
+
+Each benchmark generates a design whose size grows with the scale, runs a
+Tcl script from scripts/ on it and records the wall time and peak resident
+set size of the measured passes. A pass fails when it is slower than the
+baseline by more than the tolerance.
+"""
+
+import argparse
+import json
+import os
+import re
+import shutil
+import subprocess
+import sys
+
+BENCH_DIR = os.path.dirname(os.path.abspath(__file__))
+ROOT_DIR = os.path.dirname(BENCH_DIR)
+VEXRISCV = os.path.join(ROOT_DIR, "third_party", "VexRiscv_Lite", "VexRiscv_Lite.v")
+MINILITEX = os.path.join(ROOT_DIR, "third_party", "minilitex_ddr_arty", "minilitex_ddr_arty.v")
+MINILITEX_INIT = os.path.join(ROOT_DIR, "xdc-plugin", "tests", "minilitex_ddr_arty")
+
+
+def write(path, text):
+    with open(path, "w") as f:
+        f.write("// **AUTOGENERATED FILE** **DO NOT EDIT**\n")
+        f.write(text)
+
+
+def gen_bram(out_dir, n):
+    """n memories of 1024 words with the widths of the TDP36K ports."""
+    widths = [36, 18, 9, 4, 2, 1]
+    units = []
+    for i in range(n):
+        w = widths[i % len(widths)]
+        units.append(f"""
+  wire [{w - 1}:0] dout_{i};
+  bram_unit #(.W({w})) unit_{i} (.clk(clk), .we(we[{i}]), .waddr(waddr ^ 10'd{i % 1024}),
+    .raddr(raddr), .din(din[{w - 1}:0] ^ {w}'d{i % (1 << w)}), .dout(dout_{i}));
+  assign dout[{i}] = ^dout_{i};""")
+    write(os.path.join(out_dir, "design.v"), f"""
+module bram_unit #(parameter W = 36) (
+  input clk, input we, input [9:0] waddr, input [9:0] raddr,
+  input [W-1:0] din, output reg [W-1:0] dout
+);
+  reg [W-1:0] mem [0:1023];
+  always @(posedge clk) begin
+    if (we) mem[waddr] <= din;
+    dout <= mem[raddr];
+  end
+endmodule
+
+module top (
+  input clk, input [{n - 1}:0] we, input [9:0] waddr, input [9:0] raddr,
+  input [35:0] din, output [{n - 1}:0] dout
+);
+{"".join(units)}
+endmodule
+""")
+    return {"BENCH_TOP": "top"}
+
+
+def gen_dsp(out_dir, n):
+    """n registered 18x20 multipliers."""
+    units = []
+    for i in range(n):
+        units.append(f"""
+  wire [37:0] z_{i};
+  mult_unit unit_{i} (.clk(clk), .a(a ^ 18'd{i % (1 << 18)}), .b(b), .z(z_{i}));
+  assign z[{i}] = ^z_{i};""")
+    write(os.path.join(out_dir, "design.v"), f"""
+module mult_unit (input clk, input [17:0] a, input [19:0] b, output reg [37:0] z);
+  reg [17:0] ra;
+  reg [19:0] rb;
+  always @(posedge clk) begin
+    ra <= a;
+    rb <= b;
+    z <= ra * rb;
+  end
+endmodule
+
+module top (input clk, input [17:0] a, input [19:0] b, output [{n - 1}:0] z);
+{"".join(units)}
+endmodule
+""")
+    return {"BENCH_TOP": "top"}
+
+
+def gen_nexus_dsp(out_dir, n):
+    """n MULT9X9 cells with flip-flops on their inputs and outputs."""
+    units = []
+    for i in range(n):
+        units.append(f"""
+  wire [17:0] z_{i};
+  mult_unit unit_{i} (.clk(clk), .a(a ^ 9'd{i % 512}), .b(b), .z(z_{i}));
+  assign z[{i}] = ^z_{i};""")
+    write(os.path.join(out_dir, "design.v"), f"""
+module mult_unit (input clk, input [8:0] a, input [8:0] b, output reg [17:0] z);
+  reg [8:0] ra;
+  reg [8:0] rb;
+  wire [17:0] rz;
+  always @(posedge clk) begin
+    ra <= a;
+    rb <= b;
+    z <= rz;
+  end
+  MULT9X9 #(.REGINPUTA("BYPASS"), .REGINPUTB("BYPASS"), .REGOUTPUT("BYPASS"))
+    mult (.A(ra), .B(rb), .Z(rz));
+endmodule
+
+module top (input clk, input [8:0] a, input [8:0] b, output [{n - 1}:0] z);
+{"".join(units)}
+endmodule
+""")
+    return {"BENCH_TOP": "top"}
+
+
+def gen_io(out_dir, n):
+    """n registered tristate IOs."""
+    write(os.path.join(out_dir, "design.v"), f"""
+module top (input clk, input oe, input [{n - 1}:0] din, inout [{n - 1}:0] io, output reg [{n - 1}:0] dout);
+  reg [{n - 1}:0] q;
+  always @(posedge clk) begin
+    q <= din;
+    dout <= io;
+  end
+  assign io = oe ? q : {{{n}{{1'bz}}}};
+endmodule
+""")
+    return {"BENCH_TOP": "top"}
+
+
+def gen_inverters(out_dir, n):
+    """n inverters, each driving the invertible pins of a few cells."""
+    units = []
+    for i in range(n):
+        units.append(f"""
+  \\$_NOT_ n{i} (.A(di[{i}]), .Y(d[{i}]));
+  box b{i}_0 (.A(d[{i}]), .B(di[{(i + 1) % n}]), .Y(dout[{2 * i}]));
+  box b{i}_1 (.A(d[{i}]), .B(d[{(i + 1) % n}]), .Y(dout[{2 * i + 1}]));""")
+    write(os.path.join(out_dir, "design.v"), f"""
+(* blackbox *)
+module box (
+  (* invertible_pin = "INV_A" *) input wire A,
+  (* invertible_pin = "INV_B" *) input wire B,
+  output wire Y
+);
+  parameter [0:0] INV_A = 1'b0;
+  parameter [0:0] INV_B = 1'b0;
+endmodule
+
+module top (input wire [{n - 1}:0] di, output wire [{2 * n - 1}:0] dout);
+  wire [{n - 1}:0] d;
+{"".join(units)}
+endmodule
+""")
+    return {"BENCH_TOP": "top"}
+
+
+def gen_clock_tree(out_dir, n):
+    """n clock inputs, each buffered by an IBUF and four BUFGs, every fourth
+    one also drives a PLL with three buffered outputs."""
+    units = []
+    sdc = []
+    regs = 0
+
+    def fdce(clock):
+        nonlocal regs
+        regs += 1
+        return f"""
+  FDCE ff_{regs - 1} (.D(d), .C({clock}), .CE(1'b1), .CLR(1'b0), .Q(q[{regs - 1}]));"""
+
+    for i in range(n):
+        sdc.append(f"create_clock -period {5 + i % 16} -waveform {{0 {(5 + i % 16) / 2}}} clk_{i}\n")
+        units.append(f"""
+  wire clk_ibuf_{i};
+  IBUF ibuf_{i} (.I(clk_{i}), .O(clk_ibuf_{i}));""")
+        for j in range(4):
+            units.append(f"""
+  wire clk_bufg_{i}_{j};
+  BUFG bufg_{i}_{j} (.I(clk_ibuf_{i}), .O(clk_bufg_{i}_{j}));""")
+            units.extend(fdce(f"clk_bufg_{i}_{j}") for _ in range(2))
+        if i % 4 == 0:
+            units.append(f"""
+  wire pll_fb_{i}, pll_out0_{i}, pll_out1_{i}, pll_out2_{i};
+  PLLE2_ADV #(.CLKFBOUT_MULT(12), .CLKIN1_PERIOD({5 + i % 16}.0), .CLKOUT0_DIVIDE(12), .CLKOUT0_PHASE(90.0),
+    .CLKOUT1_DIVIDE(3), .CLKOUT2_DIVIDE(6), .DIVCLK_DIVIDE(1)) pll_{i} (
+    .CLKFBIN(pll_fb_{i}), .CLKIN1(clk_bufg_{i}_0), .RST(rst), .CLKFBOUT(pll_fb_{i}),
+    .CLKOUT0(pll_out0_{i}), .CLKOUT1(pll_out1_{i}), .CLKOUT2(pll_out2_{i}));""")
+            for j in range(3):
+                units.append(f"""
+  wire pll_bufg_{i}_{j};
+  BUFG bufg_pll_{i}_{j} (.I(pll_out{j}_{i}), .O(pll_bufg_{i}_{j}));""")
+                units.append(fdce(f"pll_bufg_{i}_{j}"))
+    body = "".join(units)
+    clocks = ", ".join(f"input clk_{i}" for i in range(n))
+    write(os.path.join(out_dir, "design.v"), f"""
+module top ({clocks}, input rst, input d, output [{regs - 1}:0] q);
+{body}
+endmodule
+""")
+    with open(os.path.join(out_dir, "design.sdc"), "w") as f:
+        f.writelines(sdc)
+    return {"BENCH_TOP": "top", "BENCH_SDC": os.path.join(out_dir, "design.sdc")}
+
+
+def module_ports(path, module):
+    """(direction, range, name) of the ports of an ANSI style module."""
+    with open(path) as f:
+        text = f.read()
+    header = re.search(r"module\s+" + module + r"\s*\((.*?)\);", text, re.S)
+    if not header:
+        raise RuntimeError(f"module {module} not found in {path}")
+    port = re.compile(r"(input|output|inout)\s+(?:wire\s+|reg\s+)?(\[[^\]]+\]\s*)?(\w+)")
+    return [(m.group(1), (m.group(2) or "").strip(), m.group(3)) for m in port.finditer(header.group(1))]
+
+
+def gen_replicated(out_dir, n, path, module):
+    """Top module bench_top with n instances of the module, each with its
+    own copy of the ports."""
+    ports = module_ports(path, module)
+    decls = []
+    insts = []
+    for i in range(n):
+        decls.extend(f"  {d} {r + ' ' if r else ''}{p}_{i}" for d, r, p in ports)
+        conns = ", ".join(f".{p}({p}_{i})" for _, _, p in ports)
+        insts.append(f"  {module} inst_{i} ({conns});\n")
+    write(os.path.join(out_dir, "design.v"), "module bench_top (\n{}\n);\n{}endmodule\n".format(",\n".join(decls), "".join(insts)))
+    return ports
+
+
+def gen_vexriscv(out_dir, n):
+    """VexRiscv_Lite replicated n times."""
+    gen_replicated(out_dir, n, VEXRISCV, "VexRiscv")
+    return {"BENCH_TOP": "bench_top", "BENCH_SOURCES": VEXRISCV}
+
+
+def gen_minilitex(out_dir, n):
+    """minilitex_ddr_arty replicated n times."""
+    gen_replicated(out_dir, n, MINILITEX, "top")
+    for init in ("mem.init", "mem_1.init"):
+        shutil.copy(os.path.join(MINILITEX_INIT, init), out_dir)
+    with open(os.path.join(out_dir, "design.sdc"), "w") as f:
+        f.writelines(f"create_clock -period 10 clk100_{i}\n" for i in range(n))
+    return {"BENCH_TOP": "bench_top", "BENCH_SOURCES": f"{VEXRISCV} {MINILITEX}", "BENCH_SDC": os.path.join(out_dir, "design.sdc")}
+
+
+def gen_sv_traversal(out_dir, n):
+    """n modules of nested procedural code: case statements in for loops
+    in always blocks, and generate loops. Most of the UHDM objects have
+    several kinds of children, so the conversion is dominated by the walk
+    over the child lists."""
+    mods = []
+    insts = []
+    for i in range(n):
+        mods.append(f"""
+module trav_{i} (
+  input  logic        clk,
+  input  logic [7:0]  sel,
+  input  logic [31:0] a,
+  input  logic [31:0] b,
+  output logic [31:0] y
+);
+  logic [31:0] acc;
+  always_ff @(posedge clk) begin
+    for (int k = 0; k < 4; k++) begin
+      case (sel[k*2 +: 2])
+        2'd0: acc[k*8 +: 8] <= a[k*8 +: 8] + b[k*8 +: 8] + 8'd{i % 256};
+        2'd1: acc[k*8 +: 8] <= a[k*8 +: 8] - b[k*8 +: 8];
+        2'd2: acc[k*8 +: 8] <= a[k*8 +: 8] ^ b[k*8 +: 8];
+        default:
+          if (sel[7]) acc[k*8 +: 8] <= a[k*8 +: 8];
+          else acc[k*8 +: 8] <= b[k*8 +: 8];
+      endcase
+    end
+  end
+  for (genvar g = 0; g < 4; g++) begin : lanes
+    assign y[g*8 +: 8] = acc[g*8 +: 8] & {{8{{sel[g]}}}};
+  end
+endmodule
+""")
+        insts.append(f"  trav_{i} inst_{i} (.clk(clk), .sel(sel), .a(a), .b(b), .y(y[{i * 32 + 31}:{i * 32}]));\n")
+    write(os.path.join(out_dir, "design.v"), "".join(mods) + f"""
+module bench_top (
+  input  logic        clk,
+  input  logic [7:0]  sel,
+  input  logic [31:0] a,
+  input  logic [31:0] b,
+  output logic [{n * 32 - 1}:0] y
+);
+{"".join(insts)}endmodule
+""")
+    return {"BENCH_TOP": "bench_top"}
+
+
+def gen_sv_ast_nodes(out_dir, n):
+    """n modules of 64 continuous assignments, each an expression of about
+    16 operators, identifiers and constants. 1024 modules give about one
+    million AST nodes."""
+    mods = []
+    insts = []
+    for i in range(n):
+        assigns = "".join(
+            f"  assign y[{k * 16 + 15}:{k * 16}] = ((a + 16'd{(i * 64 + k) % 65536}) ^ (b - c)) & (a | 16'h{k:04x}) | (c >> {k % 16});\n"
+            for k in range(64))
+        mods.append(f"""
+module nodes_{i} (
+  input  logic [15:0]   a,
+  input  logic [15:0]   b,
+  input  logic [15:0]   c,
+  output logic [1023:0] y
+);
+{assigns}endmodule
+""")
+        insts.append(f"  nodes_{i} inst_{i} (.a(a), .b(b), .c(c), .y(y_{i}));\n")
+    decls = "".join(f"  logic [1023:0] y_{i};\n" for i in range(n))
+    parity = " ^ ".join(f"(^y_{i})" for i in range(n))
+    write(os.path.join(out_dir, "design.v"), "".join(mods) + f"""
+module bench_top (
+  input  logic [15:0] a,
+  input  logic [15:0] b,
+  input  logic [15:0] c,
+  output logic        y
+);
+{decls}{"".join(insts)}  assign y = {parity};
+endmodule
+""")
+    return {"BENCH_TOP": "bench_top"}
+
+
+# Benchmark name: (script, generator, design size at scale 1)
+BENCHMARKS = {
+    "bram": ("bram.tcl", gen_bram, 64),
+    "dsp": ("dsp.tcl", gen_dsp, 64),
+    "nexus_dsp": ("nexus_dsp.tcl", gen_nexus_dsp, 64),
+    "io": ("io.tcl", gen_io, 256),
+    "inverters": ("inverters.tcl", gen_inverters, 4096),
+    "clock_tree": ("clock_tree.tcl", gen_clock_tree, 64),
+    "vexriscv": ("vexriscv.tcl", gen_vexriscv, 1),
+    "minilitex": ("minilitex.tcl", gen_minilitex, 1),
+    "sv_traversal": ("systemverilog.tcl", gen_sv_traversal, 256),
+    "sv_ast_nodes": ("systemverilog.tcl", gen_sv_ast_nodes, 1024),
+}
+
+
+def run_benchmark(name, scale, yosys, build_dir):
+    script, generator, size = BENCHMARKS[name]
+    out_dir = os.path.join(build_dir, name)
+    shutil.rmtree(out_dir, ignore_errors=True)
+    os.makedirs(out_dir)
+    env = dict(os.environ)
+    env.update(generator(out_dir, size * scale))
+    results = os.path.join(out_dir, "results.jsonl")
+    env.update({
+        "BENCH_NAME": name,
+        "BENCH_DESIGN": os.path.join(out_dir, "design.v"),
+        "BENCH_RESULTS": results,
+        "BENCH_ROOT": ROOT_DIR,
+    })
+    with open(os.path.join(out_dir, "run.tcl"), "w") as f:
+        f.write(f"source {os.path.join(BENCH_DIR, 'bench-utils.tcl')}\n")
+        f.write(f"source {os.path.join(BENCH_DIR, 'scripts', script)}\n")
+    ret = subprocess.call([yosys, "-c", "run.tcl", "-q", "-l", "yosys.log"], cwd=out_dir, env=env)
+    if ret != 0:
+        print(f"Benchmark {name} FAILED, see {os.path.join(out_dir, 'yosys.log')}")
+        return None
+    with open(results) as f:
+        return [json.loads(line) for line in f if line.strip()]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("benchmarks", nargs="*", help="benchmarks to run, all by default: " + " ".join(BENCHMARKS))
+    parser.add_argument("--scale", type=int, default=1, help="multiplies the size of the designs (default: 1)")
+    parser.add_argument("--yosys", default="yosys", help="yosys binary (default: yosys)")
+    parser.add_argument("--build-dir", default=os.path.join(BENCH_DIR, "build"), help="where designs and logs are written")
+    parser.add_argument("--baseline", default=os.path.join(BENCH_DIR, "baseline.json"), help="baseline file")
+    parser.add_argument("--tolerance", type=float, default=1.25, help="allowed slowdown against the baseline (default: 1.25)")
+    parser.add_argument("--min-seconds", type=float, default=0.5, help="passes faster than this in the baseline aren't compared (default: 0.5)")
+    parser.add_argument("--update-baseline", action="store_true", help="store the results as the new baseline")
+    parser.add_argument("--output", help="write the results to this JSON file")
+    args = parser.parse_args()
+
+    names = args.benchmarks or list(BENCHMARKS)
+    unknown = [name for name in names if name not in BENCHMARKS]
+    if unknown:
+        parser.error("unknown benchmarks: " + " ".join(unknown))
+
+    baseline = {}
+    if os.path.exists(args.baseline):
+        with open(args.baseline) as f:
+            baseline = json.load(f)
+
+    failed = False
+    results = {}
+    for name in names:
+        passes = run_benchmark(name, args.scale, args.yosys, args.build_dir)
+        if passes is None:
+            failed = True
+            continue
+        for result in passes:
+            key = f"{name}@{args.scale}/{result['pass']}"
+            results[key] = {"seconds": result["seconds"], "peak_rss_kb": result["peak_rss_kb"]}
+            status = "no baseline"
+            if key in baseline:
+                base = baseline[key]["seconds"]
+                status = f"{result['seconds'] / base:.2f}x baseline" if base > 0 else "baseline 0s"
+                if base >= args.min_seconds and result["seconds"] > base * args.tolerance:
+                    status += ", SLOWER"
+                    failed = True
+            print(f"{key:<40} {result['seconds']:10.3f} s {result['peak_rss_kb'] / 1024:10.1f} MiB  {status}")
+
+    if args.output:
+        with open(args.output, "w") as f:
+            json.dump(results, f, indent=2, sort_keys=True)
+    if args.update_baseline:
+        baseline.update(results)
+        with open(args.baseline, "w") as f:
+            json.dump(baseline, f, indent=2, sort_keys=True)
+            f.write("\n")
+        return 0
+    return 1 if failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
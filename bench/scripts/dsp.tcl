@@ -0,0 +1,9 @@
+yosys -import
+if { [info procs synth_quicklogic] == {} } { plugin -i ql-qlf }
+yosys -import  ;# ingest plugin commands
+
+read_verilog $::env(BENCH_DESIGN)
+hierarchy -top $::env(BENCH_TOP)
+
+bench_pass synth_quicklogic synth_quicklogic -family qlf_k6n10f -top $::env(BENCH_TOP) -profile synth_quicklogic.json
+bench_pass write_ql_edif write_ql_edif dsp.edif
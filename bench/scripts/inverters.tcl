@@ -0,0 +1,8 @@
+yosys -import
+if { [info procs integrateinv] == {} } { plugin -i integrateinv }
+yosys -import  ;# ingest plugin commands
+
+read_verilog -icells $::env(BENCH_DESIGN)
+hierarchy -top $::env(BENCH_TOP)
+
+bench_pass integrateinv integrateinv
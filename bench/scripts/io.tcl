@@ -0,0 +1,8 @@
+yosys -import
+if { [info procs synth_quicklogic] == {} } { plugin -i ql-qlf }
+yosys -import  ;# ingest plugin commands
+
+read_verilog $::env(BENCH_DESIGN)
+hierarchy -top $::env(BENCH_TOP)
+
+bench_pass synth_quicklogic synth_quicklogic -family pp3 -top $::env(BENCH_TOP) -profile synth_quicklogic.json
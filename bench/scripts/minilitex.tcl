@@ -0,0 +1,10 @@
+yosys -import
+if { [info procs read_sdc] == {} } { plugin -i sdc }
+yosys -import  ;# ingest plugin commands
+
+read_verilog {*}$::env(BENCH_SOURCES) $::env(BENCH_DESIGN)
+hierarchy -top $::env(BENCH_TOP)
+synth_xilinx -flatten -abc9 -nosrl -noclkbuf -nodsp -top $::env(BENCH_TOP)
+
+read_sdc $::env(BENCH_SDC)
+bench_pass propagate_clocks propagate_clocks
@@ -0,0 +1,10 @@
+yosys -import
+if { [info procs dsp_ff] == {} } { plugin -i dsp-ff }
+yosys -import  ;# ingest plugin commands
+
+read_verilog $::env(BENCH_DESIGN)
+hierarchy -top $::env(BENCH_TOP)
+synth_nexus -top $::env(BENCH_TOP)
+techmap -map +/nexus/cells_sim.v t:VLO t:VHI %u ;# Unmap VHI and VLO
+
+bench_pass dsp_ff dsp_ff -rules $::env(BENCH_ROOT)/dsp-ff-plugin/nexus-dsp_rules.txt
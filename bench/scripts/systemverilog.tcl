@@ -0,0 +1,6 @@
+yosys -import
+if { [info procs read_systemverilog] == {} } { plugin -i systemverilog }
+yosys -import  ;# ingest plugin commands
+
+bench_pass read_systemverilog read_systemverilog -profile read_systemverilog.json $::env(BENCH_DESIGN)
+bench_profile_phases read_systemverilog read_systemverilog.json {surelog uhdm_to_ast ast_process}
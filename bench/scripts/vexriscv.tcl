@@ -0,0 +1,12 @@
+yosys -import
+if { [info procs synth_quicklogic] == {} } { plugin -i ql-qlf }
+if { [info procs read_systemverilog] == {} } { plugin -i systemverilog }
+yosys -import  ;# ingest plugin commands
+
+bench_pass read_systemverilog read_systemverilog {*}$::env(BENCH_SOURCES) $::env(BENCH_DESIGN)
+design -reset
+
+read_verilog {*}$::env(BENCH_SOURCES) $::env(BENCH_DESIGN)
+hierarchy -top $::env(BENCH_TOP)
+bench_pass synth_quicklogic synth_quicklogic -family qlf_k6n10f -top $::env(BENCH_TOP) -profile synth_quicklogic.json
+bench_pass write_ql_edif write_ql_edif vexriscv.edif
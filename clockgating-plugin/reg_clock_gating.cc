@@ -14,10 +14,13 @@
 //
 // SPDX-License-Identifier: Apache-2.0
 
+#include "kernel/ff.h"
+#include "kernel/sigtools.h"
 #include "kernel/yosys.h"
 
 USING_YOSYS_NAMESPACE
-#include <iostream>
+PRIVATE_NAMESPACE_BEGIN
+
 struct CLK_Gating_Pass : public Pass {
 
     CLK_Gating_Pass() : Pass("reg_clock_gating", "performs flipflop clock gating") {}
@@ -26,82 +29,233 @@ struct CLK_Gating_Pass : public Pass {
     {
         //   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
         log("\n");
-        log("     reg_clock_gating [-map CG_map_filename] [selection]\n");
+        log("     reg_clock_gating [-cell <celltype> <gclk>:<clk>:<gate>[:<max_bits>]]...\n");
+        log("                      [-min_bits N] [selection]\n");
+        log("     reg_clock_gating -map <CG_map_filename> [selection]\n");
+        log("     reg_clock_gating <CG_map_filename> [selection]\n");
+        log("\n");
+        log("Replaces the enable of enable flipflops with a gated clock. Flipflops sharing\n");
+        log("the same clock and enable form a register bank that is driven by a single\n");
+        log("clock gating cell. Both the coarse grain cells ($dffe, $adffe, $sdffce,\n");
+        log("$dffsre, $aldffe) and their fine grain counterparts ($_DFFE_*, $_SDFFCE_*,\n");
+        log("...) are supported, they are turned into the same cells without an enable.\n");
+        log("Flipflops with a synchronous reset that does not depend on the enable are\n");
+        log("left alone, as gating their clock would gate the reset too. Flipflops that\n");
+        log("are already clock gated have no enable and are left as they are, so the\n");
+        log("pass can be run again on a part of the design.\n");
         log("\n");
+        log("    -cell <celltype> <gclk>:<clk>:<gate>[:<max_bits>]\n");
+        log("        the integrated clock gating cell to use, with the names of its\n");
+        log("        gated clock output, clock input and active-high enable input.\n");
+        log("        the option can be given several times to pick the cell by the\n");
+        log("        size of the register bank: a cell is used for banks of up to\n");
+        log("        max_bits bits, the one with the smallest max_bits that fits is\n");
+        log("        chosen, a cell without max_bits takes banks of any size. banks\n");
+        log("        not fitting any cell are left ungated. the cells are used for\n");
+        log("        rising edge flipflops only, falling edge ones are left ungated.\n");
+        log("        without this option a latch and a gate from the internal gate\n");
+        log("        library are used for both clock polarities.\n");
+        log("\n");
+        log("    -min_bits N\n");
+        log("        only gate register banks of at least N bits. default: 1\n");
         log("\n");
         log("    -map filename\n");
-        log("        the mapfile for clock gating cells implementations to be used.\n");
-        log("        maps from enable-flipflops to clock gated flipflops.\n");
-        log("        without this parameter a builtin library is used that\n");
-        log("        transforms the internal RTL cells to the internal gate\n");
-        log("        library.\n");
-        log("        check techmap command for mare details.\n");
+        log("        instead of forming register banks, map each selected enable\n");
+        log("        flipflop with techmap using the given clock gating cell\n");
+        log("        implementations. can not be combined with -cell or -min_bits.\n");
+        log("        the map file can also be given as the first argument without\n");
+        log("        -map, as older scripts do.\n");
+        log("\n");
         log("     selection\n");
         log("        this option is used to specify the flipflops to be clockgated.\n");
         log("        for example:.\n");
         log("        put the following attribute in you design: \n");
-        log("        (* clock gating *).\n");
+        log("        (* clock_gate *).\n");
         log("        and use the following command: .\n");
-        log("        reg_clock_gating -map CG_map_filename.v a:clock_gate.\n");
+        log("        reg_clock_gating -cell CG_cell GCLK:CLK:GATE a:clock_gate.\n");
         log("\n");
-        log("This pass calls the following passes to perform technology mapping \n");
-        log("of enabled flip_flops to clock-gated flipflops.\n");
-        log("\n");
-        log("    procs\n");
-        log("    opt;;\n");
-        log("    memory_collect\n");
-        log("    memory_map\n");
-        log("    opt;; \n");
-        log("    techmap -map [-map CG_map_filename] [selection]\n");
-        log("    opt;;\n");
+        log("Processes and memories have to be mapped to flipflops before, e.g. with\n");
+        log("proc, opt, memory_collect, memory_map and opt.\n");
         log("\n");
     }
 
-    virtual void execute(std::vector<std::string> args, RTLIL::Design *design)
+    // A clock gating cell and the largest register bank it is used for
+    struct GateCell {
+        RTLIL::IdString type;
+        RTLIL::IdString gclk, clk, en;
+        int max_bits;
+    };
+
+    std::vector<GateCell> gate_cells;
+
+    // Parses a register bank size, it has to be a decimal number
+    static int parse_bits(const std::string &text, const std::string &what)
     {
+        if (text.empty() || text.size() > 9 || text.find_first_not_of("0123456789") != std::string::npos)
+            log_cmd_error("Invalid bank size '%s' for %s\n", text.c_str(), what.c_str());
+        return atoi(text.c_str());
+    }
+
+    // Register bank key: clock, clock polarity, enable, enable polarity
+    typedef std::tuple<RTLIL::SigBit, bool, RTLIL::SigBit, bool> BankKey;
+
+    // Returns the smallest gating cell for a bank, nullptr if none fits
+    const GateCell *find_gate_cell(int bits) const
+    {
+        const GateCell *found = nullptr;
+        for (const auto &cell : gate_cells) {
+            if (cell.max_bits >= bits && (found == nullptr || cell.max_bits < found->max_bits))
+                found = &cell;
+        }
+        return found;
+    }
+
+    RTLIL::SigBit add_clock_gate(RTLIL::Module *module, const GateCell *gate_cell, RTLIL::SigBit clk, bool clk_pol, RTLIL::SigBit en)
+    {
+        RTLIL::SigBit gclk = module->addWire(NEW_ID);
+        if (gate_cell != nullptr) {
+            RTLIL::Cell *gate = module->addCell(NEW_ID, gate_cell->type);
+            gate->setPort(gate_cell->clk, clk);
+            gate->setPort(gate_cell->en, en);
+            gate->setPort(gate_cell->gclk, gclk);
+            return gclk;
+        }
+        // The latch holds the enable while the clock is in its active
+        // phase so that glitches cannot reach the gated clock
+        RTLIL::SigBit latched = module->addWire(NEW_ID);
+        if (clk_pol) {
+            module->addDlatchGate(NEW_ID, clk, en, latched, false);
+            module->addAndGate(NEW_ID, clk, latched, gclk);
+        } else {
+            module->addDlatchGate(NEW_ID, clk, en, latched, true);
+            module->addOrnotGate(NEW_ID, clk, latched, gclk);
+        }
+        return gclk;
+    }
+
+    int gate_module(RTLIL::Module *module, int min_bits)
+    {
+        SigMap sigmap(module);
+        FfInitVals initvals(&sigmap, module);
+
+        dict<BankKey, std::vector<FfData>> banks;
+        for (auto cell : module->selected_cells()) {
+            if (!RTLIL::builtin_ff_cell_types().count(cell->type))
+                continue;
+            FfData ff(&initvals, cell);
+            if (!ff.has_clk || !ff.has_ce)
+                continue;
+            // A gated clock would gate a reset that has priority over the enable
+            if (ff.has_srst && !ff.ce_over_srst)
+                continue;
+            RTLIL::SigBit clk = sigmap(ff.sig_clk)[0];
+            RTLIL::SigBit en = sigmap(ff.sig_ce)[0];
+            if (clk.wire == nullptr || en.wire == nullptr)
+                continue;
+            if (!ff.pol_clk && !gate_cells.empty())
+                continue;
+            banks[BankKey(clk, ff.pol_clk, en, ff.pol_ce)].push_back(ff);
+        }
+
+        int gated = 0;
+        for (auto &it : banks) {
+            RTLIL::SigBit clk, en;
+            bool clk_pol, en_pol;
+            std::tie(clk, clk_pol, en, en_pol) = it.first;
+
+            int bits = 0;
+            for (const auto &ff : it.second)
+                bits += ff.width;
+            if (bits < min_bits)
+                continue;
+
+            const GateCell *gate_cell = nullptr;
+            if (!gate_cells.empty()) {
+                gate_cell = find_gate_cell(bits);
+                if (gate_cell == nullptr)
+                    continue;
+            }
 
-        if (args.size() < 2) {
-            log_error("Incorrect number of arguments \nClock gating map file is required \n");
+            if (!en_pol)
+                en = module->NotGate(NEW_ID, en);
+            RTLIL::SigBit gclk = add_clock_gate(module, gate_cell, clk, clk_pol, en);
+
+            log("Gating %d register(s) (%d bits) clocked by %s%s with enable %s%s%s%s:\n", GetSize(it.second), bits, clk_pol ? "" : "!",
+                log_signal(clk), en_pol ? "" : "!", log_signal(std::get<2>(it.first)), gate_cell ? " using " : "",
+                gate_cell ? log_id(gate_cell->type) : "");
+            for (auto &ff : it.second) {
+                log("  %s (%s)\n", log_id(ff.name), log_id(ff.cell->type));
+                ff.has_ce = false;
+                ff.sig_clk = gclk;
+                ff.emit();
+            }
+            gated += GetSize(it.second);
         }
+        return gated;
+    }
 
-        string map_file = "";
+    void execute(std::vector<std::string> args, RTLIL::Design *design) override
+    {
+        log_header(design, "Executing Clock gating pass.\n");
+        log_push();
+
+        gate_cells.clear();
+        std::string map_file;
+        int min_bits = 1;
+        bool min_bits_set = false;
 
         size_t argidx;
         for (argidx = 1; argidx < args.size(); argidx++) {
+            if (args[argidx] == "-cell" && argidx + 2 < args.size()) {
+                GateCell cell;
+                cell.type = RTLIL::escape_id(args[++argidx]);
+                std::vector<std::string> ports = split_tokens(args[++argidx], ":");
+                if (ports.size() != 3 && ports.size() != 4)
+                    log_cmd_error("Expected <gclk>:<clk>:<gate>[:<max_bits>] for clock gating cell %s\n", log_id(cell.type));
+                cell.gclk = RTLIL::escape_id(ports[0]);
+                cell.clk = RTLIL::escape_id(ports[1]);
+                cell.en = RTLIL::escape_id(ports[2]);
+                cell.max_bits = INT_MAX;
+                if (ports.size() == 4)
+                    cell.max_bits = parse_bits(ports[3], stringf("clock gating cell %s", log_id(cell.type)));
+                gate_cells.push_back(cell);
+                continue;
+            }
+            if (args[argidx] == "-min_bits" && argidx + 1 < args.size()) {
+                min_bits = parse_bits(args[++argidx], "-min_bits");
+                min_bits_set = true;
+                continue;
+            }
             if (args[argidx] == "-map" && argidx + 1 < args.size()) {
                 map_file = args[++argidx];
                 continue;
             }
             break;
         }
-        int x = 0;
-        std::stringstream selection_string_stream;
-        for (unsigned long i = argidx; i < args.size(); i++) {
-            if (x != 0)
-                selection_string_stream << " ";
-            selection_string_stream << args[i];
-            x++;
-        }
-        std::string selection = selection_string_stream.str();
+        // Older scripts give the map file as first argument, without -map
+        if (argidx == 1 && argidx < args.size() && check_file_exists(args[argidx]))
+            map_file = args[argidx++];
+        std::vector<std::string> selection(args.begin() + argidx, args.end());
+        extra_args(args, argidx, design);
 
-        std::cout << selection << "\n";
-
-        log_header(design, "Executing Clock gating pass.\n");
-        log_push();
-
-        Pass::call(design, "proc");
-        Pass::call(design, "opt;;");
-        Pass::call(design, "memory_collect " + selection);
-        Pass::call(design, "memory_map " + selection);
-        Pass::call(design, "opt;;");
-        Pass::call(design, "techmap -map " + map_file + " " + selection);
-        Pass::call(design, "opt;;");
+        if (!map_file.empty()) {
+            if (!gate_cells.empty() || min_bits_set)
+                log_cmd_error("Option -map can not be combined with -cell or -min_bits.\n");
+            // The map file decides on the gating cell of each flipflop
+            std::vector<std::string> techmap_args = {"techmap", "-map", map_file};
+            techmap_args.insert(techmap_args.end(), selection.begin(), selection.end());
+            Pass::call(design, techmap_args);
+            log_pop();
+            return;
+        }
 
-        design->optimize();
-        design->sort();
-        design->check();
+        int gated = 0;
+        for (auto module : design->selected_modules())
+            gated += gate_module(module, min_bits);
 
-        log_header(design, "Finished Clock gating pass.\n");
+        log("Clock gated %d register(s).\n", gated);
         log_pop();
     }
 } CLK_Gating_Pass;
+
+PRIVATE_NAMESPACE_END
@@ -0,0 +1,72 @@
+yosys -import
+if { [info procs reg_clock_gating] == {} } { plugin -i clockgating }
+yosys -import  ;# ingest plugin commands
+
+set LIBDIR [file dirname $::env(DESIGN_TOP)]/../regfile/lib
+
+read_verilog $::env(DESIGN_TOP).v
+read_verilog $LIBDIR/sky130_hd_clkg_blackbox.v
+hierarchy -check -top top
+proc
+opt;;
+design -save rtl
+
+# -map picks the gating cell by the WIDTH of each coarse grain flipflop
+reg_clock_gating -map $LIBDIR/sky130_hd_ff_map.v
+opt_clean
+select -assert-count 1 t:sky130_fd_sc_hd__dlclkp_1
+select -assert-count 1 t:sky130_fd_sc_hd__dlclkp_2
+select -assert-count 1 t:sky130_fd_sc_hd__dlclkp_4
+select -assert-none t:$dffe
+
+# The map file can also be given without -map
+design -load rtl
+reg_clock_gating $LIBDIR/sky130_hd_ff_map.v
+opt_clean
+select -assert-count 1 t:sky130_fd_sc_hd__dlclkp_1
+select -assert-count 1 t:sky130_fd_sc_hd__dlclkp_2
+select -assert-count 1 t:sky130_fd_sc_hd__dlclkp_4
+select -assert-none t:$dffe
+
+# Bank sizes have to be numbers
+design -load rtl
+if { ![catch {reg_clock_gating -cell sky130_fd_sc_hd__dlclkp_4 GCLK:CLK:GATE -min_bits foo}] } {
+    error "reg_clock_gating accepted -min_bits foo"
+}
+
+# -map can not be combined with the native gating options
+design -load rtl
+if { ![catch {reg_clock_gating -map $LIBDIR/sky130_hd_ff_map.v -cell sky130_fd_sc_hd__dlclkp_4 GCLK:CLK:GATE}] } {
+    error "reg_clock_gating accepted -map together with -cell"
+}
+
+# Repeated -cell options pick the smallest cell that fits the bank
+design -load rtl
+reg_clock_gating -cell sky130_fd_sc_hd__dlclkp_4 GCLK:CLK:GATE -cell sky130_fd_sc_hd__dlclkp_1 GCLK:CLK:GATE:4 -cell sky130_fd_sc_hd__dlclkp_2 GCLK:CLK:GATE:16
+select -assert-count 1 t:sky130_fd_sc_hd__dlclkp_1
+select -assert-count 1 t:sky130_fd_sc_hd__dlclkp_2
+select -assert-count 1 t:sky130_fd_sc_hd__dlclkp_4
+select -assert-none t:$dffe
+select -assert-count 3 t:$dff
+
+# Banks larger than every cell are left ungated
+design -load rtl
+reg_clock_gating -cell sky130_fd_sc_hd__dlclkp_1 GCLK:CLK:GATE:4 -cell sky130_fd_sc_hd__dlclkp_2 GCLK:CLK:GATE:16
+select -assert-count 1 t:sky130_fd_sc_hd__dlclkp_1
+select -assert-count 1 t:sky130_fd_sc_hd__dlclkp_2
+select -assert-none t:sky130_fd_sc_hd__dlclkp_4
+select -assert-count 1 t:$dffe
+
+# Fine grain enable flipflops are banked by their shared clock and enable
+design -load rtl
+techmap
+opt_clean
+select -assert-count 52 t:$_DFFE_PP_
+reg_clock_gating -cell sky130_fd_sc_hd__dlclkp_4 GCLK:CLK:GATE -cell sky130_fd_sc_hd__dlclkp_1 GCLK:CLK:GATE:4 -cell sky130_fd_sc_hd__dlclkp_2 GCLK:CLK:GATE:16
+select -assert-count 1 t:sky130_fd_sc_hd__dlclkp_1
+select -assert-count 1 t:sky130_fd_sc_hd__dlclkp_2
+select -assert-count 1 t:sky130_fd_sc_hd__dlclkp_4
+select -assert-none t:$_DFFE_*
+select -assert-count 52 t:$_DFF_P_
+
+write_verilog -noattr [test_output_path "clockgated_bank_widths.v"]
@@ -0,0 +1,32 @@
+// Copyright 2022 AUC Open Source Hardware Lab
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); 
+// you may not use this file except in compliance with the License. 
+// You may obtain a copy of the License at:
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software 
+// distributed under the License is distributed on an "AS IS" BASIS, 
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. 
+// See the License for the specific language governing permissions and 
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+module top (
+	input			clk,
+	input	[2:0]	en,
+	input	[3:0]	d4,
+	input	[15:0]	d16,
+	input	[31:0]	d32,
+	output reg [3:0]	q4,
+	output reg [15:0]	q16,
+	output reg [31:0]	q32
+);
+	always @(posedge clk) begin
+		if (en[0]) q4 <= d4;
+		if (en[1]) q16 <= d16;
+		if (en[2]) q32 <= d32;
+	end
+endmodule
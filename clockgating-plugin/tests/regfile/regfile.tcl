@@ -10,7 +10,12 @@ read_verilog $LIBDIR/sky130_hd_clkg_blackbox.v
 hierarchy -check -auto-top
 
 
-reg_clock_gating $LIBDIR/sky130_hd_ff_map.v
+proc
+opt;;
+memory_collect
+memory_map
+opt;;
+reg_clock_gating -cell sky130_fd_sc_hd__dlclkp_4 GCLK:CLK:GATE
 opt_clean -purge
 synth -top top
 dfflibmap -liberty $LIBDIR/sky130_fd_sc_hd.lib
@@ -19,34 +19,177 @@
 #include "kernel/log.h"
 #include "libs/json11/json11.hpp"
 
+#include <fstream>
+#include <map>
+#include <sys/stat.h>
+#include <unordered_map>
+
 USING_YOSYS_NAMESPACE
 // Coordinates of HCLK_IOI tiles associated with a specified bank
 using BankTilesMap = std::unordered_map<int, std::string>;
 
-// Find the part's JSON file with information including the IO Banks
-// and extract the bank tiles.
-inline BankTilesMap get_bank_tiles(const std::string json_file_name)
+// Minimal scanner over the part's JSON file. Values other than the one of
+// interest are skipped without building a JSON tree, part files are large.
+class PartJsonScanner
 {
-    BankTilesMap bank_tiles;
-    std::ifstream json_file(json_file_name);
-    if (!json_file.good()) {
-        log_cmd_error("Can't open JSON file %s", json_file_name.c_str());
+  public:
+    PartJsonScanner(std::istream &stream, const std::string &file_name) : stream(stream), file_name(file_name) {}
+
+    // Stores the raw JSON text of the top level member with the given key
+    bool find_member(const std::string &key, std::string &value)
+    {
+        const std::string quoted_key = "\"" + key + "\"";
+        expect('{');
+        skip_spaces();
+        if (stream.peek() == '}') {
+            return false;
+        }
+        while (true) {
+            std::string member_key;
+            skip_spaces();
+            scan_string(&member_key);
+            expect(':');
+            skip_spaces();
+            if (member_key == quoted_key) {
+                value.clear();
+                scan_value(&value);
+                return true;
+            }
+            scan_value(nullptr);
+            skip_spaces();
+            int c = stream.get();
+            if (c == '}') {
+                return false;
+            }
+            if (c != ',') {
+                error();
+            }
+        }
+    }
+
+  private:
+    [[noreturn]] void error() { log_cmd_error("Malformed JSON file %s\n", file_name.c_str()); }
+
+    void skip_spaces()
+    {
+        while (isspace(stream.peek())) {
+            stream.get();
+        }
+    }
+
+    void expect(char c)
+    {
+        skip_spaces();
+        if (stream.get() != c) {
+            error();
+        }
+    }
+
+    int next(std::string *out)
+    {
+        int c = stream.get();
+        if (c == EOF) {
+            error();
+        }
+        if (out) {
+            *out += c;
+        }
+        return c;
+    }
+
+    // Consumes a string including its quotes, kept in its raw escaped form
+    void scan_string(std::string *out)
+    {
+        if (next(out) != '"') {
+            error();
+        }
+        while (true) {
+            int c = next(out);
+            if (c == '"') {
+                return;
+            }
+            if (c == '\\') {
+                next(out);
+            }
+        }
+    }
+
+    void scan_value(std::string *out)
+    {
+        int depth = 0;
+        while (true) {
+            if (stream.peek() == '"') {
+                scan_string(out);
+            } else {
+                int c = next(out);
+                if (c == '{' || c == '[') {
+                    depth++;
+                } else if (c == '}' || c == ']') {
+                    if (--depth < 0) {
+                        error();
+                    }
+                }
+            }
+            if (depth == 0 && at_value_end()) {
+                return;
+            }
+        }
+    }
+
+    bool at_value_end()
+    {
+        int c = stream.peek();
+        return c == ',' || c == '}' || c == ']' || c == EOF || isspace(c);
+    }
+
+    std::istream &stream;
+    const std::string &file_name;
+};
+
+// Extracts the bank tiles from the contents of a part's JSON file
+inline BankTilesMap parse_bank_tiles(std::istream &json_stream, const std::string &json_file_name)
+{
+    std::string iobanks_str;
+    if (!PartJsonScanner(json_stream, json_file_name).find_member("iobanks", iobanks_str)) {
+        log_cmd_error("IO Bank information missing in the part's json: %s\n", json_file_name.c_str());
     }
-    std::string json_str((std::istreambuf_iterator<char>(json_file)), std::istreambuf_iterator<char>());
     std::string error;
-    auto json = json11::Json::parse(json_str, error);
+    auto iobanks = json11::Json::parse(iobanks_str, error);
     if (!error.empty()) {
         log_cmd_error("%s\n", error.c_str());
     }
-    auto json_objects = json.object_items();
-    auto iobanks = json_objects.find("iobanks");
-    if (iobanks == json_objects.end()) {
-        log_cmd_error("IO Bank information missing in the part's json: %s\n", json_file_name.c_str());
-    }
 
-    for (auto iobank : iobanks->second.object_items()) {
+    BankTilesMap bank_tiles;
+    for (auto iobank : iobanks.object_items()) {
         bank_tiles.emplace(std::atoi(iobank.first.c_str()), iobank.second.string_value());
     }
-
     return bank_tiles;
 }
+
+// Find the part's JSON file with information including the IO Banks
+// and extract the bank tiles. Results are cached by file name and
+// modification time, so repeated calls in one session don't reread it.
+inline const BankTilesMap &get_bank_tiles(const std::string &json_file_name)
+{
+    static std::map<std::string, std::pair<time_t, BankTilesMap>> cache;
+
+    struct stat file_stat;
+    if (stat(json_file_name.c_str(), &file_stat) != 0) {
+        log_cmd_error("Can't open JSON file %s", json_file_name.c_str());
+    }
+    auto cached = cache.find(json_file_name);
+    if (cached != cache.end() && cached->second.first == file_stat.st_mtime) {
+        return cached->second.second;
+    }
+
+    std::ifstream json_file(json_file_name);
+    if (!json_file.good()) {
+        log_cmd_error("Can't open JSON file %s", json_file_name.c_str());
+    }
+    BankTilesMap bank_tiles = parse_bank_tiles(json_file, json_file_name);
+
+    auto &entry = cache[json_file_name];
+    entry.first = file_stat.st_mtime;
+    entry.second = std::move(bank_tiles);
+    return entry.second;
+}
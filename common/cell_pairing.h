@@ -0,0 +1,157 @@
+/*
+ * Copyright 2020-2022 F4PGA Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ */
+#ifndef _CELL_PAIRING_H_
+#define _CELL_PAIRING_H_
+
+#include "kernel/rtlil.h"
+#include "kernel/sigtools.h"
+
+#include <initializer_list>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+USING_YOSYS_NAMESPACE
+
+/// Source to target port name pairs, escaped once when the map is built
+typedef std::vector<std::pair<RTLIL::IdString, RTLIL::IdString>> CellPortMap;
+
+inline CellPortMap makeCellPortMap(std::initializer_list<std::pair<const char *, const char *>> a_Ports)
+{
+    CellPortMap map;
+    map.reserve(a_Ports.size());
+    for (const auto &it : a_Ports) {
+        map.emplace_back(RTLIL::escape_id(it.first), RTLIL::escape_id(it.second));
+    }
+    return map;
+}
+
+/// Looks up port width and direction in the cell definition and returns it.
+/// Returns (0, false) if it cannot be determined.
+inline std::pair<int, bool> getCellPortInfo(const RTLIL::Cell *a_Cell, const RTLIL::IdString &a_Port)
+{
+    if (!a_Cell->known()) {
+        return std::make_pair(0, false);
+    }
+
+    // Get the module defining the cell (the previous condition ensures
+    // that the pointers are valid)
+    RTLIL::Module *mod = a_Cell->module->design->module(a_Cell->type);
+    if (mod == nullptr) {
+        return std::make_pair(0, false);
+    }
+
+    // Get the wire representing the port
+    RTLIL::Wire *wire = mod->wire(a_Port);
+    if (wire == nullptr) {
+        return std::make_pair(0, false);
+    }
+
+    return std::make_pair(wire->width, wire->port_output);
+}
+
+/// Connects the ports of a_Target listed in a_Map to the concatenation of the
+/// source ports of a_Sources. Each source takes 1/a_Parts of the target port
+/// width, unconnected or narrower inputs are padded with Sx.
+inline void connectCellParts(const CellPortMap &a_Map, RTLIL::Cell *a_Target, std::initializer_list<const RTLIL::Cell *> a_Sources, int a_Parts)
+{
+    for (const auto &it : a_Map) {
+        int width;
+        bool isOutput;
+        std::tie(width, isOutput) = getCellPortInfo(a_Target, it.second);
+        int partWidth = width / a_Parts;
+
+        RTLIL::SigSpec sigspec;
+        for (const auto *cell : a_Sources) {
+            int start = sigspec.size();
+            auto conn = cell->connections_.find(it.first);
+            if (conn != cell->connections_.end()) {
+                sigspec.append(conn->second);
+            }
+            int missing = partWidth - (sigspec.size() - start);
+            if (missing > 0 && !isOutput) {
+                sigspec.append(RTLIL::SigSpec(RTLIL::Sx, missing));
+            }
+        }
+        a_Target->setPort(it.second, std::move(sigspec));
+    }
+}
+
+/// Returns the connections of the given ports mapped through a_SigMap, with
+/// unconnected ports represented by a single Sx bit. Used to build keys of
+/// cells that may share these ports.
+inline dict<RTLIL::IdString, RTLIL::SigSpec> getSharedConnections(const SigMap &a_SigMap, const RTLIL::Cell *a_Cell, const CellPortMap &a_Ports)
+{
+    dict<RTLIL::IdString, RTLIL::SigSpec> connections;
+    for (const auto &it : a_Ports) {
+        auto conn = a_Cell->connections_.find(it.first);
+        if (conn == a_Cell->connections_.end()) {
+            connections[it.first] = RTLIL::SigSpec(RTLIL::Sx);
+        } else {
+            connections[it.first] = a_SigMap(conn->second);
+        }
+    }
+    return connections;
+}
+
+/// Groups cells by a hashable key and packs pairs of cells within a group.
+///
+/// The pack callback gets the key of the group, the two cells and a running
+/// pair index unique within the module. Packed cells are removed once all
+/// groups are done so the callback may still read any of them.
+template <typename Key> class CellPairGroups
+{
+  public:
+    void add(Key &&a_Key, RTLIL::Cell *a_Cell) { m_Groups[std::move(a_Key)].push_back(a_Cell); }
+
+    /// Lets a_Order rearrange the cells of each group before packing, pairs
+    /// are taken in group order
+    template <typename F> void reorder(F a_Order)
+    {
+        for (auto &it : m_Groups) {
+            a_Order(it.second);
+        }
+    }
+
+    template <typename F> void pack(RTLIL::Module *a_Module, F a_Pack)
+    {
+        std::vector<RTLIL::Cell *> packed;
+        int index = 0;
+        for (const auto &it : m_Groups) {
+            const auto &group = it.second;
+            // Ensure an even number
+            size_t count = group.size() & ~size_t(1);
+            for (size_t i = 0; i < count; i += 2) {
+                a_Pack(it.first, group[i], group[i + 1], index++);
+                packed.push_back(group[i]);
+                packed.push_back(group[i + 1]);
+            }
+        }
+        m_Groups.clear();
+
+        for (auto *cell : packed) {
+            a_Module->remove(cell);
+        }
+    }
+
+  private:
+    dict<Key, std::vector<RTLIL::Cell *>> m_Groups;
+};
+
+#endif // _CELL_PAIRING_H_
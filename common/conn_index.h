@@ -0,0 +1,297 @@
+/*
+ * Copyright 2020-2022 F4PGA Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ */
+#ifndef _CONN_INDEX_H_
+#define _CONN_INDEX_H_
+
+#include "kernel/celltypes.h"
+#include "kernel/rtlil.h"
+#include "kernel/sigtools.h"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+USING_YOSYS_NAMESPACE
+
+/// Driver and sink index of a single module.
+///
+/// The index is built with one scan over all cell and module ports. Nets are
+/// numbered and their pins are stored in flat arrays (sinks of a net are kept
+/// contiguous) so a lookup costs one hash probe and the memory is a few words
+/// per pin. All queries take SigBits already mapped through the 'sigmap'
+/// member of the index.
+struct ConnIndex {
+
+    /// A pin of a cell or of the module itself
+    struct Pin {
+        RTLIL::Cell *cell;    /// Cell pointer (nullptr for module ports)
+        RTLIL::IdString port; /// Cell port name or module port wire name
+        int bit;              /// Bit index
+
+        Pin(RTLIL::Cell *_cell, const RTLIL::IdString &_port, int _bit = 0) : cell(_cell), port(_port), bit(_bit) {}
+
+        unsigned int hash() const
+        {
+            unsigned int h = 0;
+            if (cell != nullptr) {
+                h = mkhash_add(h, cell->hash());
+            }
+            h = mkhash_add(h, port.hash());
+            h = mkhash_add(h, bit);
+            return h;
+        }
+
+        bool operator==(const Pin &ref) const { return (cell == ref.cell) && (port == ref.port) && (bit == ref.bit); }
+
+        std::string as_string() const
+        {
+            if (cell != nullptr) {
+                return stringf("%s.%s[%d]", RTLIL::unescape_id(cell->name).c_str(), RTLIL::unescape_id(port).c_str(), bit);
+            } else {
+                return stringf("%s[%d]", RTLIL::unescape_id(port).c_str(), bit);
+            }
+        }
+    };
+
+    /// A contiguous range of pins
+    struct PinRange {
+        const Pin *first;
+        const Pin *last;
+
+        const Pin *begin() const { return first; }
+        const Pin *end() const { return last; }
+        size_t size() const { return last - first; }
+        bool empty() const { return first == last; }
+    };
+
+    /// SigMap of the indexed module
+    SigMap sigmap;
+
+    /// Builds the index for the given module
+    void build(RTLIL::Module *a_Module)
+    {
+        scan(a_Module);
+        finish();
+    }
+
+    /// First part of build(). Computes the SigMap, numbers the nets and lays
+    /// out their pins. It does not create, copy or destroy any IdString and
+    /// only reads tables shared with other modules, so after prepareScan() it
+    /// may run for several modules at once in worker threads. The index can
+    /// be queried only after finish().
+    void scan(RTLIL::Module *a_Module)
+    {
+        clear();
+        sigmap.set(a_Module);
+
+        std::vector<std::pair<int, RawPin>> sinkPins;
+        auto addSink = [&](const RTLIL::SigBit &sigbit, const RawPin &pin) { sinkPins.push_back(std::make_pair(getNet(sigbit), pin)); };
+        auto addDriver = [&](const RTLIL::SigBit &sigbit, const RawPin &pin) {
+            int net = getNet(sigbit);
+            // The first driver found wins
+            if (m_Drivers[net] < 0) {
+                m_Drivers[net] = m_RawDriverPins.size();
+                m_RawDriverPins.push_back(pin);
+            }
+        };
+
+        // Scan cell ports
+        for (auto *cell : a_Module->cells()) {
+            for (const auto &it : cell->connections()) {
+                const auto &port = it.first;
+                bool isInput, isOutput;
+                portDirection(cell, port, isInput, isOutput);
+                const auto &sigspec = it.second;
+                for (int i = 0; i < sigspec.size(); ++i) {
+                    auto sigbit = sigmap(sigspec[i]);
+                    if (isInput) {
+                        addSink(sigbit, RawPin{cell, &port, i});
+                    }
+                    if (isOutput) {
+                        addDriver(sigbit, RawPin{cell, &port, i});
+                    }
+                }
+            }
+        }
+
+        // Scan module ports
+        for (auto wire : a_Module->wires()) {
+            if (!wire->port_input && !wire->port_output) {
+                continue;
+            }
+            for (int i = 0; i < wire->width; ++i) {
+                auto sigbit = sigmap(RTLIL::SigBit(wire, i));
+                if (wire->port_output) {
+                    addSink(sigbit, RawPin{nullptr, &wire->name, i});
+                }
+                if (wire->port_input) {
+                    addDriver(sigbit, RawPin{nullptr, &wire->name, i});
+                }
+            }
+        }
+
+        // Lay the sink pins out contiguously per net
+        m_SinkOffsets.assign(m_Drivers.size() + 1, 0);
+        for (const auto &it : sinkPins) {
+            m_SinkOffsets[it.first + 1]++;
+        }
+        for (size_t i = 1; i < m_SinkOffsets.size(); ++i) {
+            m_SinkOffsets[i] += m_SinkOffsets[i - 1];
+        }
+        std::vector<int> next(m_SinkOffsets.begin(), m_SinkOffsets.end() - 1);
+        m_RawSinkPins.resize(sinkPins.size());
+        for (const auto &it : sinkPins) {
+            m_RawSinkPins[next[it.first]++] = it.second;
+        }
+    }
+
+    /// Second part of build(). Turns the pins laid out by scan() into the
+    /// ones returned by the queries. This copies port names so it must not
+    /// run concurrently with anything else using IdStrings. The module must
+    /// not be changed between scan() and finish().
+    void finish()
+    {
+        m_DriverPins.reserve(m_RawDriverPins.size());
+        for (const auto &pin : m_RawDriverPins) {
+            m_DriverPins.emplace_back(pin.cell, *pin.port, pin.bit);
+        }
+        m_SinkPins.reserve(m_RawSinkPins.size());
+        for (const auto &pin : m_RawSinkPins) {
+            m_SinkPins.emplace_back(pin.cell, *pin.port, pin.bit);
+        }
+        m_RawDriverPins = std::vector<RawPin>();
+        m_RawSinkPins = std::vector<RawPin>();
+    }
+
+    /// Makes the hash tables shared by scan() of all modules of the design
+    /// safe to read concurrently. A hash table of Yosys may rehash itself on
+    /// the first lookup after an insertion so this does one lookup in each.
+    /// Must be called from a single thread, after the cell library and the
+    /// set of modules of the design were last changed.
+    static void prepareScan(RTLIL::Design *a_Design)
+    {
+        RTLIL::IdString none;
+        yosys_celltypes.cell_types.count(none);
+        for (auto &it : yosys_celltypes.cell_types) {
+            it.second.inputs.count(none);
+            it.second.outputs.count(none);
+        }
+        a_Design->modules_.count(none);
+        for (auto &it : a_Design->modules_) {
+            it.second->wires_.count(none);
+        }
+    }
+
+    /// Clears the index
+    void clear()
+    {
+        sigmap.clear();
+        m_Nets.clear();
+        m_Drivers.clear();
+        m_DriverPins.clear();
+        m_SinkOffsets.clear();
+        m_SinkPins.clear();
+        m_RawDriverPins.clear();
+        m_RawSinkPins.clear();
+    }
+
+    /// Returns the driver of a net or nullptr if it has none
+    const Pin *driver(const RTLIL::SigBit &a_SigBit) const
+    {
+        auto it = m_Nets.find(a_SigBit);
+        if (it == m_Nets.end() || m_Drivers[it->second] < 0) {
+            return nullptr;
+        }
+        return &m_DriverPins[m_Drivers[it->second]];
+    }
+
+    /// Returns all sinks of a net
+    PinRange sinks(const RTLIL::SigBit &a_SigBit) const
+    {
+        auto it = m_Nets.find(a_SigBit);
+        if (it == m_Nets.end()) {
+            return PinRange{nullptr, nullptr};
+        }
+        const Pin *pins = m_SinkPins.data();
+        return PinRange{pins + m_SinkOffsets[it->second], pins + m_SinkOffsets[it->second + 1]};
+    }
+
+  private:
+    /// A pin as recorded by scan(). The port name is not copied, it points to
+    /// the name held by the cell connection or by the module port wire.
+    struct RawPin {
+        RTLIL::Cell *cell;
+        const RTLIL::IdString *port;
+        int bit;
+    };
+
+    /// Same as Cell::input() and Cell::output() but without passing any
+    /// IdString by value
+    static void portDirection(const RTLIL::Cell *a_Cell, const RTLIL::IdString &a_Port, bool &a_IsInput, bool &a_IsOutput)
+    {
+        a_IsInput = a_IsOutput = false;
+
+        auto type = yosys_celltypes.cell_types.find(a_Cell->type);
+        if (type != yosys_celltypes.cell_types.end()) {
+            a_IsInput = type->second.inputs.count(a_Port) != 0;
+            a_IsOutput = type->second.outputs.count(a_Port) != 0;
+            return;
+        }
+
+        if (a_Cell->module == nullptr || a_Cell->module->design == nullptr) {
+            return;
+        }
+        const auto &modules = a_Cell->module->design->modules_;
+        auto module = modules.find(a_Cell->type);
+        if (module == modules.end()) {
+            return;
+        }
+        auto wire = module->second->wires_.find(a_Port);
+        if (wire != module->second->wires_.end()) {
+            a_IsInput = wire->second->port_input;
+            a_IsOutput = wire->second->port_output;
+        }
+    }
+
+    int getNet(const RTLIL::SigBit &a_SigBit)
+    {
+        auto it = m_Nets.find(a_SigBit);
+        if (it != m_Nets.end()) {
+            return it->second;
+        }
+        int net = m_Drivers.size();
+        m_Nets.emplace(a_SigBit, net);
+        m_Drivers.push_back(-1);
+        return net;
+    }
+
+    /// Net index of each SigBit
+    dict<RTLIL::SigBit, int> m_Nets;
+    /// Index of the driver pin of each net (-1 for undriven nets)
+    std::vector<int> m_Drivers;
+    std::vector<Pin> m_DriverPins;
+    /// Sinks of net N are m_SinkPins[m_SinkOffsets[N]:m_SinkOffsets[N + 1]]
+    std::vector<int> m_SinkOffsets;
+    std::vector<Pin> m_SinkPins;
+    /// Pins recorded by scan() until finish() is called
+    std::vector<RawPin> m_RawDriverPins;
+    std::vector<RawPin> m_RawSinkPins;
+};
+
+#endif // _CONN_INDEX_H_
@@ -0,0 +1,219 @@
+/*
+ * Copyright 2020-2022 F4PGA Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ */
+#ifndef _SCRIPT_PROFILER_H_
+#define _SCRIPT_PROFILER_H_
+
+#include "kernel/rtlil.h"
+#include "kernel/yosys.h"
+
+#include <chrono>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+USING_YOSYS_NAMESPACE
+
+/// Records wall time, peak resident set size and design size around steps of
+/// a script and writes them to a JSON or CSV report.
+class ScriptProfiler
+{
+  public:
+    struct Step {
+        std::string label;
+        std::string command;
+        double seconds = 0.0;
+        long peakRssBefore = 0; /// KiB
+        long peakRssAfter = 0;  /// KiB
+        size_t cellsBefore = 0;
+        size_t cellsAfter = 0;
+        size_t wiresBefore = 0;
+        size_t wiresAfter = 0;
+    };
+
+    /// Sets the label of the steps that follow
+    void setLabel(const std::string &a_Label) { m_Label = a_Label; }
+
+    /// Starts a step
+    void begin(RTLIL::Design *a_Design, const std::string &a_Command)
+    {
+        m_Steps.emplace_back();
+        auto &step = m_Steps.back();
+        step.label = m_Label;
+        step.command = a_Command;
+        step.peakRssBefore = peakRss();
+        countObjects(a_Design, step.cellsBefore, step.wiresBefore);
+        m_Start = std::chrono::steady_clock::now();
+    }
+
+    /// Ends the step started last
+    void end(RTLIL::Design *a_Design)
+    {
+        log_assert(!m_Steps.empty());
+        auto &step = m_Steps.back();
+        step.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - m_Start).count();
+        step.peakRssAfter = peakRss();
+        countObjects(a_Design, step.cellsAfter, step.wiresAfter);
+    }
+
+    const std::vector<Step> &steps() const { return m_Steps; }
+
+    void clear()
+    {
+        m_Label.clear();
+        m_Steps.clear();
+    }
+
+    /// Writes the report. Files with the ".csv" extension get one line per
+    /// step, other files get JSON with both the steps and per label totals.
+    void write(const std::string &a_FileName) const
+    {
+        std::ofstream file(a_FileName);
+        if (!file) {
+            log_error("Cannot open file '%s' for writing!\n", a_FileName.c_str());
+        }
+
+        bool csv = a_FileName.size() >= 4 && a_FileName.compare(a_FileName.size() - 4, 4, ".csv") == 0;
+        if (csv) {
+            writeCsv(file);
+        } else {
+            writeJson(file);
+        }
+    }
+
+  private:
+    /// Peak resident set size of the process in KiB (0 if not available)
+    static long peakRss()
+    {
+#ifndef _WIN32
+        struct rusage usage;
+        if (getrusage(RUSAGE_SELF, &usage) == 0) {
+#ifdef __APPLE__
+            return usage.ru_maxrss / 1024;
+#else
+            return usage.ru_maxrss;
+#endif
+        }
+#endif
+        return 0;
+    }
+
+    static void countObjects(RTLIL::Design *a_Design, size_t &a_Cells, size_t &a_Wires)
+    {
+        a_Cells = 0;
+        a_Wires = 0;
+        if (a_Design == nullptr) {
+            return;
+        }
+        for (auto &it : a_Design->modules_) {
+            a_Cells += it.second->cells_.size();
+            a_Wires += it.second->wires_.size();
+        }
+    }
+
+    static std::string quoteJson(const std::string &a_String)
+    {
+        std::string str = "\"";
+        for (char c : a_String) {
+            if (c == '"' || c == '\\') {
+                str += '\\';
+                str += c;
+            } else if ((unsigned char)c < 0x20) {
+                str += stringf("\\u%04x", c);
+            } else {
+                str += c;
+            }
+        }
+        return str + "\"";
+    }
+
+    static std::string quoteCsv(const std::string &a_String)
+    {
+        if (a_String.find_first_of(",\"\n") == std::string::npos) {
+            return a_String;
+        }
+        std::string str = "\"";
+        for (char c : a_String) {
+            if (c == '"') {
+                str += '"';
+            }
+            str += c;
+        }
+        return str + "\"";
+    }
+
+    void writeCsv(std::ostream &a_Stream) const
+    {
+        a_Stream << "label,command,seconds,peak_rss_kb,peak_rss_delta_kb,cells_before,cells_after,wires_before,wires_after\n";
+        for (const auto &step : m_Steps) {
+            a_Stream << quoteCsv(step.label) << "," << quoteCsv(step.command) << "," << stringf("%.6f", step.seconds) << "," << step.peakRssAfter
+                     << "," << (step.peakRssAfter - step.peakRssBefore) << "," << step.cellsBefore << "," << step.cellsAfter << ","
+                     << step.wiresBefore << "," << step.wiresAfter << "\n";
+        }
+    }
+
+    void writeJson(std::ostream &a_Stream) const
+    {
+        // Per label totals, in the order of appearance
+        std::vector<Step> labels;
+        for (const auto &step : m_Steps) {
+            if (labels.empty() || labels.back().label != step.label) {
+                labels.push_back(step);
+                labels.back().seconds = 0.0;
+            }
+            auto &total = labels.back();
+            total.seconds += step.seconds;
+            total.peakRssAfter = step.peakRssAfter;
+            total.cellsAfter = step.cellsAfter;
+            total.wiresAfter = step.wiresAfter;
+        }
+
+        auto writeEntry = [&](const Step &a_Step, bool a_WithCommand) {
+            a_Stream << "    {\"label\": " << quoteJson(a_Step.label);
+            if (a_WithCommand) {
+                a_Stream << ", \"command\": " << quoteJson(a_Step.command);
+            }
+            a_Stream << ", \"seconds\": " << stringf("%.6f", a_Step.seconds) << ", \"peak_rss_kb\": " << a_Step.peakRssAfter
+                     << ", \"peak_rss_delta_kb\": " << (a_Step.peakRssAfter - a_Step.peakRssBefore) << ", \"cells_before\": " << a_Step.cellsBefore
+                     << ", \"cells_after\": " << a_Step.cellsAfter << ", \"wires_before\": " << a_Step.wiresBefore
+                     << ", \"wires_after\": " << a_Step.wiresAfter << "}";
+        };
+
+        a_Stream << "{\n  \"steps\": [\n";
+        for (size_t i = 0; i < m_Steps.size(); ++i) {
+            writeEntry(m_Steps[i], true);
+            a_Stream << ((i + 1 < m_Steps.size()) ? ",\n" : "\n");
+        }
+        a_Stream << "  ],\n  \"labels\": [\n";
+        for (size_t i = 0; i < labels.size(); ++i) {
+            writeEntry(labels[i], false);
+            a_Stream << ((i + 1 < labels.size()) ? ",\n" : "\n");
+        }
+        a_Stream << "  ]\n}\n";
+    }
+
+    std::string m_Label;
+    std::vector<Step> m_Steps;
+    std::chrono::steady_clock::time_point m_Start;
+};
+
+#endif // _SCRIPT_PROFILER_H_
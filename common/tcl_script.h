@@ -0,0 +1,172 @@
+/*
+ * Copyright 2020-2022 F4PGA Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ */
+#ifndef _TCL_SCRIPT_H_
+#define _TCL_SCRIPT_H_
+
+#include "kernel/yosys.h"
+
+#include <cctype>
+#include <cstring>
+#include <string>
+
+USING_YOSYS_NAMESPACE
+
+/// Splits a Tcl command made of literal words, i.e. bare words and braced
+/// words without nesting, so that constraint readers can run common
+/// commands without the interpreter. Anything else makes the scan fail and
+/// is left to Tcl.
+class TclLiteralScanner
+{
+  public:
+    explicit TclLiteralScanner(const std::string &command) : command(command) {}
+
+    /// Skips whitespace, returns false at the end of the command
+    bool skip_spaces()
+    {
+        while (pos < command.size() && strchr(" \t\r\n", command[pos]) && command[pos] != '\0') {
+            pos++;
+        }
+        return pos < command.size();
+    }
+
+    /// Consumes the given character if it is the next one
+    bool consume(char c)
+    {
+        if (pos < command.size() && command[pos] == c) {
+            pos++;
+            return true;
+        }
+        return false;
+    }
+
+    /// Reads a bare or braced word. Bare words may contain bus indexes like
+    /// "led[1]" if allowed, which the readers turn back into the literal
+    /// text through their 'unknown' handler.
+    bool word(std::string &out, bool allow_index = false)
+    {
+        if (pos < command.size() && command[pos] == '{') {
+            size_t end = command.find_first_of("{}\\", pos + 1);
+            if (end == std::string::npos || command[end] != '}') {
+                return false;
+            }
+            out = command.substr(pos + 1, end - pos - 1);
+            pos = end + 1;
+            return true;
+        }
+        size_t start = pos;
+        while (pos < command.size()) {
+            char c = command[pos];
+            if (allow_index && c == '[') {
+                size_t end = pos + 1;
+                while (end < command.size() && isdigit(static_cast<unsigned char>(command[end]))) {
+                    end++;
+                }
+                if (end == pos + 1 || end == command.size() || command[end] != ']') {
+                    return false;
+                }
+                pos = end + 1;
+                continue;
+            }
+            if (strchr(" \t\r\n{}[]\"$;\\", c) && c != '\0') {
+                break;
+            }
+            pos++;
+        }
+        out = command.substr(start, pos - start);
+        return pos != start;
+    }
+
+    /// Tcl replaces a backslash-newline and the whitespace after it with a
+    /// space
+    static std::string join_continued_lines(const std::string &command)
+    {
+        std::string joined;
+        size_t pos = 0;
+        size_t next;
+        while ((next = command.find("\\\n", pos)) != std::string::npos) {
+            joined.append(command, pos, next - pos);
+            joined += ' ';
+            pos = command.find_first_not_of(" \t", next + 2);
+            if (pos == std::string::npos) {
+                pos = command.size();
+            }
+        }
+        if (pos == 0) {
+            return command;
+        }
+        joined.append(command, pos, std::string::npos);
+        return joined;
+    }
+
+    /// A comment ending with a backslash continues on the next line, it is
+    /// left to Tcl
+    static bool is_comment_or_empty(const std::string &command)
+    {
+        size_t pos = command.find_first_not_of(" \t\r\n");
+        return pos == std::string::npos || (command[pos] == '#' && command.find('\\') == std::string::npos);
+    }
+
+  private:
+    const std::string &command;
+    size_t pos = 0;
+};
+
+/// Makes [info script] return the path of a constraint file while it is
+/// read and restores the previous path when going out of scope, keeping
+/// the interpreter result (e.g. an error message) across the restore.
+class TclInfoScriptGuard
+{
+  public:
+    TclInfoScriptGuard(Tcl_Interp *interp, const std::string &path) : interp(interp)
+    {
+        Tcl_Eval(interp, "info script");
+        prev_path = Tcl_GetStringResult(interp);
+        set_info_script(interp, path);
+    }
+
+    ~TclInfoScriptGuard()
+    {
+        Tcl_Obj *result = Tcl_GetObjResult(interp);
+        Tcl_IncrRefCount(result);
+        set_info_script(interp, prev_path);
+        Tcl_SetObjResult(interp, result);
+        Tcl_DecrRefCount(result);
+    }
+
+    TclInfoScriptGuard(const TclInfoScriptGuard &) = delete;
+    TclInfoScriptGuard &operator=(const TclInfoScriptGuard &) = delete;
+
+    static void set_info_script(Tcl_Interp *interp, const std::string &path)
+    {
+        Tcl_Obj *objv[3] = {Tcl_NewStringObj("info", -1), Tcl_NewStringObj("script", -1), Tcl_NewStringObj(path.c_str(), path.size())};
+        for (auto obj : objv) {
+            Tcl_IncrRefCount(obj);
+        }
+        Tcl_EvalObjv(interp, 3, objv, 0);
+        for (auto obj : objv) {
+            Tcl_DecrRefCount(obj);
+        }
+    }
+
+  private:
+    Tcl_Interp *interp;
+    std::string prev_path;
+};
+
+#endif // _TCL_SCRIPT_H_
@@ -20,6 +20,7 @@
 #include "get_cells.h"
 #include "get_count.h"
 #include "get_nets.h"
+#include "get_objects.h"
 #include "get_pins.h"
 #include "get_ports.h"
 #include "selection_to_tcl_list.h"
@@ -29,13 +30,17 @@ USING_YOSYS_NAMESPACE
 PRIVATE_NAMESPACE_BEGIN
 
 struct DesignIntrospection {
-    DesignIntrospection() {}
+    DesignIntrospection()
+        : get_objects_cmd({{"nets", &get_nets_cmd}, {"ports", &get_ports_cmd}, {"cells", &get_cells_cmd}, {"pins", &get_pins_cmd}})
+    {
+    }
     GetNets get_nets_cmd;
     GetPorts get_ports_cmd;
     GetCells get_cells_cmd;
     GetPins get_pins_cmd;
     GetCount get_count_cmd;
     SelectionToTclList selection_to_tcl_list_cmd;
+    GetObjects get_objects_cmd;
 } DesignIntrospection;
 
 PRIVATE_NAMESPACE_END
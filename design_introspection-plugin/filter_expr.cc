@@ -0,0 +1,239 @@
+/*
+ * Copyright 2020-2022 F4PGA Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ */
+#include "filter_expr.h"
+
+#include <cctype>
+#include <cstring>
+#include <map>
+
+USING_YOSYS_NAMESPACE
+
+struct FilterParser {
+    FilterExpr &expr;
+    const std::string &text;
+    bool regexp;
+    size_t pos = 0;
+
+    FilterParser(FilterExpr &expr, const std::string &text, bool regexp) : expr(expr), text(text), regexp(regexp) {}
+
+    [[noreturn]] void Error(const char *reason)
+    {
+        log_cmd_error("Incorrect filter expression '%s': %s at position %zu\n", text.c_str(), reason, pos);
+    }
+
+    void SkipSpaces()
+    {
+        while (pos < text.size() && isspace(static_cast<unsigned char>(text[pos]))) {
+            pos++;
+        }
+    }
+
+    bool Accept(const char *token)
+    {
+        SkipSpaces();
+        size_t len = strlen(token);
+        if (text.compare(pos, len, token) != 0) {
+            return false;
+        }
+        pos += len;
+        return true;
+    }
+
+    static bool IsWordChar(char c) { return !isspace(static_cast<unsigned char>(c)) && !strchr("()!=&|\"", c); }
+
+    std::string Word()
+    {
+        SkipSpaces();
+        std::string word;
+        if (pos < text.size() && text[pos] == '"') {
+            size_t end = text.find('"', pos + 1);
+            if (end == std::string::npos) {
+                Error("unterminated string");
+            }
+            word = text.substr(pos + 1, end - pos - 1);
+            pos = end + 1;
+            return word;
+        }
+        size_t start = pos;
+        while (pos < text.size() && IsWordChar(text[pos])) {
+            pos++;
+        }
+        if (pos == start) {
+            Error("expected a name or a value");
+        }
+        return text.substr(start, pos - start);
+    }
+
+    int AddNode(FilterExpr::Op op, int lhs, int rhs)
+    {
+        FilterExpr::Node node;
+        node.op = op;
+        node.lhs = lhs;
+        node.rhs = rhs;
+        node.regexp = false;
+        expr.nodes.push_back(std::move(node));
+        return GetSize(expr.nodes) - 1;
+    }
+
+    int Comparison()
+    {
+        RTLIL::IdString property(RTLIL::escape_id(Word()));
+        FilterExpr::Op op;
+        if (Accept("==")) {
+            op = FilterExpr::Op::EQUAL;
+        } else if (Accept("!=")) {
+            op = FilterExpr::Op::NOT_EQUAL;
+        } else if (Accept("=~")) {
+            op = FilterExpr::Op::MATCH;
+        } else if (Accept("!~")) {
+            op = FilterExpr::Op::NOT_MATCH;
+        } else {
+            Error("expected one of ==, !=, =~, !~");
+        }
+        int index = AddNode(op, -1, -1);
+        FilterExpr::Node &node = expr.nodes[index];
+        node.property = property;
+        node.value = Word();
+        if (regexp && (op == FilterExpr::Op::MATCH || op == FilterExpr::Op::NOT_MATCH)) {
+            try {
+                node.regex = std::regex(node.value);
+            } catch (const std::regex_error &e) {
+                Error(e.what());
+            }
+            node.regexp = true;
+        }
+        return index;
+    }
+
+    int Unary()
+    {
+        if (Accept("!")) {
+            return AddNode(FilterExpr::Op::NOT, Unary(), -1);
+        }
+        if (Accept("(")) {
+            int index = Or();
+            if (!Accept(")")) {
+                Error("expected )");
+            }
+            return index;
+        }
+        return Comparison();
+    }
+
+    int And()
+    {
+        int lhs = Unary();
+        while (Accept("&&")) {
+            lhs = AddNode(FilterExpr::Op::AND, lhs, Unary());
+        }
+        return lhs;
+    }
+
+    int Or()
+    {
+        int lhs = And();
+        while (Accept("||")) {
+            lhs = AddNode(FilterExpr::Op::OR, lhs, And());
+        }
+        return lhs;
+    }
+
+    void Parse()
+    {
+        expr.root = Or();
+        SkipSpaces();
+        if (pos != text.size()) {
+            Error("unexpected trailing characters");
+        }
+    }
+};
+
+std::shared_ptr<const FilterExpr> FilterExpr::Compile(const std::string &text, bool regexp)
+{
+    // Scripts usually reuse a handful of filters, the cap only guards
+    // against generated expressions growing the cache without bound
+    static std::map<std::pair<std::string, bool>, std::shared_ptr<const FilterExpr>> cache;
+    const size_t max_cached = 256;
+
+    auto key = std::make_pair(text, regexp);
+    auto it = cache.find(key);
+    if (it != cache.end()) {
+        return it->second;
+    }
+
+    auto expr = std::make_shared<FilterExpr>();
+    FilterParser(*expr, text, regexp).Parse();
+    if (cache.size() >= max_cached) {
+        cache.clear();
+    }
+    cache.emplace(std::move(key), expr);
+    return expr;
+}
+
+std::string FilterExpr::ConstToString(const RTLIL::Const &value)
+{
+    if (value.flags & RTLIL::CONST_FLAG_STRING) {
+        return value.decode_string();
+    }
+    if (value.is_fully_def() && GetSize(value) <= 32) {
+        return std::to_string(value.as_int());
+    }
+    return value.as_string();
+}
+
+bool FilterExpr::Eval(const RTLIL::AttrObject *object, const dict<RTLIL::IdString, RTLIL::Const> *parameters) const
+{
+    return root < 0 || EvalNode(root, object, parameters);
+}
+
+bool FilterExpr::EvalNode(int index, const RTLIL::AttrObject *object, const dict<RTLIL::IdString, RTLIL::Const> *parameters) const
+{
+    const Node &node = nodes[index];
+    switch (node.op) {
+    case Op::AND:
+        return EvalNode(node.lhs, object, parameters) && EvalNode(node.rhs, object, parameters);
+    case Op::OR:
+        return EvalNode(node.lhs, object, parameters) || EvalNode(node.rhs, object, parameters);
+    case Op::NOT:
+        return !EvalNode(node.lhs, object, parameters);
+    default:
+        break;
+    }
+
+    std::string value;
+    auto attr = object->attributes.find(node.property);
+    if (attr != object->attributes.end()) {
+        value = ConstToString(attr->second);
+    } else if (parameters != nullptr) {
+        auto param = parameters->find(node.property);
+        if (param != parameters->end()) {
+            value = ConstToString(param->second);
+        }
+    }
+
+    bool result;
+    if (node.op == Op::EQUAL || node.op == Op::NOT_EQUAL) {
+        result = value == node.value;
+    } else if (node.regexp) {
+        result = std::regex_match(value, node.regex);
+    } else {
+        result = patmatch(node.value.c_str(), value.c_str());
+    }
+    return (node.op == Op::NOT_EQUAL || node.op == Op::NOT_MATCH) ? !result : result;
+}
@@ -0,0 +1,74 @@
+/*
+ * Copyright 2020-2022 F4PGA Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ */
+#ifndef _FILTER_EXPR_H_
+#define _FILTER_EXPR_H_
+
+#include "kernel/rtlil.h"
+
+#include <memory>
+#include <regex>
+#include <string>
+#include <vector>
+
+USING_YOSYS_NAMESPACE
+
+// Compiled -filter expression of the get_* commands.
+//
+// Grammar:
+//   expr       := and_expr ( "||" and_expr )*
+//   and_expr   := unary ( "&&" unary )*
+//   unary      := "!" unary | "(" expr ")" | comparison
+//   comparison := property ( "==" | "!=" | "=~" | "!~" ) value
+//
+// A property is looked up in the attributes of the object and then in its
+// parameters, a missing property compares as an empty string. "=~" and "!~"
+// match a glob pattern, or a regular expression when compiled with regexp.
+// Values may be double-quoted.
+class FilterExpr
+{
+  public:
+    // Compiled expressions are cached by their text
+    static std::shared_ptr<const FilterExpr> Compile(const std::string &text, bool regexp);
+
+    bool Eval(const RTLIL::AttrObject *object, const dict<RTLIL::IdString, RTLIL::Const> *parameters = nullptr) const;
+
+  private:
+    enum class Op { AND, OR, NOT, EQUAL, NOT_EQUAL, MATCH, NOT_MATCH };
+
+    struct Node {
+        Op op;
+        // Operand node indices for AND, OR and NOT
+        int lhs;
+        int rhs;
+        RTLIL::IdString property;
+        std::string value;
+        bool regexp;
+        std::regex regex;
+    };
+
+    friend struct FilterParser;
+
+    bool EvalNode(int index, const RTLIL::AttrObject *object, const dict<RTLIL::IdString, RTLIL::Const> *parameters) const;
+    static std::string ConstToString(const RTLIL::Const &value);
+
+    std::vector<Node> nodes;
+    int root = -1;
+};
+
+#endif // _FILTER_EXPR_H_
@@ -27,17 +27,20 @@ std::string GetCells::SelectionType() { return "c"; }
 GetCells::SelectionObjects GetCells::ExtractSelection(RTLIL::Design *design, const CommandArgs &args)
 {
     SelectionObjects selected_objects;
-    for (auto module : design->selected_modules()) {
-        for (auto cell : module->selected_cells()) {
-            if (args.filters.size() > 0) {
-                Filter filter = args.filters.at(0);
-                std::string attr_value = cell->get_string_attribute(RTLIL::IdString(RTLIL::escape_id(filter.first)));
-                if (attr_value.compare(filter.second)) {
-                    continue;
-                }
+    auto add_object = [&](RTLIL::Cell *cell) {
+        if (PassesFilters(cell, &cell->parameters, args)) {
+            selected_objects.push_back(RTLIL::unescape_id(cell->name));
+        }
+    };
+    if (IsDirectSelection(args.selection_objects)) {
+        for (auto cell : MatchObjects(design->top_module()->cells_, args.selection_objects)) {
+            add_object(cell);
+        }
+    } else {
+        for (auto module : design->selected_modules()) {
+            for (auto cell : module->selected_cells()) {
+                add_object(cell);
             }
-            std::string object_name(RTLIL::unescape_id(cell->name));
-            selected_objects.push_back(object_name);
         }
     }
     if (selected_objects.size() == 0 and !args.is_quiet) {
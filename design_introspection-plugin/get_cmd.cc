@@ -6,7 +6,7 @@ void GetCmd::help()
 {
     //   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
     log("\n");
-    log("   get_%ss [-quiet] [-filter filter_expression] "
+    log("   get_%ss [-quiet] [-filter filter_expression] [-regexp] "
         "<%s_selection> \n",
         TypeName().c_str(), TypeName().c_str());
     log("\n");
@@ -17,9 +17,14 @@ void GetCmd::help()
         "executed.\n");
     log("\n");
     log("    -filter\n");
-    log("        Name and value of attribute to be taken into "
-        "account.\n");
-    log("        e.g. -filter { attr == \"true\" }\n");
+    log("        Expression over attributes (and parameters of cells) that the\n");
+    log("        objects have to satisfy. Comparisons use ==, != and the glob\n");
+    log("        matches =~ and !~, they can be combined with &&, ||, ! and\n");
+    log("        parentheses. A missing attribute compares as an empty string.\n");
+    log("        e.g. -filter { attr == \"true\" && IOSTANDARD =~ LVCMOS* }\n");
+    log("\n");
+    log("    -regexp\n");
+    log("        Treat the =~ and !~ filter patterns as regular expressions.\n");
     log("\n");
     log("    -quiet\n");
     log("        Don't print the result of the execution to stdout.\n");
@@ -31,8 +36,47 @@ void GetCmd::help()
     log("\n");
 }
 
+bool GetCmd::IsDirectSelection(const SelectionObjects &patterns)
+{
+    if (patterns.empty()) {
+        return false;
+    }
+    // Selection operators, named selections and the special handling of
+    // auto-generated names are left to the selection engine
+    for (const auto &pattern : patterns) {
+        if (pattern.empty() or pattern[0] == '$' or pattern[0] == '%' or pattern[0] == '@') {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Same rules as the selection engine uses for object names
+bool GetCmd::MatchName(const RTLIL::IdString &id, const std::string &pattern)
+{
+    const char *id_c = id.c_str();
+    if (id == pattern) {
+        return true;
+    }
+    if (id_c[0] == '\\' and pattern == id_c + 1) {
+        return true;
+    }
+    if (patmatch(pattern.c_str(), id_c)) {
+        return true;
+    }
+    return id_c[0] == '\\' and patmatch(pattern.c_str(), id_c + 1);
+}
+
+bool GetCmd::PassesFilters(const RTLIL::AttrObject *object, const dict<RTLIL::IdString, RTLIL::Const> *parameters, const CommandArgs &args)
+{
+    return args.filter == nullptr or args.filter->Eval(object, parameters);
+}
+
 void GetCmd::ExecuteSelection(RTLIL::Design *design, const CommandArgs &args)
 {
+    if (IsDirectSelection(args.selection_objects)) {
+        return;
+    }
     std::vector<std::string> selection_args;
     // Add name of top module to selection string
     std::transform(args.selection_objects.begin(), args.selection_objects.end(), std::back_inserter(selection_args),
@@ -45,24 +89,35 @@ void GetCmd::ExecuteSelection(RTLIL::Design *design, const CommandArgs &args)
     }
 }
 
-void GetCmd::PackToTcl(const SelectionObjects &objects)
+Tcl_Obj *GetCmd::ToTclList(SelectionObjects &&objects)
+{
+    // Build the list in one go, releasing each name once Tcl has its own
+    // copy so that large results are not held twice
+    std::vector<Tcl_Obj *> objv;
+    objv.reserve(objects.size());
+    for (auto &object : objects) {
+        objv.push_back(Tcl_NewStringObj(object.c_str(), object.size()));
+        std::string().swap(object);
+    }
+    return Tcl_NewListObj(objv.size(), objv.data());
+}
+
+void GetCmd::PackToTcl(SelectionObjects &&objects)
 {
     Tcl_Obj *tcl_result;
     if (objects.size() == 1) {
-        tcl_result = Tcl_NewStringObj(objects.at(0).c_str(), -1);
+        tcl_result = Tcl_NewStringObj(objects.at(0).c_str(), objects.at(0).size());
     } else {
-        tcl_result = Tcl_NewListObj(0, NULL);
-        for (const auto &object : objects) {
-            Tcl_Obj *value_obj = Tcl_NewStringObj(object.c_str(), -1);
-            Tcl_ListObjAppendElement(yosys_get_tcl_interp(), tcl_result, value_obj);
-        }
+        tcl_result = ToTclList(std::move(objects));
     }
     Tcl_SetObjResult(yosys_get_tcl_interp(), tcl_result);
 }
 
 GetCmd::CommandArgs GetCmd::ParseCommand(const std::vector<std::string> &args)
 {
-    CommandArgs parsed_args{.filters = Filters(), .is_quiet = false, .selection_objects = SelectionObjects()};
+    CommandArgs parsed_args{.filter = nullptr, .is_quiet = false, .selection_objects = SelectionObjects()};
+    std::string filter_text;
+    bool is_regexp = false;
     size_t argidx(0);
     for (argidx = 1; argidx < args.size(); argidx++) {
         std::string arg = args[argidx];
@@ -72,36 +127,12 @@ GetCmd::CommandArgs GetCmd::ParseCommand(const std::vector<std::string> &args)
         }
 
         if (arg == "-filter" and argidx + 1 < args.size()) {
-            std::string filter_arg = args[++argidx];
-
-            // Remove spaces
-            filter_arg.erase(std::remove_if(filter_arg.begin(), filter_arg.end(), isspace), filter_arg.end());
-
-            // Parse filters
-            // TODO Add support for multiple condition expression
-            // Currently only a single == is supported
-            std::regex filter_attr_regex("(\\w+\\s?==\\s?\\w+)([(||)(&&)]*)");
-            std::regex_token_iterator<std::string::iterator> regex_end;
-            std::regex_token_iterator<std::string::iterator> matches(filter_arg.begin(), filter_arg.end(), filter_attr_regex, 1);
-            if (matches == regex_end) {
-                log_warning("Currently -filter switch supports only a single "
-                            "'equal(==)' condition expression, the rest will be "
-                            "ignored\n");
-            }
-
-            while (matches != regex_end) {
-                std::string filter(*matches++);
-                auto separator = filter.find("==");
-                if (separator == std::string::npos) {
-                    log_cmd_error("Incorrect filter expression: %s\n", args[argidx].c_str());
-                }
-                parsed_args.filters.emplace_back(filter.substr(0, separator), filter.substr(separator + 2));
-            }
-            if (parsed_args.filters.size() > 1) {
-                log_warning("Currently -filter switch supports only a single "
-                            "'equal(==)' condition expression, the rest will be "
-                            "ignored\n");
-            }
+            filter_text = args[++argidx];
+            continue;
+        }
+
+        if (arg == "-regexp") {
+            is_regexp = true;
             continue;
         }
 
@@ -111,6 +142,9 @@ GetCmd::CommandArgs GetCmd::ParseCommand(const std::vector<std::string> &args)
 
         break;
     }
+    if (!filter_text.empty()) {
+        parsed_args.filter = FilterExpr::Compile(filter_text, is_regexp);
+    }
     std::copy(args.begin() + argidx, args.end(), std::back_inserter(parsed_args.selection_objects));
     return parsed_args;
 }
@@ -121,7 +155,12 @@ void GetCmd::execute(std::vector<std::string> args, RTLIL::Design *design)
         log_cmd_error("No top module detected\n");
     }
 
+    PackToTcl(Query(design, args));
+}
+
+GetCmd::SelectionObjects GetCmd::Query(RTLIL::Design *design, const std::vector<std::string> &args)
+{
     CommandArgs parsed_args(ParseCommand(args));
     ExecuteSelection(design, parsed_args);
-    PackToTcl(ExtractSelection(design, parsed_args));
+    return ExtractSelection(design, parsed_args);
 }
@@ -19,16 +19,15 @@
 #ifndef _GET_CMD_H_
 #define _GET_CMD_H_
 
+#include "filter_expr.h"
 #include "kernel/register.h"
 
 USING_YOSYS_NAMESPACE
 
 struct GetCmd : public Pass {
-    using Filter = std::pair<std::string, std::string>;
-    using Filters = std::vector<Filter>;
     using SelectionObjects = std::vector<std::string>;
     struct CommandArgs {
-        Filters filters;
+        std::shared_ptr<const FilterExpr> filter;
         bool is_quiet;
         SelectionObjects selection_objects;
     };
@@ -38,9 +37,53 @@ struct GetCmd : public Pass {
     void help() override;
     void execute(std::vector<std::string> args, RTLIL::Design *design) override;
 
+    // Runs the command on the given arguments (args[0] being the command
+    // name) and returns the matching objects. Used by batched queries, the
+    // caller has to make sure there is a top module.
+    SelectionObjects Query(RTLIL::Design *design, const std::vector<std::string> &args);
+    static Tcl_Obj *ToTclList(SelectionObjects &&objects);
+
   protected:
     CommandArgs ParseCommand(const std::vector<std::string> &args);
-    void PackToTcl(const SelectionObjects &objects);
+    void PackToTcl(SelectionObjects &&objects);
+
+    // Plain names and globs are matched directly against the objects of the
+    // top module instead of going through the selection engine
+    static bool IsDirectSelection(const SelectionObjects &patterns);
+    static bool MatchName(const RTLIL::IdString &id, const std::string &pattern);
+    static bool PassesFilters(const RTLIL::AttrObject *object, const dict<RTLIL::IdString, RTLIL::Const> *parameters, const CommandArgs &args);
+
+    // Returns the objects matching any of the patterns in module order, an
+    // empty result is reported once by the caller
+    template <typename T> std::vector<T *> MatchObjects(const dict<RTLIL::IdString, T *> &objects, const SelectionObjects &patterns)
+    {
+        pool<T *> matched;
+        for (const auto &pattern : patterns) {
+            if (pattern.find_first_of("*?[\\") == std::string::npos) {
+                auto it = objects.find(RTLIL::IdString("\\" + pattern));
+                if (it != objects.end()) {
+                    matched.insert(it->second);
+                }
+                continue;
+            }
+            for (const auto &it : objects) {
+                if (MatchName(it.first, pattern)) {
+                    matched.insert(it.second);
+                }
+            }
+        }
+        std::vector<T *> result;
+        if (matched.size() == 1) {
+            result.push_back(*matched.begin());
+        } else if (matched.size() > 1) {
+            for (const auto &it : objects) {
+                if (matched.count(it.second)) {
+                    result.push_back(it.second);
+                }
+            }
+        }
+        return result;
+    }
 
   private:
     virtual std::string TypeName() = 0;
@@ -69,30 +69,29 @@ void GetCount::execute(std::vector<std::string> a_Args, RTLIL::Design *a_Design)
     // Get the TCL interpreter
     Tcl_Interp *tclInterp = yosys_get_tcl_interp();
 
-    // Count objects
-    size_t moduleCount = 0;
-    size_t cellCount = 0;
-    size_t wireCount = 0;
-
-    moduleCount += a_Design->selected_modules().size();
-    for (auto module : a_Design->selected_modules()) {
-        cellCount += module->selected_cells().size();
-        wireCount += module->selected_wires().size();
-    }
-
+    // Count objects. Fully selected modules take the sizes of their object
+    // dicts, which are kept up to date by the module itself, so only
+    // partially selected modules need to visit their members.
     size_t count = 0;
-    switch (type) {
-    case ObjectType::MODULE:
-        count = moduleCount;
-        break;
-    case ObjectType::CELL:
-        count = cellCount;
-        break;
-    case ObjectType::WIRE:
-        count = wireCount;
-        break;
-    default:
-        log_assert(false);
+    for (auto &it : a_Design->modules_) {
+        RTLIL::Module *module = it.second;
+        if (!a_Design->selected_module(module->name) || module->get_blackbox_attribute()) {
+            continue;
+        }
+        bool whole = a_Design->selected_whole_module(module->name);
+        switch (type) {
+        case ObjectType::MODULE:
+            count++;
+            break;
+        case ObjectType::CELL:
+            count += whole ? module->cells_.size() : CountSelected(a_Design, module, module->cells_);
+            break;
+        case ObjectType::WIRE:
+            count += whole ? module->wires_.size() : CountSelected(a_Design, module, module->wires_);
+            break;
+        default:
+            log_assert(false);
+        }
     }
 
     // Return the value as string to the TCL interpreter
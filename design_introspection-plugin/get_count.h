@@ -31,6 +31,18 @@ struct GetCount : public Pass {
 
     void help() override;
     void execute(std::vector<std::string> a_Args, RTLIL::Design *a_Design) override;
+
+  private:
+    template <typename T> static size_t CountSelected(const RTLIL::Design *a_Design, const RTLIL::Module *a_Module, const dict<RTLIL::IdString, T *> &a_Objects)
+    {
+        size_t count = 0;
+        for (const auto &it : a_Objects) {
+            if (a_Design->selected_member(a_Module->name, it.first)) {
+                count++;
+            }
+        }
+        return count;
+    }
 };
 
 #endif // GET_COUNT_H_
@@ -27,17 +27,20 @@ std::string GetNets::SelectionType() { return "w"; }
 GetNets::SelectionObjects GetNets::ExtractSelection(RTLIL::Design *design, const CommandArgs &args)
 {
     SelectionObjects selected_objects;
-    for (auto module : design->selected_modules()) {
-        for (auto wire : module->selected_wires()) {
-            if (args.filters.size() > 0) {
-                Filter filter = args.filters.at(0);
-                std::string attr_value = wire->get_string_attribute(RTLIL::IdString(RTLIL::escape_id(filter.first)));
-                if (attr_value.compare(filter.second)) {
-                    continue;
-                }
+    auto add_object = [&](RTLIL::Wire *wire) {
+        if (PassesFilters(wire, nullptr, args)) {
+            selected_objects.push_back(RTLIL::unescape_id(wire->name));
+        }
+    };
+    if (IsDirectSelection(args.selection_objects)) {
+        for (auto wire : MatchObjects(design->top_module()->wires_, args.selection_objects)) {
+            add_object(wire);
+        }
+    } else {
+        for (auto module : design->selected_modules()) {
+            for (auto wire : module->selected_wires()) {
+                add_object(wire);
             }
-            std::string object_name(RTLIL::unescape_id(wire->name));
-            selected_objects.push_back(object_name);
         }
     }
     if (selected_objects.size() == 0 and !args.is_quiet) {
@@ -0,0 +1,98 @@
+/*
+ * Copyright 2020-2022 F4PGA Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ */
+#include "get_objects.h"
+
+USING_YOSYS_NAMESPACE
+
+void GetObjects::help()
+{
+    //   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
+    log("\n");
+    log("   get_objects -batch <queries>\n");
+    log("\n");
+    log("Resolve many get_* queries in a single command. <queries> is a Tcl list of\n");
+    log("queries, each being a list of an object kind followed by the arguments of the\n");
+    log("matching get_* command:\n");
+    log("\n");
+    log("    get_objects -batch {{cells *inter*} {pins -filter {dont_touch == true} */I}}\n");
+    log("\n");
+    log("The supported kinds are: %s.\n", KindNames().c_str());
+    log("\n");
+    log("The result is a Tcl dict mapping the text of each query to the list of\n");
+    log("matching object names.\n");
+    log("\n");
+}
+
+std::string GetObjects::KindNames()
+{
+    std::vector<std::string> kinds;
+    for (auto &it : commands) {
+        kinds.push_back(it.first);
+    }
+    std::sort(kinds.begin(), kinds.end());
+    std::string names;
+    for (auto &kind : kinds) {
+        names += (names.empty() ? "" : ", ") + kind;
+    }
+    return names;
+}
+
+std::vector<std::string> GetObjects::SplitTclList(const std::string &list)
+{
+    Tcl_Interp *interp = yosys_get_tcl_interp();
+    int argc;
+    const char **argv;
+    if (Tcl_SplitList(interp, list.c_str(), &argc, &argv) != TCL_OK) {
+        log_cmd_error("Malformed query list: %s\n", list.c_str());
+    }
+    std::vector<std::string> items(argv, argv + argc);
+    Tcl_Free(reinterpret_cast<char *>(argv));
+    return items;
+}
+
+void GetObjects::execute(std::vector<std::string> args, RTLIL::Design *design)
+{
+    if (args.size() != 3 or args[1] != "-batch") {
+        log_cmd_error("Usage: get_objects -batch <queries>\n");
+    }
+    if (design->top_module() == nullptr) {
+        log_cmd_error("No top module detected\n");
+    }
+
+    size_t selection_depth = design->selection_stack.size();
+    Tcl_Obj *result = Tcl_NewDictObj();
+    for (auto &query : SplitTclList(args[2])) {
+        std::vector<std::string> query_args = SplitTclList(query);
+        if (query_args.empty()) {
+            log_cmd_error("Empty query in batch\n");
+        }
+        auto it = commands.find(query_args[0]);
+        if (it == commands.end()) {
+            log_cmd_error("Unknown object kind '%s', expected one of: %s.\n", query_args[0].c_str(), KindNames().c_str());
+        }
+        // Query() expects the command name in place of the kind
+        query_args[0] = it->second->pass_name;
+        Tcl_Obj *key = Tcl_NewStringObj(query.c_str(), query.size());
+        Tcl_DictObjPut(nullptr, result, key, GetCmd::ToTclList(it->second->Query(design, query_args)));
+        // Pass::call only restores the selection stack once the whole batch
+        // is done, drop the selection pushed by this query right away
+        design->selection_stack.resize(selection_depth);
+    }
+    Tcl_SetObjResult(yosys_get_tcl_interp(), result);
+}
@@ -0,0 +1,43 @@
+/*
+ * Copyright 2020-2022 F4PGA Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ */
+#ifndef _GET_OBJECTS_H_
+#define _GET_OBJECTS_H_
+
+#include "get_cmd.h"
+
+USING_YOSYS_NAMESPACE
+
+struct GetObjects : public Pass {
+    GetObjects(const dict<std::string, GetCmd *> &commands)
+        : Pass("get_objects", "Resolve a batch of get_* queries in a single call"), commands(commands)
+    {
+    }
+
+    void help() override;
+    void execute(std::vector<std::string> args, RTLIL::Design *design) override;
+
+  private:
+    std::string KindNames();
+    std::vector<std::string> SplitTclList(const std::string &list);
+
+    // Object kind (e.g. "cells") to the command answering its queries
+    dict<std::string, GetCmd *> commands;
+};
+
+#endif // GET_OBJECTS_H_
@@ -37,6 +37,14 @@ GetPins::SelectionObjects GetPins::ExtractSelection(RTLIL::Design *design, const
         size_t port_separator = obj.find_last_of('/');
         std::string cell = obj.substr(0, port_separator);
         std::string port = obj.substr(port_separator + 1);
+        SelectionObjects cell_pattern{cell};
+        if (IsDirectSelection(cell_pattern)) {
+            RTLIL::IdString port_id(RTLIL::escape_id(port));
+            for (auto c : MatchObjects(design->top_module()->cells_, cell_pattern)) {
+                AddPin(selected_objects, c, port_id, port, args);
+            }
+            continue;
+        }
         SelectionObjects selection{RTLIL::unescape_id(design->top_module()->name) + "/" + SelectionType() + ":" + cell};
         extra_args(selection, 0, design);
         ExtractSingleSelection(selected_objects, design, port, args);
@@ -54,20 +62,19 @@ void GetPins::ExtractSingleSelection(SelectionObjects &objects, RTLIL::Design *d
             log_warning("Specified %s not found in design\n", TypeName().c_str());
         }
     }
+    RTLIL::IdString port_id(RTLIL::escape_id(port_name));
     for (auto module : design->selected_modules()) {
         for (auto cell : module->selected_cells()) {
-            if (!cell->hasPort(RTLIL::escape_id(port_name))) {
-                continue;
-            }
-            if (args.filters.size() > 0) {
-                Filter filter = args.filters.at(0);
-                std::string attr_value = cell->get_string_attribute(RTLIL::IdString(RTLIL::escape_id(filter.first)));
-                if (attr_value.compare(filter.second)) {
-                    continue;
-                }
-            }
-            std::string pin_name(RTLIL::unescape_id(cell->name) + "/" + port_name);
-            objects.push_back(pin_name);
+            AddPin(objects, cell, port_id, port_name, args);
         }
     }
 }
+
+void GetPins::AddPin(SelectionObjects &objects, const RTLIL::Cell *cell, const RTLIL::IdString &port_id, const std::string &port_name,
+                     const CommandArgs &args)
+{
+    if (!cell->hasPort(port_id) or !PassesFilters(cell, &cell->parameters, args)) {
+        return;
+    }
+    objects.push_back(RTLIL::unescape_id(cell->name) + "/" + port_name);
+}
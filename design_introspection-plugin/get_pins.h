@@ -32,6 +32,8 @@ struct GetPins : public GetCmd {
     SelectionObjects ExtractSelection(RTLIL::Design *design, const CommandArgs &args) override;
     void ExecuteSelection(RTLIL::Design *design, const CommandArgs &args) override;
     void ExtractSingleSelection(SelectionObjects &objects, RTLIL::Design *design, const std::string &port_name, const CommandArgs &args);
+    void AddPin(SelectionObjects &objects, const RTLIL::Cell *cell, const RTLIL::IdString &port_id, const std::string &port_name,
+                const CommandArgs &args);
 };
 
 #endif // GET_PINS_H_
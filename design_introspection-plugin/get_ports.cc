@@ -41,7 +41,7 @@ GetPorts::SelectionObjects GetPorts::ExtractSelection(RTLIL::Design *design, con
     RTLIL::IdString port_id(RTLIL::escape_id(port_str));
     SelectionObjects objects;
     if (auto wire = design->top_module()->wire(port_id)) {
-        if (wire->port_input || wire->port_output) {
+        if ((wire->port_input || wire->port_output) && PassesFilters(wire, nullptr, args)) {
             if (bit >= wire->start_offset && bit < wire->start_offset + wire->width) {
                 objects.push_back(port_name);
             }
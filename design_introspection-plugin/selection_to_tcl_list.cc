@@ -40,7 +40,7 @@ void SelectionToTclList::execute(std::vector<std::string> args, RTLIL::Design *d
     extra_args(args, 1, design);
 
     Tcl_Interp *interp = yosys_get_tcl_interp();
-    Tcl_Obj *tcl_list = Tcl_NewListObj(0, NULL);
+    std::vector<Tcl_Obj *> objv;
 
     auto &selection = design->selection();
     if (selection.empty()) {
@@ -49,34 +49,34 @@ void SelectionToTclList::execute(std::vector<std::string> args, RTLIL::Design *d
 
     for (auto mod : design->modules()) {
         if (selection.selected_module(mod->name)) {
+            std::string prefix = RTLIL::unescape_id(mod->name) + "/";
             for (auto wire : mod->wires()) {
                 if (selection.selected_member(mod->name, wire->name)) {
-                    AddObjectNameToTclList(mod->name, wire->name, tcl_list);
+                    AddObjectNameToTclList(prefix, wire->name, objv);
                 }
             }
             for (auto &it : mod->memories) {
                 if (selection.selected_member(mod->name, it.first)) {
-                    AddObjectNameToTclList(mod->name, it.first, tcl_list);
+                    AddObjectNameToTclList(prefix, it.first, objv);
                 }
             }
             for (auto cell : mod->cells()) {
                 if (selection.selected_member(mod->name, cell->name)) {
-                    AddObjectNameToTclList(mod->name, cell->name, tcl_list);
+                    AddObjectNameToTclList(prefix, cell->name, objv);
                 }
             }
             for (auto &it : mod->processes) {
                 if (selection.selected_member(mod->name, it.first)) {
-                    AddObjectNameToTclList(mod->name, it.first, tcl_list);
+                    AddObjectNameToTclList(prefix, it.first, objv);
                 }
             }
         }
     }
-    Tcl_SetObjResult(interp, tcl_list);
+    Tcl_SetObjResult(interp, Tcl_NewListObj(objv.size(), objv.data()));
 }
 
-void SelectionToTclList::AddObjectNameToTclList(RTLIL::IdString &module, RTLIL::IdString &object, Tcl_Obj *tcl_list)
+void SelectionToTclList::AddObjectNameToTclList(const std::string &prefix, const RTLIL::IdString &object, std::vector<Tcl_Obj *> &objv)
 {
-    std::string name = RTLIL::unescape_id(module) + "/" + RTLIL::unescape_id(object);
-    Tcl_Obj *value_obj = Tcl_NewStringObj(name.c_str(), name.size());
-    Tcl_ListObjAppendElement(yosys_get_tcl_interp(), tcl_list, value_obj);
+    std::string name = prefix + RTLIL::unescape_id(object);
+    objv.push_back(Tcl_NewStringObj(name.c_str(), name.size()));
 }
@@ -29,7 +29,7 @@ struct SelectionToTclList : public Pass {
     void execute(std::vector<std::string> args, RTLIL::Design *design) override;
 
   private:
-    void AddObjectNameToTclList(RTLIL::IdString &module, RTLIL::IdString &object, Tcl_Obj *tcl_list);
+    void AddObjectNameToTclList(const std::string &prefix, const RTLIL::IdString &object, std::vector<Tcl_Obj *> &objv);
 };
 
 #endif // SELECTION_TO_TCL_LIST_H_
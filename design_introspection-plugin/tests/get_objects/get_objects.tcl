@@ -0,0 +1,22 @@
+yosys -import
+if { [info procs get_objects] == {} } { plugin -i design_introspection }
+yosys -import  ;# ingest plugin commands
+
+read_verilog -icells $::env(DESIGN_TOP).v
+hierarchy -top top
+
+set result [get_objects -batch {{cells *_0} {nets ab} {pins *_0/A} {ports y} {cells missing}}]
+puts $result
+
+proc check {result query expected} {
+    set actual [lsort [dict get $result $query]]
+    if {$actual != [lsort $expected]} {
+        error "Query '$query' returned '$actual', expected '$expected'"
+    }
+}
+
+check $result {cells *_0} {and_0 not_0 or_0}
+check $result {nets ab} {ab}
+check $result {pins *_0/A} {and_0/A not_0/A or_0/A}
+check $result {ports y} {y}
+check $result {cells missing} {}
@@ -25,4 +25,8 @@ puts "\nFiltered pins"
 puts $fp "\nFiltered pins"
 puts $fp [get_pins -filter {dont_touch == true || async_reg == true && mr_ff == true} *OBUF*/I ]
 
+puts "\nPins filtered by parameters"
+puts $fp "\nPins filtered by parameters"
+puts $fp [get_pins -filter {IOSTANDARD =~ LVCMOS* && !(dont_touch == true)} OBUF_*/I ]
+
 close $fp
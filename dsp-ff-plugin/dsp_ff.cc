@@ -2,6 +2,18 @@
 #include "kernel/rtlil.h"
 #include "kernel/sigtools.h"
 
+#include "../common/conn_index.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <ctime>
+#include <map>
+#include <thread>
+#include <tuple>
+
+#include <sys/stat.h>
+
 USING_YOSYS_NAMESPACE
 PRIVATE_NAMESPACE_BEGIN
 
@@ -10,111 +22,7 @@ PRIVATE_NAMESPACE_BEGIN
 struct DspFF : public Pass {
 
     /// A structure identifying specific pin in a cell instance
-    struct CellPin {
-        RTLIL::Cell *cell;    /// Cell pointer (nullptr for top-level ports)
-        RTLIL::IdString port; /// Port name
-        int bit;              /// Bit index
-
-        CellPin(RTLIL::Cell *_cell, const RTLIL::IdString &_port, int _bit = 0) : cell(_cell), port(_port), bit(_bit) {}
-
-        CellPin(const CellPin &ref) = default;
-        CellPin(CellPin &&ref) = default;
-
-        unsigned int hash() const
-        {
-            unsigned int h = 0;
-            if (cell != nullptr) {
-                h = mkhash_add(h, cell->hash());
-            }
-            h = mkhash_add(h, port.hash());
-            h = mkhash_add(h, bit);
-            return h;
-        }
-
-        bool operator==(const CellPin &ref) const { return (cell == ref.cell) && (port == ref.port) && (bit == ref.bit); }
-
-        std::string as_string() const
-        {
-            if (cell != nullptr) {
-                return stringf("%s.%s[%d]", RTLIL::unescape_id(cell->name).c_str(), RTLIL::unescape_id(port).c_str(), bit);
-            } else {
-                return stringf("%s[%d]", RTLIL::unescape_id(port).c_str(), bit);
-            }
-        }
-    };
-
-    // ..........................................
-
-    /// Connection map
-    struct ConnMap {
-
-        /// Maps source SigBit to all sinks it drives CellPin.
-        dict<RTLIL::SigBit, std::vector<CellPin>> sinks;
-        /// Maps source SigBit to its driver CellPin
-        dict<RTLIL::SigBit, CellPin> drivers;
-
-        /// Builds the map
-        void build(RTLIL::Module *module, const SigMap &sigmap)
-        {
-            clear();
-
-            // Scan cell ports
-            for (auto *cell : module->cells()) {
-                for (const auto &it : cell->connections_) {
-                    const auto &port = it.first;
-                    const auto &sigbits = it.second.bits();
-                    for (size_t i = 0; i < sigbits.size(); ++i) {
-                        auto sigbit = sigmap(sigbits[i]);
-
-                        // This is an input port (sink))
-                        if (cell->input(port)) {
-                            auto &vec = sinks[sigbit];
-                            vec.push_back(CellPin(cell, port, i));
-                        }
-                        // This is a source
-                        if (cell->output(port)) {
-                            drivers.insert(std::make_pair(sigbit, CellPin(cell, port, i)));
-                        }
-                    }
-                }
-            }
-
-            // Scan top-level ports
-            for (auto &it : module->wires_) {
-                auto *wire = it.second;
-
-                if (!wire->port_input && !wire->port_output) {
-                    continue;
-                }
-
-                RTLIL::SigSpec sigspec(wire, wire->start_offset, wire->width);
-                const auto &sigbits = sigspec.bits();
-                for (size_t i = 0; i < sigbits.size(); ++i) {
-                    auto sigbit = sigbits[i];
-                    if (!sigbit.wire) {
-                        continue;
-                    }
-
-                    // Output port (sink)
-                    if (sigbit.wire->port_output) {
-                        auto &vec = sinks[sigmap(sigbit)];
-                        vec.push_back(CellPin(nullptr, sigbit.wire->name, i));
-                    }
-                    // Input port (source)
-                    if (sigbit.wire->port_input) {
-                        drivers.insert(std::make_pair(sigbit, CellPin(nullptr, sigbit.wire->name, i)));
-                    }
-                }
-            }
-        }
-
-        /// Clears the map
-        void clear()
-        {
-            sinks.clear();
-            drivers.clear();
-        };
-    };
+    using CellPin = ConnIndex::Pin;
 
     // ..........................................
 
@@ -184,6 +92,46 @@ struct DspFF : public Pass {
         dict<RegisterType, std::vector<PortType>> registers;
     };
 
+    /// Delays (in ns) of a sequential cell
+    struct FlopDelays {
+        float clk2q;
+        float setup;
+    };
+
+    /// Delays (in ns) of a DSP cell. The delay is the one from its inputs to
+    /// its outputs, clk2q and setup are the ones of its internal registers.
+    struct DspDelays {
+        float delay;
+        float clk2q;
+        float setup;
+    };
+
+    /// Delay table (in ns) used by the timing-driven integration
+    struct Delays {
+        /// Connection between a DSP cell and the fabric
+        float net = 0.5f;
+        /// Combinational cells, the default and per cell type
+        float cell = 0.5f;
+        dict<RTLIL::IdString, float> cells;
+        /// Sequential cells, the default and per cell type
+        FlopDelays flop = {0.4f, 0.1f};
+        dict<RTLIL::IdString, FlopDelays> flops;
+        /// DSP cells, the default and per cell type
+        DspDelays dsp = {3.0f, 0.3f, 0.2f};
+        dict<RTLIL::IdString, DspDelays> dsps;
+    };
+
+    /// Outcome of the timing check of a DSP register
+    struct TimingRecord {
+        std::string dsp;                /// "<module>.<cell> (<type>)"
+        std::string ports;              /// DSP ports of the register
+        std::vector<std::string> flops; /// Flip-flops to integrate
+        float period;                   /// Clock period, 0 if unknown
+        float before;                   /// Worst path delay without integration
+        float after;                    /// Worst path delay with integration
+        bool absorbed;
+    };
+
     /// Describes a changes made to a DSP cell
     struct DspChanges {
         pool<RTLIL::IdString> params; // Modified params
@@ -222,68 +170,177 @@ struct DspFF : public Pass {
         }
     };
 
+    /// Hashable signature of a flip-flop configuration for a register rule.
+    /// Flip-flops with equal signatures yield equal FlopData, it is built
+    /// from flat lists in the order of the rules instead of dicts.
+    struct FlopSignature {
+        RTLIL::IdString type;
+        /// Control port connections, first is false when unconnected
+        std::vector<std::pair<bool, RTLIL::SigBit>> conns;
+        /// Flip-flop and mapped DSP parameters, first is false when unset
+        std::vector<std::pair<bool, RTLIL::Const>> params;
+
+        unsigned int hash() const
+        {
+            unsigned int h = 0;
+            h = mkhash_add(h, type.hash());
+            for (const auto &conn : conns) {
+                h = mkhash_add(h, conn.first ? conn.second.hash() : 0);
+            }
+            for (const auto &param : params) {
+                h = mkhash_add(h, param.first ? param.second.hash() : 0);
+            }
+            return h;
+        }
+
+        bool operator==(const FlopSignature &ref) const { return (type == ref.type) && (conns == ref.conns) && (params == ref.params); }
+    };
+
     // ..........................................
 
-    /// Loads FF and DSP integration rules from a file
-    void load_rules(const std::string &a_FileName)
-    {
+    /// Connections of a single DSP port bit
+    struct BitConns {
+        RTLIL::SigBit sigbit;                           /// The (mapped) port bit
+        const CellPin *driver = nullptr;                /// Its driver if any
+        ConnIndex::PinRange sinks = {nullptr, nullptr}; /// Its sinks
+    };
 
-        // Parses a string and returns a vector of fields delimited by the
-        // given character.
-        auto getFields = [](const std::string &a_String, const char a_Delim = ' ', bool a_KeepEmpty = false) {
-            std::vector<std::string> fields;
-            std::stringstream ss(a_String);
+    /// A DSP cell along with connections of all its register ports. The
+    /// connections are stored in the order of the DSP type rules.
+    struct DspCell {
+        RTLIL::Cell *cell;
+        std::vector<std::vector<BitConns>> ports;
+    };
 
-            while (ss.good()) {
-                std::string field;
-                std::getline(ss, field, a_Delim);
-                if (!field.empty() || a_KeepEmpty) {
-                    fields.push_back(field);
-                }
+    /// Per-module state of the pass
+    struct ModuleContext {
+        RTLIL::Module *module = nullptr;
+        /// Module connection index (holds the module SigMap too)
+        ConnIndex connIndex;
+        /// DSP cells of the module
+        std::vector<DspCell> dspCells;
+
+        /// Cells to be removed
+        pool<RTLIL::Cell *> cellsToRemove;
+        /// DSP cells that got changed
+        dict<RTLIL::Cell *, DspChanges> dspChanges;
+
+        /// Estimated arrival times at cell outputs and departure times from
+        /// cell inputs (timing-driven integration only)
+        dict<RTLIL::Cell *, float> arrival;
+        dict<RTLIL::Cell *, float> departure;
+        pool<RTLIL::Cell *> visiting;
+        /// Clock periods indexed by (mapped) clock nets
+        dict<RTLIL::SigBit, float> clockPeriods;
+    };
+
+    // ..........................................
+
+    /// Splits a string into fields delimited by the given character. Empty
+    /// fields are skipped.
+    static std::vector<std::string> getFields(const std::string &a_String, const char a_Delim = ' ')
+    {
+        std::vector<std::string> fields;
+
+        size_t pos = 0;
+        while (pos < a_String.size()) {
+            size_t end = a_String.find(a_Delim, pos);
+            if (end == std::string::npos) {
+                end = a_String.size();
+            }
+            if (end > pos) {
+                fields.push_back(a_String.substr(pos, end - pos));
             }
+            pos = end + 1;
+        }
 
-            return fields;
-        };
+        return fields;
+    }
 
-        // Parses a vector of strings like "<name>=<value>" starting from the
-        // second one on the list
-        auto parseNameValue = [&](const std::vector<std::string> &strs) {
-            const std::regex expr("(\\S+)=(\\S+)");
-            std::smatch match;
+    /// Parses a vector of strings like "<name>=<value>" starting from the
+    /// second one on the list. The value is what follows the last '=' sign.
+    static std::vector<std::pair<std::string, std::string>> parseNameValue(const std::vector<std::string> &a_Strs)
+    {
+        std::vector<std::pair<std::string, std::string>> vec;
 
-            std::vector<std::pair<std::string, std::string>> vec;
+        for (size_t i = 1; i < a_Strs.size(); ++i) {
+            const auto &str = a_Strs[i];
 
-            for (size_t i = 1; i < strs.size(); ++i) {
-                if (std::regex_match(strs[i], match, expr)) {
-                    vec.push_back(std::make_pair(match[1], match[2]));
-                } else {
-                    log_error(" syntax error: '%s'\n", strs[i].c_str());
-                }
+            // Both the name and the value must be non-empty
+            size_t pos = (str.size() >= 2) ? str.rfind('=', str.size() - 2) : std::string::npos;
+            bool isOk = (pos != std::string::npos && pos > 0);
+            for (size_t j = 0; isOk && j < str.size(); ++j) {
+                isOk = !std::isspace((unsigned char)str[j]);
             }
 
-            return vec;
+            if (!isOk) {
+                log_error(" syntax error: '%s'\n", str.c_str());
+            }
+            vec.push_back(std::make_pair(str.substr(0, pos), str.substr(pos + 1)));
+        }
+
+        return vec;
+    }
+
+    /// Parses port name as "<name>[<hi>:<lo>]" or just "<name>"
+    static std::tuple<std::string, int, int> parsePortName(const std::string &a_Str)
+    {
+        auto isNumber = [](const std::string &str) {
+            return !str.empty() && std::all_of(str.begin(), str.end(), [](char c) { return c >= '0' && c <= '9'; });
         };
 
-        // Parses port name as "<name>[<hi>:<lo>]" or just "<name>"
-        auto parsePortName = [&](const std::string &str) {
-            const std::regex expr("^(.*)\\[([0-9]+):([0-9]+)\\]");
-            std::smatch match;
+        // Split "<name>[<hi>:<lo>]"
+        size_t lb = a_Str.rfind('[');
+        size_t colon = a_Str.rfind(':');
+        if (a_Str.empty() || a_Str.back() != ']' || lb == std::string::npos || colon == std::string::npos || colon < lb) {
+            return std::make_tuple(a_Str, -1, -1);
+        }
 
-            std::tuple<std::string, int, int> data;
-            auto res = std::regex_match(str, match, expr);
-            if (res) {
-                data = std::make_tuple(std::string(match[1]), std::stoi(match[2]), std::stoi(match[3]));
+        const auto hi = a_Str.substr(lb + 1, colon - lb - 1);
+        const auto lo = a_Str.substr(colon + 1, a_Str.size() - colon - 2);
+        if (!isNumber(hi) || !isNumber(lo)) {
+            return std::make_tuple(a_Str, -1, -1);
+        }
 
-                if ((std::get<2>(data) > std::get<1>(data)) || std::get<2>(data) < 0 || std::get<1>(data) < 0) {
-                    log_error(" invalid port spec: '%s'\n", str.c_str());
-                }
-            } else {
-                data = std::make_tuple(str, -1, -1);
+        auto data = std::make_tuple(a_Str.substr(0, lb), std::stoi(hi), std::stoi(lo));
+        if ((std::get<2>(data) > std::get<1>(data)) || std::get<2>(data) < 0 || std::get<1>(data) < 0) {
+            log_error(" invalid port spec: '%s'\n", a_Str.c_str());
+        }
+
+        return data;
+    }
+
+    /// Loads FF and DSP integration rules from a file. Rules parsed before
+    /// are reused as long as the file did not change.
+    void load_rules(const std::string &a_FileName)
+    {
+        struct stat info;
+        bool haveInfo = (stat(a_FileName.c_str(), &info) == 0);
+
+        if (haveInfo) {
+            auto it = m_RulesCache.find(a_FileName);
+            if (it != m_RulesCache.end() && it->second.mtime == info.st_mtime && it->second.size == info.st_size) {
+                log("Using rules loaded from '%s'.\n", a_FileName.c_str());
+                m_DspTypes = it->second.dspTypes;
+                m_FlopTypes = it->second.flopTypes;
+                return;
             }
+        }
 
-            return data;
-        };
+        parse_rules(a_FileName);
+
+        if (haveInfo) {
+            auto &rules = m_RulesCache[a_FileName];
+            rules.mtime = info.st_mtime;
+            rules.size = info.st_size;
+            rules.dspTypes = m_DspTypes;
+            rules.flopTypes = m_FlopTypes;
+        }
+    }
 
+    /// Parses FF and DSP integration rules from a file
+    void parse_rules(const std::string &a_FileName)
+    {
         std::ifstream file(a_FileName);
         std::string line;
 
@@ -617,6 +674,87 @@ struct DspFF : public Pass {
         }
     }
 
+    /// Parses the delay table used by the timing-driven integration
+    void parse_delays(const std::string &a_FileName)
+    {
+        std::ifstream file(a_FileName);
+        std::string line;
+
+        log("Loading delays from '%s'...\n", a_FileName.c_str());
+        if (!file) {
+            log_error(" Error opening file '%s'!\n", a_FileName.c_str());
+        }
+
+        auto getDelay = [](const std::string &str) {
+            float delay = 0.0f;
+            size_t pos = 0;
+            try {
+                delay = std::stof(str, &pos);
+            } catch (const std::exception &) {
+                pos = 0;
+            }
+            if (pos == 0 || pos != str.size() || delay < 0.0f) {
+                log_error(" invalid delay: '%s'\n", str.c_str());
+            }
+            return delay;
+        };
+
+        while (std::getline(file, line)) {
+
+            // Strip comment if any, skip empty lines
+            size_t pos = line.find("#");
+            if (pos != std::string::npos) {
+                line = line.substr(0, pos);
+            }
+            if (line.find_first_not_of(" \r\n\t") == std::string::npos) {
+                continue;
+            }
+
+            // Split the line. The type '*' sets the default.
+            const auto fields = getFields(line);
+            log_assert(fields.size() >= 1);
+
+            if (fields[0] == "net") {
+                if (fields.size() != 2) {
+                    log_error(" syntax error: '%s'\n", line.c_str());
+                }
+                m_Delays.net = getDelay(fields[1]);
+            } else if (fields[0] == "cell") {
+                if (fields.size() != 3) {
+                    log_error(" syntax error: '%s'\n", line.c_str());
+                }
+                float delay = getDelay(fields[2]);
+                if (fields[1] == "*") {
+                    m_Delays.cell = delay;
+                } else {
+                    m_Delays.cells[RTLIL::escape_id(fields[1])] = delay;
+                }
+            } else if (fields[0] == "ff") {
+                if (fields.size() != 4) {
+                    log_error(" syntax error: '%s'\n", line.c_str());
+                }
+                FlopDelays delays = {getDelay(fields[2]), getDelay(fields[3])};
+                if (fields[1] == "*") {
+                    m_Delays.flop = delays;
+                } else {
+                    m_Delays.flops[RTLIL::escape_id(fields[1])] = delays;
+                }
+            } else if (fields[0] == "dsp") {
+                if (fields.size() != 5) {
+                    log_error(" syntax error: '%s'\n", line.c_str());
+                }
+                DspDelays delays = {getDelay(fields[2]), getDelay(fields[3]), getDelay(fields[4])};
+                if (fields[1] == "*") {
+                    m_Delays.dsp = delays;
+                } else {
+                    m_Delays.dsps[RTLIL::escape_id(fields[1])] = delays;
+                }
+            } else {
+                log_error(" unexpected keyword '%s'\n", fields[0].c_str());
+            }
+        }
+    }
+
     void dump_rules()
     {
 
@@ -704,21 +842,35 @@ struct DspFF : public Pass {
 
     // ..........................................
 
-    /// Temporary SigBit to SigBit helper map.
-    SigMap m_SigMap;
-    /// Module connection map
-    ConnMap m_ConnMap;
-
-    /// Cells to be removed (per module!)
-    pool<RTLIL::Cell *> m_CellsToRemove;
-    /// DSP cells that got changed
-    dict<RTLIL::Cell *, DspChanges> m_DspChanges;
+    /// Number of threads for indexing and looking up DSP port connections
+    int m_NumThreads = 1;
+    /// Modules indexed at once per thread
+    static constexpr size_t MODULES_PER_THREAD = 4;
 
     /// DSP types
     dict<RTLIL::IdString, DspType> m_DspTypes;
     /// Flip-flop types
     dict<RTLIL::IdString, FlopType> m_FlopTypes;
 
+    /// Rules loaded from a file along with its modification time and size
+    struct Rules {
+        std::time_t mtime;
+        off_t size;
+        dict<RTLIL::IdString, DspType> dspTypes;
+        dict<RTLIL::IdString, FlopType> flopTypes;
+    };
+    /// Rules indexed by file names
+    std::map<std::string, Rules> m_RulesCache;
+
+    /// Integrate registers only when it pays off timing-wise
+    bool m_Timing = false;
+    /// Also integrate registers that lengthen paths still fitting the period
+    bool m_FitPeriod = false;
+    /// Delay table for the timing-driven integration
+    Delays m_Delays;
+    /// Timing checks done so far, in the order of processing
+    std::vector<TimingRecord> m_TimingRecords;
+
     // ..........................................
 
     DspFF() : Pass("dsp_ff", "Integrates flip-flop into DSP blocks") {}
@@ -726,10 +878,37 @@ struct DspFF : public Pass {
     void help() override
     {
         log("\n");
-        log("    dsp_ff -rules <rules.txt> [selection]\n");
+        log("    dsp_ff -rules <rules.txt> [-threads <N>] [-timing] [-fit_period]\n");
+        log("           [-delays <delays.txt>] [-report <file>] [selection]\n");
         log("\n");
         log("Integrates flip-flops with DSP blocks and enables their internal registers.\n");
         log("\n");
+        log("    -threads <N>\n");
+        log("        Index connections of selected modules and look up those of DSP ports\n");
+        log("        using up to N threads (0 uses all available cores), a few modules per\n");
+        log("        thread at a time. Only these lookups run in parallel: checking and\n");
+        log("        integrating the flip-flops creates IdStrings, sets cell parameters\n");
+        log("        and logs, none of which is thread safe in Yosys. The modules are\n");
+        log("        therefore modified one by one in the usual order and the result does\n");
+        log("        not depend on N. The default is 1.\n");
+        log("\n");
+        log("    -timing\n");
+        log("        Integrate a register only if it shortens the longest estimated path\n");
+        log("        through its flip-flops.\n");
+        log("\n");
+        log("    -fit_period\n");
+        log("        Also integrate a register that lengthens the path if the path still\n");
+        log("        fits the period of the clock of its flip-flops afterwards. The period\n");
+        log("        is taken from the PERIOD attribute of the clock wire, as set by the\n");
+        log("        create_clock command of the SDC plugin. Implies -timing.\n");
+        log("\n");
+        log("    -delays <delays.txt>\n");
+        log("        Load the delay table used by -timing from a file. Implies -timing.\n");
+        log("\n");
+        log("    -report <file>\n");
+        log("        Write a per-DSP report of the registers integrated or kept in the\n");
+        log("        fabric along with the estimated delays. Implies -timing.\n");
+        log("\n");
         log("The pass loads a set of rules from the file given with the '-rules' parameter.\n");
         log("The rules define what ports of a DSP module have internal registers and what\n");
         log("has to be done to enable them. They also define compatible flip-flop cell\n");
@@ -794,6 +973,19 @@ struct DspFF : public Pass {
         log("The 'set' and 'map' statements serve the same function as in the DSP port\n");
         log("section but here they may differ depending on the flip-flop type being\n");
         log("integrated.\n");
+        log("\n");
+        log("The delay table holds delays in ns, a '*' type sets the default for cells\n");
+        log("that are not listed:\n");
+        log("\n");
+        log("  net  <delay>                            # DSP to fabric connection\n");
+        log("  cell <type> <delay>                     # combinational cell\n");
+        log("  ff   <type> <clk-to-q> <setup>          # sequential cell\n");
+        log("  dsp  <type> <delay> <clk-to-q> <setup>  # DSP cell and its registers\n");
+        log("\n");
+        log("Path delays are estimated on the netlist as it is before the integration.\n");
+        log("Each cell counts with its delay from any input to any output, DSP cells\n");
+        log("being treated as combinational. Flip-flops, built-in flip-flop cells and\n");
+        log("'ff' cells of the table start and end paths.\n");
     }
 
     void execute(std::vector<std::string> a_Args, RTLIL::Design *a_Design) override
@@ -801,6 +993,12 @@ struct DspFF : public Pass {
         log_header(a_Design, "Executing DSP_FF pass.\n");
 
         std::string rulesFile;
+        std::string delaysFile;
+        std::string reportFile;
+
+        m_NumThreads = 1;
+        m_Timing = false;
+        m_FitPeriod = false;
 
         // Parse args
         size_t argidx;
@@ -809,6 +1007,29 @@ struct DspFF : public Pass {
                 rulesFile = a_Args[++argidx];
                 continue;
             }
+            if (a_Args[argidx] == "-threads" && (argidx + 1) < a_Args.size()) {
+                m_NumThreads = std::atoi(a_Args[++argidx].c_str());
+                continue;
+            }
+            if (a_Args[argidx] == "-timing") {
+                m_Timing = true;
+                continue;
+            }
+            if (a_Args[argidx] == "-fit_period") {
+                m_FitPeriod = true;
+                m_Timing = true;
+                continue;
+            }
+            if (a_Args[argidx] == "-delays" && (argidx + 1) < a_Args.size()) {
+                delaysFile = a_Args[++argidx];
+                m_Timing = true;
+                continue;
+            }
+            if (a_Args[argidx] == "-report" && (argidx + 1) < a_Args.size()) {
+                reportFile = a_Args[++argidx];
+                m_Timing = true;
+                continue;
+            }
 
             break;
         }
@@ -818,12 +1039,18 @@ struct DspFF : public Pass {
         if (rulesFile.empty()) {
             log_cmd_error("No rules file specified!");
         }
+        if (m_NumThreads < 0) {
+            log_cmd_error("Invalid number of threads!");
+        }
+        if (m_NumThreads == 0) {
+            m_NumThreads = std::max(1U, std::thread::hardware_concurrency());
+        }
 
         // Reset state
-        m_CellsToRemove.clear();
-        m_DspChanges.clear();
         m_DspTypes.clear();
         m_FlopTypes.clear();
+        m_Delays = Delays();
+        m_TimingRecords.clear();
 
         // Load rules
         rewrite_filename(rulesFile);
@@ -832,42 +1059,170 @@ struct DspFF : public Pass {
             dump_rules();
         }
 
-        // Process modules
-        for (auto module : a_Design->selected_modules()) {
+        // Load delays
+        if (!delaysFile.empty()) {
+            rewrite_filename(delaysFile);
+            parse_delays(delaysFile);
+        }
+
+        // Process modules. With multiple threads the connections of a batch
+        // of modules are indexed and looked up at once, otherwise module by
+        // module. The batch is kept small so that only a few indices are held
+        // in memory at a time.
+        auto modules = a_Design->selected_modules();
+        size_t batchSize = (m_NumThreads > 1) ? m_NumThreads * MODULES_PER_THREAD : 1;
+        m_DspTypes.count(RTLIL::IdString());
+        for (size_t first = 0; first < modules.size(); first += batchSize) {
+            size_t count = std::min(batchSize, modules.size() - first);
+            if (m_NumThreads > 1) {
+                // The previous batch may have added wires to modules
+                ConnIndex::prepareScan(a_Design);
+            }
+
+            // Index connections, find DSP cells
+            std::vector<ModuleContext> contexts(count);
+            for (size_t i = 0; i < count; ++i) {
+                contexts[i].module = modules[first + i];
+            }
+            forEachContext(contexts, [&](ModuleContext &a_Context) { setupContext(a_Context); });
+            for (auto &context : contexts) {
+                context.connIndex.finish();
+            }
 
-            // Setup the SigMap
-            m_SigMap.clear();
-            m_SigMap.set(module);
+            // Look up DSP port connections
+            forEachContext(contexts, [&](ModuleContext &a_Context) { collectPortConns(a_Context); });
 
-            // Build the connection map
-            m_ConnMap.clear();
-            m_ConnMap.build(module, m_SigMap);
+            // Integrate flip-flops. This stays serial: the checks of a register
+            // depend on the changes made for the previous ones and create
+            // IdStrings and log, which Yosys does not allow from threads.
+            for (auto &context : contexts) {
+                processModule(context);
+            }
+        }
 
-            // Look for DSP cells
-            for (auto cell : module->cells()) {
+        // Write the timing report
+        if (!reportFile.empty()) {
+            rewrite_filename(reportFile);
+            writeTimingReport(reportFile);
+        }
+        m_TimingRecords.clear();
+    }
 
-                // Not a DSP
-                if (!m_DspTypes.count(cell->type)) {
-                    continue;
-                }
+    // ..........................................
 
-                // Process all registers
-                auto &dspType = m_DspTypes.at(cell->type);
-                for (auto &rule : dspType.registers) {
-                    processRegister(cell, rule.first, rule.second);
+    /// Scans connections of a module and finds its DSP cells. May run in a
+    /// worker thread, the same rules as for collectPortConns() apply. The
+    /// connection index needs to be finished before it is queried.
+    void setupContext(ModuleContext &a_Context)
+    {
+        auto module = a_Context.module;
+        for (auto cell : module->cells()) {
+            if (m_DspTypes.count(cell->type)) {
+                a_Context.dspCells.push_back(DspCell{cell, {}});
+            }
+        }
+        // Modules without DSP cells are left alone
+        if (a_Context.dspCells.empty()) {
+            return;
+        }
+
+        a_Context.connIndex.scan(module);
+    }
+
+    BitConns getBitConns(ModuleContext &a_Context, const RTLIL::SigBit &a_SigBit)
+    {
+        BitConns conns;
+        conns.sigbit = a_SigBit;
+        if (a_SigBit.wire) {
+            conns.driver = a_Context.connIndex.driver(a_SigBit);
+            conns.sinks = a_Context.connIndex.sinks(a_SigBit);
+        }
+        return conns;
+    }
+
+    /// Looks up connections of all bits of DSP register ports of a module.
+    /// May run in a worker thread so it must not create, copy or destroy any
+    /// IdString (their reference counting is not thread safe). Apart from the
+    /// module SigMap it does not modify anything. The rule tables are only
+    /// read, their hash tables have settled before the workers started.
+    void collectPortConns(ModuleContext &a_Context)
+    {
+        for (auto &dspCell : a_Context.dspCells) {
+            const auto &connections = dspCell.cell->connections_;
+            const auto &dspType = m_DspTypes.at(dspCell.cell->type);
+            for (const auto &rule : dspType.registers) {
+                for (const auto &port : rule.second) {
+                    dspCell.ports.emplace_back();
+                    auto it = connections.find(port.name);
+                    if (it == connections.end()) {
+                        continue;
+                    }
+                    auto &bits = dspCell.ports.back();
+                    for (int i = 0; i < it->second.size(); ++i) {
+                        bits.push_back(getBitConns(a_Context, a_Context.connIndex.sigmap(it->second[i])));
+                    }
                 }
             }
+        }
+    }
 
-            // Remove cells
-            for (const auto &cell : m_CellsToRemove) {
-                module->remove(cell);
+    /// Calls the function for each context using up to m_NumThreads threads
+    template <typename T> void forEachContext(std::vector<ModuleContext> &a_Contexts, const T &a_Func)
+    {
+        size_t numThreads = std::min((size_t)m_NumThreads, a_Contexts.size());
+        if (numThreads <= 1) {
+            for (auto &context : a_Contexts) {
+                a_Func(context);
             }
-            m_CellsToRemove.clear();
+            return;
         }
 
-        // Clear maps
-        m_SigMap.clear();
-        m_ConnMap.clear();
+        std::atomic<size_t> next(0);
+        std::vector<std::thread> threads;
+        for (size_t i = 0; i < numThreads; ++i) {
+            threads.emplace_back([&]() {
+                for (size_t j = next++; j < a_Contexts.size(); j = next++) {
+                    a_Func(a_Contexts[j]);
+                }
+            });
+        }
+        for (auto &thread : threads) {
+            thread.join();
+        }
+    }
+
+    void processModule(ModuleContext &a_Context)
+    {
+        // Nothing to integrate
+        if (a_Context.dspCells.empty()) {
+            return;
+        }
+
+        // Estimate timing before anything gets changed
+        if (m_Timing) {
+            computeTiming(a_Context);
+        }
+
+        // Process all registers of DSP cells
+        for (const auto &dspCell : a_Context.dspCells) {
+            const auto &dspType = m_DspTypes.at(dspCell.cell->type);
+            auto portConns = dspCell.ports.data();
+            for (auto &rule : dspType.registers) {
+                processRegister(a_Context, dspCell.cell, rule.first, rule.second, portConns);
+                portConns += rule.second.size();
+            }
+        }
+
+        // Remove cells
+        for (const auto &cell : a_Context.cellsToRemove) {
+            a_Context.module->remove(cell);
+        }
+
+        a_Context.dspCells.clear();
+        a_Context.connIndex.clear();
+        a_Context.arrival.clear();
+        a_Context.departure.clear();
+        a_Context.clockPeriods.clear();
     }
 
     // ..........................................
@@ -903,11 +1258,11 @@ struct DspFF : public Pass {
         return isOk;
     }
 
-    bool checkFlopDataAgainstDspRegister(const FlopData &a_FlopData, RTLIL::Cell *a_Cell, const RegisterType &a_Register,
+    bool checkFlopDataAgainstDspRegister(ModuleContext &a_Context, const FlopData &a_FlopData, RTLIL::Cell *a_Cell, const RegisterType &a_Register,
                                          const std::vector<PortType> &a_Ports)
     {
         const auto &flopType = m_FlopTypes.at(a_FlopData.type);
-        const auto &changes = m_DspChanges[a_Cell];
+        const auto &changes = a_Context.dspChanges[a_Cell];
         bool isOk = true;
 
         log_debug("  checking connected flip-flop settings against the DSP register... ");
@@ -924,7 +1279,7 @@ struct DspFF : public Pass {
                     auto sigbits = sigspec.bits();
                     log_assert(sigbits.size() <= 1);
                     if (!sigbits.empty()) {
-                        conn = m_SigMap(sigbits[0]);
+                        conn = a_Context.connIndex.sigmap(sigbits[0]);
                     }
                 }
 
@@ -1016,7 +1371,8 @@ struct DspFF : public Pass {
 
     // ..........................................
 
-    void processRegister(RTLIL::Cell *a_Cell, const RegisterType &a_Register, const std::vector<PortType> &a_Ports)
+    void processRegister(ModuleContext &a_Context, RTLIL::Cell *a_Cell, const RegisterType &a_Register, const std::vector<PortType> &a_Ports,
+                         const std::vector<BitConns> *a_PortConns)
     {
 
         // The cell register control parameter(s) must not be set
@@ -1028,12 +1384,15 @@ struct DspFF : public Pass {
             }
         }
 
-        pool<FlopData> groups;
+        // Distinct flip-flop configurations found, keyed by their signature
+        dict<FlopSignature, FlopData> groups;
         dict<RTLIL::IdString, std::vector<RTLIL::Cell *>> flops;
 
         // Process ports
         bool flopsOk = true;
-        for (const auto &port : a_Ports) {
+        for (size_t portIdx = 0; portIdx < a_Ports.size(); ++portIdx) {
+            const auto &port = a_Ports[portIdx];
+            const auto &portConns = a_PortConns[portIdx];
             log_debug(" attempting flip-flop integration for %s.%s of %s\n", a_Cell->type.c_str(), port.name.c_str(), a_Cell->name.c_str());
 
             if (!a_Cell->hasPort(port.name)) {
@@ -1048,7 +1407,7 @@ struct DspFF : public Pass {
 
             flops[port.name] = std::vector<RTLIL::Cell *>(sigbits.size(), nullptr);
             for (size_t i = 0; i < sigbits.size(); ++i) {
-                auto sigbit = m_SigMap(sigbits[i]);
+                auto sigbit = a_Context.connIndex.sigmap(sigbits[i]);
 
                 log_debug("  %2zu. ", i);
 
@@ -1064,36 +1423,34 @@ struct DspFF : public Pass {
                     continue;
                 }
 
+                // Use the connections looked up beforehand unless the port got
+                // reconnected in the meantime.
+                const auto conns = (i < portConns.size() && portConns[i].sigbit == sigbit) ? portConns[i] : getBitConns(a_Context, sigbit);
+
                 pool<CellPin> others;
 
                 // Get sinks(s), discard the port completely if more than one sink
                 // is found.
                 if (a_Cell->output(port.name)) {
-                    if (m_ConnMap.sinks.count(sigbit)) {
-                        for (const auto &sink : m_ConnMap.sinks.at(sigbit)) {
-                            if (sink.cell != nullptr && m_CellsToRemove.count(sink.cell)) {
-                                continue;
-                            }
-                            others.insert(sink);
+                    for (const auto &sink : conns.sinks) {
+                        if (sink.cell != nullptr && a_Context.cellsToRemove.count(sink.cell)) {
+                            continue;
                         }
+                        others.insert(sink);
                     }
 
                 }
                 // Get driver. Discard if the driver drives something else too
                 else if (a_Cell->input(port.name)) {
-                    if (m_ConnMap.drivers.count(sigbit)) {
-                        auto driver = m_ConnMap.drivers.at(sigbit);
-
-                        if (m_ConnMap.sinks.count(sigbit)) {
-                            auto sinks = m_ConnMap.sinks.at(sigbit);
-                            if (sinks.size() > 1) {
-                                log_debug("multiple sinks (%zu)\n", others.size());
-                                flopsOk = false;
-                                continue;
-                            }
+                    if (auto driver = conns.driver) {
+
+                        if (conns.sinks.size() > 1) {
+                            log_debug("multiple sinks (%zu)\n", others.size());
+                            flopsOk = false;
+                            continue;
                         }
 
-                        others.insert(driver);
+                        others.insert(*driver);
                     }
                 }
 
@@ -1149,18 +1506,13 @@ struct DspFF : public Pass {
                     continue;
                 }
 
-                // Get parameters to be mapped to the DSP according to the port
-                // rule.
-                dict<RTLIL::IdString, RTLIL::Const> mappedParams;
-                for (const auto &it : a_Register.params.map) {
-                    if (flop->hasParam(it.second)) {
-                        const auto &value = flop->getParam(it.second);
-                        mappedParams.insert(std::make_pair(it.first, value));
-                    }
+                // Store the flop and its data. Flip-flops of a port are usually
+                // configured the same way so the data is collected only for the
+                // first flip-flop of each signature.
+                auto signature = getFlopSignature(a_Context, flop, a_Register);
+                if (!groups.count(signature)) {
+                    groups.insert(std::make_pair(std::move(signature), getFlopData(a_Context, flop, getMappedParams(flop, a_Register))));
                 }
-
-                // Store the flop and its data
-                groups.insert(getFlopData(flop, mappedParams));
                 flops[port.name][i] = flop;
             }
         }
@@ -1184,12 +1536,18 @@ struct DspFF : public Pass {
         }
 
         // Validate the flip flop data agains the DSP cell
-        const auto &flopData = *groups.begin();
-        if (!checkFlopDataAgainstDspRegister(flopData, a_Cell, a_Register, a_Ports)) {
+        const auto &flopData = groups.begin()->second;
+        if (!checkFlopDataAgainstDspRegister(a_Context, flopData, a_Cell, a_Register, a_Ports)) {
             log_debug(" flip-flops vs. DSP check failed\n");
             return;
         }
 
+        // Check if the integration pays off
+        if (m_Timing && !checkTiming(a_Context, a_Cell, a_Ports, flops, flopData)) {
+            log_debug(" integration does not improve timing\n");
+            return;
+        }
+
         // Log connections
         for (const auto &port : a_Ports) {
 
@@ -1248,7 +1606,7 @@ struct DspFF : public Pass {
                     sigbits[i] = sigspec.bits()[0];
                 }
 
-                m_CellsToRemove.insert(flop);
+                a_Context.cellsToRemove.insert(flop);
             }
 
             a_Cell->setPort(port.name, RTLIL::SigSpec(sigbits));
@@ -1268,7 +1626,7 @@ struct DspFF : public Pass {
 
                 log_debug(" connecting %s.%s to %s\n", a_Cell->type.c_str(), port.c_str(), sigBitName(conn).c_str());
                 a_Cell->setPort(port, conn);
-                m_DspChanges[a_Cell].conns.insert(port);
+                a_Context.dspChanges[a_Cell].conns.insert(port);
             }
         }
 
@@ -1276,7 +1634,7 @@ struct DspFF : public Pass {
         for (const auto &it : a_Register.connect) {
             log_debug(" connecting %s.%s to %s\n", a_Cell->type.c_str(), it.first.c_str(), it.second.as_string().c_str());
             a_Cell->setPort(it.first, it.second);
-            m_DspChanges[a_Cell].conns.insert(it.first);
+            a_Context.dspChanges[a_Cell].conns.insert(it.first);
         }
 
         // Map parameters (register rule)
@@ -1285,7 +1643,7 @@ struct DspFF : public Pass {
                 const auto &param = flopData.params.dsp.at(it.second);
                 log_debug(" setting param '%s' to '%s'\n", it.first.c_str(), param.decode_string().c_str());
                 a_Cell->setParam(it.first, param);
-                m_DspChanges[a_Cell].params.insert(it.first);
+                a_Context.dspChanges[a_Cell].params.insert(it.first);
             }
         }
 
@@ -1295,7 +1653,7 @@ struct DspFF : public Pass {
                 const auto &param = flopData.params.dsp.at(it.second);
                 log_debug(" setting param '%s' to '%s'\n", it.first.c_str(), param.decode_string().c_str());
                 a_Cell->setParam(it.first, param);
-                m_DspChanges[a_Cell].params.insert(it.first);
+                a_Context.dspChanges[a_Cell].params.insert(it.first);
             }
         }
 
@@ -1303,22 +1661,87 @@ struct DspFF : public Pass {
         for (const auto &it : a_Register.params.set) {
             log_debug(" setting param '%s' to '%s'\n", it.first.c_str(), it.second.decode_string().c_str());
             a_Cell->setParam(it.first, it.second);
-            m_DspChanges[a_Cell].params.insert(it.first);
+            a_Context.dspChanges[a_Cell].params.insert(it.first);
         }
 
         // Set parameters (flip-flop rule)
         for (const auto &it : flopType.params.set) {
             log_debug(" setting param '%s' to '%s'\n", it.first.c_str(), it.second.decode_string().c_str());
             a_Cell->setParam(it.first, it.second);
-            m_DspChanges[a_Cell].params.insert(it.first);
+            a_Context.dspChanges[a_Cell].params.insert(it.first);
         }
     }
 
     // ..........................................
 
+    /// Returns flip-flop parameters to be mapped to the DSP according to the
+    /// port rule.
+    dict<RTLIL::IdString, RTLIL::Const> getMappedParams(RTLIL::Cell *a_Cell, const RegisterType &a_Register)
+    {
+        dict<RTLIL::IdString, RTLIL::Const> mappedParams;
+        for (const auto &it : a_Register.params.map) {
+            if (a_Cell->hasParam(it.second)) {
+                const auto &value = a_Cell->getParam(it.second);
+                mappedParams.insert(std::make_pair(it.first, value));
+            }
+        }
+        return mappedParams;
+    }
+
+    /// Returns the signature of the FlopData that getFlopData() would give
+    /// for the flip-flop and the register rule. Parameters set by the
+    /// flip-flop rule are the same for a given type and are left out.
+    FlopSignature getFlopSignature(ModuleContext &a_Context, RTLIL::Cell *a_Cell, const RegisterType &a_Register)
+    {
+        FlopSignature signature;
+        signature.type = a_Cell->type;
+
+        const auto &flopType = m_FlopTypes.at(a_Cell->type);
+
+        // Connections to control ports
+        for (const auto &it : flopType.ports) {
+            if (it.first == RTLIL::escape_id("d") || it.first == RTLIL::escape_id("q")) {
+                continue;
+            }
+            std::pair<bool, RTLIL::SigBit> conn(false, RTLIL::SigBit());
+            if (!it.second.empty() && a_Cell->hasPort(it.second)) {
+                const auto &sigspec = a_Cell->getPort(it.second);
+                log_assert(sigspec.size() <= 1);
+                if (sigspec.size() != 0) {
+                    conn = std::make_pair(true, a_Context.connIndex.sigmap(sigspec[0]));
+                }
+            }
+            signature.conns.push_back(conn);
+        }
+
+        // Flip-flop parameters that need to match or are mapped to the DSP
+        for (const auto &it : flopType.params.matching) {
+            log_assert(a_Cell->hasParam(it));
+            signature.params.emplace_back(true, a_Cell->getParam(it));
+        }
+        for (const auto &it : flopType.params.map) {
+            log_assert(a_Cell->hasParam(it.second));
+            signature.params.emplace_back(true, a_Cell->getParam(it.second));
+        }
+
+        // DSP parameters mapped by the port rule
+        for (const auto &it : a_Register.params.map) {
+            if (flopType.params.set.count(it.first)) {
+                continue;
+            }
+            if (a_Cell->hasParam(it.second)) {
+                signature.params.emplace_back(true, a_Cell->getParam(it.second));
+            } else {
+                signature.params.emplace_back(false, RTLIL::Const());
+            }
+        }
+
+        return signature;
+    }
+
     /// Collects flip-flop connectivity data and parameters which defines the
     /// group it belongs to.
-    FlopData getFlopData(RTLIL::Cell *a_Cell, const dict<RTLIL::IdString, RTLIL::Const> &a_ExtraParams)
+    FlopData getFlopData(ModuleContext &a_Context, RTLIL::Cell *a_Cell, const dict<RTLIL::IdString, RTLIL::Const> &a_ExtraParams)
     {
         FlopData data(a_Cell->type);
 
@@ -1338,7 +1761,7 @@ struct DspFF : public Pass {
                 auto sigbits = sigspec.bits();
                 log_assert(sigbits.size() <= 1);
                 if (!sigbits.empty()) {
-                    data.conns[it.first] = m_SigMap(sigbits[0]);
+                    data.conns[it.first] = a_Context.connIndex.sigmap(sigbits[0]);
                 }
             }
         }
@@ -1368,6 +1791,326 @@ struct DspFF : public Pass {
         return data;
     }
 
+    // ..........................................
+
+    FlopDelays getFlopDelays(const RTLIL::IdString &a_Type) const
+    {
+        auto it = m_Delays.flops.find(a_Type);
+        return (it != m_Delays.flops.end()) ? it->second : m_Delays.flop;
+    }
+
+    DspDelays getDspDelays(const RTLIL::IdString &a_Type) const
+    {
+        auto it = m_Delays.dsps.find(a_Type);
+        return (it != m_Delays.dsps.end()) ? it->second : m_Delays.dsp;
+    }
+
+    /// Returns true for cells that start and end timing paths
+    bool isSequential(RTLIL::Cell *a_Cell) const
+    {
+        return m_FlopTypes.count(a_Cell->type) || m_Delays.flops.count(a_Cell->type) || RTLIL::builtin_ff_cell_types().count(a_Cell->type);
+    }
+
+    /// Returns the delay from any input to any output of a combinational
+    /// cell. For DSP cells this includes their connections to the fabric.
+    float cellDelay(RTLIL::Cell *a_Cell) const
+    {
+        if (m_DspTypes.count(a_Cell->type)) {
+            return getDspDelays(a_Cell->type).delay + 2.0f * m_Delays.net;
+        }
+        auto it = m_Delays.cells.find(a_Cell->type);
+        return (it != m_Delays.cells.end()) ? it->second : m_Delays.cell;
+    }
+
+    /// Calls the function for each cell driving an input of the given one
+    /// (a_Fanin) or driven by one of its outputs
+    template <typename T> void forEachAdjacentCell(ModuleContext &a_Context, RTLIL::Cell *a_Cell, bool a_Fanin, const T &a_Func)
+    {
+        for (const auto &it : a_Cell->connections()) {
+            if (a_Fanin ? !a_Cell->input(it.first) : !a_Cell->output(it.first)) {
+                continue;
+            }
+            for (const auto &sigbit : it.second) {
+                auto mapped = a_Context.connIndex.sigmap(sigbit);
+                if (!mapped.wire) {
+                    continue;
+                }
+                if (a_Fanin) {
+                    auto driver = a_Context.connIndex.driver(mapped);
+                    if (driver != nullptr && driver->cell != nullptr) {
+                        a_Func(driver->cell);
+                    }
+                } else {
+                    for (const auto &sink : a_Context.connIndex.sinks(mapped)) {
+                        if (sink.cell != nullptr) {
+                            a_Func(sink.cell);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    /// Computes the arrival time at outputs of a cell (a_Arrival) or the time
+    /// from its inputs to the ends of paths going through it. Sequential cells
+    /// start and end paths, a combinational loop is cut where it is found.
+    /// The fan-in (fan-out) cone is walked depth first with an explicit stack
+    /// so that the times get computed in topological order.
+    float cellTime(ModuleContext &a_Context, RTLIL::Cell *a_Cell, bool a_Arrival)
+    {
+        auto &times = a_Arrival ? a_Context.arrival : a_Context.departure;
+        auto it = times.find(a_Cell);
+        if (it != times.end()) {
+            return it->second;
+        }
+
+        // Cells along with a flag telling if their adjacent cells were pushed
+        std::vector<std::pair<RTLIL::Cell *, bool>> stack;
+        stack.push_back(std::make_pair(a_Cell, false));
+        while (!stack.empty()) {
+            auto cell = stack.back().first;
+
+            // All adjacent cells are done, except the ones closing a loop
+            if (stack.back().second) {
+                stack.pop_back();
+                float time = 0.0f;
+                forEachAdjacentCell(a_Context, cell, a_Arrival, [&](RTLIL::Cell *adjacent) {
+                    auto found = times.find(adjacent);
+                    if (found != times.end()) {
+                        time = std::max(time, found->second);
+                    }
+                });
+                a_Context.visiting.erase(cell);
+                times[cell] = time + cellDelay(cell);
+                continue;
+            }
+
+            // Already done or on the current path
+            if (times.count(cell) || a_Context.visiting.count(cell)) {
+                stack.pop_back();
+                continue;
+            }
+            if (isSequential(cell)) {
+                stack.pop_back();
+                const auto delays = getFlopDelays(cell->type);
+                times[cell] = a_Arrival ? delays.clk2q : delays.setup;
+                continue;
+            }
+
+            stack.back().second = true;
+            a_Context.visiting.insert(cell);
+            forEachAdjacentCell(a_Context, cell, a_Arrival, [&](RTLIL::Cell *adjacent) {
+                if (!times.count(adjacent) && !a_Context.visiting.count(adjacent)) {
+                    stack.push_back(std::make_pair(adjacent, false));
+                }
+            });
+        }
+
+        return times.at(a_Cell);
+    }
+
+    /// Returns the arrival time at outputs of a cell
+    float cellArrival(ModuleContext &a_Context, RTLIL::Cell *a_Cell) { return cellTime(a_Context, a_Cell, true); }
+
+    /// Returns the time from inputs of a cell to the ends of paths going
+    /// through it
+    float cellDeparture(ModuleContext &a_Context, RTLIL::Cell *a_Cell) { return cellTime(a_Context, a_Cell, false); }
+
+    /// Arrival time at a (mapped) net, 0 for module inputs and constants
+    float bitArrival(ModuleContext &a_Context, const RTLIL::SigBit &a_SigBit)
+    {
+        if (!a_SigBit.wire) {
+            return 0.0f;
+        }
+        auto driver = a_Context.connIndex.driver(a_SigBit);
+        return (driver != nullptr && driver->cell != nullptr) ? cellArrival(a_Context, driver->cell) : 0.0f;
+    }
+
+    /// Departure time from a (mapped) net, 0 for module outputs
+    float bitDeparture(ModuleContext &a_Context, const RTLIL::SigBit &a_SigBit)
+    {
+        float departure = 0.0f;
+        if (a_SigBit.wire) {
+            for (const auto &sink : a_Context.connIndex.sinks(a_SigBit)) {
+                if (sink.cell != nullptr) {
+                    departure = std::max(departure, cellDeparture(a_Context, sink.cell));
+                }
+            }
+        }
+        return departure;
+    }
+
+    /// Estimates arrival and departure times of all cells of a module and
+    /// collects clock periods
+    void computeTiming(ModuleContext &a_Context)
+    {
+        for (auto cell : a_Context.module->cells()) {
+            cellArrival(a_Context, cell);
+            cellDeparture(a_Context, cell);
+        }
+
+        for (auto wire : a_Context.module->wires()) {
+            if (!wire->has_attribute(RTLIL::escape_id("PERIOD"))) {
+                continue;
+            }
+
+            const auto str = wire->get_string_attribute(RTLIL::escape_id("PERIOD"));
+            float period = 0.0f;
+            size_t pos = 0;
+            try {
+                period = std::stof(str, &pos);
+            } catch (const std::exception &) {
+                pos = 0;
+            }
+            if (pos == 0 || period <= 0.0f) {
+                log_warning("Ignoring invalid PERIOD '%s' of wire '%s'.\n", str.c_str(), log_id(wire));
+                continue;
+            }
+
+            for (int i = 0; i < wire->width; ++i) {
+                a_Context.clockPeriods[a_Context.connIndex.sigmap(RTLIL::SigBit(wire, i))] = period;
+            }
+        }
+    }
+
+    /// Compares the longest paths through the flip-flops of a DSP register
+    /// with and without their integration. Returns true if the integration
+    /// pays off and records the outcome for the report.
+    bool checkTiming(ModuleContext &a_Context, RTLIL::Cell *a_Cell, const std::vector<PortType> &a_Ports,
+                     const dict<RTLIL::IdString, std::vector<RTLIL::Cell *>> &a_Flops, const FlopData &a_FlopData)
+    {
+        const auto &flopType = m_FlopTypes.at(a_FlopData.type);
+        const auto flopDelays = getFlopDelays(a_FlopData.type);
+        const auto dspDelays = getDspDelays(a_Cell->type);
+        const float net = m_Delays.net;
+
+        // Latest arrival at the DSP inputs, longest departure from its outputs
+        const float arrivalIn = a_Context.arrival.at(a_Cell) - cellDelay(a_Cell);
+        const float departureOut = a_Context.departure.at(a_Cell) - cellDelay(a_Cell);
+
+        auto getPin = [&](RTLIL::Cell *flop, const char *name) {
+            const auto &port = flopType.ports.at(RTLIL::escape_id(name));
+            if (port.empty() || !flop->hasPort(port) || flop->getPort(port).empty()) {
+                return RTLIL::SigBit(RTLIL::Sx);
+            }
+            return a_Context.connIndex.sigmap(flop->getPort(port)[0]);
+        };
+
+        TimingRecord record;
+        record.dsp = stringf("%s.%s (%s)", RTLIL::unescape_id(a_Context.module->name).c_str(), RTLIL::unescape_id(a_Cell->name).c_str(),
+                             RTLIL::unescape_id(a_Cell->type).c_str());
+        record.period = 0.0f;
+        record.before = 0.0f;
+        record.after = 0.0f;
+
+        for (const auto &port : a_Ports) {
+            auto it = a_Flops.find(port.name);
+            if (it == a_Flops.end()) {
+                continue;
+            }
+
+            bool isOutput = a_Cell->output(port.name);
+            bool haveFlops = false;
+
+            for (auto *flop : it->second) {
+                if (flop == nullptr) {
+                    continue;
+                }
+                record.flops.push_back(RTLIL::unescape_id(flop->name));
+                haveFlops = true;
+
+                // Paths ending at and starting from the flip-flop, then the
+                // same ones with the flip-flop moved into the DSP
+                float before, after;
+                if (isOutput) {
+                    float departureQ = bitDeparture(a_Context, getPin(flop, "q"));
+                    before = std::max(arrivalIn + 2.0f * net + dspDelays.delay + flopDelays.setup, flopDelays.clk2q + departureQ);
+                    after = std::max(arrivalIn + net + dspDelays.delay + dspDelays.setup, dspDelays.clk2q + net + departureQ);
+                } else {
+                    float arrivalD = bitArrival(a_Context, getPin(flop, "d"));
+                    before = std::max(arrivalD + flopDelays.setup, flopDelays.clk2q + 2.0f * net + dspDelays.delay + departureOut);
+                    after = std::max(arrivalD + net + dspDelays.setup, dspDelays.clk2q + net + dspDelays.delay + departureOut);
+                }
+
+                record.before = std::max(record.before, before);
+                record.after = std::max(record.after, after);
+            }
+
+            if (haveFlops) {
+                record.ports += (record.ports.empty() ? "" : " ") + RTLIL::unescape_id(port.name);
+            }
+        }
+
+        auto clk = a_FlopData.conns.find(RTLIL::escape_id("clk"));
+        if (clk != a_FlopData.conns.end()) {
+            auto it = a_Context.clockPeriods.find(clk->second);
+            if (it != a_Context.clockPeriods.end()) {
+                record.period = it->second;
+            }
+        }
+
+        // Differences below a picosecond are noise
+        const bool isShorter = (record.before - record.after) > 1e-3f;
+        const bool isMet = m_FitPeriod && record.period > 0.0f && record.after <= record.period;
+        record.absorbed = isShorter || isMet;
+
+        log(" %s %s.%s: %.3f ns -> %.3f ns", a_Cell->type.c_str(), a_Cell->name.c_str(), record.ports.c_str(), record.before, record.after);
+        if (record.period > 0.0f) {
+            log(" (period %.3f ns)", record.period);
+        }
+        log(", %s\n", record.absorbed ? "integrating" : "keeping flip-flops in the fabric");
+
+        m_TimingRecords.push_back(record);
+        return record.absorbed;
+    }
+
+    /// Writes the outcome of timing checks grouped by DSP cells
+    void writeTimingReport(const std::string &a_FileName)
+    {
+        std::ofstream file(a_FileName);
+        if (!file) {
+            log_error("Can't open report file '%s' for writing!\n", a_FileName.c_str());
+        }
+        log("Writing timing report to '%s'.\n", a_FileName.c_str());
+
+        file << "DSP register integration report (delays in ns)\n";
+
+        std::string dsp;
+        size_t numAbsorbed = 0;
+        size_t numFlops = 0;
+        float delta = 0.0f;
+        for (const auto &record : m_TimingRecords) {
+            if (record.dsp != dsp) {
+                dsp = record.dsp;
+                file << "\n" << dsp << "\n";
+            }
+
+            float delay = record.absorbed ? record.after : record.before;
+            // The delta is negative when the integration shortens the path
+            file << stringf("  %s: %s %zu flip-flop(s), delay %.3f -> %.3f, delta %+.3f", record.ports.c_str(), record.absorbed ? "absorbed" : "kept",
+                            record.flops.size(), record.before, record.after, record.after - record.before);
+            if (record.period > 0.0f) {
+                file << stringf(", period %.3f, slack %.3f", record.period, record.period - delay);
+            }
+            file << "\n";
+
+            file << "   ";
+            for (const auto &flop : record.flops) {
+                file << " " << flop;
+            }
+            file << "\n";
+
+            if (record.absorbed) {
+                numAbsorbed++;
+                numFlops += record.flops.size();
+                delta += record.after - record.before;
+            }
+        }
+
+        file << stringf("\nAbsorbed %zu of %zu register(s), %zu flip-flop(s), delta %+.3f in total\n", numAbsorbed, m_TimingRecords.size(), numFlops,
+                        delta);
+    }
+
 } DspFF;
 
 PRIVATE_NAMESPACE_END
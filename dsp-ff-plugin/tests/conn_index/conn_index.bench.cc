@@ -0,0 +1,95 @@
+/*
+ * Copyright 2020-2022 F4PGA Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ */
+#include "../common/conn_index.h"
+
+#include "kernel/yosys.h"
+
+#include <benchmark/benchmark.h>
+
+#include <memory>
+
+// Builds a module with a chain of 8 bit wide cells, every fourth one a
+// flip-flop, all of them also reading the module input
+static RTLIL::Design *makeDesign(int a_Cells)
+{
+    RTLIL::Design *design = new RTLIL::Design;
+    RTLIL::Module *module = design->addModule(ID(top));
+
+    RTLIL::Wire *clk = module->addWire(ID(clk));
+    clk->port_input = true;
+    RTLIL::Wire *in = module->addWire(ID(in), 8);
+    in->port_input = true;
+
+    RTLIL::SigSpec sig = in;
+    for (int i = 0; i < a_Cells; ++i) {
+        RTLIL::SigSpec next = module->addWire(stringf("\\n%d", i), 8);
+        if (i % 4 == 3) {
+            module->addDff(stringf("\\c%d", i), clk, sig, next);
+        } else {
+            module->addAnd(stringf("\\c%d", i), sig, in, next);
+        }
+        sig = next;
+    }
+
+    RTLIL::Wire *out = module->addWire(ID(out), 8);
+    out->port_output = true;
+    module->connect(out, sig);
+    module->fixup_ports();
+    return design;
+}
+
+static void BM_ConnIndexBuild(benchmark::State &state)
+{
+    std::unique_ptr<RTLIL::Design> design(makeDesign(state.range(0)));
+    RTLIL::Module *module = design->module(ID(top));
+    for (auto _ : state) {
+        ConnIndex index;
+        index.build(module);
+        benchmark::DoNotOptimize(index);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_ConnIndexBuild)->RangeMultiplier(8)->Range(1 << 9, 1 << 15);
+
+// Driver and sink queries on every cell output, as done by dsp_ff
+static void BM_ConnIndexQuery(benchmark::State &state)
+{
+    std::unique_ptr<RTLIL::Design> design(makeDesign(state.range(0)));
+    RTLIL::Module *module = design->module(ID(top));
+    ConnIndex index;
+    index.build(module);
+
+    std::vector<RTLIL::SigBit> bits;
+    for (auto cell : module->cells()) {
+        const RTLIL::SigSpec &output = cell->hasPort(ID::Q) ? cell->getPort(ID::Q) : cell->getPort(ID::Y);
+        for (auto bit : index.sigmap(output)) {
+            bits.push_back(bit);
+        }
+    }
+    for (auto _ : state) {
+        size_t sinks = 0;
+        for (const auto &bit : bits) {
+            benchmark::DoNotOptimize(index.driver(bit));
+            sinks += index.sinks(bit).size();
+        }
+        benchmark::DoNotOptimize(sinks);
+    }
+    state.SetItemsProcessed(state.iterations() * bits.size());
+}
+BENCHMARK(BM_ConnIndexQuery)->RangeMultiplier(8)->Range(1 << 9, 1 << 15);
@@ -0,0 +1,16 @@
+yosys -import
+if { [info procs dsp_ff] == {} } { plugin -i dsp-ff }
+yosys -import  ;# ingest plugin commands
+
+set DSP_RULES [file dirname $::env(DESIGN_TOP)]/../../nexus-dsp_rules.txt
+
+read_verilog $::env(DESIGN_TOP).v
+hierarchy -top top
+synth_nexus -top top
+techmap -map +/nexus/cells_sim.v t:VLO t:VHI %u ;# Unmap VHI and VLO
+debug dsp_ff -rules ${DSP_RULES} -threads 2
+stat
+select -assert-count 1 mult_ireg/t:MULT9X9
+select -assert-count 0 mult_ireg/t:FD1P3IX
+select -assert-count 1 mult_oreg/t:MULT9X9
+select -assert-count 0 mult_oreg/t:FD1P3IX
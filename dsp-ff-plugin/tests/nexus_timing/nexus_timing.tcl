@@ -0,0 +1,62 @@
+yosys -import
+if { [info procs dsp_ff] == {} } { plugin -i dsp-ff }
+yosys -import  ;# ingest plugin commands
+
+set DSP_RULES [file dirname $::env(DESIGN_TOP)]/../../nexus-dsp_rules.txt
+set DSP_DELAYS [file dirname $::env(DESIGN_TOP)]/nexus_timing.delays
+
+read_verilog $::env(DESIGN_TOP).v
+design -save read
+
+# Integrating the register would lengthen the path from the logic and break
+# the period.
+set TOP "mult_ireg_logic"
+design -load read
+hierarchy -top ${TOP}
+synth_nexus -flatten -noiopad
+techmap -map +/nexus/cells_sim.v t:VLO t:VHI %u ;# Unmap VHI and VLO
+setattr -set PERIOD {"5"} w:CLK
+equiv_opt -assert -async2sync -map +/nexus/cells_sim.v debug dsp_ff -rules ${DSP_RULES} -delays ${DSP_DELAYS} -fit_period -report nexus_timing_kept.rpt
+design -load postopt
+yosys cd ${TOP}
+stat
+select -assert-count 1 t:MULT9X9
+select -assert-count 9 t:FD1P3IX
+
+# Same but the path still fits the period, the register is only integrated
+# when asked for
+set TOP "mult_ireg_logic"
+design -load read
+hierarchy -top ${TOP}
+synth_nexus -flatten -noiopad
+techmap -map +/nexus/cells_sim.v t:VLO t:VHI %u ;# Unmap VHI and VLO
+setattr -set PERIOD {"20"} w:CLK
+design -save fits
+equiv_opt -assert -async2sync -map +/nexus/cells_sim.v debug dsp_ff -rules ${DSP_RULES} -delays ${DSP_DELAYS}
+design -load postopt
+yosys cd ${TOP}
+stat
+select -assert-count 1 t:MULT9X9
+select -assert-count 9 t:FD1P3IX
+
+design -load fits
+equiv_opt -assert -async2sync -map +/nexus/cells_sim.v debug dsp_ff -rules ${DSP_RULES} -delays ${DSP_DELAYS} -fit_period
+design -load postopt
+yosys cd ${TOP}
+stat
+select -assert-count 1 t:MULT9X9
+select -assert-count 0 t:FD1P3IX
+
+# Integrating the register shortens the path through the multiplier
+set TOP "mult_ireg_load"
+design -load read
+hierarchy -top ${TOP}
+synth_nexus -flatten -noiopad
+techmap -map +/nexus/cells_sim.v t:VLO t:VHI %u ;# Unmap VHI and VLO
+setattr -set PERIOD {"5"} w:CLK
+equiv_opt -assert -async2sync -map +/nexus/cells_sim.v debug dsp_ff -rules ${DSP_RULES} -delays ${DSP_DELAYS} -report nexus_timing.rpt
+design -load postopt
+yosys cd ${TOP}
+stat
+select -assert-count 1 t:MULT9X9
+select -assert-count 0 t:FD1P3IX
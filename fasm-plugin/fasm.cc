@@ -38,9 +38,15 @@ struct WriteFasm : public Backend {
     {
         //   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
         log("\n");
-        log("    write_fasm -part_json <part_json_filename> <filename>\n");
+        log("    write_fasm [-part_json <part_json_filename>] <filename>\n");
         log("\n");
-        log("Write out a file with vref FASM features.\n");
+        log("Write out a file with the FASM features of the top module cells.\n");
+        log("\n");
+        log("Cells with a FASM_FEATURES parameter or attribute contribute the features\n");
+        log("it lists, separated by whitespace. A FASM_PREFIX parameter or attribute is\n");
+        log("prepended to each of them followed by a dot. Cells with FASM_EXTRA set to\n");
+        log("INTERNAL_VREF emit the VREF feature of their IO bank, which requires the\n");
+        log("part's JSON file. Every feature is written once.\n");
         log("\n");
     }
 
@@ -56,31 +62,79 @@ struct WriteFasm : public Backend {
         extract_fasm_features(f, design, part_json);
     }
 
+    // Parameters take precedence over attributes of the same name
+    static std::string get_cell_string(const RTLIL::Cell *cell, const RTLIL::IdString &name)
+    {
+        auto param = cell->parameters.find(name);
+        if (param != cell->parameters.end()) {
+            return param->second.decode_string();
+        }
+        return cell->get_string_attribute(name);
+    }
+
     void extract_fasm_features(std::ostream *&f, RTLIL::Design *design, const std::string &part_json)
     {
         RTLIL::Module *top_module(design->top_module());
         if (top_module == nullptr) {
             log_cmd_error("%s: No top module detected.\n", pass_name.c_str());
         }
-        auto bank_tiles = get_bank_tiles(part_json);
-        // Generate a fasm feature associated with the INTERNAL_VREF value per bank
-        // e.g. VREF value of 0.675 for bank 34 is associated with tile HCLK_IOI3_X113Y26
-        // hence we need to emit the following fasm feature: HCLK_IOI3_X113Y26.VREF.V_675_MV
+        const BankTilesMap *bank_tiles = nullptr;
+
+        // Features are collected in cell order, each one once, and written in one go
+        std::vector<std::string> features;
+        pool<std::string> seen;
+        auto add_feature = [&](std::string &&feature) {
+            if (seen.insert(feature).second) {
+                features.push_back(std::move(feature));
+            }
+        };
+
         for (auto cell : top_module->cells()) {
+            std::string cell_features = get_cell_string(cell, ID(FASM_FEATURES));
+            if (!cell_features.empty()) {
+                std::string prefix = get_cell_string(cell, ID(FASM_PREFIX));
+                if (!prefix.empty()) {
+                    prefix += '.';
+                }
+                std::istringstream feature_stream(cell_features);
+                std::string feature;
+                while (feature_stream >> feature) {
+                    add_feature(prefix + feature);
+                }
+            }
+
             if (!cell->hasParam(ID(FASM_EXTRA)))
                 continue;
+            // Generate a fasm feature associated with the INTERNAL_VREF value per bank
+            // e.g. VREF value of 0.675 for bank 34 is associated with tile HCLK_IOI3_X113Y26
+            // hence we need to emit the following fasm feature: HCLK_IOI3_X113Y26.VREF.V_675_MV
             if (cell->getParam(ID(FASM_EXTRA)) == RTLIL::Const("INTERNAL_VREF")) {
-                if (bank_tiles.size() == 0) {
+                if (bank_tiles == nullptr) {
+                    if (part_json.empty()) {
+                        log_cmd_error("%s: Cell %s has FASM_EXTRA set to INTERNAL_VREF, the -part_json option is required.\n",
+                                      pass_name.c_str(), log_id(cell));
+                    }
+                    bank_tiles = &get_bank_tiles(part_json);
+                }
+                if (bank_tiles->size() == 0) {
                     log_cmd_error("%s: No bank tiles available on the target part.\n", pass_name.c_str());
                 }
                 int bank_number(cell->getParam(ID(NUMBER)).as_int());
-                if (bank_tiles.count(bank_number) == 0) {
+                if (bank_tiles->count(bank_number) == 0) {
                     log_cmd_error("%s: No IO bank number %d on the target part.\n", pass_name.c_str(), bank_number);
                 }
                 int bank_vref(cell->getParam(ID(INTERNAL_VREF)).as_int());
-                *f << "HCLK_IOI3_" << bank_tiles[bank_number] << ".VREF.V_" << bank_vref << "_MV\n";
+                add_feature("HCLK_IOI3_" + bank_tiles->at(bank_number) + ".VREF.V_" + std::to_string(bank_vref) + "_MV");
             }
         }
+
+        std::string buffer;
+        for (auto &feature : features) {
+            buffer += feature;
+            buffer += '\n';
+        }
+        f->write(buffer.data(), buffer.size());
+        log("Wrote %zu FASM features.\n", features.size());
     }
 } WriteFasm;
 
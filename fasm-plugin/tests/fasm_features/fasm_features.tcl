@@ -0,0 +1,14 @@
+yosys -import
+if { [info procs write_fasm] == {} } { plugin -i fasm }
+yosys -import  ;# ingest plugin commands
+
+read_verilog $::env(DESIGN_TOP).v
+hierarchy -check -top top
+
+write_fasm [test_output_path "fasm_features.fasm"]
+
+# INTERNAL_VREF features need the part's bank tiles
+setparam -set FASM_EXTRA "\"INTERNAL_VREF\"" top/t0
+if { ![catch {write_fasm [test_output_path "fasm_features_vref.fasm"]}] } {
+    error "write_fasm accepted an INTERNAL_VREF cell without -part_json"
+}
@@ -0,0 +1,63 @@
+// Copyright 2020-2022 F4PGA Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+(* blackbox *)
+module TILE (
+    input  I,
+    output O
+);
+  parameter FASM_PREFIX = "";
+  parameter FASM_FEATURES = "";
+endmodule
+
+module top (
+    input  a,
+    output b,
+    output c,
+    output d,
+    output e
+);
+  // Prefixed features from parameters
+  TILE #(
+      .FASM_PREFIX("CLBLL_L_X2Y1.SLICEL_X0"),
+      .FASM_FEATURES("ALUT.INIT[0] ALUT.INIT[1]")
+  ) t0 (
+      .I(a),
+      .O(b)
+  );
+
+  // Prefixed features from attributes
+  (* FASM_PREFIX = "CLBLL_L_X2Y2.SLICEL_X1", FASM_FEATURES = "BLUT.INIT[3]  BFFMUX.BX" *)
+  TILE t1 (
+      .I(a),
+      .O(c)
+  );
+
+  // Unprefixed features, the second cell repeats one of them
+  TILE #(
+      .FASM_FEATURES("GLOBAL.ENABLE")
+  ) t2 (
+      .I(a),
+      .O(d)
+  );
+
+  TILE #(
+      .FASM_FEATURES("GLOBAL.ENABLE GLOBAL.CONFIG")
+  ) t3 (
+      .I(a),
+      .O(e)
+  );
+endmodule
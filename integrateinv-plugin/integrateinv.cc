@@ -21,42 +21,53 @@
 #include "kernel/rtlil.h"
 #include "kernel/sigtools.h"
 
+#include <algorithm>
+
+#include "../common/conn_index.h"
+
 USING_YOSYS_NAMESPACE
 PRIVATE_NAMESPACE_BEGIN
 
 /// A structure representing a pin
-struct Pin {
-    RTLIL::Cell *cell;    /// Cell pointer
-    RTLIL::IdString port; /// Cell port name
-    int bit;              /// Port bit index
-
-    Pin(RTLIL::Cell *_cell, const RTLIL::IdString &_port, int _bit = 0) : cell(_cell), port(_port), bit(_bit) {}
+using Pin = ConnIndex::Pin;
 
-    Pin(const Pin &ref) = default;
+struct IntegrateInv : public Pass {
 
-    unsigned int hash() const
-    {
-        if (cell == nullptr) {
-            return mkhash_add(port.hash(), bit);
-        } else {
-            return mkhash_add(mkhash(cell->hash(), port.hash()), bit);
-        }
+    /// An invertible pin driven by an inverter that can potentially be
+    /// integrated. Cells are referred to by pointers, inverters and port
+    /// names are referred to by indices into the tables below.
+    struct InvPin {
+        RTLIL::Cell *cell; /// Cell with the invertible pin
+        int inverter;      /// Index into m_InverterCells
+        int port;          /// Index into m_InvPorts
+        int bit;           /// Bit index
     };
-};
-
-bool operator==(const Pin &lhs, const Pin &rhs) { return (lhs.cell == rhs.cell) && (lhs.port == rhs.port) && (lhs.bit == rhs.bit); }
 
-struct IntegrateInv : public Pass {
+    /// An invertible port and the name of the parameter controlling its
+    /// inversion
+    struct InvPort {
+        RTLIL::IdString port;
+        RTLIL::IdString param;
+    };
 
-    /// Temporary SigBit to SigBit helper map.
-    SigMap m_SigMap;
-    /// Map of SigBit objects to inverter cells.
-    dict<RTLIL::SigBit, RTLIL::Cell *> m_InvMap;
-    /// Map of inverter cells that can potentially be integrated and invertable
-    /// pins that they are connected to
-    dict<RTLIL::Cell *, pool<Pin>> m_Inverters;
-    /// Map of invertable pins and names of parameters controlling inversions
-    dict<Pin, RTLIL::IdString> m_InvParams;
+    /// Module connection index (holds the module SigMap too)
+    ConnIndex m_ConnIndex;
+    /// Invertible pins connected to inverters, one record per pin
+    std::vector<InvPin> m_Pins;
+    /// Inverter cells in the order they were found
+    std::vector<RTLIL::Cell *> m_InverterCells;
+    dict<RTLIL::Cell *, int> m_InverterIds;
+    /// Invertible ports found so far
+    std::vector<InvPort> m_InvPorts;
+    /// Index into m_InvPorts for each cell type and port, -1 for ports that
+    /// are not invertible
+    dict<std::pair<RTLIL::IdString, RTLIL::IdString>, int> m_InvPortIds;
+    /// Sink pins moved to another net by integration, indexed by the new net.
+    /// Together with m_RemovedSinks this keeps the connection index up to date
+    /// without rebuilding it.
+    dict<RTLIL::SigBit, std::vector<Pin>> m_AddedSinks;
+    /// Sink pins that are no longer connected to their net in the index
+    pool<Pin> m_RemovedSinks;
 
     IntegrateInv()
         : Pass("integrateinv", "Integrates inverters ($_NOT_ cells) into ports "
@@ -77,6 +88,15 @@ struct IntegrateInv : public Pass {
         log("\n");
     }
 
+    void clear()
+    {
+        m_Pins.clear();
+        m_InverterCells.clear();
+        m_InverterIds.clear();
+        m_AddedSinks.clear();
+        m_RemovedSinks.clear();
+    }
+
     void execute(std::vector<std::string> a_Args, RTLIL::Design *a_Design) override
     {
         log_header(a_Design, "Executing INTEGRATEINV pass (integrating pin inverters).\n");
@@ -86,15 +106,9 @@ struct IntegrateInv : public Pass {
         // Process modules
         for (auto module : a_Design->selected_modules()) {
 
-            // Setup the SigMap
-            m_SigMap.clear();
-            m_SigMap.set(module);
-
-            m_Inverters.clear();
-            m_InvParams.clear();
-
-            // Setup inverter map
-            buildInverterMap(module);
+            // Build the connection index
+            m_ConnIndex.build(module);
+            clear();
 
             // Identify inverters that can be integrated and assign them with
             // lists of cells and ports to integrate with
@@ -107,233 +121,265 @@ struct IntegrateInv : public Pass {
         }
 
         // Clear maps
-        m_SigMap.clear();
+        m_ConnIndex.clear();
+        clear();
+        m_InvPorts.clear();
+        m_InvPortIds.clear();
+    }
 
-        m_InvMap.clear();
-        m_Inverters.clear();
-        m_InvParams.clear();
+    /// Returns the inverter driving the given (sigmapped) SigBit if any
+    RTLIL::Cell *getDrivingInverter(const RTLIL::SigBit &a_SigBit)
+    {
+        auto driver = m_ConnIndex.driver(a_SigBit);
+        if (driver == nullptr || driver->cell == nullptr) {
+            return nullptr;
+        }
+        if (driver->cell->type != RTLIL::escape_id("$_NOT_") || driver->port != RTLIL::escape_id("Y")) {
+            return nullptr;
+        }
+        return driver->cell;
     }
 
-    void buildInverterMap(RTLIL::Module *a_Module)
+    /// Returns the index of the invertible port of the given cell type or -1
+    /// if the port is not invertible
+    int getInvPort(RTLIL::Design *a_Design, const RTLIL::IdString &a_Type, const RTLIL::IdString &a_Port)
     {
-        m_InvMap.clear();
+        auto key = std::make_pair(a_Type, a_Port);
+        auto it = m_InvPortIds.find(key);
+        if (it != m_InvPortIds.end()) {
+            return it->second;
+        }
 
-        for (auto cell : a_Module->cells()) {
+        int id = -1;
 
-            // Skip non-inverters
-            if (cell->type != RTLIL::escape_id("$_NOT_")) {
-                continue;
+        // Get the cell module and the port wire
+        auto cellModule = a_Design->module(a_Type);
+        auto wire = cellModule ? cellModule->wire(a_Port) : nullptr;
+        if (wire) {
+            // Check if the pin has an embedded inverter.
+            auto attr = wire->attributes.find(ID::invertible_pin);
+            if (attr != wire->attributes.end()) {
+                // Decode the parameter name.
+                id = m_InvPorts.size();
+                m_InvPorts.push_back(InvPort{a_Port, RTLIL::escape_id(attr->second.decode_string())});
             }
-
-            // Get output connection
-            auto sigspec = cell->getPort(RTLIL::escape_id("Y"));
-            auto sigbit = m_SigMap(sigspec.bits().at(0));
-
-            // Store
-            log_assert(m_InvMap.count(sigbit) == 0);
-            m_InvMap[sigbit] = cell;
         }
+
+        m_InvPortIds[key] = id;
+        return id;
     }
 
     void collectInverters(RTLIL::Cell *a_Cell)
     {
-        auto module = a_Cell->module;
-        auto design = module->design;
+        auto design = a_Cell->module->design;
 
-        for (auto conn : a_Cell->connections()) {
-            auto port = conn.first;
-            auto sigspec = conn.second;
+        for (const auto &conn : a_Cell->connections()) {
+            const auto &port = conn.first;
+            const auto &sigspec = conn.second;
 
             // Consider only inputs.
             if (!a_Cell->input(port)) {
                 continue;
             }
 
-            // Get the cell module
-            auto cellModule = design->module(a_Cell->type);
-            if (!cellModule) {
-                continue;
-            }
-
-            // Get wire.
-            auto wire = cellModule->wire(port);
-            if (!wire) {
-                continue;
-            }
-
-            // Check if the pin has an embedded inverter.
-            auto it = wire->attributes.find(ID::invertible_pin);
-            if (it == wire->attributes.end()) {
+            int invPort = getInvPort(design, a_Cell->type, port);
+            if (invPort < 0) {
                 continue;
             }
 
-            // Decode the parameter name.
-            RTLIL::IdString paramName = RTLIL::escape_id(it->second.decode_string());
-
             // Look for connected inverters
-            auto sigbits = sigspec.bits();
-            for (size_t bit = 0; bit < sigbits.size(); ++bit) {
+            for (int bit = 0; bit < sigspec.size(); ++bit) {
 
-                auto sigbit = sigbits[bit];
+                auto sigbit = sigspec[bit];
                 if (!sigbit.wire) {
                     continue;
                 }
 
-                sigbit = m_SigMap(sigbit);
+                sigbit = m_ConnIndex.sigmap(sigbit);
 
                 // Get the inverter if any
-                if (!m_InvMap.count(sigbit)) {
+                auto inv = getDrivingInverter(sigbit);
+                if (inv == nullptr) {
                     continue;
                 }
-                auto inv = m_InvMap.at(sigbit);
-
-                // Save the inverter pin and the parameter name
-                auto pin = Pin(a_Cell, port, bit);
 
-                auto &list = m_Inverters[inv];
-                list.insert(pin);
-
-                log_assert(m_InvParams.count(pin) == 0);
-                m_InvParams[pin] = paramName;
+                // Save the inverter pin
+                auto it = m_InverterIds.find(inv);
+                if (it == m_InverterIds.end()) {
+                    it = m_InverterIds.emplace(inv, m_InverterCells.size()).first;
+                    m_InverterCells.push_back(inv);
+                }
+                m_Pins.push_back(InvPin{a_Cell, it->second, invPort, bit});
             }
         }
     }
 
-    void integrateInverters()
+    /// Orders pins of the same cell by port and bit, cells and ports are
+    /// compared by name so that the order doesn't depend on pointer values
+    bool pinLess(const InvPin &a_Lhs, const InvPin &a_Rhs) const
     {
+        if (a_Lhs.cell != a_Rhs.cell) {
+            return a_Lhs.cell->name.index_ < a_Rhs.cell->name.index_;
+        }
+        if (a_Lhs.port != a_Rhs.port) {
+            return m_InvPorts[a_Lhs.port].port.index_ < m_InvPorts[a_Rhs.port].port.index_;
+        }
+        return a_Lhs.bit < a_Rhs.bit;
+    }
 
-        for (auto it : m_Inverters) {
-            auto inv = it.first;
-            auto pins = it.second;
-
-            // List all sinks of the inverter
-            auto sinks = getSinksForDriver(Pin(inv, RTLIL::escape_id("Y")));
-
-            // If the inverter drives only invertable pins then integrate it
-            if (sinks == pins) {
-                log("Integrating inverter %s into:\n", log_id(inv->name));
-
-                // Integrate into each pin
-                for (auto pin : pins) {
-                    log_assert(pin.cell != nullptr);
-                    log(" %s.%s[%d]\n", log_id(pin.cell->name), log_id(pin.port), pin.bit);
-
-                    // Change the connection
-                    auto sigspec = pin.cell->getPort(pin.port);
-                    auto sigbits = sigspec.bits();
-
-                    log_assert((size_t)pin.bit < sigbits.size());
-                    sigbits[pin.bit] = RTLIL::SigBit(inv->getPort(RTLIL::escape_id("A"))[0]);
-                    pin.cell->setPort(pin.port, RTLIL::SigSpec(sigbits));
-
-                    // Get the control parameter
-                    log_assert(m_InvParams.count(pin) != 0);
-                    auto paramName = m_InvParams[pin];
-
-                    RTLIL::Const invMask;
-                    auto param = pin.cell->parameters.find(paramName);
-                    if (param == pin.cell->parameters.end()) {
-                        invMask = RTLIL::Const(0, sigspec.size());
-                    } else {
-                        invMask = RTLIL::Const(param->second);
-                    }
-
-                    // Check width.
-                    if (invMask.size() != sigspec.size()) {
-                        log_error("The inversion parameter needs to be the same width as "
-                                  "the port (%s port %s parameter %s)",
-                                  log_id(pin.cell->name), log_id(pin.port), log_id(paramName));
-                    }
-
-                    // Toggle bit in the control parameter bitmask
-                    if (invMask[pin.bit] == RTLIL::State::S0) {
-                        invMask[pin.bit] = RTLIL::State::S1;
-                    } else if (invMask[pin.bit] == RTLIL::State::S1) {
-                        invMask[pin.bit] = RTLIL::State::S0;
-                    } else {
-                        log_error("The inversion parameter must contain only 0s and 1s (%s "
-                                  "parameter %s)\n",
-                                  log_id(pin.cell->name), log_id(paramName));
-                    }
-
-                    // Set the parameter back
-                    pin.cell->setParam(paramName, invMask);
+    /// Returns true if the pins of an inverter (sorted with pinLess) are all
+    /// the sinks of the inverter output
+    bool drivesOnlyPins(RTLIL::Cell *a_Inverter, const InvPin *a_First, const InvPin *a_Last)
+    {
+        auto isPin = [&](const Pin &a_Sink) {
+            if (a_Sink.cell == nullptr) {
+                return false;
+            }
+            auto it = std::lower_bound(a_First, a_Last, a_Sink, [&](const InvPin &a_Pin, const Pin &a_Key) {
+                if (a_Pin.cell != a_Key.cell) {
+                    return a_Pin.cell->name.index_ < a_Key.cell->name.index_;
+                }
+                const auto &port = m_InvPorts[a_Pin.port].port;
+                if (port != a_Key.port) {
+                    return port.index_ < a_Key.port.index_;
                 }
+                return a_Pin.bit < a_Key.bit;
+            });
+            return it != a_Last && it->cell == a_Sink.cell && m_InvPorts[it->port].port == a_Sink.port && it->bit == a_Sink.bit;
+        };
 
-                // Remove the inverter
-                inv->module->remove(inv);
+        // Get the driver sigbit
+        auto driverSigbit = m_ConnIndex.sigmap(a_Inverter->getPort(RTLIL::escape_id("Y"))[0]);
+
+        // Sinks from the index (cell inputs and top-level output ports) that
+        // are still connected and sinks connected to the net by integration
+        // of other inverters. The pins are distinct, so they are all the sinks
+        // if each sink is one of them and the counts match.
+        size_t count = 0;
+        for (const auto &sink : m_ConnIndex.sinks(driverSigbit)) {
+            if (m_RemovedSinks.count(sink)) {
+                continue;
             }
+            if (!isPin(sink)) {
+                return false;
+            }
+            count++;
         }
+        auto it = m_AddedSinks.find(driverSigbit);
+        if (it != m_AddedSinks.end()) {
+            for (const auto &sink : it->second) {
+                if (!isPin(sink)) {
+                    return false;
+                }
+                count++;
+            }
+        }
+        return count == size_t(a_Last - a_First);
     }
 
-    pool<Pin> getSinksForDriver(const Pin &a_Driver)
+    void integrateInverters()
     {
-        auto module = a_Driver.cell->module;
-        pool<Pin> sinks;
-
-        // The driver has to be an output pin
-        if (!a_Driver.cell->output(a_Driver.port)) {
-            return sinks;
-        }
+        // Group the pins by inverter, in the order the inverters were found
+        std::sort(m_Pins.begin(), m_Pins.end(), [&](const InvPin &a_Lhs, const InvPin &a_Rhs) {
+            return a_Lhs.inverter != a_Rhs.inverter ? a_Lhs.inverter < a_Rhs.inverter : pinLess(a_Lhs, a_Rhs);
+        });
+
+        // Pins to integrate and the inverter input nets they get connected to
+        typedef std::pair<InvPin, RTLIL::SigBit> Integration;
+        std::vector<Integration> integrated;
+        std::vector<RTLIL::Cell *> inverters;
+
+        for (size_t first = 0, last = 0; first < m_Pins.size(); first = last) {
+            while (last < m_Pins.size() && m_Pins[last].inverter == m_Pins[first].inverter) {
+                last++;
+            }
+            auto inv = m_InverterCells[m_Pins[first].inverter];
 
-        // Get the driver sigbit
-        auto driverSigspec = a_Driver.cell->getPort(a_Driver.port);
-        auto driverSigbit = m_SigMap(driverSigspec.bits().at(a_Driver.bit));
+            // If the inverter drives only invertable pins then integrate it
+            if (!drivesOnlyPins(inv, m_Pins.data() + first, m_Pins.data() + last)) {
+                continue;
+            }
 
-        // Look for connected sinks
-        for (auto cell : module->cells()) {
-            for (auto conn : cell->connections()) {
-                auto port = conn.first;
-                auto sigspec = conn.second;
+            log("Integrating inverter %s into:\n", log_id(inv->name));
 
-                // Consider only sinks (inputs)
-                if (!cell->input(port)) {
-                    continue;
-                }
+            // The inverter input net receives the integrated pins
+            auto invInputBit = inv->getPort(RTLIL::escape_id("A"))[0];
+            auto invInput = m_ConnIndex.sigmap(invInputBit);
+            m_RemovedSinks.insert(Pin(inv, RTLIL::escape_id("A")));
 
-                // Check all sigbits
-                auto sigbits = sigspec.bits();
-                for (size_t bit = 0; bit < sigbits.size(); ++bit) {
+            for (size_t i = first; i < last; ++i) {
+                const auto &pin = m_Pins[i];
+                const auto &port = m_InvPorts[pin.port].port;
+                log(" %s.%s[%d]\n", log_id(pin.cell->name), log_id(port), pin.bit);
 
-                    auto sigbit = sigbits[bit];
-                    if (!sigbit.wire) {
-                        continue;
-                    }
+                // Update the sinks
+                m_RemovedSinks.insert(Pin(pin.cell, port, pin.bit));
+                m_AddedSinks[invInput].push_back(Pin(pin.cell, port, pin.bit));
 
-                    // Got a sink pin of another cell
-                    sigbit = m_SigMap(sigbit);
-                    if (sigbit == driverSigbit) {
-                        sinks.insert(Pin(cell, port, bit));
-                    }
-                }
+                integrated.push_back(std::make_pair(pin, invInputBit));
             }
+
+            // Remove the inverter once all of them are processed, the sink
+            // index still refers to its pins.
+            inverters.push_back(inv);
         }
 
-        // Look for connected top-level output ports
-        for (auto conn : module->connections()) {
-            auto dst = conn.first;
-            auto src = conn.second;
+        // Change the connections and the inversion parameters, each port and
+        // its parameter of a cell are written once
+        std::sort(integrated.begin(), integrated.end(),
+                  [&](const Integration &a_Lhs, const Integration &a_Rhs) { return pinLess(a_Lhs.first, a_Rhs.first); });
 
-            auto sigbits = dst.bits();
-            for (size_t bit = 0; bit < sigbits.size(); ++bit) {
+        for (size_t first = 0, last = 0; first < integrated.size(); first = last) {
+            auto cell = integrated[first].first.cell;
+            const auto &invPort = m_InvPorts[integrated[first].first.port];
+            while (last < integrated.size() && integrated[last].first.cell == cell && integrated[last].first.port == integrated[first].first.port) {
+                last++;
+            }
 
-                auto sigbit = sigbits[bit];
-                if (!sigbit.wire) {
-                    continue;
-                }
+            auto sigspec = cell->getPort(invPort.port);
 
-                if (!sigbit.wire->port_output) {
-                    continue;
-                }
+            RTLIL::Const invMask;
+            auto param = cell->parameters.find(invPort.param);
+            if (param == cell->parameters.end()) {
+                invMask = RTLIL::Const(0, sigspec.size());
+            } else {
+                invMask = param->second;
+            }
 
-                sigbit = m_SigMap(sigbit);
-                if (sigbit == driverSigbit) {
-                    sinks.insert(Pin(nullptr, sigbit.wire->name, bit));
+            // Check width.
+            if (invMask.size() != sigspec.size()) {
+                log_error("The inversion parameter needs to be the same width as "
+                          "the port (%s port %s parameter %s)",
+                          log_id(cell->name), log_id(invPort.port), log_id(invPort.param));
+            }
+
+            for (size_t i = first; i < last; ++i) {
+                int bit = integrated[i].first.bit;
+                log_assert(bit < sigspec.size());
+                sigspec[bit] = integrated[i].second;
+
+                // Toggle bit in the control parameter bitmask
+                auto &state = invMask[bit];
+                if (state == RTLIL::State::S0) {
+                    state = RTLIL::State::S1;
+                } else if (state == RTLIL::State::S1) {
+                    state = RTLIL::State::S0;
+                } else {
+                    log_error("The inversion parameter must contain only 0s and 1s (%s "
+                              "parameter %s)\n",
+                              log_id(cell->name), log_id(invPort.param));
                 }
             }
+
+            // Set the connection and the parameter back
+            cell->setPort(invPort.port, std::move(sigspec));
+            cell->setParam(invPort.param, std::move(invMask));
         }
 
-        return sinks;
+        // Remove integrated inverters
+        for (auto inv : inverters) {
+            inv->module->remove(inv);
+        }
     }
 
 } IntegrateInv;
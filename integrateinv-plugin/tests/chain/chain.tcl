@@ -0,0 +1,14 @@
+yosys -import
+if { [info procs integrateinv] == {} } { plugin -i integrateinv }
+yosys -import  ;# ingest plugin commands
+
+read_verilog -icells $::env(DESIGN_TOP).v
+hierarchy -check -auto-top
+
+debug integrateinv
+
+# n1 gets integrated into b0. n0 then drives both b0 and b1 so it has to stay.
+select t:\$_NOT_ -assert-count 1
+select c:n0 -assert-count 1
+select c:b0 r:INV_A=1'b1 %i -assert-count 1
+select c:b1 r:INV_A=1'b1 %i -assert-none
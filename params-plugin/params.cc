@@ -38,9 +38,25 @@ struct GetParam : public Pass {
         //   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
         log("\n");
         log("   getparam name selection\n");
+        log("   getparam -multi {name1 name2 ...} selection\n");
         log("\n");
         log("Get the given parameter on the selected object. \n");
         log("\n");
+        log("With -multi several parameters are fetched at once. The result is a dict\n");
+        log("mapping the name of each selected cell that has any of them to a dict of\n");
+        log("its parameter values.\n");
+        log("\n");
+    }
+
+    static Tcl_Obj *param_to_tcl(const RTLIL::Const &param)
+    {
+        std::string value;
+        if (param.flags & RTLIL::CONST_FLAG_STRING) {
+            value = param.decode_string();
+        } else {
+            value = std::to_string(param.as_int());
+        }
+        return Tcl_NewStringObj(value.c_str(), value.size());
     }
 
     void execute(std::vector<std::string> args, RTLIL::Design *design) override
@@ -48,32 +64,250 @@ struct GetParam : public Pass {
         if (args.size() == 1) {
             log_error("Incorrect number of arguments");
         }
+        Tcl_Interp *interp = yosys_get_tcl_interp();
+
+        if (args.at(1) == "-multi") {
+            if (args.size() < 3) {
+                log_cmd_error("Missing parameter list for -multi.\n");
+            }
+            int count;
+            const char **names;
+            if (Tcl_SplitList(interp, args.at(2).c_str(), &count, &names) != TCL_OK) {
+                log_cmd_error("Malformed parameter list: %s\n", args.at(2).c_str());
+            }
+            std::vector<std::pair<RTLIL::IdString, Tcl_Obj *>> params;
+            for (int i = 0; i < count; i++) {
+                Tcl_Obj *key = Tcl_NewStringObj(names[i], -1);
+                Tcl_IncrRefCount(key);
+                params.emplace_back(RTLIL::escape_id(names[i]), key);
+            }
+            Tcl_Free(reinterpret_cast<char *>(names));
+            extra_args(args, 3, design);
+            Tcl_SetObjResult(interp, get_multi(params, design));
+            for (auto &param : params) {
+                Tcl_DecrRefCount(param.second);
+            }
+            return;
+        }
+
         extra_args(args, 2, design);
 
         auto param = RTLIL::IdString(RTLIL::escape_id(args.at(1)));
-        Tcl_Interp *interp = yosys_get_tcl_interp();
-        Tcl_Obj *tcl_list = Tcl_NewListObj(0, NULL);
+        std::vector<Tcl_Obj *> values;
+        for (auto module : design->selected_modules()) {
+            for (auto cell : module->selected_cells()) {
+                auto it = cell->parameters.find(param);
+                if (it != cell->parameters.end()) {
+                    values.push_back(param_to_tcl(it->second));
+                }
+            }
+        }
+        Tcl_SetObjResult(interp, Tcl_NewListObj(values.size(), values.data()));
+    }
 
+    // Collects the requested parameters of all selected cells in one pass,
+    // the parameter name objects are shared by all the per-cell dicts
+    Tcl_Obj *get_multi(const std::vector<std::pair<RTLIL::IdString, Tcl_Obj *>> &params, RTLIL::Design *design)
+    {
+        Tcl_Obj *result = Tcl_NewDictObj();
         for (auto module : design->selected_modules()) {
             for (auto cell : module->selected_cells()) {
-                auto params = cell->parameters;
-                auto it = params.find(param);
-                if (it != params.end()) {
-                    std::string value;
-                    auto param_obj = it->second;
-                    if (param_obj.flags & RTLIL::CONST_FLAG_STRING) {
-                        value = param_obj.decode_string();
-                    } else {
-                        value = std::to_string(param_obj.as_int());
+                Tcl_Obj *cell_params = nullptr;
+                for (auto &param : params) {
+                    auto it = cell->parameters.find(param.first);
+                    if (it == cell->parameters.end()) {
+                        continue;
+                    }
+                    if (cell_params == nullptr) {
+                        cell_params = Tcl_NewDictObj();
                     }
-                    Tcl_Obj *value_obj = Tcl_NewStringObj(value.c_str(), value.size());
-                    Tcl_ListObjAppendElement(interp, tcl_list, value_obj);
+                    Tcl_DictObjPut(nullptr, cell_params, param.second, param_to_tcl(it->second));
+                }
+                if (cell_params != nullptr) {
+                    std::string name = RTLIL::unescape_id(cell->name);
+                    Tcl_DictObjPut(nullptr, result, Tcl_NewStringObj(name.c_str(), name.size()), cell_params);
                 }
             }
         }
-        Tcl_SetObjResult(interp, tcl_list);
+        return result;
     }
 
 } GetParam;
 
+struct SetParams : public Pass {
+    SetParams() : Pass("setparams", "set parameters on many cells at once") { register_in_tcl_interpreter(pass_name); }
+
+    void help() override
+    {
+        //   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
+        log("\n");
+        log("   setparams [-file <filename>] [<updates>]\n");
+        log("\n");
+        log("Set parameters on cells of the top module. <updates> is a Tcl dict mapping cell\n");
+        log("names or glob patterns to dicts of parameter names and values:\n");
+        log("\n");
+        log("    setparams {OBUF_* {IOSTANDARD LVCMOS33 DRIVE 12} lut_0 {INIT 16'h8000}}\n");
+        log("\n");
+        log("With -file the updates are read from the given file, in the same format.\n");
+        log("Values that are plain or sized Verilog numbers are set as numbers, everything\n");
+        log("else (or a value in double quotes) as a string. When several entries match the\n");
+        log("same cell they are applied in order.\n");
+        log("\n");
+    }
+
+    struct Update {
+        std::string pattern;
+        std::vector<std::pair<RTLIL::IdString, RTLIL::Const>> params;
+    };
+
+    static bool is_glob(const std::string &pattern) { return pattern.find_first_of("*?[\\") != std::string::npos; }
+
+    static bool is_number(const std::string &value)
+    {
+        size_t quote = value.find('\'');
+        size_t digits_end = quote == std::string::npos ? value.size() : quote;
+        for (size_t i = 0; i < digits_end; i++) {
+            if (!isdigit(static_cast<unsigned char>(value[i]))) {
+                return false;
+            }
+        }
+        if (quote == std::string::npos) {
+            return !value.empty();
+        }
+        size_t i = quote + 1;
+        if (i < value.size() && (value[i] == 's' || value[i] == 'S')) {
+            i++;
+        }
+        if (i >= value.size() || !strchr("bBoOdDhH", value[i])) {
+            return false;
+        }
+        i++;
+        if (i == value.size()) {
+            return false;
+        }
+        for (; i < value.size(); i++) {
+            if (!isxdigit(static_cast<unsigned char>(value[i])) && !strchr("xXzZ_?", value[i])) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    static RTLIL::Const parse_value(const std::string &value)
+    {
+        if (value.size() >= 2 && value.front() == '"' && value.back() == '"') {
+            return RTLIL::Const(value.substr(1, value.size() - 2));
+        }
+        RTLIL::SigSpec sig;
+        if (is_number(value) && RTLIL::SigSpec::parse(sig, nullptr, value) && sig.is_fully_const()) {
+            return sig.as_const();
+        }
+        return RTLIL::Const(value);
+    }
+
+    static std::vector<std::string> split_list(const std::string &list)
+    {
+        Tcl_Interp *interp = yosys_get_tcl_interp();
+        int count;
+        const char **items;
+        if (Tcl_SplitList(interp, list.c_str(), &count, &items) != TCL_OK) {
+            log_cmd_error("Malformed parameter update list: %s\n", Tcl_GetStringResult(interp));
+        }
+        std::vector<std::string> result(items, items + count);
+        Tcl_Free(reinterpret_cast<char *>(items));
+        return result;
+    }
+
+    static void parse_updates(const std::string &text, std::vector<Update> &updates)
+    {
+        auto items = split_list(text);
+        if (items.size() % 2 != 0) {
+            log_cmd_error("Parameter updates must be pairs of a cell pattern and a parameter dict.\n");
+        }
+        for (size_t i = 0; i < items.size(); i += 2) {
+            Update update;
+            update.pattern = items[i];
+            auto params = split_list(items[i + 1]);
+            if (params.size() % 2 != 0) {
+                log_cmd_error("Odd number of elements in the parameters of '%s'.\n", items[i].c_str());
+            }
+            for (size_t j = 0; j < params.size(); j += 2) {
+                update.params.emplace_back(RTLIL::escape_id(params[j]), parse_value(params[j + 1]));
+            }
+            updates.push_back(std::move(update));
+        }
+    }
+
+    void execute(std::vector<std::string> args, RTLIL::Design *design) override
+    {
+        std::vector<Update> updates;
+        size_t argidx;
+        for (argidx = 1; argidx < args.size(); argidx++) {
+            if (args[argidx] == "-file" && argidx + 1 < args.size()) {
+                std::ifstream file(args[++argidx]);
+                if (!file.good()) {
+                    log_cmd_error("Can't open file %s\n", args[argidx].c_str());
+                }
+                std::string content{std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+                parse_updates(content, updates);
+                continue;
+            }
+            break;
+        }
+        for (; argidx < args.size(); argidx++) {
+            parse_updates(args[argidx], updates);
+        }
+
+        RTLIL::Module *top = design->top_module();
+        if (top == nullptr) {
+            log_cmd_error("No top module detected\n");
+        }
+
+        // Resolve plain names with the module's name index and all globs in
+        // one pass over its cells, remembering which updates apply to a cell
+        dict<RTLIL::Cell *, std::vector<int>> cell_updates;
+        std::vector<int> match_count(updates.size(), 0);
+        std::vector<int> globs;
+        for (int i = 0; i < GetSize(updates); i++) {
+            if (is_glob(updates[i].pattern)) {
+                globs.push_back(i);
+                continue;
+            }
+            RTLIL::Cell *cell = top->cell(RTLIL::escape_id(updates[i].pattern));
+            if (cell != nullptr) {
+                cell_updates[cell].push_back(i);
+                match_count[i]++;
+            }
+        }
+        if (!globs.empty()) {
+            for (auto cell : top->cells()) {
+                std::string name = RTLIL::unescape_id(cell->name);
+                for (int i : globs) {
+                    if (patmatch(updates[i].pattern.c_str(), name.c_str())) {
+                        cell_updates[cell].push_back(i);
+                        match_count[i]++;
+                    }
+                }
+            }
+        }
+
+        int param_count = 0;
+        for (auto &it : cell_updates) {
+            std::sort(it.second.begin(), it.second.end());
+            for (int i : it.second) {
+                for (auto &param : updates[i].params) {
+                    it.first->setParam(param.first, param.second);
+                    param_count++;
+                }
+            }
+        }
+        for (int i = 0; i < GetSize(updates); i++) {
+            if (match_count[i] == 0) {
+                log_warning("No cell matches '%s'.\n", updates[i].pattern.c_str());
+            }
+        }
+        log("Set %d parameters on %d cells.\n", param_count, GetSize(cell_updates));
+    }
+} SetParams;
+
 PRIVATE_NAMESPACE_END
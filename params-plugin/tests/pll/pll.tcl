@@ -33,6 +33,27 @@ if {$phase == $reference_phase} {
 } else {
 	puts $fp "FAIL: $phase != $reference_phase"
 }
+
+# Fetch several parameters of both instances at once
+set params [getparam -multi {CLKOUT2_PHASE NOT_A_PARAM} top/PLLE2_ADV_0 top/PLLE2_ADV]
+puts -nonewline $fp "Multi: "
+if {[dict get $params PLLE2_ADV CLKOUT2_PHASE] == 90000 && [dict get $params PLLE2_ADV_0 CLKOUT2_PHASE] == 70 && [dict size [dict get $params PLLE2_ADV]] == 1} {
+	puts $fp "PASS"
+} else {
+	puts $fp "FAIL: $params"
+}
+
+# Bulk update both instances, then restore the original values
+setparams {PLLE2_ADV* {CLKOUT2_PHASE 1}}
+set bulk_phase [getparam CLKOUT2_PHASE top/PLLE2_ADV_0 top/PLLE2_ADV]
+setparams {PLLE2_ADV_0 {CLKOUT2_PHASE 7'd70} PLLE2_ADV {CLKOUT2_PHASE 90000}}
+set phase [getparam CLKOUT2_PHASE top/PLLE2_ADV_0 top/PLLE2_ADV]
+puts -nonewline $fp "Bulk: "
+if {$bulk_phase == [list 1 1] && $phase == $reference_phase} {
+	puts $fp "PASS"
+} else {
+	puts $fp "FAIL: $bulk_phase, $phase != $reference_phase"
+}
 close $fp
 
 # Start flow after library reading
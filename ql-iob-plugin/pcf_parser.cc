@@ -18,7 +18,7 @@
  */
 #include "pcf_parser.hh"
 
-#include <regex>
+#include <cctype>
 
 // ============================================================================
 
@@ -32,7 +32,7 @@ bool PcfParser::parse(const std::string &a_FileName)
     return parse(file);
 }
 
-const std::vector<PcfParser::Constraint> PcfParser::getConstraints() const { return m_Constraints; }
+const std::vector<PcfParser::Constraint> &PcfParser::getConstraints() const { return m_Constraints; }
 
 // ============================================================================
 
@@ -46,19 +46,63 @@ bool PcfParser::parse(std::ifstream &a_Stream)
     // Clear constraints
     m_Constraints.clear();
 
-    // Parse PCF lines
-    std::regex re("^\\s*set_io\\s+([^#\\s]+)\\s+([^#\\s]+)(?:\\s+#(.*))?");
-
+    // Parse PCF lines of the form "set_io <net> <pad> [# <comment>]"
     while (a_Stream.good()) {
         std::string line;
         std::getline(a_Stream, line);
 
-        // Match against regex
-        std::cmatch cm;
-        if (std::regex_match(line.c_str(), cm, re)) {
-            m_Constraints.push_back(Constraint(cm[1].str(), cm[2].str(), cm[3].str()));
+        parseLine(line);
+    }
+
+    return true;
+}
+
+bool PcfParser::parseLine(const std::string &a_Line)
+{
+    size_t pos = 0;
+    size_t end = a_Line.size();
+
+    auto skipSpaces = [&]() {
+        size_t start = pos;
+        while (pos < end && isspace(static_cast<unsigned char>(a_Line[pos]))) {
+            pos++;
+        }
+        return pos != start;
+    };
+    auto getToken = [&]() {
+        size_t start = pos;
+        while (pos < end && a_Line[pos] != '#' && !isspace(static_cast<unsigned char>(a_Line[pos]))) {
+            pos++;
+        }
+        return a_Line.substr(start, pos - start);
+    };
+
+    skipSpaces();
+    if (getToken() != "set_io" || !skipSpaces()) {
+        return false;
+    }
+    std::string netName = getToken();
+    if (netName.empty() || !skipSpaces()) {
+        return false;
+    }
+    std::string padName = getToken();
+    if (padName.empty()) {
+        return false;
+    }
+
+    // Optional comment, anything else after the pad name is an error
+    std::string comment;
+    bool hasSpace = skipSpaces();
+    if (pos < end) {
+        if (!hasSpace || a_Line[pos] != '#') {
+            return false;
+        }
+        comment = a_Line.substr(pos + 1);
+        while (!comment.empty() && comment.back() == '\r') {
+            comment.pop_back();
         }
     }
 
+    m_Constraints.push_back(Constraint(netName, padName, comment));
     return true;
 }
@@ -53,10 +53,14 @@ public:
     bool parse (std::ifstream& a_Stream);
 
     /// Returns the constraint list
-    const std::vector<Constraint> getConstraints () const;
+    const std::vector<Constraint>& getConstraints () const;
 
 private:
 
+    /// Parses a single line and stores its constraint if it is a "set_io"
+    /// one. Returns false otherwise
+    bool parseLine (const std::string& a_Line);
+
     /// A list of constraints
     std::vector<Constraint> m_Constraints;
 };
@@ -32,7 +32,7 @@ bool PinmapParser::parse(const std::string &a_FileName)
     return parse(file);
 }
 
-const std::vector<PinmapParser::Entry> PinmapParser::getEntries() const { return m_Entries; }
+const std::vector<PinmapParser::Entry> &PinmapParser::getEntries() const { return m_Entries; }
 
 // ============================================================================
 
@@ -40,7 +40,7 @@ public:
     bool parse (std::ifstream& a_Stream);
 
     /// Returns a vector of entries
-    const std::vector<Entry> getEntries() const;
+    const std::vector<Entry>& getEntries() const;
 
 private:
 
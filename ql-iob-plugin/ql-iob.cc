@@ -46,6 +46,12 @@ struct QuicklogicIob : public Pass {
         }
     };
 
+    /// Pinmap entries of a single pad
+    struct PadEntries {
+        std::vector<const PinmapParser::Entry *> entries; // Entries in file order
+        std::unordered_map<std::string, size_t> byType;   // Index of the first entry of each type
+    };
+
     QuicklogicIob() : Pass("quicklogic_iob", "Map IO buffers to cells that correspond to their assigned locations") {}
 
     void help() YS_OVERRIDE
@@ -164,17 +170,18 @@ struct QuicklogicIob : public Pass {
             log_cmd_error("Failed to parse the pinmap CSV file!\n");
         }
 
-        // Build a map of pad names to entries
-        std::unordered_map<std::string, std::vector<PinmapParser::Entry>> pinmapMap;
+        // Build a map of pad names to entries, with each type indexed to its
+        // first entry for the pad
+        std::unordered_map<std::string, PadEntries> pinmapMap;
         for (auto &entry : pinmapParser.getEntries()) {
-            if (entry.count("name") != 0) {
-                auto &name = entry.at("name");
-
-                if (pinmapMap.count(name) == 0) {
-                    pinmapMap[name] = std::vector<PinmapParser::Entry>();
+            auto name = entry.find("name");
+            if (name != entry.end()) {
+                auto &padEntries = pinmapMap[name->second];
+                auto type = entry.find("type");
+                if (type != entry.end()) {
+                    padEntries.byType.emplace(type->second, padEntries.entries.size());
                 }
-
-                pinmapMap[name].push_back(entry);
+                padEntries.entries.push_back(&entry);
             }
         }
 
@@ -226,19 +233,20 @@ struct QuicklogicIob : public Pass {
                             netName = "";
 
                             for (auto &name : netNames) {
-                                if (constraintMap.count(name)) {
-                                    auto constraint = constraintMap.at(name);
-                                    padName = constraint.padName;
+                                auto constraint = constraintMap.find(name);
+                                if (constraint != constraintMap.end()) {
+                                    padName = constraint->second.padName;
                                     netName = name;
                                     break;
                                 }
                             }
 
                             // Check if there is an entry in the pinmap for this pad name
-                            if (pinmapMap.count(padName)) {
+                            auto padEntries = pinmapMap.find(padName);
+                            if (padEntries != pinmapMap.end()) {
 
                                 // Choose a correct entry for the cell
-                                auto entry = choosePinmapEntry(pinmapMap.at(padName), ioCellType);
+                                const auto &entry = choosePinmapEntry(padEntries->second, ioCellType);
 
                                 // Location string
                                 if (entry.count("x") && entry.count("y")) {
@@ -264,26 +272,19 @@ struct QuicklogicIob : public Pass {
         }
     }
 
-    PinmapParser::Entry choosePinmapEntry(const std::vector<PinmapParser::Entry> &a_Entries, const IoCellType &a_IoCellType)
+    const PinmapParser::Entry &choosePinmapEntry(const PadEntries &a_PadEntries, const IoCellType &a_IoCellType)
     {
-        // No preferred types, pick the first one
-        if (a_IoCellType.preferredTypes.empty()) {
-            return a_Entries[0];
-        }
-
-        // Loop over preferred types
+        // Loop over preferred types, return the first entry of the first
+        // type found for the pad
         for (auto &type : a_IoCellType.preferredTypes) {
-
-            // Find an entry for that type. If found then return it.
-            for (auto &entry : a_Entries) {
-                if (type == entry.at("type")) {
-                    return entry;
-                }
+            auto it = a_PadEntries.byType.find(type);
+            if (it != a_PadEntries.byType.end()) {
+                return *a_PadEntries.entries[it->second];
             }
         }
 
-        // No preferred type was found, pick the first one.
-        return a_Entries[0];
+        // No preferred type was found or there were none, pick the first one.
+        return *a_PadEntries.entries[0];
     }
 
 } QuicklogicIob;
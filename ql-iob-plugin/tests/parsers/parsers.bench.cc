@@ -0,0 +1,86 @@
+/*
+ * Copyright 2020-2022 F4PGA Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ */
+#include "pcf_parser.hh"
+#include "pinmap_parser.hh"
+
+#include <benchmark/benchmark.h>
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+// Writes a PCF file with the given number of set_io constraints, every
+// fourth one carrying a comment
+static std::string writePcf(int a_Count)
+{
+    std::string fileName = "parsers/bench_" + std::to_string(a_Count) + ".pcf";
+    std::ofstream file(fileName);
+    for (int i = 0; i < a_Count; ++i) {
+        file << "set_io  data_io[" << i << "]\tP" << i;
+        if (i % 4 == 0) {
+            file << "  # bank " << i / 32;
+        }
+        file << "\n";
+    }
+    return fileName;
+}
+
+// Writes a pinmap CSV file with the given number of pads
+static std::string writePinmap(int a_Count)
+{
+    std::string fileName = "parsers/bench_" + std::to_string(a_Count) + ".csv";
+    std::ofstream file(fileName);
+    file << "name,x,y,z,type\n";
+    for (int i = 0; i < a_Count; ++i) {
+        file << "P" << i << "," << i % 64 << "," << i / 64 << "," << i % 2 << ",BIDIR\n";
+    }
+    return fileName;
+}
+
+static void BM_PcfParserParse(benchmark::State &state)
+{
+    std::string fileName = writePcf(state.range(0));
+    for (auto _ : state) {
+        PcfParser parser;
+        if (!parser.parse(fileName)) {
+            state.SkipWithError("Cannot parse the PCF file");
+            break;
+        }
+        benchmark::DoNotOptimize(parser.getConstraints().data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    std::remove(fileName.c_str());
+}
+BENCHMARK(BM_PcfParserParse)->Range(64, 16 << 10);
+
+static void BM_PinmapParserParse(benchmark::State &state)
+{
+    std::string fileName = writePinmap(state.range(0));
+    for (auto _ : state) {
+        PinmapParser parser;
+        if (!parser.parse(fileName)) {
+            state.SkipWithError("Cannot parse the pinmap file");
+            break;
+        }
+        benchmark::DoNotOptimize(parser.getEntries().data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    std::remove(fileName.c_str());
+}
+BENCHMARK(BM_PinmapParserParse)->Range(64, 16 << 10);
@@ -19,26 +19,103 @@
 
 #include "kernel/sigtools.h"
 #include "kernel/yosys.h"
-#include <bitset>
-#include <stdio.h>
-#include <stdlib.h>
+#include <fstream>
+#include <sstream>
+#include <stdint.h>
 
 USING_YOSYS_NAMESPACE
 PRIVATE_NAMESPACE_BEGIN
 
-static void run_pp3_braminit(Module *module)
+// Contents of an init file: (address, value) pairs in the order they appear
+// in the file, so later words for the same address win
+struct InitImage {
+    std::vector<std::pair<int, uint64_t>> words;
+};
+
+static bool is_space(char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\n'; }
+
+static bool parse_hex(const char *first, const char *last, uint64_t &value)
 {
-    for (auto cell : module->selected_cells()) {
-        uint32_t mem[2048];
-        int32_t ramDataWidth = 32;
-        int32_t ramDataDepth = 512;
+    // Words wider than 64 bits would silently lose their top digits
+    if (first == last || last - first > 16)
+        return false;
+    value = 0;
+    for (const char *p = first; p != last; ++p) {
+        char c = *p;
+        int digit;
+        if (c >= '0' && c <= '9')
+            digit = c - '0';
+        else if (c >= 'a' && c <= 'f')
+            digit = c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F')
+            digit = c - 'A' + 10;
+        else
+            return false;
+        value = (value << 4) | digit;
+    }
+    return true;
+}
+
+// Parses a $readmemh style file, read in one go, skipping /* */ and // comments
+static bool load_init_file(const std::string &filename, InitImage &image)
+{
+    std::ifstream f(filename.c_str(), std::ios::binary);
+    if (f.fail())
+        return false;
+    std::stringstream ss;
+    ss << f.rdbuf();
+    const std::string buffer = ss.str();
+
+    const char *p = buffer.data();
+    const char *end = p + buffer.size();
+    int cursor = 0;
+
+    while (p != end) {
+        if (is_space(*p)) {
+            ++p;
+            continue;
+        }
+        if (end - p >= 2 && p[0] == '/' && p[1] == '*') {
+            const char *close = p + 2;
+            while (close != end && !(end - close >= 2 && close[0] == '*' && close[1] == '/'))
+                ++close;
+            p = (close == end) ? end : close + 2;
+            continue;
+        }
+        if (end - p >= 2 && p[0] == '/' && p[1] == '/') {
+            while (p != end && *p != '\n')
+                ++p;
+            continue;
+        }
+
+        const char *first = p;
+        while (p != end && !is_space(*p) && !(end - p >= 2 && p[0] == '/' && p[1] == '*'))
+            ++p;
+
+        bool set_cursor = (*first == '@');
+        uint64_t value;
+        if (!parse_hex(first + set_cursor, p, value)) {
+            log("Can not parse %s `%s`.\n", set_cursor ? "address" : "value", std::string(first, p).c_str());
+            continue;
+        }
+
+        if (set_cursor)
+            cursor = value;
+        else
+            image.words.emplace_back(cursor++, value);
+    }
+    return true;
+}
 
-        log("cell type %s\n", RTLIL::id2cstr(cell->name));
+static void run_pp3_braminit(Module *module, dict<std::string, InitImage> &images)
+{
+    for (auto cell : module->selected_cells()) {
+        log_debug("cell type %s\n", RTLIL::id2cstr(cell->name));
 
         /* Only consider cells we're interested in */
         if (cell->type != ID(RAM_16K_BLK) && cell->type != ID(RAM_8K_BLK))
             continue;
-        log("found ram block\n");
+        log_debug("found ram block\n");
         if (!cell->hasParam(ID(INIT_FILE)))
             continue;
         std::string init_file = cell->getParam(ID(INIT_FILE)).decode_string();
@@ -46,90 +123,39 @@ static void run_pp3_braminit(Module *module)
         if (init_file == "")
             continue;
 
-        /* Open file */
         log("Processing %s : %s\n", RTLIL::id2cstr(cell->name), init_file.c_str());
-        ramDataWidth = cell->getParam(ID(data_width_int)).as_int();
-        ramDataDepth = cell->getParam(ID(data_depth_int)).as_int();
+        int ramDataWidth = cell->getParam(ID(data_width_int)).as_int();
+        int ramDataDepth = cell->getParam(ID(data_depth_int)).as_int();
 
-        std::ifstream f;
-        f.open(init_file.c_str());
-        if (f.fail()) {
-            log("Can not open file `%s`.\n", init_file.c_str());
+        if (ramDataWidth < 1 || ramDataWidth > 64) {
+            log("WARNING: The RAM cell '%s' has data width of %d. Initialization of this width from a file is not supported!\n",
+                RTLIL::id2cstr(cell->name), ramDataWidth);
             continue;
         }
 
-        /* Defaults to 0 */
-        memset(mem, 0x00, sizeof(mem));
-
-        /* Process each line */
-        bool in_comment = false;
-        int cursor = 0;
-
-        while (!f.eof()) {
-            std::string line, token;
-            std::getline(f, line);
-
-            for (int i = 0; i < GetSize(line); i++) {
-                if (in_comment && line.compare(i, 2, "*/") == 0) {
-                    line[i] = ' ';
-                    line[i + 1] = ' ';
-                    in_comment = false;
-                    continue;
-                }
-                if (!in_comment && line.compare(i, 2, "/*") == 0)
-                    in_comment = true;
-                if (in_comment)
-                    line[i] = ' ';
-            }
-
-            while (1) {
-                bool set_cursor = false;
-                long value;
-
-                token = next_token(line, " \t\r\n");
-                if (token.empty() || token.compare(0, 2, "//") == 0)
-                    break;
-
-                if (token[0] == '@') {
-                    token = token.substr(1);
-                    set_cursor = true;
-                }
-
-                const char *nptr = token.c_str();
-                char *endptr;
-                value = strtol(nptr, &endptr, 16);
-                if (!*nptr || *endptr) {
-                    log("Can not parse %s `%s` for %s.\n", set_cursor ? "address" : "value", nptr, token.c_str());
-                    continue;
-                }
-
-                if (set_cursor)
-                    cursor = value;
-                else if (cursor >= 0 && cursor < ramDataDepth)
-                    mem[cursor++] = value;
-                else
-                    log("Attempt to initialize non existent address %d\n", cursor);
+        /* Files shared by several cells are parsed once */
+        auto it = images.find(init_file);
+        if (it == images.end()) {
+            InitImage image;
+            if (!load_init_file(init_file, image)) {
+                log("Can not open file `%s`.\n", init_file.c_str());
+                continue;
             }
+            it = images.emplace(init_file, std::move(image)).first;
         }
 
-        // TODO: Support RAM initialization for other widths than 8, 16 and 32
-        if (ramDataWidth != 8 && ramDataWidth != 16 && ramDataWidth != 32) {
-            log("WARNING: The RAM cell '%s' has data width of %d. Initialization of this width from a file is not supported yet!\n",
-                RTLIL::id2cstr(cell->name), ramDataWidth);
-            continue;
-        }
-
-        /* Set attributes */
-        std::string val = "";
-        for (int i = ramDataDepth - 1; i >= 0; i--) {
-            if (ramDataWidth == 8)
-                val += std::bitset<8>(mem[i]).to_string();
-            else if (ramDataWidth == 16)
-                val += std::bitset<16>(mem[i]).to_string();
-            else if (ramDataWidth == 32)
-                val += std::bitset<32>(mem[i]).to_string();
+        /* Defaults to 0 */
+        RTLIL::Const init(RTLIL::State::S0, ramDataWidth * ramDataDepth);
+        for (const auto &word : it->second.words) {
+            if (word.first < 0 || word.first >= ramDataDepth) {
+                log("Attempt to initialize non existent address %d\n", word.first);
+                continue;
+            }
+            auto bits = init.bits.begin() + word.first * ramDataWidth;
+            for (int i = 0; i < ramDataWidth; i++)
+                bits[i] = ((word.second >> i) & 1) ? RTLIL::State::S1 : RTLIL::State::S0;
         }
-        cell->setParam(RTLIL::escape_id("INIT"), RTLIL::Const::from_string(val));
+        cell->setParam(ID(INIT), std::move(init));
     }
 }
 
@@ -151,8 +177,9 @@ struct PP3BRAMInitPass : public Pass {
 
         extra_args(args, 1, design);
 
+        dict<std::string, InitImage> images;
         for (auto module : design->selected_modules())
-            run_pp3_braminit(module);
+            run_pp3_braminit(module, images);
     }
 } PP3BRAMInitPass;
 
@@ -0,0 +1,472 @@
+/*
+ * Copyright 2020-2022 F4PGA Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ */
+
+#include "kernel/sigtools.h"
+#include "kernel/yosys.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+#include <fcntl.h>
+#include <fstream>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+
+extern char **environ;
+
+USING_YOSYS_NAMESPACE
+PRIVATE_NAMESPACE_BEGIN
+
+struct QlAbcPartitionPass : public Pass {
+    QlAbcPartitionPass() : Pass("ql_abc_partition", "Map LUTs with ABC on independent partitions of the netlist") {}
+
+    void help() override
+    {
+        //   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
+        log("\n");
+        log("    ql_abc_partition [options] [selection]\n");
+        log("\n");
+        log("Maps the gate level logic of the selected modules to LUTs like 'abc -lut <k>'\n");
+        log("does, on several partitions at a time.\n");
+        log("\n");
+        log("The gates of a module are split into cones that only meet at registers, ports\n");
+        log("and other cells that ABC does not map, e.g. the carry chain cells. Cones are\n");
+        log("grouped into partitions of similar size and each partition is mapped by a\n");
+        log("separate yosys process running 'abc'. The netlist of Yosys cannot be shared\n");
+        log("between threads, so this is how the mapping runs on several cores. Logic\n");
+        log("is not optimized across partitions.\n");
+        log("\n");
+        log("    -lut <k>\n");
+        log("        Number of LUT inputs. Default: 6\n");
+        log("\n");
+        log("    -threads <N>\n");
+        log("        Number of ABC processes run at the same time. 0 (the default)\n");
+        log("        uses all cores.\n");
+        log("\n");
+        log("    -partitions <N>\n");
+        log("        Number of partitions per module. Default: the number of threads\n");
+        log("\n");
+        log("    -nocleanup\n");
+        log("        Keep the temporary directory with the partition netlists and logs.\n");
+        log("\n");
+        log("Modules that end up with a single partition are mapped by 'abc' in this\n");
+        log("process.\n");
+        log("\n");
+    }
+
+    // Cells that abc maps, everything else is a partition boundary
+    const pool<RTLIL::IdString> gate_types = {ID($_BUF_), ID($_NOT_),   ID($_AND_),  ID($_NAND_), ID($_OR_),   ID($_NOR_),  ID($_XOR_),  ID($_XNOR_),
+                                              ID($_ANDNOT_), ID($_ORNOT_), ID($_MUX_), ID($_NMUX_), ID($_AOI3_), ID($_OAI3_), ID($_AOI4_), ID($_OAI4_)};
+
+    struct Partition {
+        std::vector<RTLIL::Cell *> cells;
+        // Nets of the partition in the order of their wires \n<index> in
+        // the partition module, each one is a bit of the original module
+        std::vector<RTLIL::SigBit> nets;
+    };
+
+    int lut_size;
+    int num_threads;
+    int num_partitions;
+    bool cleanup;
+
+    // Removes the temporary directory of a module when it goes out of scope,
+    // also when a failing command throws with log_cmd_error
+    struct TempDir {
+        std::string path;
+        bool cleanup;
+
+        TempDir(const std::string &path, bool cleanup) : path(path), cleanup(cleanup) {}
+        ~TempDir() { remove(); }
+
+        void remove()
+        {
+            if (cleanup && !path.empty()) {
+                remove_directory(path);
+            }
+            path.clear();
+        }
+    };
+
+    // Runs yosys with the given arguments without a shell, output only goes
+    // to its log file. Returns the exit status, -1 if it could not be run.
+    // Safe to call from several threads.
+    static int run_yosys(const std::string &yosys_exe, const std::vector<std::string> &args)
+    {
+        std::vector<char *> argv;
+        argv.push_back(const_cast<char *>(yosys_exe.c_str()));
+        for (auto &arg : args) {
+            argv.push_back(const_cast<char *>(arg.c_str()));
+        }
+        argv.push_back(nullptr);
+
+        posix_spawn_file_actions_t actions;
+        posix_spawn_file_actions_init(&actions);
+        posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, "/dev/null", O_WRONLY, 0);
+        posix_spawn_file_actions_adddup2(&actions, STDOUT_FILENO, STDERR_FILENO);
+        pid_t pid;
+        int ret = posix_spawn(&pid, yosys_exe.c_str(), &actions, nullptr, argv.data(), environ);
+        posix_spawn_file_actions_destroy(&actions);
+        if (ret != 0) {
+            return -1;
+        }
+
+        int status;
+        while (waitpid(pid, &status, 0) < 0) {
+            if (errno != EINTR) {
+                return -1;
+            }
+        }
+        return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+    }
+
+    static int find_root(std::vector<int> &parent, int i)
+    {
+        while (parent[i] != i) {
+            parent[i] = parent[parent[i]];
+            i = parent[i];
+        }
+        return i;
+    }
+
+    // Splits the gates of the module into cones connected through gate to
+    // gate nets and distributes them over the partitions, largest first
+    std::vector<Partition> split(RTLIL::Module *module, const SigMap &sigmap)
+    {
+        std::vector<RTLIL::Cell *> gates;
+        for (auto cell : module->selected_cells()) {
+            if (gate_types.count(cell->type) && !cell->has_keep_attr()) {
+                gates.push_back(cell);
+            }
+        }
+
+        // Gate driving each net
+        dict<RTLIL::SigBit, int> drivers;
+        for (int i = 0; i < GetSize(gates); i++) {
+            for (auto &conn : gates[i]->connections()) {
+                if (gates[i]->output(conn.first)) {
+                    for (auto bit : sigmap(conn.second)) {
+                        if (bit.wire) {
+                            drivers[bit] = i;
+                        }
+                    }
+                }
+            }
+        }
+
+        // Cones
+        std::vector<int> parent(gates.size());
+        for (int i = 0; i < GetSize(gates); i++) {
+            parent[i] = i;
+        }
+        for (int i = 0; i < GetSize(gates); i++) {
+            for (auto &conn : gates[i]->connections()) {
+                if (!gates[i]->input(conn.first)) {
+                    continue;
+                }
+                for (auto bit : sigmap(conn.second)) {
+                    auto it = drivers.find(bit);
+                    if (it != drivers.end()) {
+                        parent[find_root(parent, i)] = find_root(parent, it->second);
+                    }
+                }
+            }
+        }
+        dict<int, std::vector<RTLIL::Cell *>> cones;
+        for (int i = 0; i < GetSize(gates); i++) {
+            cones[find_root(parent, i)].push_back(gates[i]);
+        }
+
+        std::vector<std::vector<RTLIL::Cell *> *> order;
+        for (auto &it : cones) {
+            order.push_back(&it.second);
+        }
+        std::stable_sort(order.begin(), order.end(), [](const std::vector<RTLIL::Cell *> *a, const std::vector<RTLIL::Cell *> *b) {
+            return a->size() > b->size() || (a->size() == b->size() && a->front()->name.str() < b->front()->name.str());
+        });
+
+        std::vector<Partition> partitions(std::min(num_partitions, GetSize(order)));
+        for (auto cone : order) {
+            auto smallest = std::min_element(partitions.begin(), partitions.end(),
+                                             [](const Partition &a, const Partition &b) { return a.cells.size() < b.cells.size(); });
+            smallest->cells.insert(smallest->cells.end(), cone->begin(), cone->end());
+        }
+        return partitions;
+    }
+
+    // Writes the cells of a partition to a module of their own. Nets driven
+    // outside of the partition become inputs, nets used outside of it become
+    // outputs.
+    void write_partition(Partition &partition, const SigMap &sigmap, const pool<RTLIL::SigBit> &used_outside, const std::string &file_name)
+    {
+        RTLIL::Design *part_design = new RTLIL::Design;
+        RTLIL::Module *part = part_design->addModule(ID(partition));
+
+        pool<RTLIL::SigBit> driven;
+        for (auto cell : partition.cells) {
+            for (auto &conn : cell->connections()) {
+                if (cell->output(conn.first)) {
+                    for (auto bit : sigmap(conn.second)) {
+                        driven.insert(bit);
+                    }
+                }
+            }
+        }
+
+        dict<RTLIL::SigBit, RTLIL::SigBit> local;
+        auto local_bit = [&](RTLIL::SigBit bit) {
+            bit = sigmap(bit);
+            if (!bit.wire) {
+                return bit;
+            }
+            auto it = local.find(bit);
+            if (it != local.end()) {
+                return it->second;
+            }
+            RTLIL::Wire *wire = part->addWire(stringf("\\n%d", GetSize(partition.nets)));
+            wire->port_input = !driven.count(bit);
+            wire->port_output = driven.count(bit) && used_outside.count(bit);
+            partition.nets.push_back(bit);
+            return local[bit] = RTLIL::SigBit(wire);
+        };
+
+        for (auto cell : partition.cells) {
+            RTLIL::Cell *copy = part->addCell(cell->name, cell->type);
+            copy->parameters = cell->parameters;
+            for (auto &conn : cell->connections()) {
+                RTLIL::SigSpec sig;
+                for (auto bit : conn.second) {
+                    sig.append(local_bit(bit));
+                }
+                copy->setPort(conn.first, sig);
+            }
+        }
+        part->fixup_ports();
+
+        Pass::call(part_design, std::vector<std::string>{"write_rtlil", file_name});
+        delete part_design;
+    }
+
+    // Replaces the cells of a partition with the mapped netlist, returns
+    // false if the file has none
+    bool read_partition(RTLIL::Module *module, const Partition &partition, const std::string &file_name)
+    {
+        RTLIL::Design *mapped_design = new RTLIL::Design;
+        Pass::call(mapped_design, std::vector<std::string>{"read_rtlil", file_name});
+        RTLIL::Module *mapped = mapped_design->module(ID(partition));
+        if (mapped == nullptr) {
+            delete mapped_design;
+            return false;
+        }
+
+        for (auto cell : partition.cells) {
+            module->remove(cell);
+        }
+
+        dict<RTLIL::Wire *, RTLIL::SigSpec> wires;
+        for (auto wire : mapped->wires()) {
+            if (wire->port_id) {
+                wires[wire] = partition.nets.at(atoi(wire->name.c_str() + 2));
+            } else {
+                wires[wire] = module->addWire(NEW_ID, wire->width);
+            }
+        }
+        auto remap = [&](const RTLIL::SigSpec &sig) {
+            RTLIL::SigSpec result;
+            for (auto bit : sig) {
+                result.append(bit.wire ? RTLIL::SigBit(wires.at(bit.wire)[bit.offset]) : bit);
+            }
+            return result;
+        };
+
+        for (auto cell : mapped->cells()) {
+            RTLIL::Cell *copy = module->addCell(NEW_ID, cell->type);
+            copy->parameters = cell->parameters;
+            for (auto &conn : cell->connections()) {
+                copy->setPort(conn.first, remap(conn.second));
+            }
+        }
+        for (auto &conn : mapped->connections()) {
+            module->connect(remap(conn.first), remap(conn.second));
+        }
+        delete mapped_design;
+        return true;
+    }
+
+    // Copies the log of a failed partition into this log, since the
+    // temporary directory is removed before the error unless -nocleanup
+    [[noreturn]] void fail_partition(TempDir &temp_dir, RTLIL::Module *module, int index, const char *what)
+    {
+        std::string log_name = stringf("%s/part%d.log", temp_dir.path.c_str(), index);
+        std::ifstream log_file(log_name);
+        std::string line;
+        while (std::getline(log_file, line)) {
+            log("  %s\n", line.c_str());
+        }
+        if (temp_dir.cleanup) {
+            temp_dir.remove();
+            log_cmd_error("%s partition %d of module %s failed.\n", what, index, log_id(module));
+        }
+        log_cmd_error("%s partition %d of module %s failed, see %s.\n", what, index, log_id(module), log_name.c_str());
+    }
+
+    void execute(std::vector<std::string> args, RTLIL::Design *design) override
+    {
+        log_header(design, "Executing QL_ABC_PARTITION pass.\n");
+
+        lut_size = 6;
+        num_threads = 0;
+        num_partitions = 0;
+        cleanup = true;
+
+        size_t argidx;
+        for (argidx = 1; argidx < args.size(); argidx++) {
+            if (args[argidx] == "-lut" && argidx + 1 < args.size()) {
+                lut_size = atoi(args[++argidx].c_str());
+                continue;
+            }
+            if (args[argidx] == "-threads" && argidx + 1 < args.size()) {
+                num_threads = atoi(args[++argidx].c_str());
+                continue;
+            }
+            if (args[argidx] == "-partitions" && argidx + 1 < args.size()) {
+                num_partitions = atoi(args[++argidx].c_str());
+                continue;
+            }
+            if (args[argidx] == "-nocleanup") {
+                cleanup = false;
+                continue;
+            }
+            break;
+        }
+        extra_args(args, argidx, design);
+
+        if (lut_size < 1) {
+            log_cmd_error("Invalid LUT size!\n");
+        }
+        if (num_threads < 0) {
+            log_cmd_error("Invalid number of threads!\n");
+        }
+        if (num_threads == 0) {
+            num_threads = std::max(1U, std::thread::hardware_concurrency());
+        }
+        if (num_partitions < 0) {
+            log_cmd_error("Invalid number of partitions!\n");
+        }
+        if (num_partitions == 0) {
+            num_partitions = num_threads;
+        }
+
+        std::string abc_cmd = stringf("abc -lut %d", lut_size);
+
+        // The partitions are mapped by the yosys executable running this pass
+        std::string yosys_exe = proc_self_dirname() + "yosys";
+        if (num_partitions > 1 && !check_file_exists(yosys_exe)) {
+            log_warning("Cannot find '%s', mapping each module with a single '%s'.\n", yosys_exe.c_str(), abc_cmd.c_str());
+            num_partitions = 1;
+        }
+
+        for (auto module : design->selected_modules()) {
+            if (module->has_processes_warn()) {
+                continue;
+            }
+
+            SigMap sigmap(module);
+            std::vector<Partition> partitions = split(module, sigmap);
+            if (partitions.size() <= 1) {
+                Pass::call_on_module(design, module, abc_cmd);
+                continue;
+            }
+
+            // Nets read by anything that is not a gate of a partition
+            pool<RTLIL::Cell *> gates;
+            for (auto &partition : partitions) {
+                gates.insert(partition.cells.begin(), partition.cells.end());
+            }
+            pool<RTLIL::SigBit> used_outside;
+            for (auto cell : module->cells()) {
+                if (gates.count(cell)) {
+                    continue;
+                }
+                for (auto &conn : cell->connections()) {
+                    if (!cell->output(conn.first) || cell->input(conn.first)) {
+                        for (auto bit : sigmap(conn.second)) {
+                            used_outside.insert(bit);
+                        }
+                    }
+                }
+            }
+            for (auto wire : module->wires()) {
+                if (wire->port_output || wire->get_bool_attribute(ID::keep)) {
+                    for (auto bit : sigmap(wire)) {
+                        used_outside.insert(bit);
+                    }
+                }
+            }
+
+            size_t largest = 0;
+            for (auto &partition : partitions) {
+                largest = std::max(largest, partition.cells.size());
+            }
+            log("Mapping %d gates of module %s in %d partitions, the largest has %d gates.\n", GetSize(gates), log_id(module), GetSize(partitions),
+                int(largest));
+
+            TempDir temp_dir(make_temp_dir(get_base_tmpdir() + "/yosys-ql-abc-XXXXXX"), cleanup);
+            std::vector<std::vector<std::string>> commands;
+            for (int i = 0; i < GetSize(partitions); i++) {
+                std::string prefix = stringf("%s/part%d", temp_dir.path.c_str(), i);
+                write_partition(partitions[i], sigmap, used_outside, prefix + ".il");
+                commands.push_back({"-q", "-l", prefix + ".log", "-p",
+                                    stringf("read_rtlil \"%s.il\"; %s; opt_clean; write_rtlil \"%s.mapped.il\"", prefix.c_str(), abc_cmd.c_str(),
+                                            prefix.c_str())});
+            }
+
+            // The workers only start processes, they do not touch the design
+            std::vector<int> status(commands.size());
+            std::atomic<size_t> next(0);
+            std::vector<std::thread> threads;
+            for (int i = 0; i < std::min(num_threads, GetSize(commands)); i++) {
+                threads.emplace_back([&]() {
+                    for (size_t j = next++; j < commands.size(); j = next++) {
+                        status[j] = run_yosys(yosys_exe, commands[j]);
+                    }
+                });
+            }
+            for (auto &thread : threads) {
+                thread.join();
+            }
+
+            for (int i = 0; i < GetSize(partitions); i++) {
+                if (status[i] != 0) {
+                    fail_partition(temp_dir, module, i, "Mapping");
+                }
+            }
+            for (int i = 0; i < GetSize(partitions); i++) {
+                if (!read_partition(module, partitions[i], stringf("%s/part%d.mapped.il", temp_dir.path.c_str(), i))) {
+                    fail_partition(temp_dir, module, i, "Reading the mapped netlist of");
+                }
+            }
+        }
+    }
+} QlAbcPartitionPass;
+
+PRIVATE_NAMESPACE_END
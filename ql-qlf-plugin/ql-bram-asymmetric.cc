@@ -4,10 +4,19 @@
 USING_YOSYS_NAMESPACE
 PRIVATE_NAMESPACE_BEGIN
 
-#include "pmgen/ql-bram-asymmetric-wider-read.h"
-#include "pmgen/ql-bram-asymmetric-wider-write.h"
+// Both patterns share one matcher so the module is indexed once
+#include "pmgen/ql-bram-asymmetric.h"
 
-void test_ql_bram_asymmetric_wider_read(ql_bram_asymmetric_wider_read_pm &pm)
+// Returns the wire if it belongs to the module, nullptr otherwise. Uses the
+// name index of the module instead of scanning all of its wires.
+static RTLIL::Wire *module_wire(RTLIL::Module *module, RTLIL::Wire *wire)
+{
+    if (wire == nullptr || module->wire(wire->name) != wire)
+        return nullptr;
+    return wire;
+}
+
+void test_ql_bram_asymmetric_wider_read(ql_bram_asymmetric_pm &pm)
 {
     auto mem = pm.st_ql_bram_asymmetric_wider_read.mem;
     auto mem_wr_addr = pm.st_ql_bram_asymmetric_wider_read.mem_wr_addr;
@@ -83,18 +92,11 @@ void test_ql_bram_asymmetric_wider_read(ql_bram_asymmetric_wider_read_pm &pm)
     RTLIL::Wire *rd_addr_w = nullptr;
     RTLIL::Wire *rd_data_w = nullptr;
 
-    for (auto wire : pm.module->wires_) {
-        if (wire.second == wr_en_cw)
-            wr_en_w = wire.second;
-        if (wire.second == wr_addr_cw)
-            wr_addr_w = wire.second;
-        if (wire.second == wr_data_cw)
-            wr_data_w = wire.second;
-        if (wire.second == rd_data_cw)
-            rd_data_w = wire.second;
-        if (wire.second == rd_addr_cw)
-            rd_addr_w = wire.second;
-    }
+    wr_en_w = module_wire(pm.module, wr_en_cw);
+    wr_addr_w = module_wire(pm.module, wr_addr_cw);
+    wr_data_w = module_wire(pm.module, wr_data_cw);
+    rd_data_w = module_wire(pm.module, rd_data_cw);
+    rd_addr_w = module_wire(pm.module, rd_addr_cw);
 
     if (!wr_en_w | !wr_addr_w | !wr_data_w | !rd_data_w | !rd_addr_w)
         log_error("Match between RAM input wires and memory cell ports not found\n");
@@ -160,14 +162,14 @@ void test_ql_bram_asymmetric_wider_read(ql_bram_asymmetric_wider_read_pm &pm)
     cell->setPort(RTLIL::escape_id("WR_EN"), RTLIL::SigSpec(wr_en_w));
 
     // Cleanup the module from unused cells
-    pm.module->remove(mem);
-    pm.module->remove(mux);
-    pm.module->remove(wr_en_shift);
-    pm.module->remove(wr_en_and);
-    pm.module->remove(wr_data_shift);
+    pm.autoremove(mem);
+    pm.autoremove(mux);
+    pm.autoremove(wr_en_shift);
+    pm.autoremove(wr_en_and);
+    pm.autoremove(wr_data_shift);
 }
 
-void test_ql_bram_asymmetric_wider_write(ql_bram_asymmetric_wider_write_pm &pm)
+void test_ql_bram_asymmetric_wider_write(ql_bram_asymmetric_pm &pm)
 {
     auto mem = pm.st_ql_bram_asymmetric_wider_write.mem;
     auto mem_wr_addr = pm.st_ql_bram_asymmetric_wider_write.mem_wr_addr;
@@ -269,20 +271,12 @@ void test_ql_bram_asymmetric_wider_write(ql_bram_asymmetric_wider_write_pm &pm)
     RTLIL::Wire *wr_addr_w = nullptr;
     RTLIL::Wire *wr_data_w = nullptr;
 
-    for (auto wire : pm.module->wires_) {
-        if (wire.second == rd_addr_wc)
-            rd_addr_w = wire.second;
-        if (wire.second == rd_data_wc)
-            rd_data_w = wire.second;
-        if (wire.second == rd_en_wc)
-            rd_en_w = wire.second;
-        if (wire.second == clk_wc)
-            rd_clk_w = wire.second;
-        if (wire.second == wr_addr_wc)
-            wr_addr_w = wire.second;
-        if (wire.second == wr_data_wc)
-            wr_data_w = wire.second;
-    }
+    rd_addr_w = module_wire(pm.module, rd_addr_wc);
+    rd_data_w = module_wire(pm.module, rd_data_wc);
+    rd_en_w = module_wire(pm.module, rd_en_wc);
+    rd_clk_w = module_wire(pm.module, clk_wc);
+    wr_addr_w = module_wire(pm.module, wr_addr_wc);
+    wr_data_w = module_wire(pm.module, wr_data_wc);
 
     if (!rd_addr_w | !rd_data_w | !rd_en_w | !rd_clk_w | !wr_addr_w | !wr_data_w)
         log_error("Match between RAM input wires and memory cell ports not found\n");
@@ -335,17 +329,17 @@ void test_ql_bram_asymmetric_wider_write(ql_bram_asymmetric_wider_write_pm &pm)
     cell->setPort(RTLIL::escape_id("RD_EN"), rd_en_s);
 
     // Cleanup the module from unused cells
-    pm.module->remove(mem);
-    pm.module->remove(rd_data_shift);
-    pm.module->remove(rd_data_ff);
-    pm.module->remove(wr_en_mux);
+    pm.autoremove(mem);
+    pm.autoremove(rd_data_shift);
+    pm.autoremove(rd_data_ff);
+    pm.autoremove(wr_en_mux);
     if (wr_addr_ff)
-        pm.module->remove(wr_addr_ff);
+        pm.autoremove(wr_addr_ff);
     // Check if detected $and is connected to RD_ADDR
     if ((rd_addr_and_a_wc != rd_addr_w) & (rd_addr_and_b_wc != rd_addr_w))
         log_error("This is not the $and cell we are looking for\n");
     else
-        pm.module->remove(rd_addr_and);
+        pm.autoremove(rd_addr_and);
 }
 
 struct QLBramAsymmetric : public Pass {
@@ -378,11 +372,10 @@ struct QLBramAsymmetric : public Pass {
 
         int found_cells;
         for (auto module : a_Design->selected_modules()) {
-            found_cells = ql_bram_asymmetric_wider_write_pm(module, module->selected_cells())
-                            .run_ql_bram_asymmetric_wider_write(test_ql_bram_asymmetric_wider_write);
+            ql_bram_asymmetric_pm pm(module, module->selected_cells());
+            found_cells = pm.run_ql_bram_asymmetric_wider_write(test_ql_bram_asymmetric_wider_write);
             log_debug("found %d cells matching for wider write port\n", found_cells);
-            found_cells = ql_bram_asymmetric_wider_read_pm(module, module->selected_cells())
-                            .run_ql_bram_asymmetric_wider_read(test_ql_bram_asymmetric_wider_read);
+            found_cells = pm.run_ql_bram_asymmetric_wider_read(test_ql_bram_asymmetric_wider_read);
             log_debug("found %d cells matching for wider read port\n", found_cells);
         }
     }
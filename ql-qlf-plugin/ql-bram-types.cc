@@ -0,0 +1,161 @@
+/*
+ * Copyright 2020-2022 F4PGA Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ */
+
+#include "kernel/yosys.h"
+
+USING_YOSYS_NAMESPACE
+PRIVATE_NAMESPACE_BEGIN
+
+struct QlBramTypesPass : public Pass {
+    QlBramTypesPass() : Pass("ql_bram_types", "Change TDP36K cells to the types of their configurations") {}
+
+    void help() override
+    {
+        //   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
+        log("\n");
+        log("    ql_bram_types [selection]\n");
+        log("\n");
+        log("Changes the type of each TDP36K cell to a specialized type for its configuration,\n");
+        log("e.g. TDP36K_BRAM_A_X36_B_X36_nonsplit or TDP36K_FIFO_SYNC_A1_X18_B1_X18_A2_X9_B2_X9_split.\n");
+        log("The configuration is read from the is_inferred, is_split, is_fifo and sync_fifo\n");
+        log("attributes and the port width attributes of the cell. Cells with an unsupported\n");
+        log("configuration are left unchanged.\n");
+        log("\n");
+    }
+
+    // Integer value of an attribute, string attributes are accepted if they
+    // hold a decimal number
+    static bool get_int_attribute(const RTLIL::Cell *cell, const RTLIL::IdString &name, int &value)
+    {
+        auto it = cell->attributes.find(name);
+        if (it == cell->attributes.end())
+            return false;
+        const RTLIL::Const &attr = it->second;
+        if ((attr.flags & RTLIL::CONST_FLAG_STRING) == 0) {
+            value = attr.as_int();
+            return true;
+        }
+        std::string str = attr.decode_string();
+        char *end;
+        long parsed = strtol(str.c_str(), &end, 10);
+        if (str.empty() || *end != '\0')
+            return false;
+        value = parsed;
+        return true;
+    }
+
+    static bool attribute_is(const RTLIL::Cell *cell, const RTLIL::IdString &name, int expected)
+    {
+        int value;
+        return get_int_attribute(cell, name, value) && value == expected;
+    }
+
+    // Values of the width attributes if all of them are present and supported
+    static bool get_widths(const RTLIL::Cell *cell, const std::vector<RTLIL::IdString> &names, bool split, std::vector<int> &widths)
+    {
+        static const pool<int> nonsplit_widths = {1, 2, 4, 9, 18, 36};
+        static const pool<int> split_widths = {1, 2, 4, 9, 18};
+        widths.clear();
+        for (auto &name : names) {
+            int width;
+            if (!get_int_attribute(cell, name, width) || !(split ? split_widths : nonsplit_widths).count(width))
+                return false;
+            widths.push_back(width);
+        }
+        return true;
+    }
+
+    static std::string nonsplit_type(const char *mode, const std::vector<int> &widths)
+    {
+        return stringf("TDP36K_%s_A_X%d_B_X%d_nonsplit", mode, widths[0], widths[1]);
+    }
+
+    static std::string split_type(const char *mode, const std::vector<int> &widths)
+    {
+        return stringf("TDP36K_%s_A1_X%d_B1_X%d_A2_X%d_B2_X%d_split", mode, widths[0], widths[1], widths[2], widths[3]);
+    }
+
+    static const char *fifo_mode(const RTLIL::Cell *cell)
+    {
+        if (!attribute_is(cell, ID(is_fifo), 1))
+            return nullptr;
+        if (attribute_is(cell, ID(sync_fifo), 0))
+            return "FIFO_ASYNC";
+        if (attribute_is(cell, ID(sync_fifo), 1))
+            return "FIFO_SYNC";
+        return nullptr;
+    }
+
+    // The specialized type of the cell, empty if there is none. The checks
+    // are done in the order of the chtype commands this pass replaces, the
+    // first matching configuration wins.
+    static std::string bram_type(const RTLIL::Cell *cell)
+    {
+        std::vector<int> widths;
+        if (attribute_is(cell, ID(is_inferred), 0)) {
+            if (get_widths(cell, {ID(port_a_dwidth), ID(port_b_dwidth)}, false, widths)) {
+                if (attribute_is(cell, ID(is_fifo), 0))
+                    return nonsplit_type("BRAM", widths);
+                if (const char *mode = fifo_mode(cell))
+                    return nonsplit_type(mode, widths);
+            }
+            if (attribute_is(cell, ID(is_split), 1) &&
+                get_widths(cell, {ID(port_a1_dwidth), ID(port_b1_dwidth), ID(port_a2_dwidth), ID(port_b2_dwidth)}, true, widths)) {
+                if (attribute_is(cell, ID(is_fifo), 0))
+                    return split_type("BRAM", widths);
+                if (const char *mode = fifo_mode(cell))
+                    return split_type(mode, widths);
+            }
+        } else if (attribute_is(cell, ID(is_inferred), 1)) {
+            if (get_widths(cell, {ID(port_a_width), ID(port_b_width)}, false, widths))
+                return nonsplit_type("BRAM", widths);
+            if (get_widths(cell, {ID(port_a1_width), ID(port_b1_width), ID(port_a2_width), ID(port_b2_width)}, true, widths))
+                return split_type("BRAM", widths);
+        }
+        return std::string();
+    }
+
+    void execute(std::vector<std::string> args, RTLIL::Design *design) override
+    {
+        log_header(design, "Executing QL_BRAM_TYPES pass.\n");
+
+        extra_args(args, 1, design);
+
+        // Cells of a configuration share the new type name
+        dict<std::string, RTLIL::IdString> type_ids;
+        int cnt = 0;
+        for (auto module : design->selected_modules()) {
+            for (auto cell : module->selected_cells()) {
+                if (cell->type != ID(TDP36K))
+                    continue;
+                std::string type = bram_type(cell);
+                if (type.empty())
+                    continue;
+                auto it = type_ids.find(type);
+                if (it == type_ids.end())
+                    it = type_ids.emplace(type, RTLIL::escape_id(type)).first;
+                cell->type = it->second;
+                cnt++;
+            }
+        }
+        log("Changed the type of %d TDP36K cells.\n", cnt);
+    }
+} QlBramTypesPass;
+
+PRIVATE_NAMESPACE_END
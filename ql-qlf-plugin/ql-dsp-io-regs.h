@@ -0,0 +1,206 @@
+/*
+ * Copyright 2020-2022 F4PGA Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#ifndef _QL_DSP_IO_REGS_H_
+#define _QL_DSP_IO_REGS_H_
+
+#include "kernel/rtlil.h"
+#include "kernel/sigtools.h"
+
+#include "ql-dsp-mode-bits.h"
+
+#include <stdint.h>
+#include <string>
+#include <utility>
+#include <vector>
+
+USING_YOSYS_NAMESPACE
+
+/// Configuration dependent types of the k6n10f QL_DSP2/QL_DSP3 cells, shared
+/// by ql_dsp_io_regs and ql_dsp_legalize
+namespace QlDspIORegs
+{
+
+// Returns a pair of mask and value describing constant bit connections of
+// a SigSpec
+inline std::pair<uint32_t, uint32_t> get_constant_mask_value(const RTLIL::SigSpec *sigspec, const SigMap &sigmap)
+{
+    uint32_t mask = 0L;
+    uint32_t value = 0L;
+
+    auto sigbits = sigspec->bits();
+    for (ssize_t i = (sigbits.size() - 1); i >= 0; --i) {
+        auto other = sigmap(sigbits[i]);
+
+        mask <<= 1;
+        value <<= 1;
+
+        // A known constant
+        if (!other.is_wire() && other.data != RTLIL::Sx) {
+            mask |= 0x1;
+            value |= (other.data == RTLIL::S1);
+        }
+    }
+
+    return std::make_pair(mask, value);
+}
+
+/// Changes the type of an inferred QL_DSP2/QL_DSP3 cell to the one matching
+/// its configuration, e.g. QL_DSP2_MULTACC_REGIN, and removes the ports that
+/// the configuration doesn't use. Other cells are left unchanged.
+inline void set_type(RTLIL::Cell *dsp, const SigMap &sigmap)
+{
+    static const std::vector<std::string> ports2del_mult = {"load_acc", "subtract", "acc_fir", "dly_b"};
+    static const std::vector<std::string> ports2del_mult_acc = {"acc_fir", "dly_b"};
+    static const std::vector<std::string> ports2del_mult_add = {"dly_b"};
+    static const std::vector<std::string> ports2del_extension = {"saturate_enable", "shift_right", "round"};
+
+    std::string cell_type = dsp->type.str();
+    if (cell_type != RTLIL::escape_id("QL_DSP2") && cell_type != RTLIL::escape_id("QL_DSP3")) {
+        return;
+    }
+
+    // If the cell does not have the "is_inferred" attribute set
+    // then don't touch it.
+    if (!dsp->has_attribute(RTLIL::escape_id("is_inferred")) || dsp->get_bool_attribute(RTLIL::escape_id("is_inferred")) == false) {
+        return;
+    }
+
+    bool del_clk = true;
+    bool use_dsp_cfg_params = (cell_type == RTLIL::escape_id("QL_DSP3"));
+
+    int reg_in_i;
+    int out_sel_i;
+
+    // Get DSP configuration
+    if (use_dsp_cfg_params) {
+        // Read MODE_BITS at correct indexes
+        const auto &mode_bits = dsp->getParam(ID(MODE_BITS));
+        if (GetSize(mode_bits) < QlDspModeBits::SIZE)
+            log_error("MODE_BITS of %s is too narrow!", log_id(dsp));
+        reg_in_i = QlDspModeBits::get(mode_bits, QlDspModeBits::REGISTER_INPUTS);
+        out_sel_i = QlDspModeBits::get(mode_bits, QlDspModeBits::OUTPUT_SELECT);
+    } else {
+        // Read dedicated configuration ports
+        const RTLIL::SigSpec *register_inputs;
+        register_inputs = &dsp->getPort(RTLIL::escape_id("register_inputs"));
+        if (!register_inputs)
+            log_error("register_inputs port not found!");
+        auto reg_in_c = register_inputs->as_const();
+        reg_in_i = reg_in_c.as_int();
+
+        const RTLIL::SigSpec *output_select;
+        output_select = &dsp->getPort(RTLIL::escape_id("output_select"));
+        if (!output_select)
+            log_error("output_select port not found!");
+        auto out_sel_c = output_select->as_const();
+        out_sel_i = out_sel_c.as_int();
+    }
+
+    // Get the feedback port
+    const RTLIL::SigSpec *feedback;
+    feedback = &dsp->getPort(RTLIL::escape_id("feedback"));
+    if (!feedback)
+        log_error("feedback port not found!");
+
+    // Check if feedback is or can be set to 0 which implies MACC
+    auto feedback_con = get_constant_mask_value(feedback, sigmap);
+    bool have_macc = (feedback_con.second == 0x0);
+
+    // Build new type name
+    std::string new_type = cell_type;
+    new_type += "_MULT";
+
+    if (have_macc) {
+        switch (out_sel_i) {
+        case 1:
+        case 2:
+        case 3:
+        case 5:
+        case 7:
+            del_clk = false;
+            new_type += "ACC";
+            break;
+        default:
+            break;
+        }
+    } else {
+        switch (out_sel_i) {
+        case 1:
+        case 2:
+        case 3:
+        case 5:
+        case 7:
+            new_type += "ADD";
+            break;
+        default:
+            break;
+        }
+    }
+
+    if (reg_in_i) {
+        del_clk = false;
+        new_type += "_REGIN";
+    }
+
+    if (out_sel_i > 3) {
+        del_clk = false;
+        new_type += "_REGOUT";
+    }
+
+    // Set new type name
+    dsp->type = RTLIL::IdString(new_type);
+
+    std::vector<std::string> ports2del;
+
+    if (del_clk)
+        ports2del.push_back("clk");
+
+    switch (out_sel_i) {
+    case 0:
+    case 4:
+    case 6:
+        ports2del.insert(ports2del.end(), ports2del_mult.begin(), ports2del_mult.end());
+        // Mark for deleton additional configuration ports
+        if (!use_dsp_cfg_params) {
+            ports2del.insert(ports2del.end(), ports2del_extension.begin(), ports2del_extension.end());
+        }
+        break;
+    case 1:
+    case 2:
+    case 3:
+    case 5:
+    case 7:
+        if (have_macc) {
+            ports2del.insert(ports2del.end(), ports2del_mult_acc.begin(), ports2del_mult_acc.end());
+        } else {
+            ports2del.insert(ports2del.end(), ports2del_mult_add.begin(), ports2del_mult_add.end());
+        }
+        break;
+    }
+
+    for (auto portname : ports2del) {
+        const RTLIL::SigSpec *port = &dsp->getPort(RTLIL::escape_id(portname));
+        if (!port)
+            log_error("%s port not found!", portname.c_str());
+        dsp->connections_.erase(RTLIL::escape_id(portname));
+    }
+}
+
+} // namespace QlDspIORegs
+
+#endif // _QL_DSP_IO_REGS_H_
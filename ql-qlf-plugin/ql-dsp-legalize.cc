@@ -0,0 +1,324 @@
+/*
+ * Copyright 2020-2022 F4PGA Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "kernel/log.h"
+#include "kernel/register.h"
+#include "kernel/rtlil.h"
+#include "kernel/sigtools.h"
+
+#include "ql-dsp-io-regs.h"
+#include "ql-dsp-mode-bits.h"
+
+USING_YOSYS_NAMESPACE
+PRIVATE_NAMESPACE_BEGIN
+
+// ============================================================================
+
+struct QlDspLegalizePass : public Pass {
+
+    QlDspLegalizePass() : Pass("ql_dsp_legalize", "Maps QuickLogic k6n10f multipliers to final QL_DSP2/QL_DSP3 cells") {}
+
+    void help() override
+    {
+        log("\n");
+        log("    ql_dsp_legalize [options] [selection]\n");
+        log("\n");
+        log("    This pass takes the $__QL_MUL20X18 and $__QL_MUL10X9 cells left by\n");
+        log("    mul2dsp and the dsp_t1_* cells inferred by ql_dsp_macc all the way\n");
+        log("    to the final QL_DSP2/QL_DSP3 cells. It is equivalent to running:\n");
+        log("\n");
+        log("        techmap -map +/quicklogic/qlf_k6n10f/dsp_map.v\n");
+        log("        ql_dsp_simd\n");
+        log("        techmap -map +/quicklogic/qlf_k6n10f/dsp_final_map.v\n");
+        log("        ql_dsp_io_regs\n");
+        log("\n");
+        log("    but the cells are rewritten in place, without elaborating the\n");
+        log("    techmap libraries.\n");
+        log("\n");
+        log("    -use_dsp_cfg_params\n");
+        log("        Map multipliers to DSP blocks with configuration bits available as\n");
+        log("        module parameters (QL_DSP3). By default the configuration bits are\n");
+        log("        available at module ports (QL_DSP2).\n");
+        log("\n");
+    }
+
+    // ..........................................
+
+    /// A port of a dsp_t1_* cell and the QL_DSP2/QL_DSP3 port it maps to
+    struct FinalPort {
+        RTLIL::IdString src;
+        RTLIL::IdString dst;
+        int width;      // Width of the QL_DSP2/QL_DSP3 port
+        int frac_width; // Width of the dsp_t1_10x9x32 port
+        bool is_output;
+    };
+
+    // Ports common to both final DSP types
+    const std::vector<FinalPort> m_FinalPorts = {
+      {ID(a_i), ID(a), 20, 10, false},
+      {ID(b_i), ID(b), 18, 9, false},
+      {ID(acc_fir_i), ID(acc_fir), 6, 6, false},
+      {ID(z_o), ID(z), 38, 19, true},
+      {ID(dly_b_o), ID(dly_b), 18, 9, true},
+
+      {ID(clock_i), ID(clk), 1, 1, false},
+      {ID(reset_i), ID(reset), 1, 1, false},
+
+      {ID(feedback_i), ID(feedback), 3, 3, false},
+      {ID(load_acc_i), ID(load_acc), 1, 1, false},
+      {ID(unsigned_a_i), ID(unsigned_a), 1, 1, false},
+      {ID(unsigned_b_i), ID(unsigned_b), 1, 1, false},
+      {ID(subtract_i), ID(subtract), 1, 1, false},
+    };
+
+    // Configuration ports, QL_DSP2 only
+    const std::vector<FinalPort> m_FinalCfgPorts = {
+      {ID(output_select_i), ID(output_select), 3, 3, false},
+      {ID(saturate_enable_i), ID(saturate_enable), 1, 1, false},
+      {ID(shift_right_i), ID(shift_right), 6, 6, false},
+      {ID(round_i), ID(round), 1, 1, false},
+      {ID(register_inputs_i), ID(register_inputs), 1, 1, false},
+    };
+
+    // Configuration parameters of dsp_t1_*_cfg_params and their MODE_BITS
+    // fields, QL_DSP3 only
+    const std::vector<std::pair<RTLIL::IdString, QlDspModeBits::Field>> m_FinalCfgParams = {
+      {ID(OUTPUT_SELECT), QlDspModeBits::OUTPUT_SELECT}, {ID(SATURATE_ENABLE), QlDspModeBits::SATURATE_ENABLE},
+      {ID(SHIFT_RIGHT), QlDspModeBits::SHIFT_RIGHT},     {ID(ROUND), QlDspModeBits::ROUND},
+      {ID(REGISTER_INPUTS), QlDspModeBits::REGISTER_INPUTS}};
+
+    // FIR coefficient parameters and their MODE_BITS fields
+    const std::vector<std::pair<RTLIL::IdString, QlDspModeBits::Field>> m_FinalCoeffParams = {
+      {ID(COEFF_0), QlDspModeBits::COEFF_0}, {ID(COEFF_1), QlDspModeBits::COEFF_1},
+      {ID(COEFF_2), QlDspModeBits::COEFF_2}, {ID(COEFF_3), QlDspModeBits::COEFF_3}};
+
+    /// Use QL_DSP3 with configuration parameters (-use_dsp_cfg_params)
+    bool m_UseCfgParams = false;
+
+    /// SigMap of the module being processed
+    SigMap m_SigMap;
+
+    // ..........................................
+
+    void clear_flags() override { m_UseCfgParams = false; }
+
+    void execute(std::vector<std::string> a_Args, RTLIL::Design *a_Design) override
+    {
+        log_header(a_Design, "Executing QL_DSP_LEGALIZE pass.\n");
+
+        size_t argidx;
+        for (argidx = 1; argidx < a_Args.size(); argidx++) {
+            if (a_Args[argidx] == "-use_dsp_cfg_params") {
+                m_UseCfgParams = true;
+                continue;
+            }
+            break;
+        }
+        extra_args(a_Args, argidx, a_Design);
+
+        for (auto module : a_Design->selected_modules()) {
+            // None of the steps below adds module level connections so
+            // a single SigMap serves all of them
+            m_SigMap.set(module);
+
+            size_t num_mults = 0;
+            for (auto cell : module->selected_cells()) {
+                num_mults += mapMultiplier(module, cell);
+            }
+
+            Pass::call_on_module(a_Design, module, "ql_dsp_simd");
+
+            size_t num_dsps = 0;
+            for (auto cell : module->selected_cells()) {
+                num_dsps += mapFinal(module, cell);
+            }
+
+            for (auto cell : module->selected_cells()) {
+                QlDspIORegs::set_type(cell, m_SigMap);
+            }
+
+            log("Module %s: %zu multiplier(s) mapped to DSP, %zu final DSP cell(s).\n", log_id(module), num_mults, num_dsps);
+        }
+
+        m_SigMap.clear();
+    }
+
+    // ..........................................
+
+    /// Maps a $__QL_MUL20X18 or $__QL_MUL10X9 cell to a dsp_t1_* cell, as
+    /// qlf_k6n10f/dsp_map.v does. Returns false for other cells.
+    bool mapMultiplier(RTLIL::Module *a_Module, RTLIL::Cell *a_Cell)
+    {
+        int a_width, b_width, z_width;
+        std::string type;
+        if (a_Cell->type == ID($__QL_MUL20X18)) {
+            a_width = 20;
+            b_width = 18;
+            z_width = 38;
+            type = "dsp_t1_20x18x64";
+        } else if (a_Cell->type == ID($__QL_MUL10X9)) {
+            a_width = 10;
+            b_width = 9;
+            z_width = 19;
+            type = "dsp_t1_10x9x32";
+        } else {
+            return false;
+        }
+        type += m_UseCfgParams ? "_cfg_params" : "_cfg_ports";
+
+        bool a_signed = a_Cell->getParam(ID(A_SIGNED)).as_bool();
+        bool b_signed = a_Cell->getParam(ID(B_SIGNED)).as_bool();
+
+        // Sign extend / pad inputs with zeros, pad the output
+        RTLIL::SigSpec sig_a = a_Cell->getPort(ID(A));
+        RTLIL::SigSpec sig_b = a_Cell->getPort(ID(B));
+        RTLIL::SigSpec sig_z = a_Cell->getPort(ID(Y));
+        log_assert(GetSize(sig_a) <= a_width && GetSize(sig_b) <= b_width && GetSize(sig_z) <= z_width);
+
+        sig_a.extend_u0(a_width, a_signed);
+        sig_b.extend_u0(b_width, b_signed);
+        if (GetSize(sig_z) < z_width) {
+            sig_z.append(a_Module->addWire(NEW_ID, z_width - GetSize(sig_z)));
+        }
+
+        a_Cell->unsetPort(ID(A));
+        a_Cell->unsetPort(ID(B));
+        a_Cell->unsetPort(ID(Y));
+        a_Cell->parameters.clear();
+        a_Cell->type = RTLIL::escape_id(type);
+        a_Cell->set_bool_attribute(ID(is_inferred), true);
+
+        a_Cell->setPort(ID(a_i), sig_a);
+        a_Cell->setPort(ID(b_i), sig_b);
+        a_Cell->setPort(ID(acc_fir_i), RTLIL::SigSpec(RTLIL::S0, 6));
+        a_Cell->setPort(ID(z_o), sig_z);
+
+        a_Cell->setPort(ID(feedback_i), RTLIL::SigSpec(RTLIL::S0, 3));
+        a_Cell->setPort(ID(load_acc_i), RTLIL::SigSpec(RTLIL::S0));
+        a_Cell->setPort(ID(unsigned_a_i), RTLIL::SigSpec(a_signed ? RTLIL::S0 : RTLIL::S1));
+        a_Cell->setPort(ID(unsigned_b_i), RTLIL::SigSpec(b_signed ? RTLIL::S0 : RTLIL::S1));
+        a_Cell->setPort(ID(subtract_i), RTLIL::SigSpec(RTLIL::S0));
+
+        if (m_UseCfgParams) {
+            a_Cell->setParam(ID(OUTPUT_SELECT), RTLIL::Const(RTLIL::S0, 3));
+            a_Cell->setParam(ID(SATURATE_ENABLE), RTLIL::Const(RTLIL::S0));
+            a_Cell->setParam(ID(SHIFT_RIGHT), RTLIL::Const(RTLIL::S0, 6));
+            a_Cell->setParam(ID(ROUND), RTLIL::Const(RTLIL::S0));
+            a_Cell->setParam(ID(REGISTER_INPUTS), RTLIL::Const(RTLIL::S0));
+        } else {
+            a_Cell->setPort(ID(output_select_i), RTLIL::SigSpec(RTLIL::S0, 3));
+            a_Cell->setPort(ID(saturate_enable_i), RTLIL::SigSpec(RTLIL::S0));
+            a_Cell->setPort(ID(shift_right_i), RTLIL::SigSpec(RTLIL::S0, 6));
+            a_Cell->setPort(ID(round_i), RTLIL::SigSpec(RTLIL::S0));
+            a_Cell->setPort(ID(register_inputs_i), RTLIL::SigSpec(RTLIL::S0));
+        }
+
+        return true;
+    }
+
+    /// Returns a parameter of a dsp_t1_* cell, parameters that are not set
+    /// take the zero default of the techmap library
+    static RTLIL::Const getFinalParam(const RTLIL::Cell *a_Cell, const RTLIL::IdString &a_Name, int a_Width)
+    {
+        if (a_Cell->hasParam(a_Name)) {
+            return a_Cell->getParam(a_Name);
+        }
+        return RTLIL::Const(RTLIL::S0, a_Width);
+    }
+
+    /// Maps a dsp_t1_* cell left over by ql_dsp_simd to a QL_DSP2 or QL_DSP3
+    /// cell, as qlf_k6n10f/dsp_final_map.v does. Returns false for other
+    /// cells.
+    bool mapFinal(RTLIL::Module *a_Module, RTLIL::Cell *a_Cell)
+    {
+        bool fractured;
+        if (a_Cell->type.in(ID(dsp_t1_20x18x64_cfg_ports), ID(dsp_t1_20x18x64_cfg_params))) {
+            fractured = false;
+        } else if (a_Cell->type.in(ID(dsp_t1_10x9x32_cfg_ports), ID(dsp_t1_10x9x32_cfg_params))) {
+            fractured = true;
+        } else {
+            return false;
+        }
+        bool use_cfg_params = a_Cell->type.in(ID(dsp_t1_20x18x64_cfg_params), ID(dsp_t1_10x9x32_cfg_params));
+
+        // Build the new connections. Ports left unconnected get fresh wires
+        // like techmap would give them, the upper halves of the fractured
+        // data inputs are tied to zero.
+        dict<RTLIL::IdString, RTLIL::SigSpec> connections;
+        auto mapPorts = [&](const std::vector<FinalPort> &a_Ports) {
+            for (const auto &port : a_Ports) {
+                int src_width = fractured ? port.frac_width : port.width;
+                auto it = a_Cell->connections_.find(port.src);
+                RTLIL::SigSpec sig = (it != a_Cell->connections_.end()) ? it->second : RTLIL::SigSpec(a_Module->addWire(NEW_ID, src_width));
+                if (GetSize(sig) > src_width) {
+                    sig = sig.extract(0, src_width);
+                }
+                if (port.is_output) {
+                    if (GetSize(sig) < port.width) {
+                        sig.append(a_Module->addWire(NEW_ID, port.width - GetSize(sig)));
+                    }
+                } else {
+                    sig.extend_u0(src_width, false);
+                    sig.extend_u0(port.width, false);
+                }
+                connections[port.dst] = sig;
+            }
+        };
+        mapPorts(m_FinalPorts);
+        if (!use_cfg_params) {
+            mapPorts(m_FinalCfgPorts);
+            connections[ID(f_mode)] = RTLIL::SigSpec(fractured ? RTLIL::S1 : RTLIL::S0);
+        }
+
+        // Assemble MODE_BITS, a fractured DSP uses the lower half of each
+        // coefficient field
+        std::vector<RTLIL::State> mode_bits(use_cfg_params ? QlDspModeBits::SIZE : QlDspModeBits::BASE_SIZE, RTLIL::S0);
+        for (const auto &it : m_FinalCoeffParams) {
+            QlDspModeBits::Field field = it.second;
+            if (fractured) {
+                field.width /= 2;
+            }
+            QlDspModeBits::set(mode_bits, field, getFinalParam(a_Cell, it.first, field.width));
+        }
+        if (use_cfg_params) {
+            QlDspModeBits::set(mode_bits, QlDspModeBits::F_MODE, fractured ? 1u : 0u);
+            for (const auto &it : m_FinalCfgParams) {
+                QlDspModeBits::set(mode_bits, it.second, getFinalParam(a_Cell, it.first, it.second.width));
+            }
+        }
+
+        std::vector<RTLIL::IdString> old_ports;
+        for (const auto &it : a_Cell->connections_) {
+            old_ports.push_back(it.first);
+        }
+        for (const auto &port : old_ports) {
+            a_Cell->unsetPort(port);
+        }
+        a_Cell->parameters.clear();
+        a_Cell->type = use_cfg_params ? ID(QL_DSP3) : ID(QL_DSP2);
+        a_Cell->setParam(ID(MODE_BITS), RTLIL::Const(std::move(mode_bits)));
+        for (const auto &it : connections) {
+            a_Cell->setPort(it.first, it.second);
+        }
+
+        return true;
+    }
+
+} QlDspLegalizePass;
+
+PRIVATE_NAMESPACE_END
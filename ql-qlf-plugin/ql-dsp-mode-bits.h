@@ -0,0 +1,91 @@
+/*
+ * Copyright 2020-2022 F4PGA Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#ifndef _QL_DSP_MODE_BITS_H_
+#define _QL_DSP_MODE_BITS_H_
+
+#include "kernel/rtlil.h"
+
+#include <algorithm>
+#include <stdint.h>
+#include <vector>
+
+USING_YOSYS_NAMESPACE
+
+/// Layout of the MODE_BITS parameter of the k6n10f QL_DSP2 and QL_DSP3
+/// cells, see the QL_DSP3 model in qlf_k6n10f/dsp_sim.v. QL_DSP2 only has
+/// the coefficients, QL_DSP3 carries the whole configuration.
+namespace QlDspModeBits
+{
+
+struct Field {
+    int offset;
+    int width;
+};
+
+constexpr Field COEFF_0 = {0, 20};
+constexpr Field COEFF_1 = {20, 20};
+constexpr Field COEFF_2 = {40, 20};
+constexpr Field COEFF_3 = {60, 20};
+constexpr Field F_MODE = {80, 1};
+constexpr Field OUTPUT_SELECT = {81, 3};
+constexpr Field SATURATE_ENABLE = {84, 1};
+constexpr Field SHIFT_RIGHT = {85, 6};
+constexpr Field ROUND = {91, 1};
+constexpr Field REGISTER_INPUTS = {92, 1};
+
+/// MODE_BITS width of QL_DSP2
+constexpr int BASE_SIZE = F_MODE.offset;
+/// MODE_BITS width of QL_DSP3
+constexpr int SIZE = REGISTER_INPUTS.offset + REGISTER_INPUTS.width;
+
+static_assert(COEFF_3.offset + COEFF_3.width == BASE_SIZE, "coefficients must fill the QL_DSP2 MODE_BITS");
+static_assert(ROUND.offset + ROUND.width == REGISTER_INPUTS.offset, "fields must be contiguous");
+
+/// Reads a field as an unsigned integer. Bits other than 1 read as 0.
+inline uint32_t get(const RTLIL::Const &a_Bits, Field a_Field)
+{
+    log_assert(a_Field.width <= 32 && a_Field.offset + a_Field.width <= GetSize(a_Bits.bits));
+    uint32_t value = 0;
+    for (int i = a_Field.width - 1; i >= 0; --i) {
+        value = (value << 1) | (a_Bits.bits[a_Field.offset + i] == RTLIL::S1);
+    }
+    return value;
+}
+
+/// Writes the low bits of an unsigned integer into a field
+inline void set(std::vector<RTLIL::State> &a_Bits, Field a_Field, uint32_t a_Value)
+{
+    log_assert(a_Field.width <= 32 && a_Field.offset + a_Field.width <= GetSize(a_Bits));
+    for (int i = 0; i < a_Field.width; ++i) {
+        a_Bits[a_Field.offset + i] = ((a_Value >> i) & 1) ? RTLIL::S1 : RTLIL::S0;
+    }
+}
+
+/// Copies a parameter value into a field. A narrower value is zero
+/// extended and a wider one truncated, as the techmap libraries do when
+/// they pass it on as a parameter of the field width.
+inline void set(std::vector<RTLIL::State> &a_Bits, Field a_Field, const RTLIL::Const &a_Value)
+{
+    log_assert(a_Field.offset + a_Field.width <= GetSize(a_Bits));
+    RTLIL::Const value = a_Value.extract(0, a_Field.width);
+    std::copy(value.bits.begin(), value.bits.end(), a_Bits.begin() + a_Field.offset);
+}
+
+} // namespace QlDspModeBits
+
+#endif // _QL_DSP_MODE_BITS_H_
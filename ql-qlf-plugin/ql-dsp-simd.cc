@@ -21,12 +21,12 @@
 #include "kernel/rtlil.h"
 #include "kernel/sigtools.h"
 
+#include "../common/cell_pairing.h"
+#include "ql-dsp-mode-bits.h"
+
 USING_YOSYS_NAMESPACE
 PRIVATE_NAMESPACE_BEGIN
 
-#define MODE_BITS_BASE_SIZE 80
-#define MODE_BITS_EXTENSION_SIZE 13
-
 // ============================================================================
 
 struct QlDspSimdPass : public Pass {
@@ -36,11 +36,17 @@ struct QlDspSimdPass : public Pass {
     void help() override
     {
         log("\n");
-        log("    ql_dsp_simd [selection]\n");
+        log("    ql_dsp_simd [options] [selection]\n");
         log("\n");
         log("    This pass identifies k6n10f DSP cells with identical configuration\n");
         log("    and packs pairs of them together into other DSP cells that can\n");
         log("    perform SIMD operation.\n");
+        log("\n");
+        log("    -cluster\n");
+        log("        Pair DSP cells from the same part of the design: cells with the\n");
+        log("        same hierarchy prefix are paired first, preferring cells that\n");
+        log("        share a data input net. Cells of a pair always share their clock\n");
+        log("        and control nets. By default cells are paired in module order.\n");
     }
 
     // ..........................................
@@ -71,31 +77,46 @@ struct QlDspSimdPass : public Pass {
 
     // DSP control and config ports to consider and how to map them to ports
     // of the target DSP cell
-    const std::vector<std::pair<std::string, std::string>> m_DspCfgPorts = {std::make_pair("clock_i", "clk"),
-                                                                            std::make_pair("reset_i", "reset"),
+    const CellPortMap m_DspCfgPorts = makeCellPortMap({{"clock_i", "clk"},
+                                                       {"reset_i", "reset"},
 
-                                                                            std::make_pair("feedback_i", "feedback"),
-                                                                            std::make_pair("load_acc_i", "load_acc"),
-                                                                            std::make_pair("unsigned_a_i", "unsigned_a"),
-                                                                            std::make_pair("unsigned_b_i", "unsigned_b"),
+                                                       {"feedback_i", "feedback"},
+                                                       {"load_acc_i", "load_acc"},
+                                                       {"unsigned_a_i", "unsigned_a"},
+                                                       {"unsigned_b_i", "unsigned_b"},
 
-                                                                            std::make_pair("subtract_i", "subtract")};
+                                                       {"subtract_i", "subtract"}});
     // For QL_DSP2 expand with configuration ports
-    const std::vector<std::pair<std::string, std::string>> m_DspCfgPorts_expand = {
-      std::make_pair("output_select_i", "output_select"), std::make_pair("saturate_enable_i", "saturate_enable"),
-      std::make_pair("shift_right_i", "shift_right"), std::make_pair("round_i", "round"), std::make_pair("register_inputs_i", "register_inputs")};
-
-    // For QL_DSP3 use parameters instead
-    const std::vector<std::string> m_DspParams2Mode = {"OUTPUT_SELECT", "SATURATE_ENABLE", "SHIFT_RIGHT", "ROUND", "REGISTER_INPUTS"};
+    const CellPortMap m_DspCfgPorts_expand = makeCellPortMap({{"output_select_i", "output_select"},
+                                                              {"saturate_enable_i", "saturate_enable"},
+                                                              {"shift_right_i", "shift_right"},
+                                                              {"round_i", "round"},
+                                                              {"register_inputs_i", "register_inputs"}});
+    // Both of the above, for QL_DSP2
+    const CellPortMap m_DspCfgPorts_all = concatPortMaps(m_DspCfgPorts, m_DspCfgPorts_expand);
+
+    // For QL_DSP3 use parameters instead, stored in these MODE_BITS fields
+    const std::vector<std::pair<RTLIL::IdString, QlDspModeBits::Field>> m_DspParams2Mode = {
+      {ID(OUTPUT_SELECT), QlDspModeBits::OUTPUT_SELECT}, {ID(SATURATE_ENABLE), QlDspModeBits::SATURATE_ENABLE},
+      {ID(SHIFT_RIGHT), QlDspModeBits::SHIFT_RIGHT},     {ID(ROUND), QlDspModeBits::ROUND},
+      {ID(REGISTER_INPUTS), QlDspModeBits::REGISTER_INPUTS}};
 
     // DSP data ports and how to map them to ports of the target DSP cell
-    const std::vector<std::pair<std::string, std::string>> m_DspDataPorts = {
-      std::make_pair("a_i", "a"), std::make_pair("b_i", "b"),         std::make_pair("acc_fir_i", "acc_fir"),
-      std::make_pair("z_o", "z"), std::make_pair("dly_b_o", "dly_b"),
-    };
-
-    // DSP parameters
-    const std::vector<std::string> m_DspParams = {"COEFF_3", "COEFF_2", "COEFF_1", "COEFF_0"};
+    const CellPortMap m_DspDataPorts = makeCellPortMap({
+      {"a_i", "a"},
+      {"b_i", "b"},
+      {"acc_fir_i", "acc_fir"},
+      {"z_o", "z"},
+      {"dly_b_o", "dly_b"},
+    });
+
+    // DSP parameters and the MODE_BITS fields they go to. The order is
+    // reversed on purpose: the pass has always stored COEFF_3 of the
+    // fragments in the lowest field and COEFF_0 in the highest one, and the
+    // fields are listed here so that the MODE_BITS it produces stay the same.
+    const std::vector<RTLIL::IdString> m_DspParams = {ID(COEFF_3), ID(COEFF_2), ID(COEFF_1), ID(COEFF_0)};
+    const std::vector<QlDspModeBits::Field> m_DspCoeffFields = {QlDspModeBits::COEFF_0, QlDspModeBits::COEFF_1, QlDspModeBits::COEFF_2,
+                                                                QlDspModeBits::COEFF_3};
 
     // Source DSP cell type (SISD)
     const std::string m_SisdDspType = "dsp_t1_10x9x32";
@@ -103,20 +124,105 @@ struct QlDspSimdPass : public Pass {
     const std::string m_SisdDspType_cfg_params_suffix = "_cfg_params";
 
     // Target DSP cell types for the SIMD mode
-    const std::string m_SimdDspType_cfg_ports = "QL_DSP2";
-    const std::string m_SimdDspType_cfg_params = "QL_DSP3";
+    const RTLIL::IdString m_SimdDspType_cfg_ports = ID(QL_DSP2);
+    const RTLIL::IdString m_SimdDspType_cfg_params = ID(QL_DSP3);
 
     /// Temporary SigBit to SigBit helper map.
     SigMap m_SigMap;
 
+    /// Pair cells by affinity (-cluster)
+    bool m_Cluster = false;
+
     // ..........................................
 
+    static CellPortMap concatPortMaps(const CellPortMap &a_First, const CellPortMap &a_Second)
+    {
+        CellPortMap map = a_First;
+        map.insert(map.end(), a_Second.begin(), a_Second.end());
+        return map;
+    }
+
+    void map_pair(const DspConfig &config, const RTLIL::Cell *dsp_a, const RTLIL::Cell *dsp_b, int index, RTLIL::Module *module)
+    {
+        bool use_cfg_params = config.use_cfg_params;
+
+        std::string name = stringf("simd%d", index);
+        const RTLIL::IdString &SimdDspType = use_cfg_params ? m_SimdDspType_cfg_params : m_SimdDspType_cfg_ports;
+
+        log(" SIMD: %s (%s) + %s (%s) => %s (%s)\n", RTLIL::unescape_id(dsp_a->name).c_str(), RTLIL::unescape_id(dsp_a->type).c_str(),
+            RTLIL::unescape_id(dsp_b->name).c_str(), RTLIL::unescape_id(dsp_b->type).c_str(), RTLIL::unescape_id(name).c_str(),
+            RTLIL::unescape_id(SimdDspType).c_str());
+
+        // Create the new cell
+        RTLIL::Cell *simd = module->addCell(RTLIL::escape_id(name), SimdDspType);
+
+        // Check if the target cell is known (important to know
+        // its port widths)
+        if (!simd->known()) {
+            log_error(" The target cell type '%s' is not known!", RTLIL::unescape_id(SimdDspType).c_str());
+        }
+
+        // Connect common ports
+        for (const auto &it : use_cfg_params ? m_DspCfgPorts : m_DspCfgPorts_all) {
+            simd->setPort(it.second, config.connections.at(it.first));
+        }
+
+        // Connect data ports
+        connectCellParts(m_DspDataPorts, simd, {dsp_a, dsp_b}, 2);
+
+        // Concatenate FIR coefficient parameters into the single
+        // MODE_BITS parameter, each coefficient field holds the values of
+        // both fragments
+        std::vector<RTLIL::State> mode_bits(use_cfg_params ? QlDspModeBits::SIZE : QlDspModeBits::BASE_SIZE, RTLIL::S0);
+        for (size_t i = 0; i < m_DspCoeffFields.size(); ++i) {
+            const auto &field = m_DspCoeffFields[i];
+            const auto &val_a = dsp_a->getParam(m_DspParams[i]);
+            const auto &val_b = dsp_b->getParam(m_DspParams[i]);
+            log_assert(GetSize(val_a) == field.width / 2 && GetSize(val_b) == field.width / 2);
+
+            QlDspModeBits::set(mode_bits, {field.offset, field.width / 2}, val_a);
+            QlDspModeBits::set(mode_bits, {field.offset + field.width / 2, field.width / 2}, val_b);
+        }
+        if (use_cfg_params) {
+            // Add additional config parameters if necessary
+            QlDspModeBits::set(mode_bits, QlDspModeBits::F_MODE, 1u); // Enable fractured mode
+            for (const auto &it : m_DspParams2Mode) {
+                const auto &param = dsp_a->getParam(it.first);
+                log_assert(param == dsp_b->getParam(it.first));
+                QlDspModeBits::set(mode_bits, it.second, param);
+            }
+        } else {
+            // Enable the fractured mode by connecting the control
+            // port.
+            simd->setPort(ID(f_mode), RTLIL::S1);
+        }
+        simd->setParam(ID(MODE_BITS), RTLIL::Const(std::move(mode_bits)));
+
+        // Handle the "is_inferred" attribute. If one of the fragments
+        // is not inferred mark the whole DSP as not inferred
+        bool is_inferred_a = dsp_a->get_bool_attribute(ID(is_inferred));
+        bool is_inferred_b = dsp_b->get_bool_attribute(ID(is_inferred));
+
+        simd->set_bool_attribute(ID(is_inferred), is_inferred_a && is_inferred_b);
+    }
+
     void execute(std::vector<std::string> a_Args, RTLIL::Design *a_Design) override
     {
         log_header(a_Design, "Executing QL_DSP_SIMD pass.\n");
 
         // Parse args
-        extra_args(a_Args, 1, a_Design);
+        m_Cluster = false;
+        size_t argidx;
+        for (argidx = 1; argidx < a_Args.size(); argidx++) {
+            if (a_Args[argidx] == "-cluster") {
+                m_Cluster = true;
+                continue;
+            }
+            break;
+        }
+        extra_args(a_Args, argidx, a_Design);
+
+        const std::string sisdDspType = RTLIL::escape_id(m_SisdDspType);
 
         // Process modules
         for (auto module : a_Design->selected_modules()) {
@@ -126,11 +232,11 @@ struct QlDspSimdPass : public Pass {
             m_SigMap.set(module);
 
             // Assemble DSP cell groups
-            dict<DspConfig, std::vector<RTLIL::Cell *>> groups;
+            CellPairGroups<DspConfig> groups;
             for (auto cell : module->selected_cells()) {
 
                 // Check if this is a DSP cell we are looking for (type starts with m_SisdDspType)
-                if (strncmp(cell->type.c_str(), RTLIL::escape_id(m_SisdDspType).c_str(), RTLIL::escape_id(m_SisdDspType).size()) != 0) {
+                if (strncmp(cell->type.c_str(), sisdDspType.c_str(), sisdDspType.size()) != 0) {
                     continue;
                 }
 
@@ -140,146 +246,17 @@ struct QlDspSimdPass : public Pass {
                 }
 
                 // Add to a group
-                const auto key = getDspConfig(cell);
-                groups[key].push_back(cell);
+                groups.add(getDspConfig(cell), cell);
             }
 
-            std::vector<const RTLIL::Cell *> cellsToRemove;
-
-            // Map cell pairs to the target DSP SIMD cell
-            for (const auto &it : groups) {
-                const auto &group = it.second;
-                const auto &config = it.first;
-
-                bool use_cfg_params = config.use_cfg_params;
-                // Ensure an even number
-                size_t count = group.size();
-                if (count & 1)
-                    count--;
-
-                // Map SIMD pairs
-                for (size_t i = 0; i < count; i += 2) {
-                    const RTLIL::Cell *dsp_a = group[i];
-                    const RTLIL::Cell *dsp_b = group[i + 1];
-
-                    std::string name = stringf("simd%ld", i / 2);
-                    std::string SimdDspType;
-
-                    if (use_cfg_params)
-                        SimdDspType = m_SimdDspType_cfg_params;
-                    else
-                        SimdDspType = m_SimdDspType_cfg_ports;
-
-                    log(" SIMD: %s (%s) + %s (%s) => %s (%s)\n", RTLIL::unescape_id(dsp_a->name).c_str(), RTLIL::unescape_id(dsp_a->type).c_str(),
-                        RTLIL::unescape_id(dsp_b->name).c_str(), RTLIL::unescape_id(dsp_b->type).c_str(), RTLIL::unescape_id(name).c_str(),
-                        SimdDspType.c_str());
-
-                    // Create the new cell
-                    RTLIL::Cell *simd = module->addCell(RTLIL::escape_id(name), RTLIL::escape_id(SimdDspType));
-
-                    // Check if the target cell is known (important to know
-                    // its port widths)
-                    if (!simd->known()) {
-                        log_error(" The target cell type '%s' is not known!", SimdDspType.c_str());
-                    }
-
-                    std::vector<std::pair<std::string, std::string>> DspCfgPorts = m_DspCfgPorts;
-                    if (!use_cfg_params)
-                        DspCfgPorts.insert(DspCfgPorts.end(), m_DspCfgPorts_expand.begin(), m_DspCfgPorts_expand.end());
-
-                    // Connect common ports
-                    for (const auto &it : DspCfgPorts) {
-                        auto sport = RTLIL::escape_id(it.first);
-                        auto dport = RTLIL::escape_id(it.second);
-
-                        simd->setPort(dport, config.connections.at(sport));
-                    }
-
-                    // Connect data ports
-                    for (const auto &it : m_DspDataPorts) {
-                        auto sport = RTLIL::escape_id(it.first);
-                        auto dport = RTLIL::escape_id(it.second);
-
-                        size_t width;
-                        bool isOutput;
-
-                        std::tie(width, isOutput) = getPortInfo(simd, dport);
-
-                        auto getConnection = [&](const RTLIL::Cell *cell) {
-                            RTLIL::SigSpec sigspec;
-                            if (cell->hasPort(sport)) {
-                                const auto &sig = cell->getPort(sport);
-                                sigspec.append(sig);
-                            }
-                            if (sigspec.bits().size() < width / 2) {
-                                if (isOutput) {
-                                    for (size_t i = 0; i < width / 2 - sigspec.bits().size(); ++i) {
-                                        sigspec.append(RTLIL::SigSpec());
-                                    }
-                                } else {
-                                    sigspec.append(RTLIL::SigSpec(RTLIL::Sx, width / 2 - sigspec.bits().size()));
-                                }
-                            }
-                            return sigspec;
-                        };
-
-                        RTLIL::SigSpec sigspec;
-                        sigspec.append(getConnection(dsp_a));
-                        sigspec.append(getConnection(dsp_b));
-                        simd->setPort(dport, sigspec);
-                    }
-
-                    // Concatenate FIR coefficient parameters into the single
-                    // MODE_BITS parameter
-                    std::vector<RTLIL::State> mode_bits;
-                    for (const auto &it : m_DspParams) {
-                        auto val_a = dsp_a->getParam(RTLIL::escape_id(it));
-                        auto val_b = dsp_b->getParam(RTLIL::escape_id(it));
-
-                        mode_bits.insert(mode_bits.end(), val_a.begin(), val_a.end());
-                        mode_bits.insert(mode_bits.end(), val_b.begin(), val_b.end());
-                    }
-                    long unsigned int mode_bits_size = MODE_BITS_BASE_SIZE;
-                    if (use_cfg_params) {
-                        // Add additional config parameters if necessary
-                        mode_bits.push_back(RTLIL::S1); // MODE_BITS[80] == F_MODE : Enable fractured mode
-                        for (const auto &it : m_DspParams2Mode) {
-                            log_assert(dsp_a->getParam(RTLIL::escape_id(it)) == dsp_b->getParam(RTLIL::escape_id(it)));
-                            auto param = dsp_a->getParam(RTLIL::escape_id(it));
-                            if (param.size() > 1) {
-                                mode_bits.insert(mode_bits.end(), param.bits.begin(), param.bits.end());
-                            } else {
-                                mode_bits.push_back(param.bits[0]);
-                            }
-                        }
-                        mode_bits_size += MODE_BITS_EXTENSION_SIZE;
-                    } else {
-                        // Enable the fractured mode by connecting the control
-                        // port.
-                        simd->setPort(RTLIL::escape_id("f_mode"), RTLIL::S1);
-                    }
-                    simd->setParam(RTLIL::escape_id("MODE_BITS"), RTLIL::Const(mode_bits));
-                    log_assert(mode_bits.size() == mode_bits_size);
-
-                    // Handle the "is_inferred" attribute. If one of the fragments
-                    // is not inferred mark the whole DSP as not inferred
-                    bool is_inferred_a =
-                      dsp_a->has_attribute(RTLIL::escape_id("is_inferred")) ? dsp_a->get_bool_attribute(RTLIL::escape_id("is_inferred")) : false;
-                    bool is_inferred_b =
-                      dsp_b->has_attribute(RTLIL::escape_id("is_inferred")) ? dsp_b->get_bool_attribute(RTLIL::escape_id("is_inferred")) : false;
-
-                    simd->set_bool_attribute(RTLIL::escape_id("is_inferred"), is_inferred_a && is_inferred_b);
-
-                    // Mark DSP parts for removal
-                    cellsToRemove.push_back(dsp_a);
-                    cellsToRemove.push_back(dsp_b);
-                }
+            if (m_Cluster) {
+                groups.reorder([&](std::vector<RTLIL::Cell *> &group) { clusterGroup(group); });
             }
 
-            // Remove old cells
-            for (const auto &cell : cellsToRemove) {
-                module->remove(const_cast<RTLIL::Cell *>(cell));
-            }
+            // Map cell pairs to the target DSP SIMD cell
+            groups.pack(module, [&](const DspConfig &config, const RTLIL::Cell *dsp_a, const RTLIL::Cell *dsp_b, int index) {
+                map_pair(config, dsp_a, dsp_b, index, module);
+            });
         }
 
         // Clear
@@ -288,28 +265,93 @@ struct QlDspSimdPass : public Pass {
 
     // ..........................................
 
-    /// Looks up port width and direction in the cell definition and returns it.
-    /// Returns (0, false) if it cannot be determined.
-    std::pair<size_t, bool> getPortInfo(RTLIL::Cell *a_Cell, RTLIL::IdString a_Port)
+    /// Returns the hierarchy prefix of a (flattened) cell name
+    static std::string getHierPrefix(const RTLIL::Cell *a_Cell)
     {
-        if (!a_Cell->known()) {
-            return std::make_pair(0, false);
+        const std::string &name = a_Cell->name.str();
+        if (name[0] != '\\') {
+            return std::string();
+        }
+        size_t pos = name.rfind('.');
+        if (pos == std::string::npos) {
+            return std::string();
         }
+        return name.substr(0, pos);
+    }
 
-        // Get the module defining the cell (the previous condition ensures
-        // that the pointers are valid)
-        RTLIL::Module *mod = a_Cell->module->design->module(a_Cell->type);
-        if (mod == nullptr) {
-            return std::make_pair(0, false);
+    /// Reorders a group of DSP cells so that consecutive cells have the same
+    /// hierarchy prefix and, where possible, share a data input net. Cells
+    /// left over in a cluster go to the end to be paired across clusters.
+    void clusterGroup(std::vector<RTLIL::Cell *> &a_Group)
+    {
+        dict<std::string, std::vector<RTLIL::Cell *>> clusters;
+        for (auto cell : a_Group) {
+            clusters[getHierPrefix(cell)].push_back(cell);
         }
 
-        // Get the wire representing the port
-        RTLIL::Wire *wire = mod->wire(a_Port);
-        if (wire == nullptr) {
-            return std::make_pair(0, false);
+        std::vector<RTLIL::Cell *> paired, unpaired;
+        paired.reserve(a_Group.size());
+        for (const auto &it : clusters) {
+            const auto &cells = it.second;
+
+            // Cells sinking each data input net, with the position of the
+            // first entry that may still be unused
+            dict<RTLIL::SigBit, std::pair<std::vector<int>, size_t>> sinks;
+            std::vector<pool<RTLIL::SigBit>> inputs(cells.size());
+            for (size_t i = 0; i < cells.size(); ++i) {
+                for (const auto &port : {ID(a_i), ID(b_i)}) {
+                    auto conn = cells[i]->connections_.find(port);
+                    if (conn == cells[i]->connections_.end()) {
+                        continue;
+                    }
+                    for (const auto &bit : m_SigMap(conn->second)) {
+                        if (bit.wire != nullptr && inputs[i].insert(bit).second) {
+                            sinks[bit].first.push_back(i);
+                        }
+                    }
+                }
+            }
+
+            std::vector<bool> used(cells.size(), false);
+            size_t next = 0;
+            for (size_t i = 0; i < cells.size(); ++i) {
+                if (used[i]) {
+                    continue;
+                }
+                used[i] = true;
+
+                int partner = -1;
+                for (const auto &bit : inputs[i]) {
+                    auto &sink = sinks.at(bit);
+                    while (sink.second < sink.first.size() && used[sink.first[sink.second]]) {
+                        sink.second++;
+                    }
+                    if (sink.second < sink.first.size()) {
+                        partner = sink.first[sink.second];
+                        break;
+                    }
+                }
+                if (partner < 0) {
+                    while (next < cells.size() && used[next]) {
+                        next++;
+                    }
+                    if (next < cells.size()) {
+                        partner = next;
+                    }
+                }
+
+                if (partner < 0) {
+                    unpaired.push_back(cells[i]);
+                    continue;
+                }
+                used[partner] = true;
+                paired.push_back(cells[i]);
+                paired.push_back(cells[partner]);
+            }
         }
 
-        return std::make_pair(wire->width, wire->port_output);
+        a_Group = std::move(paired);
+        a_Group.insert(a_Group.end(), unpaired.begin(), unpaired.end());
     }
 
     /// Given a DSP cell populates and returns a DspConfig struct for it.
@@ -317,39 +359,12 @@ struct QlDspSimdPass : public Pass {
     {
         DspConfig config;
 
-        string cell_type = a_Cell->type.str();
-        string suffix = m_SisdDspType_cfg_params_suffix;
-
-        bool use_cfg_params = cell_type.size() >= suffix.size() && 0 == cell_type.compare(cell_type.size() - suffix.size(), suffix.size(), suffix);
+        const std::string &cell_type = a_Cell->type.str();
+        const std::string &suffix = m_SisdDspType_cfg_params_suffix;
 
-        std::vector<std::pair<std::string, std::string>> DspCfgPorts = m_DspCfgPorts;
-        if (!use_cfg_params)
-            DspCfgPorts.insert(DspCfgPorts.end(), m_DspCfgPorts_expand.begin(), m_DspCfgPorts_expand.end());
-
-        config.use_cfg_params = use_cfg_params;
-
-        for (const auto &it : DspCfgPorts) {
-            auto port = RTLIL::escape_id(it.first);
-
-            // Port unconnected
-            if (!a_Cell->hasPort(port)) {
-                config.connections[port] = RTLIL::SigSpec(RTLIL::Sx);
-                continue;
-            }
-
-            // Get the port connection and map it to unique SigBits
-            const auto &orgSigSpec = a_Cell->getPort(port);
-            const auto &orgSigBits = orgSigSpec.bits();
-
-            RTLIL::SigSpec newSigSpec;
-            for (size_t i = 0; i < orgSigBits.size(); ++i) {
-                auto newSigBit = m_SigMap(orgSigBits[i]);
-                newSigSpec.append(newSigBit);
-            }
-
-            // Store
-            config.connections[port] = newSigSpec;
-        }
+        config.use_cfg_params =
+          cell_type.size() >= suffix.size() && 0 == cell_type.compare(cell_type.size() - suffix.size(), suffix.size(), suffix);
+        config.connections = getSharedConnections(m_SigMap, a_Cell, config.use_cfg_params ? m_DspCfgPorts : m_DspCfgPorts_all);
 
         return config;
     }
@@ -0,0 +1,113 @@
+/*
+ * Copyright 2020-2022 F4PGA Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#ifndef _QL_EDIF_NAMES_H_
+#define _QL_EDIF_NAMES_H_
+
+#include "kernel/rtlil.h"
+
+#include <string>
+#include <vector>
+
+USING_YOSYS_NAMESPACE
+
+/// Maps design identifiers to EDIF identifiers, used by write_ql_edif.
+/// Identifiers that EDIF can not take as they are get a generated idNNNNN
+/// name and a rename clause at their definition.
+struct EdifNames {
+    int counter;
+    char delim_left, delim_right;
+    pool<std::string> generated_names, used_names;
+    // Names as referenced in EDIF, also for names that needed no renaming
+    dict<std::string, std::string> name_map;
+    // The same keyed by IdString, saves unescaping on every reference
+    dict<RTLIL::IdString, std::string> id_map;
+
+    EdifNames() : counter(1), delim_left('['), delim_right(']') {}
+
+    // Whether an identifier can be used in EDIF as it is
+    static bool is_plain(const std::string &id)
+    {
+        enum : unsigned char { OTHER, LETTER, DIGIT, UNDERSCORE };
+        static const std::vector<unsigned char> char_class = [] {
+            std::vector<unsigned char> table(256, OTHER);
+            for (int c = 'A'; c <= 'Z'; c++)
+                table[c] = LETTER;
+            for (int c = 'a'; c <= 'z'; c++)
+                table[c] = LETTER;
+            for (int c = '0'; c <= '9'; c++)
+                table[c] = DIGIT;
+            table['_'] = UNDERSCORE;
+            return table;
+        }();
+
+        if (id.empty())
+            return true;
+        if (char_class[(unsigned char)id[0]] != LETTER)
+            return false;
+        if (char_class[(unsigned char)id.back()] == UNDERSCORE)
+            return false;
+        for (size_t i = 1; i < id.size(); i++)
+            if (char_class[(unsigned char)id[i]] == OTHER)
+                return false;
+        return true;
+    }
+
+    std::string operator()(std::string id, bool define, bool port_rename = false, int range_left = 0, int range_right = 0)
+    {
+        if (define) {
+            std::string new_id = operator()(id, false);
+            if (port_rename)
+                return stringf("(rename %s \"%s%c%d:%d%c\")", new_id.c_str(), id.c_str(), delim_left, range_left, range_right, delim_right);
+            return new_id != id ? stringf("(rename %s \"%s\")", new_id.c_str(), id.c_str()) : id;
+        }
+
+        auto it = name_map.find(id);
+        if (it != name_map.end())
+            return it->second;
+
+        if (!generated_names.count(id) && id != "GND" && id != "VCC" && is_plain(id)) {
+            used_names.insert(id);
+            name_map.emplace(id, id);
+            return id;
+        }
+
+        std::string gen_name;
+        while (1) {
+            gen_name = stringf("id%05d", counter++);
+            if (generated_names.count(gen_name) == 0 && used_names.count(gen_name) == 0)
+                break;
+        }
+        generated_names.insert(gen_name);
+        name_map.emplace(id, gen_name);
+        return gen_name;
+    }
+
+    std::string ref(const RTLIL::IdString &id)
+    {
+        auto it = id_map.find(id);
+        if (it != id_map.end())
+            return it->second;
+        std::string name = operator()(RTLIL::unescape_id(id), false);
+        id_map.emplace(id, name);
+        return name;
+    }
+
+    std::string ref(const std::string &id) { return operator()(RTLIL::unescape_id(id), false); }
+};
+
+#endif // _QL_EDIF_NAMES_H_
@@ -20,11 +20,15 @@
 // [[CITE]] EDIF Version 2 0 0 Grammar
 // http://web.archive.org/web/20050730021644/http://www.edif.org/documentation/BNF_GRAMMAR/index.html
 
+#include "ql-edif-names.h"
+
 #include "kernel/celltypes.h"
 #include "kernel/log.h"
 #include "kernel/register.h"
 #include "kernel/rtlil.h"
 #include "kernel/sigtools.h"
+#include <algorithm>
+#include <sstream>
 #include <string>
 
 USING_YOSYS_NAMESPACE
@@ -32,59 +36,7 @@ PRIVATE_NAMESPACE_BEGIN
 
 #define EDIF_DEF(_id) edif_names(RTLIL::unescape_id(_id), true).c_str()
 #define EDIF_DEFR(_id, _ren, _bl, _br) edif_names(RTLIL::unescape_id(_id), true, _ren, _bl, _br).c_str()
-#define EDIF_REF(_id) edif_names(RTLIL::unescape_id(_id), false).c_str()
-
-struct EdifNames {
-    int counter;
-    char delim_left, delim_right;
-    std::set<std::string> generated_names, used_names;
-    std::map<std::string, std::string> name_map;
-
-    EdifNames() : counter(1), delim_left('['), delim_right(']') {}
-
-    std::string operator()(std::string id, bool define, bool port_rename = false, int range_left = 0, int range_right = 0)
-    {
-        if (define) {
-            std::string new_id = operator()(id, false);
-            if (port_rename)
-                return stringf("(rename %s \"%s%c%d:%d%c\")", new_id.c_str(), id.c_str(), delim_left, range_left, range_right, delim_right);
-            return new_id != id ? stringf("(rename %s \"%s\")", new_id.c_str(), id.c_str()) : id;
-        }
-
-        if (name_map.count(id) > 0)
-            return name_map.at(id);
-        if (generated_names.count(id) > 0)
-            goto do_rename;
-        if (id == "GND" || id == "VCC")
-            goto do_rename;
-
-        for (size_t i = 0; i < id.size(); i++) {
-            if ('A' <= id[i] && id[i] <= 'Z')
-                continue;
-            if ('a' <= id[i] && id[i] <= 'z')
-                continue;
-            if ('0' <= id[i] && id[i] <= '9' && i > 0)
-                continue;
-            if (id[i] == '_' && i > 0 && i != id.size() - 1)
-                continue;
-            goto do_rename;
-        }
-
-        used_names.insert(id);
-        return id;
-
-    do_rename:;
-        std::string gen_name;
-        while (1) {
-            gen_name = stringf("id%05d", counter++);
-            if (generated_names.count(gen_name) == 0 && used_names.count(gen_name) == 0)
-                break;
-        }
-        generated_names.insert(gen_name);
-        name_map[id] = gen_name;
-        return gen_name;
-    }
-};
+#define EDIF_REF(_id) edif_names.ref(_id).c_str()
 
 struct QLEdifBackend : public Backend {
     QLEdifBackend() : Backend("ql_edif", "write design to EDIF netlist file") {}
@@ -207,39 +159,39 @@ struct QLEdifBackend : public Backend {
             log_error("No module found in design!\n");
 
         *f << stringf("(edif %s\n", EDIF_DEF(top_module_name));
-        *f << stringf("  (edifVersion 2 0 0)\n");
-        *f << stringf("  (edifLevel 0)\n");
-        *f << stringf("  (keywordMap (keywordLevel 0))\n");
+        *f << "  (edifVersion 2 0 0)\n";
+        *f << "  (edifLevel 0)\n";
+        *f << "  (keywordMap (keywordLevel 0))\n";
         *f << stringf("  (comment \"Generated by %s\")\n", yosys_version_str);
 
-        *f << stringf("  (external LIB\n");
-        *f << stringf("    (edifLevel 0)\n");
-        *f << stringf("    (technology (numberDefinition))\n");
+        *f << "  (external LIB\n";
+        *f << "    (edifLevel 0)\n";
+        *f << "    (technology (numberDefinition))\n";
 
         if (!nogndvcc) {
-            *f << stringf("    (cell GND\n");
-            *f << stringf("      (cellType GENERIC)\n");
-            *f << stringf("      (view VIEW_NETLIST\n");
-            *f << stringf("        (viewType NETLIST)\n");
+            *f << "    (cell GND\n";
+            *f << "      (cellType GENERIC)\n";
+            *f << "      (view VIEW_NETLIST\n";
+            *f << "        (viewType NETLIST)\n";
             *f << stringf("        (interface (port %c (direction OUTPUT)))\n", gndvccy ? 'Y' : 'G');
-            *f << stringf("      )\n");
-            *f << stringf("    )\n");
+            *f << "      )\n";
+            *f << "    )\n";
 
-            *f << stringf("    (cell VCC\n");
-            *f << stringf("      (cellType GENERIC)\n");
-            *f << stringf("      (view VIEW_NETLIST\n");
-            *f << stringf("        (viewType NETLIST)\n");
+            *f << "    (cell VCC\n";
+            *f << "      (cellType GENERIC)\n";
+            *f << "      (view VIEW_NETLIST\n";
+            *f << "        (viewType NETLIST)\n";
             *f << stringf("        (interface (port %c (direction OUTPUT)))\n", gndvccy ? 'Y' : 'P');
-            *f << stringf("      )\n");
-            *f << stringf("    )\n");
+            *f << "      )\n";
+            *f << "    )\n";
         }
 
         for (auto &cell_it : lib_cell_ports) {
             *f << stringf("    (cell %s\n", EDIF_DEF(cell_it.first));
-            *f << stringf("      (cellType GENERIC)\n");
-            *f << stringf("      (view VIEW_NETLIST\n");
-            *f << stringf("        (viewType NETLIST)\n");
-            *f << stringf("        (interface\n");
+            *f << "      (cellType GENERIC)\n";
+            *f << "      (view VIEW_NETLIST\n";
+            *f << "        (viewType NETLIST)\n";
+            *f << "        (interface\n";
             for (auto &port_it : cell_it.second) {
                 const char *dir = "INOUT";
                 if (ct.cell_known(cell_it.first)) {
@@ -267,11 +219,11 @@ struct QLEdifBackend : public Backend {
                     }
                 }
             }
-            *f << stringf("        )\n");
-            *f << stringf("      )\n");
-            *f << stringf("    )\n");
+            *f << "        )\n";
+            *f << "      )\n";
+            *f << "    )\n";
         }
-        *f << stringf("  )\n");
+        *f << "  )\n";
 
         std::vector<RTLIL::Module *> sorted_modules;
 
@@ -302,15 +254,18 @@ struct QLEdifBackend : public Backend {
                 module_deps.erase(sorted_modules.at(sorted_modules_idx++));
         }
 
-        *f << stringf("  (library DESIGN\n");
-        *f << stringf("    (edifLevel 0)\n");
-        *f << stringf("    (technology (numberDefinition))\n");
+        *f << "  (library DESIGN\n";
+        *f << "    (edifLevel 0)\n";
+        *f << "    (technology (numberDefinition))\n";
 
+        // Each module cell is written to a buffer of its own and appended to
+        // the file in dependency order, the properties go to that buffer too
+        std::ostream *os = f;
         auto add_prop = [&](IdString name, Const val) {
             if ((val.flags & RTLIL::CONST_FLAG_STRING) != 0)
-                *f << stringf("\n            (property %s (string \"%s\"))", EDIF_DEF(name), val.decode_string().c_str());
+                *os << stringf("\n            (property %s (string \"%s\"))", EDIF_DEF(name), val.decode_string().c_str());
             else if (val.bits.size() <= 32 && RTLIL::SigSpec(val).is_fully_def()) {
-                *f << stringf("\n            (property %s (integer %u))", EDIF_DEF(name), val.as_int());
+                *os << stringf("\n            (property %s (integer %u))", EDIF_DEF(name), val.as_int());
             } else {
                 std::string hex_string = "";
                 for (size_t i = 0; i < val.bits.size(); i += 4) {
@@ -326,18 +281,18 @@ struct QLEdifBackend : public Backend {
                     char digit_str[2] = {"0123456789abcdef"[digit_value], 0};
                     hex_string = std::string(digit_str) + hex_string;
                 }
-                *f << stringf("\n            (property %s (string \"%d'h%s\"))", EDIF_DEF(name), GetSize(val.bits), hex_string.c_str());
+                *os << stringf("\n            (property %s (string \"%d'h%s\"))", EDIF_DEF(name), GetSize(val.bits), hex_string.c_str());
             }
         };
         auto add_lut_prop = [&](IdString name, Const val, int lut_in) {
             if ((val.flags & RTLIL::CONST_FLAG_STRING) != 0)
-                *f << stringf("\n            (property %s (string \"%s\"))", EDIF_DEF(name), val.decode_string().c_str());
+                *os << stringf("\n            (property %s (string \"%s\"))", EDIF_DEF(name), val.decode_string().c_str());
             else if (val.bits.size() <= 32 && RTLIL::SigSpec(val).is_fully_def()) {
                 if (strstr(name.c_str(), "INIT")) {
                     int hex_code_width = ((1 << lut_in) / 4);
-                    *f << stringf("\n            (property %s (string \"%0*X\"))", EDIF_DEF(name), hex_code_width, val.as_int());
+                    *os << stringf("\n            (property %s (string \"%0*X\"))", EDIF_DEF(name), hex_code_width, val.as_int());
                 } else {
-                    *f << stringf("\n            (property %s (integer %u))", EDIF_DEF(name), val.as_int());
+                    *os << stringf("\n            (property %s (integer %u))", EDIF_DEF(name), val.as_int());
                 }
             } else {
                 std::string hex_string = "";
@@ -354,21 +309,25 @@ struct QLEdifBackend : public Backend {
                     char digit_str[2] = {"0123456789abcdef"[digit_value], 0};
                     hex_string = std::string(digit_str) + hex_string;
                 }
-                *f << stringf("\n            (property %s (string \"%d'h%s\"))", EDIF_DEF(name), GetSize(val.bits), hex_string.c_str());
+                *os << stringf("\n            (property %s (string \"%d'h%s\"))", EDIF_DEF(name), GetSize(val.bits), hex_string.c_str());
             }
         };
         for (auto module : sorted_modules) {
             if (module->get_blackbox_attribute())
                 continue;
 
+            std::ostringstream module_buffer;
+            os = &module_buffer;
+
             SigMap sigmap(module);
-            std::map<RTLIL::SigSpec, std::set<std::pair<std::string, bool>>> net_join_db;
+            // Port references joined by each net, sorted and made unique before writing
+            dict<RTLIL::SigBit, std::vector<std::pair<std::string, bool>>> net_join_db;
 
-            *f << stringf("    (cell %s\n", EDIF_DEF(module->name));
-            *f << stringf("      (cellType GENERIC)\n");
-            *f << stringf("      (view VIEW_NETLIST\n");
-            *f << stringf("        (viewType NETLIST)\n");
-            *f << stringf("        (interface\n");
+            *os << stringf("    (cell %s\n", EDIF_DEF(module->name));
+            *os << "      (cellType GENERIC)\n";
+            *os << "      (view VIEW_NETLIST\n";
+            *os << "        (viewType NETLIST)\n";
+            *os << "        (interface\n";
 
             for (auto cell : module->cells()) {
                 for (auto &conn : cell->connections())
@@ -450,43 +409,42 @@ struct QLEdifBackend : public Backend {
                 else if (!wire->port_input)
                     dir = "OUTPUT";
                 if (wire->width == 1) {
-                    *f << stringf("          (port %s (direction %s)", EDIF_DEF(wire->name), dir);
+                    *os << stringf("          (port %s (direction %s)", EDIF_DEF(wire->name), dir);
                     if (attr_properties)
                         for (auto &p : wire->attributes)
                             add_prop(p.first, p.second);
-                    *f << ")\n";
-                    RTLIL::SigSpec sig = sigmap(RTLIL::SigSpec(wire));
-                    net_join_db[sig].insert(make_pair(stringf("(portRef %s)", EDIF_REF(wire->name)), wire->port_input));
+                    *os << ")\n";
+                    RTLIL::SigBit sig = sigmap(RTLIL::SigBit(wire));
+                    net_join_db[sig].emplace_back(stringf("(portRef %s)", EDIF_REF(wire->name)), wire->port_input);
                 } else {
                     int b[2];
                     b[wire->upto ? 0 : 1] = wire->start_offset;
                     b[wire->upto ? 1 : 0] = wire->start_offset + GetSize(wire) - 1;
-                    *f << stringf("          (port (array %s %d) (direction %s)", EDIF_DEFR(wire->name, port_rename, b[0], b[1]), wire->width, dir);
+                    *os << stringf("          (port (array %s %d) (direction %s)", EDIF_DEFR(wire->name, port_rename, b[0], b[1]), wire->width, dir);
                     if (attr_properties)
                         for (auto &p : wire->attributes)
                             add_prop(p.first, p.second);
 
-                    *f << ")\n";
+                    *os << ")\n";
                     for (int i = 0; i < wire->width; i++) {
-                        RTLIL::SigSpec sig = sigmap(RTLIL::SigSpec(wire, i));
-                        net_join_db[sig].insert(
-                          make_pair(stringf("(portRef %s_%d_)", EDIF_REF(wire->name), GetSize(wire) - i - 1), wire->port_input));
+                        RTLIL::SigBit sig = sigmap(RTLIL::SigBit(wire, i));
+                        net_join_db[sig].emplace_back(stringf("(portRef %s_%d_)", EDIF_REF(wire->name), GetSize(wire) - i - 1), wire->port_input);
                     }
                 }
             }
 
-            *f << stringf("        )\n");
-            *f << stringf("        (contents\n");
+            *os << "        )\n";
+            *os << "        (contents\n";
 
             if (!nogndvcc) {
-                *f << stringf("          (instance GND (viewRef VIEW_NETLIST (cellRef GND (libraryRef LIB))))\n");
-                *f << stringf("          (instance VCC (viewRef VIEW_NETLIST (cellRef VCC (libraryRef LIB))))\n");
+                *os << "          (instance GND (viewRef VIEW_NETLIST (cellRef GND (libraryRef LIB))))\n";
+                *os << "          (instance VCC (viewRef VIEW_NETLIST (cellRef VCC (libraryRef LIB))))\n";
             }
 
             for (auto cell : module->cells()) {
-                *f << stringf("          (instance %s\n", EDIF_DEF(cell->name));
-                *f << stringf("            (viewRef VIEW_NETLIST (cellRef %s%s))", EDIF_REF(cell->type),
-                              lib_cell_ports.count(cell->type) > 0 ? " (libraryRef LIB)" : "");
+                *os << stringf("          (instance %s\n", EDIF_DEF(cell->name));
+                *os << stringf("            (viewRef VIEW_NETLIST (cellRef %s%s))", EDIF_REF(cell->type),
+                               lib_cell_ports.count(cell->type) > 0 ? " (libraryRef LIB)" : "");
                 const char *lut_pos;
                 lut_pos = strstr(cell->type.c_str(), "LUT");
                 if (lut_pos) {
@@ -504,47 +462,61 @@ struct QLEdifBackend : public Backend {
                             add_prop(p.first, p.second);
                 }
 
-                *f << stringf(")\n");
+                *os << ")\n";
+                auto cell_module = design->module(cell->type);
                 for (auto &p : cell->connections()) {
                     RTLIL::SigSpec sig = sigmap(p.second);
+                    bool is_output = cell->output(p.first);
+                    auto port_wire = cell_module ? cell_module->wire(p.first) : nullptr;
                     for (int i = 0; i < GetSize(sig); i++)
                         if (sig[i].wire == NULL && sig[i] != RTLIL::State::S0 && sig[i] != RTLIL::State::S1)
                             log_warning("Bit %d of cell port %s.%s.%s driven by %s will be left unconnected in EDIF output.\n", i, log_id(module),
                                         log_id(cell), log_id(p.first), log_signal(sig[i]));
                         else {
                             int member_idx = GetSize(sig) - i - 1;
-                            auto m = design->module(cell->type);
                             int width = sig.size();
-                            if (m) {
-                                auto w = m->wire(p.first);
-                                if (w) {
-                                    member_idx = GetSize(w) - i - 1;
-                                    width = GetSize(w);
-                                }
+                            if (port_wire) {
+                                member_idx = GetSize(port_wire) - i - 1;
+                                width = GetSize(port_wire);
                             }
                             if (width == 1)
-                                net_join_db[sig[i]].insert(make_pair(
-                                  stringf("(portRef %s (instanceRef %s))", EDIF_REF(p.first), EDIF_REF(cell->name)), cell->output(p.first)));
+                                net_join_db[sig[i]].emplace_back(stringf("(portRef %s (instanceRef %s))", EDIF_REF(p.first), EDIF_REF(cell->name)),
+                                                                 is_output);
                             else {
-                                net_join_db[sig[i]].insert(make_pair(stringf("(portRef %s_%d_ (instanceRef %s))", EDIF_REF(p.first),
-                                                                             width - member_idx - 1, EDIF_REF(cell->name)), // reverse IDs
-                                                                     cell->output(p.first)));
+                                net_join_db[sig[i]].emplace_back(stringf("(portRef %s_%d_ (instanceRef %s))", EDIF_REF(p.first),
+                                                                         width - member_idx - 1, EDIF_REF(cell->name)), // reverse IDs
+                                                                 is_output);
                             }
                         }
                 }
             }
 
+            // Nets are written in the order of their SigSpec, as when they were
+            // collected in a std::map, so the output does not depend on hashing
+            std::vector<std::pair<RTLIL::SigSpec, std::vector<std::pair<std::string, bool>> *>> nets;
+            nets.reserve(net_join_db.size());
             for (auto &it : net_join_db) {
-                RTLIL::SigBit sig = it.first;
+                auto &refs = it.second;
+                std::sort(refs.begin(), refs.end());
+                refs.erase(std::unique(refs.begin(), refs.end()), refs.end());
+                nets.emplace_back(RTLIL::SigSpec(it.first), &refs);
+            }
+            std::sort(nets.begin(), nets.end(),
+                      [](const std::pair<RTLIL::SigSpec, std::vector<std::pair<std::string, bool>> *> &a,
+                         const std::pair<RTLIL::SigSpec, std::vector<std::pair<std::string, bool>> *> &b) { return a.first < b.first; });
+
+            for (auto &it : nets) {
+                const auto &refs = *it.second;
+                RTLIL::SigBit sig = it.first.as_bit();
                 if (sig.wire == NULL && sig != RTLIL::State::S0 && sig != RTLIL::State::S1) {
                     if (sig == RTLIL::State::Sx) {
-                        for (auto &ref : it.second)
+                        for (auto &ref : refs)
                             log_warning("Exporting x-bit on %s as zero bit.\n", ref.first.c_str());
                         sig = RTLIL::State::S0;
                     } else if (sig == RTLIL::State::Sz) {
                         continue;
                     } else {
-                        for (auto &ref : it.second)
+                        for (auto &ref : refs)
                             log_error("Don't know how to handle %s on %s.\n", log_signal(sig), ref.first.c_str());
                         log_abort();
                     }
@@ -560,22 +532,22 @@ struct QLEdifBackend : public Backend {
                         if (netname[i] == ' ' || netname[i] == '\\')
                             netname.erase(netname.begin() + i--);
                 }
-                *f << stringf("          (net %s (joined\n", EDIF_DEF(netname));
-                for (auto &ref : it.second)
-                    *f << stringf("              %s\n", ref.first.c_str());
+                *os << stringf("          (net %s (joined\n", EDIF_DEF(netname));
+                for (auto &ref : refs)
+                    *os << stringf("              %s\n", ref.first.c_str());
                 if (sig.wire == NULL) {
                     if (nogndvcc)
                         log_error("Design contains constant nodes (map with \"hilomap\" first).\n");
                     if (sig == RTLIL::State::S0)
-                        *f << stringf("            (portRef %c (instanceRef GND))\n", gndvccy ? 'Y' : 'G');
+                        *os << stringf("            (portRef %c (instanceRef GND))\n", gndvccy ? 'Y' : 'G');
                     if (sig == RTLIL::State::S1)
-                        *f << stringf("            (portRef %c (instanceRef VCC))\n", gndvccy ? 'Y' : 'P');
+                        *os << stringf("            (portRef %c (instanceRef VCC))\n", gndvccy ? 'Y' : 'P');
                 }
-                *f << stringf("            )");
+                *os << "            )";
                 if (attr_properties && sig.wire != NULL)
                     for (auto &p : sig.wire->attributes)
                         add_prop(p.first, p.second);
-                *f << stringf("\n          )\n");
+                *os << "\n          )\n";
             }
 
             for (auto wire : module->wires()) {
@@ -595,19 +567,19 @@ struct QLEdifBackend : public Backend {
                             netname.erase(netname.begin() + i--);
 
                     if (keepmode) {
-                        *f << stringf("          (net %s (joined\n", EDIF_DEF(netname));
+                        *os << stringf("          (net %s (joined\n", EDIF_DEF(netname));
 
                         auto &refs = net_join_db.at(mapped_sig);
                         for (auto &ref : refs)
                             if (ref.second)
-                                *f << stringf("              %s\n", ref.first.c_str());
-                        *f << stringf("            )");
+                                *os << stringf("              %s\n", ref.first.c_str());
+                        *os << "            )";
 
                         if (attr_properties && raw_sig.wire != NULL)
                             for (auto &p : raw_sig.wire->attributes)
                                 add_prop(p.first, p.second);
 
-                        *f << stringf("\n          )\n");
+                        *os << "\n          )\n";
                     } else {
                         log_warning("Ignoring conflicting 'keep' property on net %s. Use -keep to generate the extra net nevertheless.\n",
                                     EDIF_DEF(netname));
@@ -615,17 +587,20 @@ struct QLEdifBackend : public Backend {
                 }
             }
 
-            *f << stringf("        )\n");
-            *f << stringf("      )\n");
-            *f << stringf("    )\n");
+            *os << "        )\n";
+            *os << "      )\n";
+            *os << "    )\n";
+
+            *f << module_buffer.str();
+            os = f;
         }
-        *f << stringf("  )\n");
+        *f << "  )\n";
 
         *f << stringf("  (design %s\n", EDIF_DEF(top_module_name));
         *f << stringf("    (cellRef %s (libraryRef DESIGN))\n", EDIF_REF(top_module_name));
-        *f << stringf("  )\n");
+        *f << "  )\n";
 
-        *f << stringf(")\n");
+        *f << ")\n";
     }
 } QLEdifBackend;
 
@@ -0,0 +1,309 @@
+/*
+ * Copyright 2020-2022 F4PGA Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#ifndef _QL_LIB_CACHE_H_
+#define _QL_LIB_CACHE_H_
+
+#include "kernel/register.h"
+#include "kernel/rtlil.h"
+#include "kernel/yosys.h"
+
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <sys/stat.h>
+#include <vector>
+
+USING_YOSYS_NAMESPACE
+
+/// Keeps the Verilog libraries read by synth_quicklogic parsed for the rest
+/// of the Yosys process, so that repeated runs don't elaborate the same
+/// files again.
+///
+/// Each entry is a design in 'saved_designs', read once with the command
+/// that would otherwise be run on every invocation. Entries are keyed by the
+/// command, i.e. by the ordered files together with the define set, and by
+/// the verilog_defines of the design for library reads. They are read
+/// again once one of the files or of the files they `include changes on
+/// disk, or the saved design was removed with 'design -delete'. Included
+/// files are found by scanning for `include "file" lines, an include whose
+/// name comes from a macro is not tracked.
+class QlLibCache
+{
+  public:
+    /// Rewrites a techmap command so that its Verilog map files are taken
+    /// from the cache as a single '-map %<design>'. The files are read into
+    /// that design in the order given, like techmap does, so a `define in
+    /// one is seen by the next. Other commands, and techmap commands with a
+    /// map that is not a Verilog file, are returned unchanged.
+    static std::string techmapCommand(const std::string &a_Command)
+    {
+        std::vector<std::string> args = split_tokens(a_Command);
+        if (args.empty() || args[0] != "techmap") {
+            return a_Command;
+        }
+
+        // The define set of the frontend call that techmap would make
+        std::string frontend = "read_verilog -nooverwrite -noblackbox";
+        std::vector<std::string> maps;
+        for (size_t i = 1; i + 1 < args.size(); ++i) {
+            if (args[i] == "-D" || args[i] == "-I") {
+                frontend += " " + args[i] + " " + args[i + 1];
+            }
+            if (args[i] == "-map") {
+                const std::string &file = args[i + 1];
+                if (file[0] == '%' || file.size() <= 2 || file.compare(file.size() - 2, 2, ".v") != 0) {
+                    return a_Command;
+                }
+                maps.push_back(file);
+            }
+        }
+        if (maps.empty()) {
+            return a_Command;
+        }
+
+        std::string command = args[0] + " -map %" + get(frontend, maps);
+        for (size_t i = 1; i < args.size(); ++i) {
+            if (args[i] == "-map") {
+                ++i;
+            } else {
+                command += " " + args[i];
+            }
+        }
+        return command;
+    }
+
+    /// Runs 'read_verilog -lib <flags> <files>' on a design using the
+    /// cached modules. The defines set on the design with verilog_defines
+    /// apply to the files as they would for read_verilog and are part of
+    /// the key. An existing module of the same name is replaced if it is a
+    /// blackbox and is an error otherwise, like read_verilog does.
+    static void readLibrary(RTLIL::Design *a_Design, const std::string &a_Flags, const std::vector<std::string> &a_Files)
+    {
+        std::string name = get("read_verilog -lib " + a_Flags, a_Files, a_Design);
+        log("Reading library modules of %s from the cache.\n", name.c_str());
+
+        for (auto module : saved_designs.at(name)->modules()) {
+            RTLIL::Module *existing = a_Design->module(module->name);
+            if (existing != nullptr) {
+                if (!existing->get_blackbox_attribute()) {
+                    log_error("Re-definition of module `%s'!\n", log_id(module->name));
+                }
+                a_Design->remove(existing);
+            }
+            a_Design->add(module->clone());
+        }
+    }
+
+    /// Splits a 'read_verilog -lib' command into its flags and files.
+    /// Returns false for any other command.
+    static bool parseReadLibrary(const std::string &a_Command, std::string &a_Flags, std::vector<std::string> &a_Files)
+    {
+        std::vector<std::string> args = split_tokens(a_Command);
+        if (args.size() < 2 || args[0] != "read_verilog" || std::find(args.begin(), args.end(), "-lib") == args.end()) {
+            return false;
+        }
+
+        a_Flags.clear();
+        a_Files.clear();
+        for (size_t i = 1; i < args.size(); ++i) {
+            if (args[i] == "-lib") {
+                continue;
+            }
+            if (args[i][0] == '-') {
+                // Options with a value
+                if (args[i] == "-D" || args[i] == "-I") {
+                    if (i + 1 == args.size()) {
+                        return false;
+                    }
+                    a_Flags += (a_Flags.empty() ? "" : " ") + args[i] + " " + args[i + 1];
+                    ++i;
+                    continue;
+                }
+                a_Flags += (a_Flags.empty() ? "" : " ") + args[i];
+            } else {
+                a_Files.push_back(args[i]);
+            }
+        }
+        return !a_Files.empty();
+    }
+
+    /// Frees the cached designs, the libraries are read again on next use
+    static void clear()
+    {
+        for (auto &it : entries()) {
+            if (saved_designs.count(it.second.name)) {
+                delete saved_designs.at(it.second.name);
+                saved_designs.erase(it.second.name);
+            }
+        }
+        entries().clear();
+    }
+
+  private:
+    /// A cached design and the files it was read from
+    struct Entry {
+        std::string name;
+        std::vector<std::pair<std::string, struct stat>> files;
+    };
+
+    static std::map<std::string, Entry> &entries()
+    {
+        static std::map<std::string, Entry> s_Entries;
+        return s_Entries;
+    }
+
+    static bool isSame(const struct stat &a_First, const struct stat &a_Second)
+    {
+        return a_First.st_mtime == a_Second.st_mtime && a_First.st_size == a_Second.st_size && a_First.st_ino == a_Second.st_ino;
+    }
+
+    /// Appends the files a Verilog file pulls in with `include, and theirs,
+    /// looked up the way the Yosys preprocessor does: as given, next to the
+    /// including file, then in the include directories. Lines inside
+    /// comments or disabled `ifdef blocks are taken as well, which at worst
+    /// tracks a file too many.
+    static void addIncludes(const std::string &a_File, const std::vector<std::string> &a_IncludeDirs, std::vector<std::string> &a_Files)
+    {
+        std::ifstream stream(a_File);
+        std::string line;
+        while (std::getline(stream, line)) {
+            size_t pos = line.find("`include");
+            size_t first = pos == std::string::npos ? pos : line.find('"', pos);
+            size_t last = first == std::string::npos ? first : line.find('"', first + 1);
+            if (last == std::string::npos) {
+                continue;
+            }
+
+            std::string name = line.substr(first + 1, last - first - 1);
+            std::vector<std::string> candidates = {name};
+            if (!name.empty() && name[0] != '/') {
+                size_t separator = a_File.find_last_of('/');
+                if (separator != std::string::npos) {
+                    candidates.push_back(a_File.substr(0, separator + 1) + name);
+                }
+                for (const auto &dir : a_IncludeDirs) {
+                    candidates.push_back(dir + "/" + name);
+                }
+            }
+            for (const auto &candidate : candidates) {
+                if (check_file_exists(candidate)) {
+                    if (std::find(a_Files.begin(), a_Files.end(), candidate) == a_Files.end()) {
+                        a_Files.push_back(candidate);
+                        addIncludes(candidate, a_IncludeDirs, a_Files);
+                    }
+                    break;
+                }
+            }
+        }
+    }
+
+    /// Returns the defines set on a design with verilog_defines, as listed
+    /// by 'verilog_defines -list'
+    static std::string listDefines(RTLIL::Design *a_Design)
+    {
+        std::ostringstream buffer;
+        std::vector<FILE *> files;
+        std::vector<std::ostream *> streams = {&buffer};
+        std::swap(files, log_files);
+        std::swap(streams, log_streams);
+        Pass::call(a_Design, "verilog_defines -list");
+        std::swap(files, log_files);
+        std::swap(streams, log_streams);
+        return buffer.str();
+    }
+
+    /// Returns the name of the saved design holding the result of running
+    /// a frontend command on a list of files, (re-)reads it if needed. With
+    /// a design given, its verilog_defines are in effect for the command.
+    static std::string get(const std::string &a_Frontend, const std::vector<std::string> &a_Files, RTLIL::Design *a_Defines = nullptr)
+    {
+        std::string command = a_Frontend;
+        std::vector<std::string> paths;
+        for (const auto &file : a_Files) {
+            std::string path = file;
+            rewrite_filename(path);
+
+            struct stat info = {};
+            if (stat(path.c_str(), &info) != 0) {
+                log_cmd_error("Can't open library file `%s'.\n", path.c_str());
+            }
+            paths.push_back(path);
+            command += " " + path;
+        }
+        std::string key = command;
+        if (a_Defines != nullptr) {
+            key += "\n" + listDefines(a_Defines);
+        }
+
+        // The files read last time, included ones too, must all be unchanged
+        auto &entry = entries()[key];
+        bool valid = !entry.name.empty() && saved_designs.count(entry.name);
+        for (size_t i = 0; valid && i < entry.files.size(); ++i) {
+            struct stat info = {};
+            valid = stat(entry.files[i].first.c_str(), &info) == 0 && isSame(entry.files[i].second, info);
+        }
+        if (valid) {
+            return entry.name;
+        }
+
+        if (entry.name.empty()) {
+            entry.name = stringf("ql_lib_cache_%zu", entries().size());
+        }
+        if (saved_designs.count(entry.name)) {
+            delete saved_designs.at(entry.name);
+            saved_designs.erase(entry.name);
+        }
+
+        log("Caching `%s' as %s.\n", command.c_str(), entry.name.c_str());
+        log_push();
+        RTLIL::Design *design = new RTLIL::Design;
+        if (a_Defines != nullptr) {
+            // Lend the defines to the new design for the time of the read
+            std::swap(design->verilog_defines, a_Defines->verilog_defines);
+            Pass::call(design, command);
+            std::swap(design->verilog_defines, a_Defines->verilog_defines);
+        } else {
+            Pass::call(design, command);
+        }
+        log_pop();
+
+        saved_designs[entry.name] = design;
+
+        std::vector<std::string> include_dirs;
+        std::vector<std::string> args = split_tokens(a_Frontend);
+        for (size_t i = 0; i + 1 < args.size(); ++i) {
+            if (args[i] == "-I") {
+                include_dirs.push_back(args[i + 1]);
+            }
+        }
+        for (size_t i = 0, count = paths.size(); i < count; ++i) {
+            addIncludes(paths[i], include_dirs, paths);
+        }
+        entry.files.clear();
+        for (const auto &path : paths) {
+            struct stat info = {};
+            stat(path.c_str(), &info);
+            entry.files.push_back(std::make_pair(path, info));
+        }
+        return entry.name;
+    }
+};
+
+#endif // _QL_LIB_CACHE_H_
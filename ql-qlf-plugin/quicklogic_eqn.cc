@@ -34,31 +34,48 @@ struct QuicklogicEqnPass : public Pass {
         log("\n");
     }
 
-    Const init2eqn(Const init, int inputs)
+    // LUT truth table as a word, bit i holds the output for input value i
+    static uint32_t init2word(const Const &init, int inputs)
     {
-        std::string init_bits = init.as_string();
-        const char *names[] = {"I0", "I1", "I2", "I3", "I4"};
+        uint32_t word = 0;
+        int width = std::min(1 << inputs, GetSize(init.bits));
+        for (int i = 0; i < width; i++)
+            if (init.bits[i] == RTLIL::State::S1)
+                word |= 1u << i;
+        return word;
+    }
+
+    // Sum of products with one product term per set bit of the truth table
+    static Const word2eqn(uint32_t word, int inputs)
+    {
+        if (word == 0)
+            return Const("0");
+
+        static const char *names[] = {"~I0", "~I1", "~I2", "~I3", "~I4"};
 
+        // Each term is "(" ["~"] "In" ("*" ["~"] "In")* ")" and terms are
+        // joined with "+"
+        int width = 1 << inputs;
+        int terms = 0;
+        for (int i = 0; i < width; i++)
+            terms += (word >> i) & 1;
         std::string eqn;
-        int width = (int)pow(2, inputs);
-        for (int i = 0; i < width; i++) {
-            if (init_bits[width - 1 - i] == '1') {
-                eqn += "(";
-                for (int j = 0; j < inputs; j++) {
-                    if (i & (1 << j))
-                        eqn += names[j];
-                    else
-                        eqn += std::string("~") + names[j];
+        eqn.reserve(terms * (2 + 4 * inputs));
 
-                    if (j != (inputs - 1))
-                        eqn += "*";
-                }
-                eqn += ")+";
+        for (int i = 0; i < width; i++) {
+            if (((word >> i) & 1) == 0)
+                continue;
+            if (!eqn.empty())
+                eqn += '+';
+            eqn += '(';
+            for (int j = 0; j < inputs; j++) {
+                if (j != 0)
+                    eqn += '*';
+                // Skip the "~" for inputs that are 1 in this term
+                eqn += names[j] + ((i >> j) & 1);
             }
+            eqn += ')';
         }
-        if (eqn.empty())
-            return Const("0");
-        eqn = eqn.substr(0, eqn.length() - 1);
         return Const(eqn);
     }
 
@@ -68,29 +85,25 @@ struct QuicklogicEqnPass : public Pass {
 
         extra_args(args, args.size(), design);
 
+        const dict<RTLIL::IdString, int> lut_inputs = {{ID(LUT1), 1}, {ID(LUT2), 2}, {ID(LUT3), 3}, {ID(LUT4), 4}, {ID(LUT5), 5}};
+
+        // Many LUTs implement the same function, compute each equation once
+        dict<std::pair<int, uint32_t>, Const> eqn_cache;
+
         int cnt = 0;
         for (auto module : design->selected_modules()) {
             for (auto cell : module->selected_cells()) {
-                if (cell->type == ID(LUT1)) {
-                    cell->setParam(ID(EQN), init2eqn(cell->getParam(ID::INIT), 1));
-                    cnt++;
-                }
-                if (cell->type == ID(LUT2)) {
-                    cell->setParam(ID(EQN), init2eqn(cell->getParam(ID::INIT), 2));
-                    cnt++;
-                }
-                if (cell->type == ID(LUT3)) {
-                    cell->setParam(ID(EQN), init2eqn(cell->getParam(ID::INIT), 3));
-                    cnt++;
-                }
-                if (cell->type == ID(LUT4)) {
-                    cell->setParam(ID(EQN), init2eqn(cell->getParam(ID::INIT), 4));
-                    cnt++;
-                }
-                if (cell->type == ID(LUT5)) {
-                    cell->setParam(ID(EQN), init2eqn(cell->getParam(ID::INIT), 5));
-                    cnt++;
-                }
+                auto it = lut_inputs.find(cell->type);
+                if (it == lut_inputs.end())
+                    continue;
+
+                int inputs = it->second;
+                auto key = std::make_pair(inputs, init2word(cell->getParam(ID::INIT), inputs));
+                auto eqn = eqn_cache.find(key);
+                if (eqn == eqn_cache.end())
+                    eqn = eqn_cache.emplace(key, word2eqn(key.second, inputs)).first;
+                cell->setParam(ID(EQN), eqn->second);
+                cnt++;
             }
         }
         log_header(design, "Updated %d of LUT* elements with equation.\n", cnt);
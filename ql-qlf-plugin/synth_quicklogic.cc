@@ -21,6 +21,11 @@
 #include "kernel/register.h"
 #include "kernel/rtlil.h"
 
+#include <algorithm>
+
+#include "../common/script_profiler.h"
+#include "ql-lib-cache.h"
+
 USING_YOSYS_NAMESPACE
 PRIVATE_NAMESPACE_BEGIN
 
@@ -78,6 +83,11 @@ struct SynthQuickLogicPass : public ScriptPass {
         log("        ports. Specifying this forces usage of DSP block with configuration\n");
         log("        bits available as module parameters.\n");
         log("\n");
+        log("    -dsp_techmap\n");
+        log("        For qlf_k6n10f, map multipliers to the final DSP cells with the\n");
+        log("        dsp_map.v and dsp_final_map.v techmap libraries instead of the\n");
+        log("        ql_dsp_legalize pass. Meant as a reference for the native pass.\n");
+        log("\n");
         log("    -no_adder\n");
         log("        By default use adder cells in output netlist.\n");
         log("        Specifying this switch turns it off.\n");
@@ -90,6 +100,23 @@ struct SynthQuickLogicPass : public ScriptPass {
         log("        Emit specialized BRAM cells for particular address and data width\n");
         log("        configurations.\n");
         log("\n");
+        log("    -abc_threads <N>\n");
+        log("        For qlf_k6n10f, map LUTs with ql_abc_partition, which runs 'abc -lut 6'\n");
+        log("        on independent partitions of the netlist, N processes at a time. 0\n");
+        log("        uses all cores. This replaces abc9, logic is not optimized across\n");
+        log("        partitions.\n");
+        log("\n");
+        log("    -no_lib_cache\n");
+        log("        By default the cell libraries and techmap map files are parsed once\n");
+        log("        and kept for later runs in the same Yosys process, keyed by file and\n");
+        log("        defines. Specifying this switch reads them on every run. Files are\n");
+        log("        read again when they or the files they `include change, includes\n");
+        log("        with a name given by a macro are not tracked and need this switch.\n");
+        log("\n");
+        log("    -clear_lib_cache\n");
+        log("        Free the cell libraries and techmap map files kept by earlier runs\n");
+        log("        before running, they are parsed again.\n");
+        log("\n");
         log("    -no_ff_map\n");
         log("        By default ff techmap is turned on. Specifying this switch turns it off.\n");
         log("\n");
@@ -97,21 +124,59 @@ struct SynthQuickLogicPass : public ScriptPass {
         log("        By default infer synchronous S/R flip-flops for architectures that\n");
         log("        support them. Specifying this switch turns it off.\n");
         log("\n");
+        log("    -hier_split\n");
+        log("        Do not flatten the design before synthesis. Every unique module is\n");
+        log("        synthesized once, no matter how many times it is instantiated, and the\n");
+        log("        design is flattened after LUT mapping, followed by a light optimization\n");
+        log("        across the former module boundaries. The modules are synthesized one\n");
+        log("        after another in this process, as passes can not run concurrently.\n");
+        log("\n");
+        log("    -checkpoint <dir>\n");
+        log("        Write the design to <dir>/<label>.il after each of the coarse,\n");
+        log("        map_bram, map_ffs, map_luts and map_cells steps that is executed.\n");
+        log("\n");
+        log("    -resume\n");
+        log("        Load the latest snapshot found in the -checkpoint directory and\n");
+        log("        continue the script from the step that follows it. The other\n");
+        log("        options should match the ones of the run that wrote the snapshot.\n");
+        log("\n");
+        log("    -profile <file>\n");
+        log("        Record wall time, peak RSS and cell/wire counts of the design before\n");
+        log("        and after each executed command and write them to the given file.\n");
+        log("        Files with the '.csv' extension get one line per command, any other\n");
+        log("        file gets JSON with per command entries and per label totals.\n");
+        log("\n");
         log("\n");
         log("The following commands are executed by this synthesis command:\n");
         help_script();
         log("\n");
     }
 
-    string top_opt, edif_file, blif_file, family, currmodule, verilog_file, use_dsp_cfg_params, lib_path;
+    string top_opt, edif_file, blif_file, family, currmodule, verilog_file, use_dsp_cfg_params, lib_path, profile_file, checkpoint_dir;
     bool nodsp;
+    bool dspTechmap;
+    bool libCache;
+    bool clearLibCache;
     bool inferAdder;
     bool inferBram;
     bool bramTypes;
     bool abcOpt;
     bool abc9;
+    int abcThreads;
     bool noffmap;
     bool nosdff;
+    bool hier_split;
+    bool resume;
+
+    ScriptProfiler profiler;
+
+    // Labels after which a snapshot is written with -checkpoint, in script order
+    const std::vector<std::string> checkpoint_labels = {"coarse", "map_bram", "map_ffs", "map_luts", "map_cells"};
+
+    // All labels of the script, in order, used to find where to resume
+    const std::vector<std::string> script_labels = {"begin",    "prepare", "map_dsp",   "coarse", "map_bram", "map_ffram", "map_gates", "map_ffs",
+                                                    "map_luts", "flatten", "map_cells", "check",  "iomap",    "finalize",  "blif",      "edif",
+                                                    "verilog"};
 
     void clear_flags() override
     {
@@ -126,11 +191,20 @@ struct SynthQuickLogicPass : public ScriptPass {
         bramTypes = false;
         abcOpt = true;
         abc9 = true;
+        abcThreads = -1;
         noffmap = false;
         nodsp = false;
+        dspTechmap = false;
+        libCache = true;
+        clearLibCache = false;
         nosdff = false;
+        hier_split = false;
+        resume = false;
+        checkpoint_dir = "";
         use_dsp_cfg_params = "";
         lib_path = "+/quicklogic/";
+        profile_file = "";
+        profiler.clear();
     }
 
     void execute(std::vector<std::string> args, RTLIL::Design *design) override
@@ -180,6 +254,10 @@ struct SynthQuickLogicPass : public ScriptPass {
                 use_dsp_cfg_params = " -use_dsp_cfg_params";
                 continue;
             }
+            if (args[argidx] == "-dsp_techmap") {
+                dspTechmap = true;
+                continue;
+            }
             if (args[argidx] == "-no_adder") {
                 inferAdder = false;
                 continue;
@@ -200,6 +278,20 @@ struct SynthQuickLogicPass : public ScriptPass {
                 abc9 = false;
                 continue;
             }
+            if (args[argidx] == "-abc_threads" && argidx + 1 < args.size()) {
+                abcThreads = atoi(args[++argidx].c_str());
+                if (abcThreads < 0)
+                    log_cmd_error("Invalid number of ABC threads!\n");
+                continue;
+            }
+            if (args[argidx] == "-no_lib_cache") {
+                libCache = false;
+                continue;
+            }
+            if (args[argidx] == "-clear_lib_cache") {
+                clearLibCache = true;
+                continue;
+            }
             if (args[argidx] == "-no_ff_map") {
                 noffmap = true;
                 continue;
@@ -208,6 +300,22 @@ struct SynthQuickLogicPass : public ScriptPass {
                 nosdff = true;
                 continue;
             }
+            if (args[argidx] == "-hier_split") {
+                hier_split = true;
+                continue;
+            }
+            if (args[argidx] == "-checkpoint" && argidx + 1 < args.size()) {
+                checkpoint_dir = args[++argidx];
+                continue;
+            }
+            if (args[argidx] == "-resume") {
+                resume = true;
+                continue;
+            }
+            if (args[argidx] == "-profile" && argidx + 1 < args.size()) {
+                profile_file = args[++argidx];
+                continue;
+            }
 
             break;
         }
@@ -227,26 +335,147 @@ struct SynthQuickLogicPass : public ScriptPass {
             nosdff = true;
         }
 
+        if (abcThreads >= 0 && family != "qlf_k6n10f") {
+            log_warning("-abc_threads is only supported for qlf_k6n10f, ignoring it for %s.\n", family.c_str());
+            abcThreads = -1;
+        }
+
+        if (family == "qlf_k6n10f" && abcThreads >= 0) {
+            abc9 = false;
+        }
+
         if (abc9 && design->scratchpad_get_int("abc9.D", 0) == 0) {
             log_warning("delay target has not been set via SDC or scratchpad; assuming 12 MHz clock.\n");
             design->scratchpad_set_int("abc9.D", 500); // 12MHz = 83.33.. ns; divided by two to allow for interconnect delay.
         }
 
+        if (resume && checkpoint_dir.empty())
+            log_cmd_error("-resume requires -checkpoint <dir>.\n");
+
+        if (resume && !run_from.empty())
+            log_cmd_error("-resume cannot be combined with -run.\n");
+
         log_header(design, "Executing SYNTH_QUICKLOGIC pass.\n");
         log_push();
 
+        if (clearLibCache) {
+            QlLibCache::clear();
+        }
+
+        if (resume) {
+            run_from = resume_from_checkpoint(design);
+        } else if (!checkpoint_dir.empty()) {
+            // Remove the snapshots of a previous run, so that -resume never picks a stale one
+            create_directory(checkpoint_dir);
+            for (const auto &label : checkpoint_labels) {
+                remove(checkpoint_file(label).c_str());
+            }
+        }
+
         run_script(design, run_from, run_to);
 
+        if (!profile_file.empty()) {
+            log("Writing profile to '%s'.\n", profile_file.c_str());
+            profiler.write(profile_file);
+            profiler.clear();
+        }
+
         log_pop();
     }
 
+    std::string checkpoint_file(const std::string &label) const { return checkpoint_dir + "/" + label + ".il"; }
+
+    // Replaces the design with the latest snapshot and returns the label to continue from
+    std::string resume_from_checkpoint(RTLIL::Design *design)
+    {
+        for (auto it = checkpoint_labels.rbegin(); it != checkpoint_labels.rend(); ++it) {
+            std::string filename = checkpoint_file(*it);
+            if (!check_file_exists(filename))
+                continue;
+
+            log("Resuming from snapshot '%s'.\n", filename.c_str());
+            for (auto module : design->modules().to_vector()) {
+                design->remove(module);
+            }
+            Pass::call(design, "read_rtlil " + filename);
+
+            auto label = std::find(script_labels.begin(), script_labels.end(), *it);
+            log_assert(label != script_labels.end() && label + 1 != script_labels.end());
+            return *(label + 1);
+        }
+        log_cmd_error("No snapshot found in '%s'.\n", checkpoint_dir.c_str());
+    }
+
+    // Writes a snapshot of the design after the specified label
+    void checkpoint(const std::string &label)
+    {
+        if (help_mode) {
+            run("write_rtlil <dir>/" + label + ".il", "(if -checkpoint)");
+        } else if (!checkpoint_dir.empty()) {
+            run("write_rtlil " + checkpoint_file(label));
+        }
+    }
+
+    // These hide ScriptPass::check_label() and ScriptPass::run() so that the
+    // commands of the script can be profiled.
+    bool check_label(std::string label, std::string info = std::string())
+    {
+        bool active = ScriptPass::check_label(label, info);
+        if (active) {
+            profiler.setLabel(label);
+        }
+        return active;
+    }
+
+    void run(std::string command, std::string info = std::string())
+    {
+        if (help_mode) {
+            ScriptPass::run(command, info);
+            return;
+        }
+
+        if (!profile_file.empty()) {
+            profiler.begin(active_design, command);
+        }
+        run_cached(command);
+        if (!profile_file.empty()) {
+            profiler.end(active_design);
+        }
+    }
+
+    // Runs a command, reading the cell libraries and techmap map files from
+    // the library cache unless -no_lib_cache is given
+    void run_cached(const std::string &command)
+    {
+        std::string flags;
+        std::vector<std::string> files;
+        if (!libCache) {
+            ScriptPass::run(command);
+        } else if (QlLibCache::parseReadLibrary(command, flags, files)) {
+            log("\n-- Running command `%s' from the library cache --\n", command.c_str());
+            QlLibCache::readLibrary(active_design, flags, files);
+            active_design->check();
+        } else {
+            ScriptPass::run(QlLibCache::techmapCommand(command));
+        }
+    }
+
     void script() override
     {
         if (help_mode) {
             family = "<family>";
         }
 
+        // Computed outside of the labels, as they are needed by the labels after "prepare"
+        // also when the script is started later with -run or -resume
         std::string noDFFArgs;
+        if (nosdff) {
+            noDFFArgs += " -nosdff";
+        }
+        if (family == "qlf_k4n8") {
+            noDFFArgs += " -nodffe";
+        }
+
         if (check_label("begin")) {
             std::string family_path = " " + lib_path + family;
             std::string readVelArgs;
@@ -269,7 +498,9 @@ struct SynthQuickLogicPass : public ScriptPass {
 
         if (check_label("prepare")) {
             run("proc");
-            run("flatten");
+            if (help_mode || !hier_split) {
+                run("flatten", "(unless -hier_split)");
+            }
             if (help_mode || family == "pp3") {
                 run("tribuf -logic", "                   (for pp3)");
             }
@@ -277,13 +508,6 @@ struct SynthQuickLogicPass : public ScriptPass {
             run("opt_expr");
             run("opt_clean");
 
-            if (nosdff) {
-                noDFFArgs += " -nosdff";
-            }
-            if (family == "qlf_k4n8") {
-                noDFFArgs += " -nodffe";
-            }
-
             run("check");
             run("opt -nodffe -nosdff");
             run("fsm");
@@ -294,7 +518,7 @@ struct SynthQuickLogicPass : public ScriptPass {
             run("share");
         }
 
-        if (check_label("map_dsp"), "(skip if -no_dsp)") {
+        if (check_label("map_dsp", "(skip if -no_dsp)")) {
             if (help_mode || family == "qlf_k6n10") {
                 if (help_mode || !nodsp) {
                     run("memory_dff", "                      (for qlf_k6n10)");
@@ -333,14 +557,11 @@ struct SynthQuickLogicPass : public ScriptPass {
                     run("ql_dsp_macc" + use_dsp_cfg_params, "(for qlf_k6n10f)");
                     run("techmap -map +/mul2dsp.v [...]", "  (for qlf_k6n10f)");
                     run("chtype -set $mul t:$__soft_mul", "  (for qlf_k6n10f)");
-                    run("techmap -map " + lib_path + family + "/dsp_map.v", "(for qlf_k6n10f)");
-                    if (use_dsp_cfg_params.empty())
-                        run("techmap -map " + lib_path + family + "/dsp_map.v -D USE_DSP_CFG_PARAMS=0", "(for qlf_k6n10f)");
-                    else
-                        run("techmap -map " + lib_path + family + "/dsp_map.v -D USE_DSP_CFG_PARAMS=1", "(for qlf_k6n10f)");
-                    run("ql_dsp_simd", "                     (for qlf_k6n10f)");
-                    run("techmap -map " + lib_path + family + "/dsp_final_map.v", "(for qlf_k6n10f)");
-                    run("ql_dsp_io_regs", "                  (for qlf_k6n10f)");
+                    run("ql_dsp_legalize" + use_dsp_cfg_params, "(for qlf_k6n10f unless -dsp_techmap)");
+                    run("techmap -map " + lib_path + family + "/dsp_map.v", "(for qlf_k6n10f if -dsp_techmap)");
+                    run("ql_dsp_simd", "                     (for qlf_k6n10f if -dsp_techmap)");
+                    run("techmap -map " + lib_path + family + "/dsp_final_map.v", "(for qlf_k6n10f if -dsp_techmap)");
+                    run("ql_dsp_io_regs", "                  (for qlf_k6n10f if -dsp_techmap)");
                 } else if (!nodsp) {
 
                     run("wreduce t:$mul");
@@ -354,13 +575,17 @@ struct SynthQuickLogicPass : public ScriptPass {
                                     rule.a_maxwidth, rule.b_maxwidth, rule.a_minwidth, rule.b_minwidth, rule.type.c_str()));
                         run("chtype -set $mul t:$__soft_mul");
                     }
-                    if (use_dsp_cfg_params.empty())
-                        run("techmap -map " + lib_path + family + "/dsp_map.v -D USE_DSP_CFG_PARAMS=0");
-                    else
-                        run("techmap -map " + lib_path + family + "/dsp_map.v -D USE_DSP_CFG_PARAMS=1");
-                    run("ql_dsp_simd");
-                    run("techmap -map " + lib_path + family + "/dsp_final_map.v");
-                    run("ql_dsp_io_regs");
+                    if (!dspTechmap) {
+                        run("ql_dsp_legalize" + use_dsp_cfg_params);
+                    } else {
+                        if (use_dsp_cfg_params.empty())
+                            run("techmap -map " + lib_path + family + "/dsp_map.v -D USE_DSP_CFG_PARAMS=0");
+                        else
+                            run("techmap -map " + lib_path + family + "/dsp_map.v -D USE_DSP_CFG_PARAMS=1");
+                        run("ql_dsp_simd");
+                        run("techmap -map " + lib_path + family + "/dsp_final_map.v");
+                        run("ql_dsp_io_regs");
+                    }
                 }
             }
         }
@@ -374,6 +599,7 @@ struct SynthQuickLogicPass : public ScriptPass {
             run("opt" + noDFFArgs);
             run("memory -nomap");
             run("opt_clean");
+            checkpoint("coarse");
         }
 
         if (check_label("map_bram", "(skip if -no_bram)") && (help_mode || family == "qlf_k6n10" || family == "qlf_k6n10f" || family == "pp3") && inferBram) {
@@ -393,68 +619,11 @@ struct SynthQuickLogicPass : public ScriptPass {
                 run("techmap -map " + lib_path + family + "/brams_final_map.v");
             }
 
-           
-            // Perform a series of 'chtype' passess
-            if (help_mode) {
-                run("chtype -set TDP36K_<mode> t:TDP36K a:<mode>", "(if -bram_types)");
-            }
-            if (bramTypes) {
-							
-				for (int a_dwidth : {1, 2, 4, 9, 18, 36})
-                    for (int b_dwidth: {1, 2, 4, 9, 18, 36}) {
-                        auto cmd = stringf("chtype -set TDP36K_BRAM_A_X%d_B_X%d_nonsplit t:TDP36K a:is_inferred=0 %%i a:is_fifo=0 %%i a:port_a_dwidth=%d %%i a:port_b_dwidth=%d %%i",
-                                            a_dwidth, b_dwidth, a_dwidth, b_dwidth);
-                        run(cmd);						
-						
-                        auto cmd1 = stringf("chtype -set TDP36K_FIFO_ASYNC_A_X%d_B_X%d_nonsplit t:TDP36K a:is_inferred=0 %%i a:is_fifo=1 %%i a:sync_fifo=0 %%i "
-                                            "a:port_a_dwidth=%d %%i a:port_b_dwidth=%d %%i",
-                                            a_dwidth, b_dwidth, a_dwidth, b_dwidth);
-                        run(cmd1);
-
-                        auto cmd2 = stringf("chtype -set TDP36K_FIFO_SYNC_A_X%d_B_X%d_nonsplit t:TDP36K a:is_inferred=0 %%i a:is_fifo=1 %%i a:sync_fifo=1 %%i "
-                                            "a:port_a_dwidth=%d %%i a:port_b_dwidth=%d %%i",
-                                            a_dwidth, b_dwidth, a_dwidth, b_dwidth);
-                        run(cmd2);
-                    }
-
-                for (int a1_dwidth : {1, 2, 4, 9, 18})
-                    for (int b1_dwidth: {1, 2, 4, 9, 18})
-                        for (int a2_dwidth : {1, 2, 4, 9, 18})
-                            for (int b2_dwidth: {1, 2, 4, 9, 18}) {
-                                auto cmd = stringf("chtype -set TDP36K_BRAM_A1_X%d_B1_X%d_A2_X%d_B2_X%d_split t:TDP36K a:is_inferred=0 %%i a:is_split=1 %%i a:is_fifo=0 %%i a:port_a1_dwidth=%d %%i a:port_b1_dwidth=%d %%i a:port_a2_dwidth=%d %%i a:port_b2_dwidth=%d %%i",
-                                                    a1_dwidth, b1_dwidth, a2_dwidth, b2_dwidth, a1_dwidth, b1_dwidth, a2_dwidth, b2_dwidth);
-                                run(cmd);	
-										
-                                auto cmd1 = stringf("chtype -set TDP36K_FIFO_ASYNC_A1_X%d_B1_X%d_A2_X%d_B2_X%d_split t:TDP36K a:is_inferred=0 %%i a:is_split=1 %%i a:is_fifo=1 %%i a:sync_fifo=0 %%i "
-                                                     "a:port_a1_dwidth=%d %%i a:port_b1_dwidth=%d %%i a:port_a2_dwidth=%d %%i a:port_b2_dwidth=%d %%i",
-                                                    a1_dwidth, b1_dwidth, a2_dwidth, b2_dwidth, a1_dwidth, b1_dwidth, a2_dwidth, b2_dwidth);
-                                run(cmd1);
-
-                                auto cmd2 = stringf("chtype -set TDP36K_FIFO_SYNC_A1_X%d_B1_X%d_A2_X%d_B2_X%d_split t:TDP36K a:is_inferred=0 %%i a:is_split=1 %%i a:is_fifo=1 %%i a:sync_fifo=1 %%i "
-                                                    "a:port_a1_dwidth=%d %%i a:port_b1_dwidth=%d %%i a:port_a2_dwidth=%d %%i a:port_b2_dwidth=%d %%i",
-                                                    a1_dwidth, b1_dwidth, a2_dwidth, b2_dwidth, a1_dwidth, b1_dwidth, a2_dwidth, b2_dwidth);
-                                run(cmd2);
-                            }				
-				
-
-                for (int a_width : {1, 2, 4, 9, 18, 36})
-                    for (int b_width: {1, 2, 4, 9, 18, 36}) {
-                        auto cmd = stringf(
-                          "chtype -set TDP36K_BRAM_A_X%d_B_X%d_nonsplit t:TDP36K a:is_inferred=1 %%i a:port_a_width=%d %%i a:port_b_width=%d %%i",
-                          a_width, b_width, a_width, b_width);
-                        run(cmd);
-                    }
-
-                for (int a1_width : {1, 2, 4, 9, 18})
-                    for (int b1_width: {1, 2, 4, 9, 18})
-                        for (int a2_width : {1, 2, 4, 9, 18})
-                            for (int b2_width: {1, 2, 4, 9, 18}) {
-                                auto cmd = stringf(
-                                "chtype -set TDP36K_BRAM_A1_X%d_B1_X%d_A2_X%d_B2_X%d_split t:TDP36K a:is_inferred=1 %%i a:port_a1_width=%d %%i a:port_b1_width=%d %%i a:port_a2_width=%d %%i a:port_b2_width=%d %%i",
-                                a1_width, b1_width, a2_width, b2_width, a1_width, b1_width, a2_width, b2_width);
-                                run(cmd);
-                            }
+            // Change the TDP36K cells to the types of their configurations
+            if (help_mode || bramTypes) {
+                run("ql_bram_types", "(if -bram_types)");
             }
+            checkpoint("map_bram");
         }
 
         if (check_label("map_ffram")) {
@@ -521,11 +690,17 @@ struct SynthQuickLogicPass : public ScriptPass {
             run("opt_merge");
             run("opt_clean");
             run("opt" + noDFFArgs);
+            checkpoint("map_ffs");
         }
 
         if (check_label("map_luts")) {
             if (help_mode || abcOpt) {
-                if (help_mode || family == "qlf_k6n10" || family == "qlf_k6n10f") {
+                if (help_mode) {
+                    run("ql_abc_partition -lut 6 -threads <N>", "(for qlf_k6n10f if -abc_threads)");
+                }
+                if (!help_mode && family == "qlf_k6n10f" && abcThreads >= 0) {
+                    run(stringf("ql_abc_partition -lut 6 -threads %d", abcThreads));
+                } else if (help_mode || family == "qlf_k6n10" || family == "qlf_k6n10f") {
                     if (abc9) {
                         run("read_verilog -lib -specify -icells +/quicklogic/pp3/abc9_model.v");
                         //run("techmap -map +/quicklogic/pp3/abc9_map.v");
@@ -564,6 +739,15 @@ struct SynthQuickLogicPass : public ScriptPass {
             }
             run("clean");
             run("opt_lut");
+            checkpoint("map_luts");
+        }
+
+        if (check_label("flatten", "(if -hier_split)") && (help_mode || hier_split)) {
+            run("flatten");
+            run("opt_expr");
+            run("opt_merge");
+            run("opt_clean");
+            run("opt_lut");
         }
 
         if (check_label("map_cells", "(for pp3, qlf_k6n10)") && (help_mode || family == "qlf_k6n10" || family == "pp3")) {
@@ -571,6 +755,7 @@ struct SynthQuickLogicPass : public ScriptPass {
             techMapArgs = "-map " + lib_path + family + "/lut_map.v";
             run("techmap " + techMapArgs);
             run("clean");
+            checkpoint("map_cells");
         }
 
         if (check_label("check")) {
@@ -0,0 +1,21 @@
+yosys -import
+if { [info procs quicklogic_eqn] == {} } { plugin -i ql-qlf }
+yosys -import  ;# ingest plugin commands
+
+# LUT mapping on several partitions for qlf_k6n10f
+read_verilog $::env(DESIGN_TOP).v
+hierarchy -top top
+yosys proc
+equiv_opt -assert -map +/quicklogic/qlf_k6n10f/cells_sim.v synth_quicklogic -family qlf_k6n10f -no_adder -abc_threads 2
+design -load postopt
+yosys cd top
+
+stat
+select -assert-min 1 t:\$lut
+select -assert-none t:\$_AND_ t:\$_OR_ t:\$_XOR_ t:\$_NOT_ t:\$_MUX_
+
+# -abc_threads only applies to qlf_k6n10f, other families warn and use abc
+design -reset
+read_verilog $::env(DESIGN_TOP).v
+hierarchy -top top
+synth_quicklogic -family qlf_k6n10 -abc_threads 2 -run begin:prepare
@@ -0,0 +1,40 @@
+// Copyright 2020-2022 F4PGA Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+// Logic cones separated by registers, mapped in several partitions
+module top (
+    input clk,
+    input [7:0] a,
+    input [7:0] b,
+    input [3:0] sel,
+    output reg [7:0] x,
+    output reg [7:0] y,
+    output z
+);
+  reg [7:0] ra, rb;
+
+  always @(posedge clk) begin
+    ra <= a ^ {b[3:0], b[7:4]};
+    rb <= sel[0] ? a & b : a | ~b;
+  end
+
+  always @(posedge clk) begin
+    x <= sel[1] ? ra : (ra ^ rb) & {8{sel[2]}};
+    y <= {rb[6:0], rb[7]} ^ (sel[3] ? ra : ~ra);
+  end
+
+  assign z = ^x & |y;
+endmodule
@@ -0,0 +1,17 @@
+yosys -import
+if { [info procs quicklogic_eqn] == {} } { plugin -i ql-qlf }
+yosys -import  ;# ingest plugin commands
+
+set SNAPSHOT_DIR [test_output_path "checkpoint_snapshots"]
+file delete -force $SNAPSHOT_DIR
+
+# Full run writing the snapshots
+read_verilog $::env(DESIGN_TOP).v
+hierarchy -top top
+synth_quicklogic -family qlf_k4n8 -checkpoint $SNAPSHOT_DIR
+design -reset
+
+# Run resumed from the latest snapshot
+synth_quicklogic -family qlf_k4n8 -checkpoint $SNAPSHOT_DIR -resume
+yosys cd top
+select -assert-min 1 t:\$lut
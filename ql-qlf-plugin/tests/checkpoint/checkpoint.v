@@ -0,0 +1,36 @@
+// Copyright 2020-2022 F4PGA Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+module sub (
+    input  [3:0] a,
+    input  [3:0] b,
+    output [3:0] y
+);
+  assign y = (a & b) ^ {b[2:0], a[3]};
+endmodule
+
+module top (
+    input  [3:0] a,
+    input  [3:0] b,
+    output [7:0] y
+);
+  wire [3:0] y0, y1;
+
+  sub sub0 (.a(a), .b(b), .y(y0));
+  sub sub1 (.a(b), .b(a), .y(y1));
+
+  assign y = {y1, y0};
+endmodule
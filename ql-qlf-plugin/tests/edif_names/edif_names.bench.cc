@@ -0,0 +1,72 @@
+/*
+ * Copyright 2020-2022 F4PGA Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ */
+#include "ql-edif-names.h"
+
+#include "kernel/yosys.h"
+
+#include <benchmark/benchmark.h>
+
+#include <string>
+#include <vector>
+
+// Net names as written by synth_quicklogic, a quarter of them needs renaming
+static std::vector<RTLIL::IdString> makeNames(int a_Count)
+{
+    std::vector<RTLIL::IdString> names;
+    names.reserve(a_Count);
+    for (int i = 0; i < a_Count; ++i) {
+        if (i % 4 == 0) {
+            names.push_back(stringf("$auto$alumacc.cc:485:replace_alu$%d", i));
+        } else {
+            names.push_back(stringf("\\core_data_%d", i));
+        }
+    }
+    return names;
+}
+
+// Every name seen for the first time, as when writing the definitions
+static void BM_EdifNamesDefine(benchmark::State &state)
+{
+    std::vector<RTLIL::IdString> names = makeNames(state.range(0));
+    for (auto _ : state) {
+        EdifNames edif_names;
+        for (const auto &name : names) {
+            benchmark::DoNotOptimize(edif_names(RTLIL::unescape_id(name), true));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * names.size());
+}
+BENCHMARK(BM_EdifNamesDefine)->RangeMultiplier(8)->Range(1 << 9, 1 << 15);
+
+// Repeated references to known names, as when writing the connections
+static void BM_EdifNamesRef(benchmark::State &state)
+{
+    std::vector<RTLIL::IdString> names = makeNames(state.range(0));
+    EdifNames edif_names;
+    for (const auto &name : names) {
+        edif_names.ref(name);
+    }
+    for (auto _ : state) {
+        for (const auto &name : names) {
+            benchmark::DoNotOptimize(edif_names.ref(name));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * names.size());
+}
+BENCHMARK(BM_EdifNamesRef)->RangeMultiplier(8)->Range(1 << 9, 1 << 15);
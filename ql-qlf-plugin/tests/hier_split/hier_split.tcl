@@ -0,0 +1,33 @@
+yosys -import
+if { [info procs quicklogic_eqn] == {} } { plugin -i ql-qlf }
+yosys -import  ;# ingest plugin commands
+
+# Reference: the design flattened before synthesis
+read_verilog $::env(DESIGN_TOP).v
+hierarchy -top top
+synth_quicklogic -family qlf_k4n8
+yosys cd top
+select -assert-count 8 t:\$lut
+yosys cd
+design -reset
+
+# Synthesis without flattening, the design must still be flat at the end
+read_verilog $::env(DESIGN_TOP).v
+hierarchy -top top
+proc
+design -save rtl
+synth_quicklogic -family qlf_k4n8 -hier_split
+yosys cd top
+select -assert-none t:sub
+select -assert-count 8 t:\$lut
+yosys cd
+design -stash gate
+
+# The result must be equivalent to the flattened RTL
+design -load rtl
+flatten
+design -stash gold
+design -copy-from gold -as gold top
+design -copy-from gate -as gate top
+miter -equiv -flatten -make_assert gold gate miter
+sat -verify -prove-asserts miter
@@ -0,0 +1,37 @@
+yosys -import
+if { [info procs quicklogic_eqn] == {} } { plugin -i ql-qlf }
+yosys -import  ;# ingest plugin commands
+
+# Synthesize the same design twice in one process, the second run has to
+# take the libraries from the cache and give the same result
+read_verilog $::env(DESIGN_TOP).v
+design -save read
+
+synth_quicklogic -family qlf_k6n10f -top top -no_abc9
+yosys cd top
+select -assert-count 1 t:QL_DSP2_MULT
+
+design -load read
+synth_quicklogic -family qlf_k6n10f -top top -no_abc9
+yosys cd top
+select -assert-count 1 t:QL_DSP2_MULT
+
+# Without the cache the libraries are read as before
+design -load read
+synth_quicklogic -family qlf_k6n10f -top top -no_abc9 -no_lib_cache
+yosys cd top
+select -assert-count 1 t:QL_DSP2_MULT
+
+# A verilog_defines set on the design is part of the key of library reads
+design -load read
+verilog_defines -DQL_LIB_CACHE_TEST
+synth_quicklogic -family qlf_k6n10f -top top -no_abc9
+yosys cd top
+select -assert-count 1 t:QL_DSP2_MULT
+verilog_defines -UQL_LIB_CACHE_TEST
+
+# Clearing the cache frees the saved designs, they are read again
+design -load read
+synth_quicklogic -family qlf_k6n10f -top top -no_abc9 -clear_lib_cache
+yosys cd top
+select -assert-count 1 t:QL_DSP2_MULT
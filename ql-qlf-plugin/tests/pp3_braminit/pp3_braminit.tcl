@@ -0,0 +1,11 @@
+yosys -import
+if { [info procs quicklogic_eqn] == {} } { plugin -i ql-qlf }
+yosys -import  ;# ingest plugin commands
+
+read_verilog $::env(DESIGN_TOP).v
+pp3_braminit
+
+# Both cells share the init file, word 0 is left at zero since its over-long
+# value is rejected
+select -assert-count 2 t:RAM_8K_BLK r:INIT=72'haaaa80001ffffc0000 %i
+select -assert-none t:RAM_8K_BLK r:INIT_FILE %i
@@ -0,0 +1,44 @@
+// Copyright 2020-2022 F4PGA Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+module top (
+    input  wire        clk,
+    input  wire [ 1:0] addr,
+    output wire [17:0] data
+);
+
+  RAM_8K_BLK #(
+      .INIT_FILE     ("init_18.txt"),
+      .data_width_int(18),
+      .data_depth_int(4)
+  ) ram_a (
+      .WClk(clk),
+      .RClk(clk),
+      .RA(addr),
+      .RD(data)
+  );
+
+  RAM_8K_BLK #(
+      .INIT_FILE     ("init_18.txt"),
+      .data_width_int(18),
+      .data_depth_int(4)
+  ) ram_b (
+      .WClk(clk),
+      .RClk(clk),
+      .RA(addr)
+  );
+
+endmodule
@@ -0,0 +1,15 @@
+yosys -import
+if { [info procs quicklogic_eqn] == {} } { plugin -i ql-qlf }
+yosys -import  ;# ingest plugin commands
+
+read_verilog $::env(DESIGN_TOP).v
+design -save read
+
+# JSON report
+hierarchy -top top
+synth_quicklogic -family qlf_k4n8 -profile $::env(DESIGN_TOP).json
+
+# CSV report
+design -load read
+hierarchy -top top
+synth_quicklogic -family qlf_k4n8 -profile $::env(DESIGN_TOP).csv
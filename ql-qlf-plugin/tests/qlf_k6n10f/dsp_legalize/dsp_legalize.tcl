@@ -0,0 +1,54 @@
+yosys -import
+if { [info procs quicklogic_eqn] == {} } { plugin -i ql-qlf}
+yosys -import  ;# ingest plugin commands
+
+read_verilog dsp_legalize.v
+design -save read
+
+# Synthesizes the design with the given extra options, checks that the result
+# is equivalent to the input and that it contains the expected DSP cells. Both
+# the native ql_dsp_legalize route and the -dsp_techmap reference route have
+# to give the same cells.
+proc check_dsp_route {top options dsp} {
+    design -load read
+    hierarchy -top ${top}
+    design -save preopt
+
+    synth_quicklogic -family qlf_k6n10f -top ${top} {*}${options}
+    design -stash postopt
+
+    design -copy-from preopt  -as gold A:top
+    design -copy-from postopt -as gate A:top
+
+    techmap -wb -autoproc -map +/quicklogic/qlf_k6n10f/cells_sim.v
+    techmap -wb -autoproc -map +/quicklogic/qlf_k6n10f/dsp_sim.v
+    yosys proc
+    opt_expr
+    opt_clean -purge
+
+    async2sync
+    equiv_make gold gate equiv
+    equiv_induct equiv
+    equiv_status -assert equiv
+
+    design -load postopt
+    yosys cd ${top}
+    # Two 8x8 multipliers packed in SIMD mode, one 20x18 multiplier and one MACC
+    select -assert-count 2 t:${dsp}_MULT
+    select -assert-count 1 t:${dsp}_MULTACC
+    select -assert-count 0 t:dsp_t1_*
+    select -assert-count 0 t:\$__QL_MUL*
+
+    return
+}
+
+check_dsp_route "legalize_mixed" {} "QL_DSP2"
+check_dsp_route "legalize_mixed" {-dsp_techmap} "QL_DSP2"
+check_dsp_route "legalize_mixed" {-use_dsp_cfg_params} "QL_DSP3"
+check_dsp_route "legalize_mixed" {-use_dsp_cfg_params -dsp_techmap} "QL_DSP3"
+
+# Coefficients of another width than their field are resized as by techmap
+design -load read
+hierarchy -top legalize_narrow_coeff
+ql_dsp_legalize
+select -assert-count 1 t:QL_DSP2* r:MODE_BITS=80'h00000000000000300005 %i
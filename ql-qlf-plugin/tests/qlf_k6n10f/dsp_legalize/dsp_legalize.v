@@ -0,0 +1,62 @@
+// Copyright 2020-2022 F4PGA Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+module legalize_mixed (
+    input  wire        clk,
+
+    input  wire [ 7:0] a0,
+    input  wire [ 7:0] b0,
+    output wire [15:0] z0,
+
+    input  wire [ 7:0] a1,
+    input  wire [ 7:0] b1,
+    output wire [15:0] z1,
+
+    input  wire signed [19:0] a2,
+    input  wire signed [17:0] b2,
+    output wire signed [37:0] z2,
+
+    input  wire [ 7:0] a3,
+    input  wire [ 7:0] b3,
+    output reg  [15:0] z3
+);
+
+    assign z0 = a0 * b0;
+    assign z1 = a1 * b1;
+    assign z2 = a2 * b2;
+
+    always @(posedge clk)
+        z3 <= z3 + (a3 * b3);
+
+endmodule
+
+module legalize_narrow_coeff (
+    input  wire [19:0] a,
+    input  wire [17:0] b,
+    output wire [37:0] z
+);
+
+    // COEFF_0 is narrower than its MODE_BITS field and COEFF_1 is wider
+    dsp_t1_20x18x64_cfg_ports #(
+        .COEFF_0(4'd5),
+        .COEFF_1(24'hf00003)
+    ) dsp (
+        .a_i(a),
+        .b_i(b),
+        .z_o(z)
+    );
+
+endmodule
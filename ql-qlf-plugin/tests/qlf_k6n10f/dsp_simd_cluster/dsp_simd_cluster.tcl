@@ -0,0 +1,15 @@
+yosys -import
+if { [info procs quicklogic_eqn] == {} } { plugin -i ql-qlf}
+yosys -import  ;# ingest plugin commands
+
+read_verilog -lib +/quicklogic/qlf_k6n10f/dsp_sim.v
+read_verilog dsp_simd_cluster.v
+hierarchy -top top
+
+ql_dsp_simd -cluster
+select -assert-count 2 t:QL_DSP2
+select -assert-count 0 t:dsp_t1_10x9x32_cfg_ports
+
+# Multipliers of the same instance end up in the same SIMD cell
+select -assert-count 1 w:z0 %ci1 t:QL_DSP2 %i w:z2 %ci1 t:QL_DSP2 %i %i
+select -assert-count 1 w:z1 %ci1 t:QL_DSP2 %i w:z3 %ci1 t:QL_DSP2 %i %i
@@ -0,0 +1,115 @@
+// Copyright 2020-2022 F4PGA Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+// Flattened names of two instances of a module with two multipliers each.
+// In module order the multipliers of u0 and u1 alternate.
+module top (
+    input  wire         clk,
+
+    input  wire [ 7:0]  a0,
+    input  wire [ 7:0]  a1,
+    input  wire [ 7:0]  b0,
+    input  wire [ 7:0]  b1,
+    input  wire [ 7:0]  b2,
+    input  wire [ 7:0]  b3,
+
+    output wire [15:0]  z0,
+    output wire [15:0]  z1,
+    output wire [15:0]  z2,
+    output wire [15:0]  z3
+);
+
+    dsp_t1_10x9x32_cfg_ports \u0.mult_x  (
+        .a_i    (a0),
+        .b_i    (b0),
+        .z_o    (z0),
+
+        .clock_i            (clk),
+
+        .feedback_i         (3'd0),
+        .load_acc_i         (1'b0),
+        .unsigned_a_i       (1'b1),
+        .unsigned_b_i       (1'b1),
+
+        .output_select_i    (3'd0),
+        .saturate_enable_i  (1'b0),
+        .shift_right_i      (6'd0),
+        .round_i            (1'b0),
+        .subtract_i         (1'b0),
+        .register_inputs_i  (1'b1)
+    );
+
+    dsp_t1_10x9x32_cfg_ports \u1.mult_x  (
+        .a_i    (a1),
+        .b_i    (b1),
+        .z_o    (z1),
+
+        .clock_i            (clk),
+
+        .feedback_i         (3'd0),
+        .load_acc_i         (1'b0),
+        .unsigned_a_i       (1'b1),
+        .unsigned_b_i       (1'b1),
+
+        .output_select_i    (3'd0),
+        .saturate_enable_i  (1'b0),
+        .shift_right_i      (6'd0),
+        .round_i            (1'b0),
+        .subtract_i         (1'b0),
+        .register_inputs_i  (1'b1)
+    );
+
+    dsp_t1_10x9x32_cfg_ports \u0.mult_y  (
+        .a_i    (a0),
+        .b_i    (b2),
+        .z_o    (z2),
+
+        .clock_i            (clk),
+
+        .feedback_i         (3'd0),
+        .load_acc_i         (1'b0),
+        .unsigned_a_i       (1'b1),
+        .unsigned_b_i       (1'b1),
+
+        .output_select_i    (3'd0),
+        .saturate_enable_i  (1'b0),
+        .shift_right_i      (6'd0),
+        .round_i            (1'b0),
+        .subtract_i         (1'b0),
+        .register_inputs_i  (1'b1)
+    );
+
+    dsp_t1_10x9x32_cfg_ports \u1.mult_y  (
+        .a_i    (a1),
+        .b_i    (b3),
+        .z_o    (z3),
+
+        .clock_i            (clk),
+
+        .feedback_i         (3'd0),
+        .load_acc_i         (1'b0),
+        .unsigned_a_i       (1'b1),
+        .unsigned_b_i       (1'b1),
+
+        .output_select_i    (3'd0),
+        .saturate_enable_i  (1'b0),
+        .shift_right_i      (6'd0),
+        .round_i            (1'b0),
+        .subtract_i         (1'b0),
+        .register_inputs_i  (1'b1)
+    );
+
+endmodule
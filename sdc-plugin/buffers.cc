@@ -16,87 +16,138 @@
  * SPDX-License-Identifier: Apache-2.0
  */
 #include "buffers.h"
-#include <cassert>
+#include <algorithm>
 #include <cmath>
+#include <cstdlib>
 #include <limits>
 #include <string>
 #include <vector>
 
-const std::vector<std::string> Pll::inputs = {"CLKIN1", "CLKIN2"};
-const std::vector<std::string> Pll::outputs = {"CLKOUT0", "CLKOUT1", "CLKOUT2", "CLKOUT3", "CLKOUT4", "CLKOUT5"};
-const float Pll::delay = 0;
-const std::string Pll::name = "PLLE2_ADV";
-
-Pll::Pll(RTLIL::Cell *cell, float input_clock_period, float input_clock_rising_edge) : ClockDivider({"PLLE2_ADV"})
+const std::vector<ClockDivider> &ClockDivider::Types()
 {
-    assert(RTLIL::unescape_id(cell->type) == "PLLE2_ADV");
-    FetchParams(cell);
-    CheckInputClockPeriod(cell, input_clock_period);
-    CalculateOutputClockPeriods();
-    CalculateOutputClockWaveforms(input_clock_rising_edge);
+    static const std::vector<ClockDivider> types = {
+      {.type = "PLLE2_ADV",
+       .inputs = {"CLKIN1", "CLKIN2"},
+       .outputs = {"CLKOUT0", "CLKOUT1", "CLKOUT2", "CLKOUT3", "CLKOUT4", "CLKOUT5"},
+       .input_period = "CLKIN1_PERIOD",
+       .mult = {{"CLKFBOUT_MULT"}, 5.0},
+       .divide = {{"DIVCLK_DIVIDE"}, 1.0},
+       .feedback_phase = {{"CLKFBOUT_PHASE"}, 0.0},
+       .output_divide = {{"{}_DIVIDE"}, 1.0},
+       .output_phase = {{"{}_PHASE"}, 0.0},
+       .output_duty_cycle = {{"{}_DUTY_CYCLE"}, 0.5}},
+      {.type = "PLLE2_BASE",
+       .inputs = {"CLKIN1"},
+       .outputs = {"CLKOUT0", "CLKOUT1", "CLKOUT2", "CLKOUT3", "CLKOUT4", "CLKOUT5"},
+       .input_period = "CLKIN1_PERIOD",
+       .mult = {{"CLKFBOUT_MULT"}, 5.0},
+       .divide = {{"DIVCLK_DIVIDE"}, 1.0},
+       .feedback_phase = {{"CLKFBOUT_PHASE"}, 0.0},
+       .output_divide = {{"{}_DIVIDE"}, 1.0},
+       .output_phase = {{"{}_PHASE"}, 0.0},
+       .output_duty_cycle = {{"{}_DUTY_CYCLE"}, 0.5}},
+      // CLKOUT0 and the feedback of MMCMs have fractional dividers
+      {.type = "MMCME2_ADV",
+       .inputs = {"CLKIN1", "CLKIN2"},
+       .outputs = {"CLKOUT0", "CLKOUT1", "CLKOUT2", "CLKOUT3", "CLKOUT4", "CLKOUT5", "CLKOUT6"},
+       .input_period = "CLKIN1_PERIOD",
+       .mult = {{"CLKFBOUT_MULT_F"}, 5.0},
+       .divide = {{"DIVCLK_DIVIDE"}, 1.0},
+       .feedback_phase = {{"CLKFBOUT_PHASE"}, 0.0},
+       .output_divide = {{"{}_DIVIDE_F", "{}_DIVIDE"}, 1.0},
+       .output_phase = {{"{}_PHASE"}, 0.0},
+       .output_duty_cycle = {{"{}_DUTY_CYCLE"}, 0.5}},
+      {.type = "MMCME2_BASE",
+       .inputs = {"CLKIN1"},
+       .outputs = {"CLKOUT0", "CLKOUT1", "CLKOUT2", "CLKOUT3", "CLKOUT4", "CLKOUT5", "CLKOUT6"},
+       .input_period = "CLKIN1_PERIOD",
+       .mult = {{"CLKFBOUT_MULT_F"}, 5.0},
+       .divide = {{"DIVCLK_DIVIDE"}, 1.0},
+       .feedback_phase = {{"CLKFBOUT_PHASE"}, 0.0},
+       .output_divide = {{"{}_DIVIDE_F", "{}_DIVIDE"}, 1.0},
+       .output_phase = {{"{}_PHASE"}, 0.0},
+       .output_duty_cycle = {{"{}_DUTY_CYCLE"}, 0.5}},
+      // BUFR_DIVIDE is "BYPASS" or "1" to "8", BYPASS falls back to the default
+      {.type = "BUFR",
+       .inputs = {"I"},
+       .outputs = {"O"},
+       .input_period = "",
+       .mult = {{}, 1.0},
+       .divide = {{}, 1.0},
+       .feedback_phase = {{}, 0.0},
+       .output_divide = {{"BUFR_DIVIDE"}, 1.0},
+       .output_phase = {{}, 0.0},
+       .output_duty_cycle = {{}, 0.5}},
+    };
+    return types;
 }
 
-void Pll::CheckInputClockPeriod(RTLIL::Cell *cell, float input_clock_period)
+std::vector<ClockWaveform> ClockDivider::OutputWaveforms(RTLIL::Cell *cell, float input_clock_period, float input_clock_rising_edge) const
 {
-    float abs_diff = fabs(ClkinPeriod() - input_clock_period);
-    bool approx_equal = abs_diff < std::max(ClkinPeriod(), input_clock_period) * 10 * std::numeric_limits<float>::epsilon();
-    if (!approx_equal) {
-        log_cmd_error("CLKIN[1/2]_PERIOD doesn't match the virtual clock constraint "
-                      "propagated to the CLKIN[1/2] input of the clock divider cell: "
-                      "%s.\nInput clock period: %f, CLKIN[1/2]_PERIOD: %f\n",
-                      RTLIL::id2cstr(cell->name), input_clock_period, ClkinPeriod());
+    float clkin_period = input_period.empty() ? input_clock_period : FetchParam(cell, input_period, 0.0);
+    float clk_mult = FetchParam(cell, mult, "");
+    float divclk_divisor = FetchParam(cell, divide, "");
+    float clk_fbout_phase = FetchParam(cell, feedback_phase, "");
+    if (!input_period.empty()) {
+        CheckInputClockPeriod(cell, clkin_period, input_clock_period);
     }
-}
 
-void Pll::FetchParams(RTLIL::Cell *cell)
-{
-    clkin1_period = FetchParam(cell, "CLKIN1_PERIOD", 0.0);
-    clkin2_period = FetchParam(cell, "CLKIN2_PERIOD", 0.0);
-    clk_mult = FetchParam(cell, "CLKFBOUT_MULT", 5.0);
-    clk_fbout_phase = FetchParam(cell, "CLKFBOUT_PHASE", 0.0);
-    divclk_divisor = FetchParam(cell, "DIVCLK_DIVIDE", 1.0);
-    for (auto output : outputs) {
-        // CLKOUT[0-5]_DUTY_CYCLE
-        clkout_duty_cycle[output] = FetchParam(cell, output + "_DUTY_CYCLE", 0.5);
-        // CLKOUT[0-5]_DIVIDE
-        clkout_divisor[output] = FetchParam(cell, output + "_DIVIDE", 1.0);
-        // CLKOUT[0-5]_PHASE
-        clkout_phase[output] = FetchParam(cell, output + "_PHASE", 0.0);
+    std::vector<ClockWaveform> output_waveforms;
+    output_waveforms.reserve(outputs.size());
+    for (auto &output : outputs) {
+        float clkout_divisor = FetchParam(cell, output_divide, output);
+        float clkout_phase = FetchParam(cell, output_phase, output);
+        float clkout_duty_cycle = FetchParam(cell, output_duty_cycle, output);
+        ClockWaveform waveform;
+        waveform.period = clkin_period * clkout_divisor / clk_mult * divclk_divisor;
+        waveform.rising_edge = fmod(input_clock_rising_edge - (clk_fbout_phase / 360.0) * clkin_period + waveform.period * (clkout_phase / 360.0),
+                                    waveform.period);
+        waveform.falling_edge = fmod(waveform.rising_edge + clkout_duty_cycle * waveform.period, waveform.period);
+        output_waveforms.push_back(waveform);
     }
+    return output_waveforms;
 }
 
-void Pll::CalculateOutputClockPeriods()
+void ClockDivider::CheckInputClockPeriod(RTLIL::Cell *cell, float clkin_period, float input_clock_period) const
 {
-    for (auto output : outputs) {
-        // CLKOUT[0-5]_PERIOD = CLKIN1_PERIOD * CLKOUT[0-5]_DIVIDE *
-        // DIVCLK_DIVIDE / CLKFBOUT_MULT
-        clkout_period[output] = ClkinPeriod() * clkout_divisor.at(output) / clk_mult * divclk_divisor;
+    float abs_diff = fabs(clkin_period - input_clock_period);
+    bool approx_equal = abs_diff < std::max(clkin_period, input_clock_period) * 10 * std::numeric_limits<float>::epsilon();
+    if (!approx_equal) {
+        log_cmd_error("%s doesn't match the virtual clock constraint "
+                      "propagated to the input of the clock divider cell: "
+                      "%s.\nInput clock period: %f, %s: %f\n",
+                      input_period.c_str(), RTLIL::id2cstr(cell->name), input_clock_period, input_period.c_str(), clkin_period);
     }
 }
 
-void Pll::CalculateOutputClockWaveforms(float input_clock_rising_edge)
+float ClockDivider::FetchParam(RTLIL::Cell *cell, const ClockDividerParam &param, const std::string &output) const
 {
-    for (auto output : outputs) {
-        float output_clock_period = clkout_period.at(output);
-        clkout_rising_edge[output] =
-          fmod(input_clock_rising_edge - (clk_fbout_phase / 360.0) * ClkinPeriod() + output_clock_period * (clkout_phase[output] / 360.0),
-               output_clock_period);
-        clkout_falling_edge[output] = fmod(clkout_rising_edge[output] + clkout_duty_cycle[output] * output_clock_period, output_clock_period);
+    for (auto &name : param.names) {
+        std::string param_name(name);
+        size_t pos = param_name.find("{}");
+        if (pos != std::string::npos) {
+            param_name.replace(pos, 2, output);
+        }
+        if (cell->hasParam(RTLIL::escape_id(param_name))) {
+            return FetchParam(cell, param_name, param.default_value);
+        }
     }
+    return param.default_value;
 }
 
-float Pll::FetchParam(RTLIL::Cell *cell, std::string &&param_name, float default_value)
+float ClockDivider::FetchParam(RTLIL::Cell *cell, const std::string &param_name, float default_value)
 {
     RTLIL::IdString param(RTLIL::escape_id(param_name));
     if (cell->hasParam(param)) {
         auto param_obj = cell->parameters.at(param);
-        std::string value;
         if (param_obj.flags & RTLIL::CONST_FLAG_STRING) {
-            value = param_obj.decode_string();
-        } else {
-            value = std::to_string(param_obj.as_int());
+            // Non-numeric values like BUFR_DIVIDE="BYPASS" use the default
+            std::string value = param_obj.decode_string();
+            char *end;
+            float number = strtof(value.c_str(), &end);
+            return end == value.c_str() ? default_value : number;
         }
-        return std::stof(value);
+        return param_obj.as_int();
     }
     return default_value;
 }
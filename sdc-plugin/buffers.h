@@ -20,7 +20,6 @@
 
 #include "kernel/rtlil.h"
 #include <string>
-#include <unordered_map>
 #include <vector>
 
 USING_YOSYS_NAMESPACE
@@ -40,51 +39,54 @@ struct Bufg : Buffer {
     Bufg() : Buffer(0, "BUFG", "O"){};
 };
 
-struct ClockDivider {
-    std::string type;
+// Parameter of a clock divider. The first of the names the cell has is used,
+// "{}" in a name stands for the name of the output.
+struct ClockDividerParam {
+    std::vector<std::string> names;
+    float default_value;
 };
 
-struct Pll : public ClockDivider {
-    Pll() : ClockDivider({"PLLE2_ADV"}) {}
-    Pll(RTLIL::Cell *cell, float input_clock_period, float input_clock_rising_edge);
-
-    // Helper function to fetch a cell parameter or return a default value
-    static float FetchParam(RTLIL::Cell *cell, std::string &&param_name, float default_value);
+struct ClockWaveform {
+    float period;
+    float rising_edge;
+    float falling_edge;
+};
 
-    // Get the period of the input clock
-    // TODO Add support for CLKINSEL
-    float ClkinPeriod() { return clkin1_period; }
+// Clock divider cell type described as data. The output clocks are derived
+// from the input clock as:
+//   period = input period * output divide * divide / mult
+//   rising edge = input rising edge - feedback phase / 360 * input period +
+//                 output phase / 360 * period
+//   falling edge = rising edge + duty cycle * period
+struct ClockDivider {
+    std::string type;
+    std::vector<std::string> inputs;
+    std::vector<std::string> outputs;
+    // Parameter with the expected period of the input clock, the period
+    // of the propagated clock is used as is when empty
+    std::string input_period;
+    ClockDividerParam mult;
+    ClockDividerParam divide;
+    ClockDividerParam feedback_phase;
+    ClockDividerParam output_divide;
+    ClockDividerParam output_phase;
+    ClockDividerParam output_duty_cycle;
+
+    // All the supported clock divider types
+    static const std::vector<ClockDivider> &Types();
+
+    // Waveforms of the outputs in the order of outputs
+    std::vector<ClockWaveform> OutputWaveforms(RTLIL::Cell *cell, float input_clock_period, float input_clock_rising_edge) const;
 
-    static const std::vector<std::string> inputs;
-    static const std::vector<std::string> outputs;
-    std::unordered_map<std::string, float> clkout_period;
-    std::unordered_map<std::string, float> clkout_duty_cycle;
-    std::unordered_map<std::string, float> clkout_rising_edge;
-    std::unordered_map<std::string, float> clkout_falling_edge;
+    // Helper function to fetch a cell parameter or return a default value
+    static float FetchParam(RTLIL::Cell *cell, const std::string &param_name, float default_value);
 
   private:
-    // Approximate equality check of the input clock period and specified in
-    // CLKIN[1/2]_PERIOD parameter
-    void CheckInputClockPeriod(RTLIL::Cell *cell, float input_clock_period);
-
-    // Fetch cell's parameters needed for further calculations
-    void FetchParams(RTLIL::Cell *cell);
-
-    // Calculate the period on the output clocks
-    void CalculateOutputClockPeriods();
-
-    // Calculate the rising and falling edges of the output clocks
-    void CalculateOutputClockWaveforms(float input_clock_rising_edge);
+    float FetchParam(RTLIL::Cell *cell, const ClockDividerParam &param, const std::string &output) const;
 
-    static const float delay;
-    static const std::string name;
-    std::unordered_map<std::string, float> clkout_divisor;
-    std::unordered_map<std::string, float> clkout_phase;
-    float clkin1_period;
-    float clkin2_period;
-    float divclk_divisor;
-    float clk_mult;
-    float clk_fbout_phase;
+    // Approximate equality check of the input clock period and the one
+    // specified in the input period parameter
+    void CheckInputClockPeriod(RTLIL::Cell *cell, float clkin_period, float input_clock_period) const;
 };
 
 #endif // _BUFFERS_H_
@@ -0,0 +1,135 @@
+/*
+ * Copyright 2020-2022 F4PGA Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "clock_domains.h"
+#include "clocks.h"
+#include "kernel/sigtools.h"
+#include <algorithm>
+#include <limits>
+
+USING_YOSYS_NAMESPACE
+
+// Flip-flops and memories keep their place in the top module whether or not
+// their clock is constrained, abc9 only maps the combinational logic
+static bool IsSequentialCell(RTLIL::Cell *cell)
+{
+    return RTLIL::builtin_ff_cell_types().count(cell->type) ||
+           cell->type.in(ID($mem), ID($mem_v2), ID($memrd), ID($memrd_v2), ID($memwr), ID($memwr_v2));
+}
+
+// Internal cells are clocked by the clock ports of flip-flops and memories,
+// a clock reaching any other input of theirs is just data. Blackbox cells
+// and primitives are not mapped by abc9 so any of their inputs counts.
+static bool IsClockPort(RTLIL::Cell *cell, RTLIL::IdString port)
+{
+    if (!cell->type.begins_with("$")) {
+        return cell->input(port);
+    }
+    if (cell->type.in(ID($mem), ID($mem_v2))) {
+        return port == ID::RD_CLK || port == ID::WR_CLK;
+    }
+    if (cell->type.in(ID($memrd), ID($memrd_v2), ID($memwr), ID($memwr_v2))) {
+        return port == ID::CLK;
+    }
+    return RTLIL::builtin_ff_cell_types().count(cell->type) && (port == ID::CLK || port == ID::C);
+}
+
+ClockDomainPartition::ClockDomainPartition(RTLIL::Design *design)
+{
+    RTLIL::Module *top_module = design->top_module();
+    SigMap sigmap(top_module);
+
+    dict<RTLIL::SigBit, int> clock_targets;
+    for (auto &clock : Clocks::GetClocks(design)) {
+        int target = Clock::Abc9DelayTarget(clock.second);
+        for (auto bit : sigmap(clock.second)) {
+            auto it = clock_targets.find(bit);
+            if (it == clock_targets.end() || it->second > target) {
+                clock_targets[bit] = target;
+            }
+        }
+    }
+
+    // Drivers of the internal combinational cells and the domain of the
+    // clocked cells
+    dict<RTLIL::SigBit, RTLIL::Cell *> drivers;
+    std::vector<std::pair<int, RTLIL::Cell *>> clocked_cells;
+    pool<RTLIL::Cell *> logic_cells;
+    for (auto cell : top_module->cells()) {
+        int target = std::numeric_limits<int>::max();
+        for (auto &conn : cell->connections()) {
+            if (!IsClockPort(cell, conn.first)) {
+                continue;
+            }
+            for (auto bit : sigmap(conn.second)) {
+                auto it = clock_targets.find(bit);
+                if (it != clock_targets.end()) {
+                    target = std::min(target, it->second);
+                }
+            }
+        }
+        if (target != std::numeric_limits<int>::max()) {
+            clocked_cells.emplace_back(target, cell);
+            continue;
+        }
+        // Sequential cells on an unconstrained clock end the cones like
+        // clocked cells but start none
+        if (!cell->type.begins_with("$") || IsSequentialCell(cell)) {
+            continue;
+        }
+        logic_cells.insert(cell);
+        for (auto &conn : cell->connections()) {
+            if (cell->output(conn.first)) {
+                for (auto bit : sigmap(conn.second)) {
+                    drivers[bit] = cell;
+                }
+            }
+        }
+    }
+
+    // Walking the cones from the fastest domain on assigns every cell its
+    // final target on the first visit, so each cell is visited once
+    std::stable_sort(clocked_cells.begin(), clocked_cells.end(),
+                     [](const std::pair<int, RTLIL::Cell *> &a, const std::pair<int, RTLIL::Cell *> &b) { return a.first < b.first; });
+    dict<RTLIL::Cell *, int> targets;
+    std::vector<RTLIL::Cell *> worklist;
+    for (auto &clocked_cell : clocked_cells) {
+        int target = clocked_cell.first;
+        worklist.push_back(clocked_cell.second);
+        while (!worklist.empty()) {
+            RTLIL::Cell *cell = worklist.back();
+            worklist.pop_back();
+            for (auto &conn : cell->connections()) {
+                if (!cell->input(conn.first)) {
+                    continue;
+                }
+                for (auto bit : sigmap(conn.second)) {
+                    auto it = drivers.find(bit);
+                    if (it != drivers.end() && targets.count(it->second) == 0) {
+                        targets[it->second] = target;
+                        worklist.push_back(it->second);
+                    }
+                }
+            }
+        }
+    }
+
+    for (auto cell : logic_cells) {
+        auto it = targets.find(cell);
+        partitions_[it == targets.end() ? no_target : it->second].push_back(cell);
+    }
+}
@@ -0,0 +1,52 @@
+/*
+ * Copyright 2020-2022 F4PGA Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#ifndef _CLOCK_DOMAINS_H_
+#define _CLOCK_DOMAINS_H_
+
+#include "kernel/rtlil.h"
+#include <map>
+#include <vector>
+
+USING_YOSYS_NAMESPACE
+
+// Partitions the combinational logic of the top module by clock domain.
+//
+// Flip-flops and memories with their clock port on a clock wire, and
+// blackbox cells with any input on one, are clocked cells and belong to the
+// domain of that clock. Flip-flops and memories on an unconstrained clock
+// stay where they are and end the cones like clocked cells. Other internal
+// cells are logic even if a clock reaches them. The internal (non-blackbox) cells in the input cone
+// of a clocked cell, up to other clocked cells and module ports, take the
+// ABC9 delay target of the fastest domain they feed. Logic that feeds no
+// clocked cell is left without a target.
+class ClockDomainPartition
+{
+  public:
+    // Delay target of the logic that feeds no clocked cell
+    static const int no_target = 0;
+
+    explicit ClockDomainPartition(RTLIL::Design *design);
+
+    // Partitions ordered by their delay target in picoseconds
+    const std::map<int, std::vector<RTLIL::Cell *>> &Partitions() const { return partitions_; }
+
+  private:
+    std::map<int, std::vector<RTLIL::Cell *>> partitions_;
+};
+
+#endif // _CLOCK_DOMAINS_H_
@@ -0,0 +1,155 @@
+/*
+ * Copyright 2020-2022 F4PGA Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "clock_graph.h"
+#include <algorithm>
+
+USING_YOSYS_NAMESPACE
+
+static const char *ClockTypeName(Clock::ClockType type)
+{
+    switch (type) {
+    case Clock::EXPLICIT:
+        return "explicit";
+    case Clock::GENERATED:
+        return "generated";
+    case Clock::PROPAGATED:
+        return "propagated";
+    }
+    return "unknown";
+}
+
+static std::string JsonString(const std::string &str)
+{
+    std::string quoted("\"");
+    for (char c : str) {
+        if (c == '"' || c == '\\') {
+            quoted += '\\';
+        }
+        quoted += c;
+    }
+    return quoted + "\"";
+}
+
+static std::string JsonList(const std::vector<std::string> &list)
+{
+    std::string json("[");
+    for (auto &item : list) {
+        if (json.size() > 1) {
+            json += ", ";
+        }
+        json += JsonString(item);
+    }
+    return json + "]";
+}
+
+void ClockGraph::Clear(RTLIL::Design *design)
+{
+    design_ = design;
+    finished_ = false;
+    nodes_.clear();
+    node_ids_.clear();
+    edges_.clear();
+    edge_set_.clear();
+}
+
+void ClockGraph::AddEdge(RTLIL::Wire *from, RTLIL::Wire *to, RTLIL::Cell *cell, float delay)
+{
+    Edge edge{.from = ObjectName(from->name), .to = ObjectName(to->name), .cell = ObjectName(cell->name), .cell_type = ObjectName(cell->type), .delay = delay};
+    if (edge_set_.insert(std::make_tuple(edge.from, edge.to, edge.cell)).second) {
+        edges_.push_back(edge);
+    }
+}
+
+void ClockGraph::Finish(const NetlistIndex &index)
+{
+    pool<std::string> edge_cells;
+    for (auto &edge : edges_) {
+        edge_cells.insert(edge.cell);
+    }
+    for (auto &clock : Clocks::GetClocks(design_)) {
+        RTLIL::Wire *wire = clock.second;
+        Node node{.wire = ObjectName(wire->name),
+                  .clock = Clock::Name(wire),
+                  .period = Clock::Period(wire),
+                  .rising_edge = Clock::RisingEdge(wire),
+                  .falling_edge = Clock::FallingEdge(wire),
+                  .type = Clock::IsGenerated(wire) ? Clock::GENERATED : Clock::IsPropagated(wire) ? Clock::PROPAGATED : Clock::EXPLICIT,
+                  .sinks = {}};
+        if (index.Contains(wire)) {
+            for (auto &sink : index.Sinks(wire)) {
+                std::string cell(ObjectName(sink.cell->name));
+                if (!edge_cells.count(cell)) {
+                    node.sinks.push_back(cell);
+                }
+            }
+        }
+        std::sort(node.sinks.begin(), node.sinks.end());
+        node.sinks.erase(std::unique(node.sinks.begin(), node.sinks.end()), node.sinks.end());
+        node_ids_[node.wire] = nodes_.size();
+        nodes_.push_back(std::move(node));
+    }
+    // Propagation order depends on the netlist order, the output shouldn't
+    std::sort(edges_.begin(), edges_.end(),
+              [](const Edge &a, const Edge &b) { return std::tie(a.from, a.to, a.cell) < std::tie(b.from, b.to, b.cell); });
+    finished_ = true;
+}
+
+std::vector<std::string> ClockGraph::Fanout(const std::string &clock, bool transitive) const
+{
+    std::vector<int> worklist;
+    pool<int> visited;
+    for (size_t id = 0; id < nodes_.size(); id++) {
+        if ((nodes_[id].clock == clock || nodes_[id].wire == clock) && visited.insert(id).second) {
+            worklist.push_back(id);
+        }
+    }
+    for (size_t next = 0; transitive && next < worklist.size(); next++) {
+        const std::string &wire = nodes_[worklist[next]].wire;
+        for (auto &edge : edges_) {
+            auto to = node_ids_.find(edge.to);
+            if (edge.from == wire && to != node_ids_.end() && visited.insert(to->second).second) {
+                worklist.push_back(to->second);
+            }
+        }
+    }
+    std::vector<std::string> fanout;
+    for (int id : worklist) {
+        fanout.insert(fanout.end(), nodes_[id].sinks.begin(), nodes_[id].sinks.end());
+    }
+    std::sort(fanout.begin(), fanout.end());
+    fanout.erase(std::unique(fanout.begin(), fanout.end()), fanout.end());
+    return fanout;
+}
+
+void ClockGraph::WriteJson(std::ostream &file) const
+{
+    file << "{\n  \"clocks\": [";
+    for (size_t id = 0; id < nodes_.size(); id++) {
+        auto &node = nodes_[id];
+        file << (id ? ",\n" : "\n") << "    {\"wire\": " << JsonString(node.wire) << ", \"name\": " << JsonString(node.clock)
+             << ", \"type\": " << JsonString(ClockTypeName(node.type)) << ", \"period\": " << node.period << ", \"waveform\": ["
+             << node.rising_edge << ", " << node.falling_edge << "], \"sinks\": " << JsonList(node.sinks) << "}";
+    }
+    file << "\n  ],\n  \"edges\": [";
+    for (size_t id = 0; id < edges_.size(); id++) {
+        auto &edge = edges_[id];
+        file << (id ? ",\n" : "\n") << "    {\"from\": " << JsonString(edge.from) << ", \"to\": " << JsonString(edge.to)
+             << ", \"cell\": " << JsonString(edge.cell) << ", \"type\": " << JsonString(edge.cell_type) << ", \"delay\": " << edge.delay << "}";
+    }
+    file << "\n  ]\n}\n";
+}
@@ -0,0 +1,91 @@
+/*
+ * Copyright 2020-2022 F4PGA Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#ifndef _CLOCK_GRAPH_H_
+#define _CLOCK_GRAPH_H_
+
+#include "clocks.h"
+#include "kernel/rtlil.h"
+#include "netlist_index.h"
+#include <ostream>
+#include <string>
+#include <tuple>
+#include <vector>
+
+USING_YOSYS_NAMESPACE
+
+// Clock tree found by propagate_clocks: a node per clock wire of the top
+// module, an edge per buffer or clock divider a clock goes through and the
+// cells clocked by each clock wire.
+//
+// Objects are kept by name so the graph can be queried and written out
+// after the netlist has changed; it describes the design as it was when
+// propagate_clocks was last run.
+class ClockGraph
+{
+  public:
+    struct Node {
+        std::string wire;
+        std::string clock;
+        float period;
+        float rising_edge;
+        float falling_edge;
+        Clock::ClockType type;
+        std::vector<std::string> sinks;
+    };
+
+    struct Edge {
+        std::string from;
+        std::string to;
+        std::string cell;
+        std::string cell_type;
+        float delay;
+    };
+
+    // Drops the graph, propagation adds the edges again
+    void Clear(RTLIL::Design *design);
+
+    // Records that the clock of the wire from reaches the wire to through
+    // the cell. Edges seen before are ignored.
+    void AddEdge(RTLIL::Wire *from, RTLIL::Wire *to, RTLIL::Cell *cell, float delay);
+
+    // Adds the nodes for the clocks of the design and looks up their sinks.
+    // Cells on an edge of the graph aren't sinks.
+    void Finish(const NetlistIndex &index);
+
+    bool IsBuiltFor(RTLIL::Design *design) const { return design_ == design && finished_; }
+
+    // Sink cells of the clock, i.e. of all the wires the clock is defined on.
+    // The clock is given by its name or by the name of one of its wires.
+    // With transitive the sinks of the clocks reached through buffers and
+    // dividers are included.
+    std::vector<std::string> Fanout(const std::string &clock, bool transitive) const;
+
+    void WriteJson(std::ostream &file) const;
+
+  private:
+    static std::string ObjectName(const RTLIL::IdString &name) { return RTLIL::unescape_id(name); }
+
+    RTLIL::Design *design_ = nullptr;
+    bool finished_ = false;
+    std::vector<Node> nodes_;
+    dict<std::string, int> node_ids_;
+    std::vector<Edge> edges_;
+    pool<std::tuple<std::string, std::string, std::string>> edge_set_;
+};
+
+#endif // _CLOCK_GRAPH_H_
@@ -20,22 +20,144 @@
 #include "propagation.h"
 #include <cassert>
 #include <cmath>
+#include <memory>
 #include <regex>
 
-void Clock::Add(const std::string &name, RTLIL::Wire *wire, float period, float rising_edge, float falling_edge, ClockType type)
+// Typed properties of a clock added by Clock::Add. Names are interned in
+// the registry.
+struct ClockData {
+    RTLIL::IdString wire_name;
+    int name;
+    int source_wires;
+    float period;
+    float rising_edge;
+    float falling_edge;
+    Clock::ClockType type;
+};
+
+// Clock wires of the top module of a design. The registry is attached to the
+// design as a monitor so that adding, removing or blacking out modules drops
+// the cached state.
+//
+// Only Clock::Add, i.e. create_clock and propagate_clocks, adds wires to a
+// valid registry. A wire marked as a clock by other means, e.g. by setting
+// CLOCK_SIGNAL with setattr or by a pass creating a new clock wire, is not
+// reported to monitors and is only found once the registry is rebuilt after
+// a module is added, removed or blacked out, or a cached clock wire is gone.
+// Netlists read with such attributes add modules and are picked up.
+//
+// The registry also holds the properties of the clocks added by the plugin,
+// they are the source of truth for those wires. The wire attributes are only
+// written when Clocks::WriteAttributes is called at the end of a command,
+// for every wire added or redefined since the last call. Changing these
+// attributes by other means, e.g. with setattr, does not change a clock
+// added by the plugin and the attributes are overwritten when the clock is
+// redefined.
+struct ClockRegistry : public RTLIL::Monitor {
+    RTLIL::Module *top_module = nullptr;
+    bool valid = false;
+    // Wire names are kept next to the pointers so that stale entries can be
+    // detected without dereferencing wires that might have been removed
+    std::map<std::string, std::pair<RTLIL::IdString, RTLIL::Wire *>> clocks;
+
+    dict<RTLIL::Wire *, ClockData> data;
+    // Wires with properties not written to their attributes yet
+    pool<RTLIL::Wire *> unwritten;
+    std::vector<std::string> names;
+    dict<std::string, int> name_ids;
+
+    void Add(RTLIL::Wire *wire) { clocks[Clock::WireName(wire)] = std::make_pair(wire->name, wire); }
+
+    int Intern(const std::string &name)
+    {
+        auto it = name_ids.find(name);
+        if (it != name_ids.end()) {
+            return it->second;
+        }
+        names.push_back(name);
+        return name_ids[name] = names.size() - 1;
+    }
+
+    const ClockData *Find(RTLIL::Wire *wire) const
+    {
+        auto it = data.find(wire);
+        return it != data.end() && it->second.wire_name == wire->name ? &it->second : nullptr;
+    }
+
+    void Clear()
+    {
+        valid = false;
+        data.clear();
+        unwritten.clear();
+    }
+
+    void notify_module_add(RTLIL::Module *) override { valid = false; }
+    void notify_module_del(RTLIL::Module *) override { Clear(); }
+    void notify_blackout(RTLIL::Module *) override { Clear(); }
+};
+
+static dict<RTLIL::Design *, std::unique_ptr<ClockRegistry>> clock_registries;
+
+static ClockRegistry &GetClockRegistry(RTLIL::Design *design)
+{
+    auto &registry = clock_registries[design];
+    // A design allocated at the address of a deleted one isn't monitored yet
+    if (!registry || !design->monitors.count(registry.get())) {
+        registry.reset(new ClockRegistry());
+        design->monitors.insert(registry.get());
+    }
+    return *registry;
+}
+
+static ClockRegistry *GetClockRegistry(RTLIL::Wire *wire)
+{
+    if (!wire->module || !wire->module->design) {
+        return nullptr;
+    }
+    return &GetClockRegistry(wire->module->design);
+}
+
+// Properties of a clock added by the plugin, nullptr for clocks that are only
+// described by wire attributes, e.g. after reading a JSON netlist
+static const ClockData *FindClockData(RTLIL::Wire *wire)
+{
+    ClockRegistry *registry = GetClockRegistry(wire);
+    return registry ? registry->Find(wire) : nullptr;
+}
+
+static void WriteClockAttributes(RTLIL::Wire *wire, const std::string &name, const std::string &source_wires, float period, float rising_edge,
+                                 float falling_edge, Clock::ClockType type)
 {
     wire->set_string_attribute(RTLIL::escape_id("CLOCK_SIGNAL"), "yes");
-    wire->set_bool_attribute(RTLIL::escape_id("IS_GENERATED"), type == GENERATED);
-    wire->set_bool_attribute(RTLIL::escape_id("IS_EXPLICIT"), type == EXPLICIT);
-    wire->set_bool_attribute(RTLIL::escape_id("IS_PROPAGATED"), type == PROPAGATED);
+    wire->set_bool_attribute(RTLIL::escape_id("IS_GENERATED"), type == Clock::GENERATED);
+    wire->set_bool_attribute(RTLIL::escape_id("IS_EXPLICIT"), type == Clock::EXPLICIT);
+    wire->set_bool_attribute(RTLIL::escape_id("IS_PROPAGATED"), type == Clock::PROPAGATED);
     wire->set_string_attribute(RTLIL::escape_id("CLASS"), "clock");
     wire->set_string_attribute(RTLIL::escape_id("NAME"), name);
-    wire->set_string_attribute(RTLIL::escape_id("SOURCE_WIRES"), Clock::WireName(wire));
+    wire->set_string_attribute(RTLIL::escape_id("SOURCE_WIRES"), source_wires);
     wire->set_string_attribute(RTLIL::escape_id("PERIOD"), std::to_string(period));
     std::string waveform(std::to_string(rising_edge) + " " + std::to_string(falling_edge));
     wire->set_string_attribute(RTLIL::escape_id("WAVEFORM"), waveform);
 }
 
+void Clock::Add(const std::string &name, RTLIL::Wire *wire, float period, float rising_edge, float falling_edge, ClockType type)
+{
+    ClockRegistry *registry = GetClockRegistry(wire);
+    if (!registry) {
+        WriteClockAttributes(wire, name, Clock::WireName(wire), period, rising_edge, falling_edge, type);
+        return;
+    }
+    registry->unwritten.insert(wire);
+    registry->data[wire] = ClockData{.wire_name = wire->name,
+                                     .name = registry->Intern(name),
+                                     .source_wires = registry->Intern(Clock::WireName(wire)),
+                                     .period = period,
+                                     .rising_edge = rising_edge,
+                                     .falling_edge = falling_edge,
+                                     .type = type};
+    Clocks::Register(wire);
+}
+
 void Clock::Add(const std::string &name, std::vector<RTLIL::Wire *> wires, float period, float rising_edge, float falling_edge, ClockType type)
 {
     std::for_each(wires.begin(), wires.end(), [&](RTLIL::Wire *wire) { Add(name, wire, period, rising_edge, falling_edge, type); });
@@ -46,8 +168,20 @@ void Clock::Add(RTLIL::Wire *wire, float period, float rising_edge, float fallin
     Add(Clock::WireName(wire), wire, period, rising_edge, falling_edge, type);
 }
 
+int Clock::Abc9DelayTarget(RTLIL::Wire *clock_wire)
+{
+    // By convention, delays in Yosys are in picoseconds, but ABC9 has
+    // no information on interconnect delay, so target half the specified
+    // clock period to give timing slack; otherwise ABC9 may produce a
+    // mapping that cannot meet the specified clock.
+    return Period(clock_wire) * 1000.0 / 2.0;
+}
+
 float Clock::Period(RTLIL::Wire *clock_wire)
 {
+    if (auto data = FindClockData(clock_wire)) {
+        return data->period;
+    }
     if (!clock_wire->has_attribute(RTLIL::escape_id("PERIOD"))) {
         log_cmd_error("PERIOD has not been specified on wire '%s'.\n", WireName(clock_wire).c_str());
     }
@@ -66,6 +200,9 @@ float Clock::Period(RTLIL::Wire *clock_wire)
 
 std::pair<float, float> Clock::Waveform(RTLIL::Wire *clock_wire)
 {
+    if (auto data = FindClockData(clock_wire)) {
+        return std::make_pair(data->rising_edge, data->falling_edge);
+    }
     if (!clock_wire->has_attribute(RTLIL::escape_id("WAVEFORM"))) {
         float period(Period(clock_wire));
         if (!period) {
@@ -96,6 +233,10 @@ float Clock::FallingEdge(RTLIL::Wire *clock_wire) { return Waveform(clock_wire).
 
 std::string Clock::Name(RTLIL::Wire *clock_wire)
 {
+    ClockRegistry *registry = GetClockRegistry(clock_wire);
+    if (auto data = registry ? registry->Find(clock_wire) : nullptr) {
+        return registry->names.at(data->name);
+    }
     if (clock_wire->has_attribute(RTLIL::escape_id("NAME"))) {
         return clock_wire->get_string_attribute(RTLIL::escape_id("NAME"));
     }
@@ -112,12 +253,24 @@ std::string Clock::WireName(RTLIL::Wire *clock_wire)
 
 std::string Clock::SourceWireName(RTLIL::Wire *clock_wire)
 {
+    ClockRegistry *registry = GetClockRegistry(clock_wire);
+    if (auto data = registry ? registry->Find(clock_wire) : nullptr) {
+        return registry->names.at(data->source_wires);
+    }
     if (clock_wire->has_attribute(RTLIL::escape_id("SOURCE_WIRES"))) {
         return clock_wire->get_string_attribute(RTLIL::escape_id("SOURCE_WIRES"));
     }
     return Name(clock_wire);
 }
 
+bool Clock::IsOfType(RTLIL::Wire *wire, ClockType type, const std::string &attribute_name)
+{
+    if (auto data = FindClockData(wire)) {
+        return data->type == type;
+    }
+    return GetClockWireBoolAttribute(wire, attribute_name);
+}
+
 bool Clock::GetClockWireBoolAttribute(RTLIL::Wire *wire, const std::string &attribute_name)
 {
     if (wire->has_attribute(RTLIL::escape_id(attribute_name))) {
@@ -126,37 +279,79 @@ bool Clock::GetClockWireBoolAttribute(RTLIL::Wire *wire, const std::string &attr
     return false;
 }
 
+bool Clocks::IsClockWire(RTLIL::Wire *wire)
+{
+    if (FindClockData(wire)) {
+        return true;
+    }
+    return wire->has_attribute(RTLIL::escape_id("CLOCK_SIGNAL")) && wire->get_string_attribute(RTLIL::escape_id("CLOCK_SIGNAL")) == "yes";
+}
+
 const std::map<std::string, RTLIL::Wire *> Clocks::GetClocks(RTLIL::Design *design)
 {
     std::map<std::string, RTLIL::Wire *> clock_wires;
     RTLIL::Module *top_module = design->top_module();
-    for (auto &wire_obj : top_module->wires_) {
-        auto &wire = wire_obj.second;
-        if (wire->has_attribute(RTLIL::escape_id("CLOCK_SIGNAL"))) {
-            if (wire->get_string_attribute(RTLIL::escape_id("CLOCK_SIGNAL")) == "yes") {
-                clock_wires.insert(std::make_pair(Clock::WireName(wire), wire));
+    if (!top_module) {
+        return clock_wires;
+    }
+    ClockRegistry &registry = GetClockRegistry(design);
+    if (registry.valid && registry.top_module == top_module) {
+        // Wires can be removed or renamed without notifying the monitors
+        for (auto &clock : registry.clocks) {
+            RTLIL::Wire *wire = top_module->wire(clock.second.first);
+            if (wire != clock.second.second || !IsClockWire(wire)) {
+                registry.valid = false;
+                break;
+            }
+        }
+    }
+    if (!registry.valid || registry.top_module != top_module) {
+        registry.clocks.clear();
+        registry.top_module = top_module;
+        for (auto &wire_obj : top_module->wires_) {
+            auto &wire = wire_obj.second;
+            if (IsClockWire(wire)) {
+                registry.Add(wire);
             }
         }
+        registry.valid = true;
+    }
+    for (auto &clock : registry.clocks) {
+        clock_wires.emplace_hint(clock_wires.end(), clock.first, clock.second.second);
     }
     return clock_wires;
 }
 
+void Clocks::Register(RTLIL::Wire *wire)
+{
+    if (!wire->module || !wire->module->design) {
+        return;
+    }
+    ClockRegistry &registry = GetClockRegistry(wire->module->design);
+    // An invalid registry is rebuilt on the next query anyway
+    if (registry.valid && registry.top_module == wire->module) {
+        registry.Add(wire);
+    }
+}
+
+void Clocks::WriteAttributes(RTLIL::Design *design)
+{
+    ClockRegistry &registry = GetClockRegistry(design);
+    for (auto wire : registry.unwritten) {
+        auto &data = registry.data.at(wire);
+        WriteClockAttributes(wire, registry.names.at(data.name), registry.names.at(data.source_wires), data.period, data.rising_edge,
+                             data.falling_edge, data.type);
+    }
+    registry.unwritten.clear();
+}
+
 void Clocks::UpdateAbc9DelayTarget(RTLIL::Design *design)
 {
     std::map<std::string, RTLIL::Wire *> clock_wires = Clocks::GetClocks(design);
 
     for (auto &clock_wire : clock_wires) {
-        auto &wire = clock_wire.second;
-        float period = Clock::Period(wire);
-
         // Set the ABC9 delay to the shortest clock period in the design.
-        //
-        // By convention, delays in Yosys are in picoseconds, but ABC9 has
-        // no information on interconnect delay, so target half the specified
-        // clock period to give timing slack; otherwise ABC9 may produce a
-        // mapping that cannot meet the specified clock.
         int abc9_delay = design->scratchpad_get_int("abc9.D", INT32_MAX);
-        int period_ps = period * 1000.0 / 2.0;
-        design->scratchpad_set_int("abc9.D", std::min(abc9_delay, period_ps));
+        design->scratchpad_set_int("abc9.D", std::min(abc9_delay, Clock::Abc9DelayTarget(clock_wire.second)));
     }
 }
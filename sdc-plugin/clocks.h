@@ -48,23 +48,40 @@ class Clock
     static std::string WireName(RTLIL::Wire *wire);
     static std::string AddEscaping(const std::string &name) { return std::regex_replace(name, std::regex{"\\$"}, "\\$"); }
     static std::string SourceWireName(RTLIL::Wire *clock_wire);
-    static bool IsPropagated(RTLIL::Wire *wire) { return GetClockWireBoolAttribute(wire, "IS_PROPAGATED"); }
+    // ABC9 delay target in picoseconds for logic clocked by the clock
+    static int Abc9DelayTarget(RTLIL::Wire *clock_wire);
+    static bool IsPropagated(RTLIL::Wire *wire) { return IsOfType(wire, PROPAGATED, "IS_PROPAGATED"); }
 
-    static bool IsGenerated(RTLIL::Wire *wire) { return GetClockWireBoolAttribute(wire, "IS_GENERATED"); }
+    static bool IsGenerated(RTLIL::Wire *wire) { return IsOfType(wire, GENERATED, "IS_GENERATED"); }
 
-    static bool IsExplicit(RTLIL::Wire *wire) { return GetClockWireBoolAttribute(wire, "IS_EXPLICIT"); }
+    static bool IsExplicit(RTLIL::Wire *wire) { return IsOfType(wire, EXPLICIT, "IS_EXPLICIT"); }
 
   private:
     static std::pair<float, float> Waveform(RTLIL::Wire *clock_wire);
 
+    static bool IsOfType(RTLIL::Wire *wire, ClockType type, const std::string &attribute_name);
+
     static bool GetClockWireBoolAttribute(RTLIL::Wire *wire, const std::string &attribute_name);
 };
 
 class Clocks
 {
   public:
+    // Clock wires of the top module are cached per design. The cache is updated
+    // by Clock::Add only and rebuilt from the wire attributes whenever the
+    // design reports a module change or one of the cached wires is gone, so
+    // clock attributes set on other wires, e.g. with setattr, are not seen
+    // until then.
     static const std::map<std::string, RTLIL::Wire *> GetClocks(RTLIL::Design *design);
+    static void Register(RTLIL::Wire *wire);
+    // Clock::Add keeps the clock properties in a typed table. This writes
+    // them to the wire attributes for other passes and backends, commands
+    // adding clocks call it once they are done.
+    static void WriteAttributes(RTLIL::Design *design);
     static void UpdateAbc9DelayTarget(RTLIL::Design *design);
+
+  private:
+    static bool IsClockWire(RTLIL::Wire *wire);
 };
 
 #endif // _CLOCKS_H_
@@ -0,0 +1,159 @@
+/*
+ * Copyright 2020-2022 F4PGA Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "netlist_index.h"
+#include <algorithm>
+
+USING_YOSYS_NAMESPACE
+
+NetlistIndex::NetlistIndex(RTLIL::Design *design, RTLIL::Module *module) : module_(module), sigmap_(module)
+{
+    cell_types_.setup(design);
+    for (auto cell : module->cells()) {
+        for (auto &conn : cell->connections()) {
+            if (!IsInput(cell, conn.first)) {
+                continue;
+            }
+            for (auto bit : sigmap_(conn.second)) {
+                if (bit.wire) {
+                    sinks_[bit].push_back(Sink{cell, conn.first});
+                }
+            }
+        }
+    }
+    for (auto wire : module->wires()) {
+        for (auto bit : sigmap_(wire)) {
+            if (bit.wire) {
+                auto &wires = wires_[bit];
+                if (wires.empty() || wires.back() != wire) {
+                    wires.push_back(wire);
+                }
+            }
+        }
+    }
+}
+
+std::vector<NetlistIndex::Sink> NetlistIndex::Sinks(RTLIL::Wire *wire) const
+{
+    std::vector<Sink> sinks;
+    if (!Contains(wire)) {
+        return sinks;
+    }
+    pool<std::pair<RTLIL::Cell *, RTLIL::IdString>> visited;
+    for (auto bit : sigmap_(wire)) {
+        auto it = sinks_.find(bit);
+        if (it == sinks_.end()) {
+            continue;
+        }
+        for (auto &sink : it->second) {
+            if (visited.insert(std::make_pair(sink.cell, sink.port)).second) {
+                sinks.push_back(sink);
+            }
+        }
+    }
+    return sinks;
+}
+
+bool NetlistIndex::HasSinks(RTLIL::Wire *wire) const
+{
+    if (!Contains(wire)) {
+        return false;
+    }
+    for (auto bit : sigmap_(wire)) {
+        if (sinks_.count(bit)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::vector<RTLIL::Wire *> NetlistIndex::PortWires(RTLIL::Cell *cell, const RTLIL::IdString &port) const
+{
+    std::vector<RTLIL::Wire *> wires;
+    if (!cell || !cell->hasPort(port) || !IsOutput(cell, port)) {
+        return wires;
+    }
+    for (auto &chunk : cell->getPort(port).chunks()) {
+        if (chunk.wire && std::find(wires.begin(), wires.end(), chunk.wire) == wires.end()) {
+            wires.push_back(chunk.wire);
+        }
+    }
+    return wires;
+}
+
+std::vector<RTLIL::Wire *> NetlistIndex::Aliases(RTLIL::Wire *wire) const
+{
+    std::vector<RTLIL::Wire *> aliases;
+    if (!Contains(wire)) {
+        return aliases;
+    }
+    pool<RTLIL::Wire *> visited;
+    for (auto bit : sigmap_(wire)) {
+        auto it = wires_.find(bit);
+        if (it == wires_.end()) {
+            continue;
+        }
+        for (auto alias : it->second) {
+            if (visited.insert(alias).second) {
+                aliases.push_back(alias);
+            }
+        }
+    }
+    return aliases;
+}
+
+std::vector<RTLIL::Wire *> NetlistIndex::InputWires(RTLIL::Cell *cell) const
+{
+    std::vector<RTLIL::Wire *> input_wires;
+    if (!cell || cell->module != module_) {
+        return input_wires;
+    }
+    pool<RTLIL::Wire *> visited;
+    for (auto &conn : cell->connections()) {
+        if (!IsInput(cell, conn.first)) {
+            continue;
+        }
+        for (auto bit : sigmap_(conn.second)) {
+            auto it = wires_.find(bit);
+            if (it == wires_.end()) {
+                continue;
+            }
+            for (auto wire : it->second) {
+                if (visited.insert(wire).second) {
+                    input_wires.push_back(wire);
+                }
+            }
+        }
+    }
+    return input_wires;
+}
+
+bool NetlistIndex::IsInput(RTLIL::Cell *cell, const RTLIL::IdString &port) const
+{
+    if (!cell_types_.cell_known(cell->type)) {
+        return true;
+    }
+    return cell_types_.cell_input(cell->type, port);
+}
+
+bool NetlistIndex::IsOutput(RTLIL::Cell *cell, const RTLIL::IdString &port) const
+{
+    if (!cell_types_.cell_known(cell->type)) {
+        return true;
+    }
+    return cell_types_.cell_output(cell->type, port);
+}
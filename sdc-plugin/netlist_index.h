@@ -0,0 +1,74 @@
+/*
+ * Copyright 2020-2022 F4PGA Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#ifndef _NETLIST_INDEX_H_
+#define _NETLIST_INDEX_H_
+
+#include "kernel/celltypes.h"
+#include "kernel/rtlil.h"
+#include "kernel/sigtools.h"
+#include <vector>
+
+USING_YOSYS_NAMESPACE
+
+// Driver to sink connectivity of a single module.
+//
+// The index is built with one pass over the module's cells and answers the
+// queries needed by the clock propagation in O(fanout) instead of evaluating
+// a selection expression on the whole module for every hop.
+// Port directions follow the rules of the Yosys 'select' command: ports of
+// cells with an unknown type are treated as both inputs and outputs.
+class NetlistIndex
+{
+  public:
+    struct Sink {
+        RTLIL::Cell *cell;
+        RTLIL::IdString port;
+    };
+
+    NetlistIndex(RTLIL::Design *design, RTLIL::Module *module);
+
+    // Check if the wire belongs to the indexed module
+    bool Contains(RTLIL::Wire *wire) const { return wire && wire->module == module_; }
+
+    // Cell ports with an input connected to any bit of the wire
+    std::vector<Sink> Sinks(RTLIL::Wire *wire) const;
+
+    // Check if any bit of the wire drives a cell input
+    bool HasSinks(RTLIL::Wire *wire) const;
+
+    // Wires connected to an output port of the cell
+    std::vector<RTLIL::Wire *> PortWires(RTLIL::Cell *cell, const RTLIL::IdString &port) const;
+
+    // Wires sharing at least one net with the wire, the wire itself included
+    std::vector<RTLIL::Wire *> Aliases(RTLIL::Wire *wire) const;
+
+    // Wires sharing at least one net with an input of the cell
+    std::vector<RTLIL::Wire *> InputWires(RTLIL::Cell *cell) const;
+
+  private:
+    bool IsInput(RTLIL::Cell *cell, const RTLIL::IdString &port) const;
+    bool IsOutput(RTLIL::Cell *cell, const RTLIL::IdString &port) const;
+
+    RTLIL::Module *module_;
+    CellTypes cell_types_;
+    SigMap sigmap_;
+    dict<RTLIL::SigBit, std::vector<Sink>> sinks_;
+    dict<RTLIL::SigBit, std::vector<RTLIL::Wire *>> wires_;
+};
+
+#endif // _NETLIST_INDEX_H_
@@ -16,88 +16,178 @@
  * SPDX-License-Identifier: Apache-2.0
  */
 #include "propagation.h"
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <thread>
 
 USING_YOSYS_NAMESPACE
 
-void Propagation::PropagateThroughBuffers(Buffer buffer)
+// Collect the cells among the sinks accepted by the filter
+template <typename Filter> static std::vector<RTLIL::Cell *> FilterSinkCells(const std::vector<NetlistIndex::Sink> &sinks, Filter filter)
 {
+    std::vector<RTLIL::Cell *> sink_cells;
+    for (auto &sink : sinks) {
+        if (filter(sink) && std::find(sink_cells.begin(), sink_cells.end(), sink.cell) == sink_cells.end()) {
+            sink_cells.push_back(sink.cell);
+        }
+    }
+    return sink_cells;
+}
+
+void Propagation::PropagateThroughBuffers(Buffer buffer, int threads)
+{
+    std::vector<RTLIL::Wire *> clock_wires;
     for (auto &clock : Clocks::GetClocks(design_)) {
-        auto &clock_wire = clock.second;
+        clock_wires.push_back(clock.second);
+    }
+    std::vector<std::vector<SinkWire>> buf_wires(clock_wires.size());
+    if (index_) {
+        // The trees of the clocks are independent, each one is walked on its
+        // own. Clock::Add below isn't thread safe so it stays serial.
+        BufferGraph graph(BuildBufferGraph(buffer));
+        size_t num_threads = std::min<size_t>(std::max(threads, 1), clock_wires.size());
+        std::atomic<size_t> next(0);
+        auto worker = [&]() {
+            for (size_t i = next++; i < clock_wires.size(); i = next++) {
+                buf_wires[i] = FindSinkWiresInBufferGraph(graph, clock_wires[i]);
+            }
+        };
+        std::vector<std::thread> workers;
+        for (size_t i = 1; i < num_threads; i++) {
+            workers.emplace_back(worker);
+        }
+        worker();
+        for (auto &thread : workers) {
+            thread.join();
+        }
+    } else {
+        for (size_t i = 0; i < clock_wires.size(); i++) {
+            buf_wires[i] = FindSinkWiresForCellType(clock_wires[i], buffer.type, buffer.output);
+        }
+    }
+    for (size_t i = 0; i < clock_wires.size(); i++) {
+        auto &clock_wire = clock_wires[i];
 #ifdef SDC_DEBUG
         log("Clock wire %s\n", Clock::WireName(clock_wire).c_str());
 #endif
-        auto buf_wires = FindSinkWiresForCellType(clock_wire, buffer.type, buffer.output);
-        int path_delay(0);
-        for (auto wire : buf_wires) {
+        for (auto &buf_wire : buf_wires[i]) {
+            auto wire = buf_wire.wire;
 #ifdef SDC_DEBUG
             log("%s wire: %s\n", buffer.type.c_str(), RTLIL::id2cstr(wire->name));
 #endif
-            path_delay += buffer.delay;
+            float path_delay = buffer.delay * buf_wire.depth;
             Clock::Add(wire, Clock::Period(clock_wire), Clock::RisingEdge(clock_wire) + path_delay, Clock::FallingEdge(clock_wire) + path_delay,
                        Clock::PROPAGATED);
+            AddEdge(buf_wire.driver, wire, buf_wire.cell, buffer.delay);
         }
     }
 }
 
-std::vector<RTLIL::Wire *> Propagation::FindSinkWiresForCellType(RTLIL::Wire *driver_wire, const std::string &cell_type, const std::string &cell_port)
+Propagation::BufferGraph Propagation::BuildBufferGraph(const Buffer &buffer)
 {
-    std::vector<RTLIL::Wire *> wires;
-    if (!driver_wire) {
-        return wires;
+    BufferGraph graph;
+    RTLIL::Module *top_module = design_->top_module();
+    assert(top_module);
+    RTLIL::IdString cell_type(RTLIL::escape_id(buffer.type));
+    RTLIL::IdString output(RTLIL::escape_id(buffer.output));
+    for (auto cell : top_module->cells()) {
+        if (cell->type != cell_type) {
+            continue;
+        }
+        BufferFanout fanout{cell, index_->PortWires(cell, output)};
+        for (auto wire : index_->InputWires(cell)) {
+            graph[wire].push_back(fanout);
+        }
     }
-    auto cell = FindSinkCellOfType(driver_wire, cell_type);
-    RTLIL::Wire *wire = FindSinkWireOnPort(cell, cell_port);
-    if (wire) {
-        wires.push_back(wire);
-        auto further_wires = FindSinkWiresForCellType(wire, cell_type, cell_port);
-        std::copy(further_wires.begin(), further_wires.end(), std::back_inserter(wires));
+    return graph;
+}
+
+// Every wire is visited once so reconvergent paths and loops terminate and
+// the wires are reported with the shortest number of cells from the driver.
+template <typename FanoutFunc> std::vector<Propagation::SinkWire> Propagation::WalkSinkWires(RTLIL::Wire *driver_wire, FanoutFunc fanout_of)
+{
+    std::vector<SinkWire> wires;
+    pool<RTLIL::Wire *> visited{driver_wire};
+    std::vector<SinkWire> worklist{SinkWire{driver_wire, 0, nullptr, nullptr}};
+    std::vector<std::pair<RTLIL::Cell *, RTLIL::Wire *>> fanout;
+    for (size_t next = 0; next < worklist.size(); next++) {
+        SinkWire current = worklist.at(next);
+        fanout.clear();
+        fanout_of(current.wire, fanout);
+        for (auto &edge : fanout) {
+            if (!visited.insert(edge.second).second) {
+                continue;
+            }
+            SinkWire sink{edge.second, current.depth + 1, current.wire, edge.first};
+            wires.push_back(sink);
+            worklist.push_back(sink);
+        }
     }
     return wires;
 }
 
-RTLIL::Cell *Propagation::FindSinkCellOfType(RTLIL::Wire *wire, const std::string &type)
+// Same walk as FindSinkWiresForCellType over a prebuilt buffer graph
+std::vector<Propagation::SinkWire> Propagation::FindSinkWiresInBufferGraph(const BufferGraph &graph, RTLIL::Wire *driver_wire)
+{
+    return WalkSinkWires(driver_wire, [&graph](RTLIL::Wire *wire, std::vector<std::pair<RTLIL::Cell *, RTLIL::Wire *>> &fanout) {
+        auto it = graph.find(wire);
+        if (it == graph.end()) {
+            return;
+        }
+        for (auto &buffer : it->second) {
+            for (auto output : buffer.outputs) {
+                fanout.emplace_back(buffer.cell, output);
+            }
+        }
+    });
+}
+
+std::vector<Propagation::SinkWire> Propagation::FindSinkWiresForCellType(RTLIL::Wire *driver_wire, const std::string &cell_type,
+                                                                          const std::string &cell_port)
+{
+    if (!driver_wire) {
+        return std::vector<SinkWire>();
+    }
+    return WalkSinkWires(driver_wire, [&](RTLIL::Wire *wire, std::vector<std::pair<RTLIL::Cell *, RTLIL::Wire *>> &fanout) {
+        for (auto cell : FindSinkCellsOfType(wire, cell_type)) {
+            for (auto output : FindSinkWiresOnPort(cell, cell_port)) {
+                fanout.emplace_back(cell, output);
+            }
+        }
+    });
+}
+
+std::vector<RTLIL::Cell *> Propagation::FindSinkCellsOfType(RTLIL::Wire *wire, const std::string &type)
 {
-    RTLIL::Cell *sink_cell = NULL;
     if (!wire) {
-        return sink_cell;
+        return std::vector<RTLIL::Cell *>();
+    }
+    if (UseIndex(wire)) {
+        RTLIL::IdString cell_type(RTLIL::escape_id(type));
+        return FilterSinkCells(index_->Sinks(wire), [&](const NetlistIndex::Sink &sink) { return sink.cell->type == cell_type; });
     }
     RTLIL::Module *top_module = design_->top_module();
     assert(top_module);
     std::string base_selection = top_module->name.str() + "/w:" + wire->name.str();
     pass_->extra_args(std::vector<std::string>{base_selection, "%co:+" + type, base_selection, "%d"}, 0, design_);
-    auto selected_cells = top_module->selected_cells();
-    // FIXME Handle more than one sink
-    assert(selected_cells.size() <= 1);
-    if (selected_cells.size() > 0) {
-        sink_cell = selected_cells.at(0);
-#ifdef SDC_DEBUG
-        log("Found sink cell: %s\n", RTLIL::unescape_id(sink_cell->name).c_str());
-#endif
-    }
-    return sink_cell;
+    return top_module->selected_cells();
 }
 
-RTLIL::Cell *Propagation::FindSinkCellOnPort(RTLIL::Wire *wire, const std::string &port)
+std::vector<RTLIL::Cell *> Propagation::FindSinkCellsOnPort(RTLIL::Wire *wire, const std::string &port)
 {
-    RTLIL::Cell *sink_cell = NULL;
     if (!wire) {
-        return sink_cell;
+        return std::vector<RTLIL::Cell *>();
+    }
+    if (UseIndex(wire)) {
+        RTLIL::IdString port_id(RTLIL::escape_id(port));
+        return FilterSinkCells(index_->Sinks(wire), [&](const NetlistIndex::Sink &sink) { return sink.port == port_id; });
     }
     RTLIL::Module *top_module = design_->top_module();
     assert(top_module);
     std::string base_selection = top_module->name.str() + "/w:" + wire->name.str();
     pass_->extra_args(std::vector<std::string>{base_selection, "%co:+[" + port + "]", base_selection, "%d"}, 0, design_);
-    auto selected_cells = top_module->selected_cells();
-    // FIXME Handle more than one sink
-    assert(selected_cells.size() <= 1);
-    if (selected_cells.size() > 0) {
-        sink_cell = selected_cells.at(0);
-#ifdef SDC_DEBUG
-        log("Found sink cell: %s\n", RTLIL::unescape_id(sink_cell->name).c_str());
-#endif
-    }
-    return sink_cell;
+    return top_module->selected_cells();
 }
 
 bool Propagation::WireHasSinkCell(RTLIL::Wire *wire)
@@ -105,6 +195,9 @@ bool Propagation::WireHasSinkCell(RTLIL::Wire *wire)
     if (!wire) {
         return false;
     }
+    if (UseIndex(wire)) {
+        return index_->HasSinks(wire);
+    }
     RTLIL::Module *top_module = design_->top_module();
     assert(top_module);
     std::string base_selection = top_module->name.str() + "/w:" + wire->name.str();
@@ -113,26 +206,19 @@ bool Propagation::WireHasSinkCell(RTLIL::Wire *wire)
     return selected_cells.size() > 0;
 }
 
-RTLIL::Wire *Propagation::FindSinkWireOnPort(RTLIL::Cell *cell, const std::string &port_name)
+std::vector<RTLIL::Wire *> Propagation::FindSinkWiresOnPort(RTLIL::Cell *cell, const std::string &port_name)
 {
-    RTLIL::Wire *sink_wire = NULL;
     if (!cell) {
-        return sink_wire;
+        return std::vector<RTLIL::Wire *>();
+    }
+    if (index_ && cell->module == design_->top_module()) {
+        return index_->PortWires(cell, RTLIL::escape_id(port_name));
     }
     RTLIL::Module *top_module = design_->top_module();
     assert(top_module);
     std::string base_selection = top_module->name.str() + "/c:" + cell->name.str();
     pass_->extra_args(std::vector<std::string>{base_selection, "%co:+[" + port_name + "]", base_selection, "%d"}, 0, design_);
-    auto selected_wires = top_module->selected_wires();
-    // FIXME Handle more than one sink
-    assert(selected_wires.size() <= 1);
-    if (selected_wires.size() > 0) {
-        sink_wire = selected_wires.at(0);
-#ifdef SDC_DEBUG
-        log("Found sink wire: %s\n", RTLIL::unescape_id(sink_wire->name).c_str());
-#endif
-    }
-    return sink_wire;
+    return top_module->selected_wires();
 }
 
 void NaturalPropagation::Run()
@@ -156,6 +242,9 @@ void NaturalPropagation::Run()
 
 std::vector<RTLIL::Wire *> NaturalPropagation::FindAliasWires(RTLIL::Wire *wire)
 {
+    if (UseIndex(wire)) {
+        return index_->Aliases(wire);
+    }
     RTLIL::Module *top_module = design_->top_module();
     assert(top_module);
     std::vector<RTLIL::Wire *> alias_wires;
@@ -174,11 +263,11 @@ void BufferPropagation::Run()
     log("Start buffer clock propagation\n");
     log("IBUF pass\n");
 #endif
-    PropagateThroughBuffers(IBuf());
+    PropagateThroughBuffers(IBuf(), threads_);
 #ifdef SDC_DEBUG
     log("BUFG pass\n");
 #endif
-    PropagateThroughBuffers(Bufg());
+    PropagateThroughBuffers(Bufg(), threads_);
 #ifdef SDC_DEBUG
     log("Finish buffer clock propagation\n\n");
 #endif
@@ -189,49 +278,78 @@ void ClockDividerPropagation::Run()
 #ifdef SDC_DEBUG
     log("Start clock divider clock propagation\n");
 #endif
-    PropagateThroughClockDividers(Pll());
-    PropagateThroughBuffers(Bufg());
+    PropagateThroughClockDividers();
 #ifdef SDC_DEBUG
     log("Finish clock divider clock propagation\n\n");
 #endif
 }
 
-void ClockDividerPropagation::PropagateThroughClockDividers(ClockDivider divider)
+void ClockDividerPropagation::PropagateThroughClockDividers()
 {
+    // Clock wires are processed in the order their clocks become known, so
+    // dividers driven by generated clocks, also through BUFGs, are handled
+    // after the divider generating their input clock
+    std::vector<RTLIL::Wire *> worklist;
+    pool<RTLIL::Wire *> queued;
     for (auto &clock : Clocks::GetClocks(design_)) {
-        auto &clock_wire = clock.second;
+        worklist.push_back(clock.second);
+        queued.insert(clock.second);
+    }
+    auto enqueue = [&](RTLIL::Wire *wire) {
+        if (queued.insert(wire).second) {
+            worklist.push_back(wire);
+        }
+    };
+    Bufg bufg;
+    pool<RTLIL::Cell *> visited;
+    for (size_t next = 0; next < worklist.size(); next++) {
+        RTLIL::Wire *driver_wire = worklist.at(next);
 #ifdef SDC_DEBUG
-        log("Processing clock %s\n", Clock::WireName(clock_wire).c_str());
+        log("Processing clock %s\n", Clock::WireName(driver_wire).c_str());
 #endif
-        PropagateClocksForCellType(clock_wire, divider.type);
+        for (auto &divider : ClockDivider::Types()) {
+            for (auto wire : PropagateClocksForCellType(driver_wire, divider, visited)) {
+                enqueue(wire);
+                for (auto &buf_wire : FindSinkWiresForCellType(wire, bufg.type, bufg.output)) {
+                    float path_delay = bufg.delay * buf_wire.depth;
+                    Clock::Add(buf_wire.wire, Clock::Period(wire), Clock::RisingEdge(wire) + path_delay, Clock::FallingEdge(wire) + path_delay,
+                               Clock::PROPAGATED);
+                    AddEdge(buf_wire.driver, buf_wire.wire, buf_wire.cell, bufg.delay);
+                    enqueue(buf_wire.wire);
+                }
+            }
+        }
     }
 }
 
-void ClockDividerPropagation::PropagateClocksForCellType(RTLIL::Wire *driver_wire, const std::string &cell_type)
+std::vector<RTLIL::Wire *> ClockDividerPropagation::PropagateClocksForCellType(RTLIL::Wire *driver_wire, const ClockDivider &divider,
+                                                                               pool<RTLIL::Cell *> &visited)
 {
-    if (cell_type == "PLLE2_ADV") {
-        RTLIL::Cell *cell = NULL;
-        for (auto input : Pll::inputs) {
-            cell = FindSinkCellOnPort(driver_wire, input);
-            if (cell and RTLIL::unescape_id(cell->type) == cell_type) {
-                break;
+    std::vector<RTLIL::Wire *> clock_wires;
+    RTLIL::IdString cell_type(RTLIL::escape_id(divider.type));
+    for (auto &input : divider.inputs) {
+        for (auto cell : FindSinkCellsOnPort(driver_wire, input)) {
+            if (cell->type != cell_type or !visited.insert(cell).second) {
+                continue;
             }
-        }
-        if (!cell) {
-            return;
-        }
-        Pll pll(cell, Clock::Period(driver_wire), Clock::RisingEdge(driver_wire));
-        for (auto output : Pll::outputs) {
-            RTLIL::Wire *wire = FindSinkWireOnPort(cell, output);
-            // Don't add clocks on dangling wires
-            // TODO Remove the workaround with the WireHasSinkCell check once the following issue is fixed:
-            // https://github.com/SymbiFlow/yosys-f4pga-plugins/issues/59
-            if (wire && WireHasSinkCell(wire)) {
-                float clkout_period(pll.clkout_period.at(output));
-                float clkout_rising_edge(pll.clkout_rising_edge.at(output));
-                float clkout_falling_edge(pll.clkout_falling_edge.at(output));
-                Clock::Add(wire, clkout_period, clkout_rising_edge, clkout_falling_edge, Clock::GENERATED);
+#ifdef SDC_DEBUG
+            log("Found sink cell: %s\n", RTLIL::unescape_id(cell->name).c_str());
+#endif
+            auto waveforms = divider.OutputWaveforms(cell, Clock::Period(driver_wire), Clock::RisingEdge(driver_wire));
+            for (size_t i = 0; i < divider.outputs.size(); i++) {
+                for (auto wire : FindSinkWiresOnPort(cell, divider.outputs[i])) {
+                    // Don't add clocks on dangling wires
+                    // TODO Remove the workaround with the WireHasSinkCell check once the following issue is fixed:
+                    // https://github.com/SymbiFlow/yosys-f4pga-plugins/issues/59
+                    if (WireHasSinkCell(wire)) {
+                        auto &waveform = waveforms[i];
+                        Clock::Add(wire, waveform.period, waveform.rising_edge, waveform.falling_edge, Clock::GENERATED);
+                        AddEdge(driver_wire, wire, cell, 0);
+                        clock_wires.push_back(wire);
+                    }
+                }
             }
         }
     }
+    return clock_wires;
 }
@@ -18,14 +18,24 @@
 #ifndef _PROPAGATION_H_
 #define _PROPAGATION_H_
 
+#include "clock_graph.h"
 #include "clocks.h"
+#include "netlist_index.h"
+#include <unordered_map>
+#include <vector>
 
 USING_YOSYS_NAMESPACE
 
 class Propagation
 {
   public:
-    Propagation(RTLIL::Design *design, Pass *pass) : design_(design), pass_(pass) {}
+    // When no netlist index is given the sinks are looked up by evaluating
+    // selection expressions on the top module. The cells a clock goes through
+    // are recorded in the graph if one is given.
+    Propagation(RTLIL::Design *design, Pass *pass, const NetlistIndex *index = nullptr, ClockGraph *graph = nullptr)
+        : design_(design), pass_(pass), index_(index), graph_(graph)
+    {
+    }
     virtual ~Propagation() {}
 
     virtual void Run() = 0;
@@ -33,21 +43,59 @@ class Propagation
   protected:
     RTLIL::Design *design_;
     Pass *pass_;
+    const NetlistIndex *index_;
+    ClockGraph *graph_;
+
+    // Wire reached from a driver through a number of cells of a given type.
+    // The last of these cells and the wire driving it are kept too.
+    struct SinkWire {
+        RTLIL::Wire *wire;
+        int depth;
+        RTLIL::Wire *driver;
+        RTLIL::Cell *cell;
+    };
+
+    void AddEdge(RTLIL::Wire *from, RTLIL::Wire *to, RTLIL::Cell *cell, float delay)
+    {
+        if (graph_) {
+            graph_->AddEdge(from, to, cell, delay);
+        }
+    }
+
+    // Buffers of one type fed by each wire and the wires they drive. Only
+    // plain pointers are stored so the graph can be walked from several
+    // threads; the netlist index isn't safe for that.
+    struct BufferFanout {
+        RTLIL::Cell *cell;
+        std::vector<RTLIL::Wire *> outputs;
+    };
+    typedef std::unordered_map<RTLIL::Wire *, std::vector<BufferFanout>> BufferGraph;
 
     // This propagation doesn't change the clock so the sink wire is only marked
-    // as propagated clock signal, but has the properties of the driving clock
-    void PropagateThroughBuffers(Buffer buffer);
-    std::vector<RTLIL::Wire *> FindSinkWiresForCellType(RTLIL::Wire *driver_wire, const std::string &cell_type, const std::string &cell_port);
-    RTLIL::Cell *FindSinkCellOfType(RTLIL::Wire *wire, const std::string &type);
-    RTLIL::Cell *FindSinkCellOnPort(RTLIL::Wire *wire, const std::string &port);
-    RTLIL::Wire *FindSinkWireOnPort(RTLIL::Cell *cell, const std::string &port_name);
+    // as propagated clock signal, but has the properties of the driving clock.
+    // The buffer trees of the clocks are walked on up to threads threads when
+    // a netlist index is available, the clocks are then added in clock order.
+    void PropagateThroughBuffers(Buffer buffer, int threads = 1);
+    BufferGraph BuildBufferGraph(const Buffer &buffer);
+    // Breadth-first walk from a driver wire. fanout_of(wire, fanout) appends
+    // the (cell, output wire) pairs of the buffers fed by the wire.
+    template <typename FanoutFunc> static std::vector<SinkWire> WalkSinkWires(RTLIL::Wire *driver_wire, FanoutFunc fanout_of);
+    static std::vector<SinkWire> FindSinkWiresInBufferGraph(const BufferGraph &graph, RTLIL::Wire *driver_wire);
+    std::vector<SinkWire> FindSinkWiresForCellType(RTLIL::Wire *driver_wire, const std::string &cell_type, const std::string &cell_port);
+    std::vector<RTLIL::Cell *> FindSinkCellsOfType(RTLIL::Wire *wire, const std::string &type);
+    std::vector<RTLIL::Cell *> FindSinkCellsOnPort(RTLIL::Wire *wire, const std::string &port);
+    std::vector<RTLIL::Wire *> FindSinkWiresOnPort(RTLIL::Cell *cell, const std::string &port_name);
     bool WireHasSinkCell(RTLIL::Wire *wire);
+    bool UseIndex(RTLIL::Wire *wire) { return index_ && index_->Contains(wire); }
 };
 
 class NaturalPropagation : public Propagation
 {
   public:
-    NaturalPropagation(RTLIL::Design *design, Pass *pass) : Propagation(design, pass) {}
+    NaturalPropagation(RTLIL::Design *design, Pass *pass, const NetlistIndex *index = nullptr, ClockGraph *graph = nullptr)
+        : Propagation(design, pass, index, graph)
+    {
+    }
 
     void Run() override;
     std::vector<RTLIL::Wire *> FindAliasWires(RTLIL::Wire *wire);
@@ -56,18 +104,30 @@ class NaturalPropagation : public Propagation
 class BufferPropagation : public Propagation
 {
   public:
-    BufferPropagation(RTLIL::Design *design, Pass *pass) : Propagation(design, pass) {}
+    BufferPropagation(RTLIL::Design *design, Pass *pass, const NetlistIndex *index = nullptr, ClockGraph *graph = nullptr, int threads = 1)
+        : Propagation(design, pass, index, graph), threads_(threads)
+    {
+    }
 
     void Run() override;
+
+  private:
+    int threads_;
 };
 
 class ClockDividerPropagation : public Propagation
 {
   public:
-    ClockDividerPropagation(RTLIL::Design *design, Pass *pass) : Propagation(design, pass) {}
+    ClockDividerPropagation(RTLIL::Design *design, Pass *pass, const NetlistIndex *index = nullptr, ClockGraph *graph = nullptr)
+        : Propagation(design, pass, index, graph)
+    {
+    }
 
     void Run() override;
-    void PropagateClocksForCellType(RTLIL::Wire *driver_wire, const std::string &cell_type);
-    void PropagateThroughClockDividers(ClockDivider divider);
+    // Adds the clocks generated by the dividers of the given type that
+    // driver_wire feeds and returns their wires. Dividers in visited are
+    // skipped, this way each one is processed once.
+    std::vector<RTLIL::Wire *> PropagateClocksForCellType(RTLIL::Wire *driver_wire, const ClockDivider &divider, pool<RTLIL::Cell *> &visited);
+    void PropagateThroughClockDividers();
 };
 #endif // PROPAGATION_H_
@@ -24,13 +24,19 @@
 #include <ostream>
 #include <sstream>
 #include <string>
+#include <thread>
 #include <vector>
 
+#include "../common/tcl_script.h"
+#include "clock_domains.h"
+#include "clock_graph.h"
 #include "clocks.h"
 #include "kernel/log.h"
 #include "kernel/register.h"
 #include "kernel/rtlil.h"
+#include "netlist_index.h"
 #include "propagation.h"
+#include "sdc_reader.h"
 #include "sdc_writer.h"
 #include "set_clock_groups.h"
 #include "set_false_path.h"
@@ -40,54 +46,31 @@ USING_YOSYS_NAMESPACE
 
 PRIVATE_NAMESPACE_BEGIN
 
-struct ReadSdcCmd : public Frontend {
-    ReadSdcCmd() : Frontend("sdc", "Read SDC file") {}
-
-    void help() override
-    {
-        log("\n");
-        log("    read_sdc <filename>\n");
-        log("\n");
-        log("Read SDC file.\n");
-        log("\n");
-    }
-
-    void execute(std::istream *&f, std::string filename, std::vector<std::string> args, RTLIL::Design *) override
-    {
-        if (args.size() < 2) {
-            log_cmd_error("Missing script file.\n");
-        }
-        log("\nReading clock constraints file(SDC)\n\n");
-        size_t argidx = 1;
-        extra_args(f, filename, args, argidx);
-        std::string content{std::istreambuf_iterator<char>(*f), std::istreambuf_iterator<char>()};
-        log("%s\n", content.c_str());
-        Tcl_Interp *interp = yosys_get_tcl_interp();
-        if (Tcl_EvalFile(interp, args[argidx].c_str()) != TCL_OK) {
-            log_cmd_error("TCL interpreter returned an error: %s\n", Tcl_GetStringResult(interp));
-        }
-    }
-};
-
 struct WriteSdcCmd : public Backend {
     WriteSdcCmd(SdcWriter &sdc_writer) : Backend("sdc", "Write SDC file"), sdc_writer_(sdc_writer) {}
 
     void help() override
     {
         log("\n");
-        log("    write_sdc [-include_propagated_clocks] <filename>\n");
+        log("    write_sdc [-include_propagated_clocks] [-split_clock_domains] <filename>\n");
         log("\n");
         log("Write SDC file.\n");
         log("\n");
         log("    -include_propagated_clocks\n");
         log("       Write out all propagated clocks");
         log("\n");
+        log("    -split_clock_domains\n");
+        log("       Write the clocks and the constraints that refer to a single clock\n");
+        log("       domain to <filename>_<clock_name>.sdc. The remaining constraints\n");
+        log("       are written to <filename>.\n");
+        log("\n");
     }
 
     void execute(std::ostream *&f, std::string filename, std::vector<std::string> args, RTLIL::Design *design) override
     {
         size_t argidx;
         bool include_propagated = false;
+        bool split_clock_domains = false;
         if (args.size() < 2) {
             log_cmd_error("Missing output file.\n");
         }
@@ -97,11 +80,19 @@ struct WriteSdcCmd : public Backend {
                 include_propagated = true;
                 continue;
             }
+            if (arg == "-split_clock_domains" && argidx + 1 < args.size()) {
+                split_clock_domains = true;
+                continue;
+            }
             break;
         }
         log("\nWriting out clock constraints file(SDC)\n");
         extra_args(f, filename, args, argidx);
-        sdc_writer_.WriteSdc(design, *f, include_propagated);
+        if (split_clock_domains) {
+            sdc_writer_.WriteSdcPerClockDomain(design, *f, filename, include_propagated);
+        } else {
+            sdc_writer_.WriteSdc(design, *f, include_propagated);
+        }
     }
 
     SdcWriter &sdc_writer_;
@@ -123,6 +114,11 @@ struct CreateClockCmd : public Pass {
             "falling edges) of the clock.\n");
         log("It is specified as a list of two elements/time values: the first "
             "rising edge and the next falling edge.\n");
+        log("Defining a clock again on the same target replaces its properties.\n");
+        log("The properties are written to the PERIOD, WAVEFORM, etc. attributes "
+            "of the target wires.\n");
+        log("Setting these attributes directly, e.g. with setattr, does not "
+            "change a clock created by the plugin.\n");
         log("\n");
     }
 
@@ -163,12 +159,35 @@ struct CreateClockCmd : public Pass {
         if (period <= 0) {
             log_cmd_error("Incorrect period value\n");
         }
+        // If clock name is not specified then take the name of the first target
+        std::vector<RTLIL::Wire *> selected_wires;
+        // The index holds the wires of all modules, after a cd the names
+        // have to be looked up in the active module by the selection
+        if (wire_index && design->selected_active_module.empty() && std::all_of(args.begin() + argidx, args.end(), WireNameIndex::IsPlainName)) {
+            selected_wires = wire_index->Find(args.begin() + argidx, args.end());
+        } else {
+            SelectWires(args, argidx, design, selected_wires);
+        }
+        if (selected_wires.size() == 0) {
+            log_cmd_error("Target selection is empty\n");
+        }
+        if (name.empty()) {
+            name = RTLIL::unescape_id(selected_wires.at(0)->name);
+        }
+        if (!is_waveform_specified) {
+            rising_edge = 0;
+            falling_edge = period / 2;
+        }
+        Clock::Add(name, selected_wires, period, rising_edge, falling_edge, Clock::EXPLICIT);
+        Clocks::WriteAttributes(design);
+    }
+
+    void SelectWires(std::vector<std::string> &args, size_t argidx, RTLIL::Design *design, std::vector<RTLIL::Wire *> &selected_wires)
+    {
         // Add "w:" prefix to selection arguments to enforce wire object
         // selection
         AddWirePrefix(args, argidx);
         extra_args(args, argidx, design);
-        // If clock name is not specified then take the name of the first target
-        std::vector<RTLIL::Wire *> selected_wires;
         for (auto module : design->modules()) {
             if (!design->selected(module)) {
                 continue;
@@ -182,17 +201,6 @@ struct CreateClockCmd : public Pass {
                 }
             }
         }
-        if (selected_wires.size() == 0) {
-            log_cmd_error("Target selection is empty\n");
-        }
-        if (name.empty()) {
-            name = RTLIL::unescape_id(selected_wires.at(0)->name);
-        }
-        if (!is_waveform_specified) {
-            rising_edge = 0;
-            falling_edge = period / 2;
-        }
-        Clock::Add(name, selected_wires, period, rising_edge, falling_edge, Clock::EXPLICIT);
     }
 
     void AddWirePrefix(std::vector<std::string> &args, size_t argidx)
@@ -200,6 +208,65 @@ struct CreateClockCmd : public Pass {
         auto selection_begin = args.begin() + argidx;
         std::transform(selection_begin, args.end(), selection_begin, [](std::string &w) { return "w:" + w; });
     }
+
+    // Set by read_sdc while reading a file
+    const WireNameIndex *wire_index = nullptr;
+};
+
+struct ReadSdcCmd : public Frontend {
+    ReadSdcCmd(CreateClockCmd &create_clock_cmd) : Frontend("sdc", "Read SDC file"), create_clock_cmd_(create_clock_cmd) {}
+
+    void help() override
+    {
+        log("\n");
+        log("    read_sdc <filename>\n");
+        log("\n");
+        log("Read SDC file.\n");
+        log("\n");
+        log("Commands of the plugin made of literal words, optionally with\n");
+        log("[get_ports <name>] or [get_nets <name>] arguments, are run directly.\n");
+        log("The rest of the file is evaluated by the Tcl interpreter.\n");
+        log("\n");
+    }
+
+    void execute(std::istream *&f, std::string filename, std::vector<std::string> args, RTLIL::Design *design) override
+    {
+        if (args.size() < 2) {
+            log_cmd_error("Missing script file.\n");
+        }
+        log("\nReading clock constraints file(SDC)\n\n");
+        size_t argidx = 1;
+        extra_args(f, filename, args, argidx);
+        std::string content{std::istreambuf_iterator<char>(*f), std::istreambuf_iterator<char>()};
+        log("%s\n", content.c_str());
+        Tcl_Interp *interp = yosys_get_tcl_interp();
+        // Clock targets of the whole file are resolved with one index
+        WireNameIndex wire_index(design);
+        bool ok;
+        {
+            ReadScope scope(interp, args[argidx], create_clock_cmd_, wire_index);
+            ok = SdcReader(interp, design).Eval(content);
+        }
+        if (!ok) {
+            log_cmd_error("TCL interpreter returned an error: %s\n", Tcl_GetStringResult(interp));
+        }
+    }
+
+    // State of the interpreter and of the commands while a file is read,
+    // restored also when a command of the file throws
+    struct ReadScope {
+        ReadScope(Tcl_Interp *interp, const std::string &path, CreateClockCmd &create_clock_cmd, const WireNameIndex &wire_index)
+            : info_script(interp, path), create_clock_cmd(create_clock_cmd)
+        {
+            create_clock_cmd.wire_index = &wire_index;
+        }
+        ~ReadScope() { create_clock_cmd.wire_index = nullptr; }
+
+        TclInfoScriptGuard info_script;
+        CreateClockCmd &create_clock_cmd;
+    };
+
+    CreateClockCmd &create_clock_cmd_;
 };
 
 struct GetClocksCmd : public Pass {
@@ -213,6 +280,12 @@ struct GetClocksCmd : public Pass {
         log("\n");
         log("Returns all clocks in the design.\n");
         log("\n");
+        log("Clocks are the wires added by create_clock and propagate_clocks, and\n");
+        log("the wires with the CLOCK_SIGNAL attribute when the design was read. The\n");
+        log("clock wires are cached, a CLOCK_SIGNAL attribute set later by other\n");
+        log("commands, e.g. setattr, is only seen after a module of the design is\n");
+        log("added or removed.\n");
+        log("\n");
         log("    -include_generated_clocks\n");
         log("        Include auto-generated clocks.\n");
         log("\n");
@@ -306,28 +379,56 @@ struct GetClocksCmd : public Pass {
 };
 
 struct PropagateClocksCmd : public Pass {
-    PropagateClocksCmd() : Pass("propagate_clocks", "Propagate clock information") {}
+    PropagateClocksCmd(ClockGraph &clock_graph) : Pass("propagate_clocks", "Propagate clock information"), clock_graph_(clock_graph) {}
 
     void help() override
     {
         log("\n");
-        log("    propagate_clocks\n");
+        log("    propagate_clocks [-threads <N>]\n");
         log("\n");
         log("Propagate clock information throughout the design.\n");
+        log("The resulting clock graph is kept for write_clock_graph and\n");
+        log("get_clock_fanout.\n");
+        log("\n");
+        log("    -threads <N>\n");
+        log("        Walk the buffer trees of the clocks using up to N threads (0 uses\n");
+        log("        all available cores). The clocks are then added one by one in the\n");
+        log("        usual order so the result does not depend on N. The default is 1.\n");
         log("\n");
     }
 
     void execute(std::vector<std::string> args, RTLIL::Design *design) override
     {
-        if (args.size() > 1) {
-            log_warning("Command accepts no arguments.\nAll will be ignored.\n");
+        int threads(1);
+        size_t argidx;
+        for (argidx = 1; argidx < args.size(); argidx++) {
+            if (args[argidx] == "-threads" && argidx + 1 < args.size()) {
+                const std::string &value = args[++argidx];
+                if (value.empty() || value.find_first_not_of("0123456789") != std::string::npos) {
+                    log_cmd_error("Invalid number of threads: '%s'\n", value.c_str());
+                }
+                threads = std::atoi(value.c_str());
+                continue;
+            }
+            break;
+        }
+        if (argidx < args.size()) {
+            log_warning("Command accepts only the -threads option.\nAll other arguments will be ignored.\n");
+        }
+        if (threads == 0) {
+            threads = std::max(1U, std::thread::hardware_concurrency());
         }
         if (!design->top_module()) {
             log_cmd_error("No top module selected\n");
         }
 
-        std::array<std::unique_ptr<Propagation>, 2> passes{std::unique_ptr<Propagation>(new BufferPropagation(design, this)),
-                                                           std::unique_ptr<Propagation>(new ClockDividerPropagation(design, this))};
+        // Propagation only changes wire attributes so a single connectivity
+        // index of the top module serves all the propagation passes
+        NetlistIndex index(design, design->top_module());
+        clock_graph_.Clear(design);
+        std::array<std::unique_ptr<Propagation>, 2> passes{
+          std::unique_ptr<Propagation>(new BufferPropagation(design, this, &index, &clock_graph_, threads)),
+          std::unique_ptr<Propagation>(new ClockDividerPropagation(design, this, &index, &clock_graph_))};
 
         log("Perform clock propagation\n");
 
@@ -335,29 +436,189 @@ struct PropagateClocksCmd : public Pass {
             pass->Run();
         }
 
+        Clocks::WriteAttributes(design);
         Clocks::UpdateAbc9DelayTarget(design);
+        clock_graph_.Finish(index);
+    }
+
+    ClockGraph &clock_graph_;
+};
+
+struct WriteClockGraphCmd : public Backend {
+    WriteClockGraphCmd(ClockGraph &clock_graph) : Backend("clock_graph", "Write the clock graph found by propagate_clocks"), clock_graph_(clock_graph) {}
+
+    void help() override
+    {
+        log("\n");
+        log("    write_clock_graph <filename>\n");
+        log("\n");
+        log("Write the clock graph found by the last propagate_clocks run as JSON. The\n");
+        log("graph lists the clock wires with their period, waveform and the cells they\n");
+        log("clock, and the buffers and clock dividers between the clock wires.\n");
+        log("\n");
+    }
+
+    void execute(std::ostream *&f, std::string filename, std::vector<std::string> args, RTLIL::Design *design) override
+    {
+        if (args.size() < 2) {
+            log_cmd_error("Missing output file.\n");
+        }
+        if (!clock_graph_.IsBuiltFor(design)) {
+            log_cmd_error("No clock graph found, run propagate_clocks first.\n");
+        }
+        extra_args(f, filename, args, 1);
+        log("\nWriting out clock graph\n");
+        clock_graph_.WriteJson(*f);
+    }
+
+    ClockGraph &clock_graph_;
+};
+
+struct GetClockFanoutCmd : public Pass {
+    GetClockFanoutCmd(ClockGraph &clock_graph) : Pass("get_clock_fanout", "Get the cells clocked by a clock"), clock_graph_(clock_graph) {}
+
+    void help() override
+    {
+        log("\n");
+        log("    get_clock_fanout [-transitive] <clock>\n");
+        log("\n");
+        log("Returns the cells clocked by the clock, given by its name or the name of\n");
+        log("its wire. The answer comes from the clock graph found by the last\n");
+        log("propagate_clocks run, the netlist isn't traversed again.\n");
+        log("\n");
+        log("    -transitive\n");
+        log("        Include the cells clocked by the clocks derived from the clock\n");
+        log("        through buffers and clock dividers.\n");
+        log("\n");
+    }
+
+    void execute(std::vector<std::string> args, RTLIL::Design *design) override
+    {
+        bool transitive(false);
+        size_t argidx;
+        for (argidx = 1; argidx < args.size(); argidx++) {
+            std::string arg = args[argidx];
+            if (arg == "-transitive") {
+                transitive = true;
+                continue;
+            }
+            if (arg.size() > 0 and arg[0] == '-') {
+                log_cmd_error("Unknown option %s.\n", arg.c_str());
+            }
+            break;
+        }
+        if (argidx + 1 != args.size()) {
+            log_cmd_error("Expected exactly one clock\n");
+        }
+        if (!clock_graph_.IsBuiltFor(design)) {
+            log_cmd_error("No clock graph found, run propagate_clocks first.\n");
+        }
+        Tcl_Interp *interp = yosys_get_tcl_interp();
+        Tcl_Obj *tcl_list = Tcl_NewListObj(0, NULL);
+        for (auto &cell : clock_graph_.Fanout(args[argidx], transitive)) {
+            Tcl_ListObjAppendElement(interp, tcl_list, Tcl_NewStringObj(cell.c_str(), cell.size()));
+        }
+        Tcl_SetObjResult(interp, tcl_list);
+    }
+
+    ClockGraph &clock_graph_;
+};
+
+struct Abc9ClockDomainsCmd : public Pass {
+    Abc9ClockDomainsCmd() : Pass("abc9_clock_domains", "Run ABC9 with a delay target per clock domain") {}
+
+    void help() override
+    {
+        log("\n");
+        log("    abc9_clock_domains [abc9 options]\n");
+        log("\n");
+        log("Split the combinational logic of the top module by the clock domain it\n");
+        log("feeds and run abc9 on each part with half the period of its fastest clock\n");
+        log("as delay target (-D). Logic that feeds no clocked cell is mapped with the\n");
+        log("default abc9 delay target. The parts are flattened back into the top module\n");
+        log("afterwards, so the top module is expected to be flat, e.g. after\n");
+        log("synth_xilinx -flatten. Clocked cells and blackbox cells are not passed to\n");
+        log("abc9.\n");
+        log("\n");
+        log("The options are passed to each abc9 call.\n");
+        log("\n");
+    }
+
+    void execute(std::vector<std::string> args, RTLIL::Design *design) override
+    {
+        RTLIL::Module *top_module = design->top_module();
+        if (!top_module) {
+            log_cmd_error("No top module selected\n");
+        }
+        std::string abc9_args;
+        for (size_t argidx = 1; argidx < args.size(); argidx++) {
+            abc9_args += " " + args[argidx];
+        }
+
+        log_header(design, "Executing ABC9_CLOCK_DOMAINS pass.\n");
+        log_push();
+
+        // Move each partition to its own module
+        std::map<std::string, int> targets;
+        for (auto &partition : ClockDomainPartition(design).Partitions()) {
+            std::string name(partition.first == ClockDomainPartition::no_target ? "abc9_no_target" : "abc9_D" + std::to_string(partition.first));
+            log("Partition %s: %zu cells\n", name.c_str(), partition.second.size());
+            for (auto cell : partition.second) {
+                cell->set_string_attribute(ID(submod), name);
+            }
+            targets[name] = partition.first;
+        }
+        if (targets.empty()) {
+            log("No logic to map.\n");
+            log_pop();
+            return;
+        }
+        std::string top_name(RTLIL::unescape_id(top_module->name));
+        Pass::call(design, "submod " + top_name);
+
+        for (auto &target : targets) {
+            RTLIL::Module *module = design->module(top_module->name.str() + "_" + target.first);
+            if (!module) {
+                log_cmd_error("Partition module %s_%s not found\n", top_name.c_str(), target.first.c_str());
+            }
+            std::string delay(target.second == ClockDomainPartition::no_target ? "" : " -D " + std::to_string(target.second));
+            log("Mapping partition %s with abc9%s\n", target.first.c_str(), delay.c_str());
+            Pass::call_on_module(design, module, "abc9" + delay + abc9_args);
+        }
+
+        Pass::call_on_module(design, top_module, "flatten");
+        for (auto &target : targets) {
+            design->remove(design->module(top_module->name.str() + "_" + target.first));
+        }
+        log_pop();
     }
 };
 
 class SdcPlugin
 {
   public:
-    SdcPlugin() : write_sdc_cmd_(sdc_writer_), set_false_path_cmd_(sdc_writer_), set_max_delay_cmd_(sdc_writer_), set_clock_groups_cmd_(sdc_writer_)
+    SdcPlugin()
+        : read_sdc_cmd_(create_clock_cmd_), write_sdc_cmd_(sdc_writer_), write_clock_graph_cmd_(clock_graph_), propagate_clocks_cmd_(clock_graph_),
+          get_clock_fanout_cmd_(clock_graph_), set_false_path_cmd_(sdc_writer_), set_max_delay_cmd_(sdc_writer_), set_clock_groups_cmd_(sdc_writer_)
     {
         log("Loaded SDC plugin\n");
     }
 
     ReadSdcCmd read_sdc_cmd_;
     WriteSdcCmd write_sdc_cmd_;
+    WriteClockGraphCmd write_clock_graph_cmd_;
     CreateClockCmd create_clock_cmd_;
     GetClocksCmd get_clocks_cmd_;
     PropagateClocksCmd propagate_clocks_cmd_;
+    GetClockFanoutCmd get_clock_fanout_cmd_;
     SetFalsePath set_false_path_cmd_;
     SetMaxDelay set_max_delay_cmd_;
     SetClockGroups set_clock_groups_cmd_;
+    Abc9ClockDomainsCmd abc9_clock_domains_cmd_;
 
   private:
     SdcWriter sdc_writer_;
+    ClockGraph clock_graph_;
 } SdcPlugin;
 
 PRIVATE_NAMESPACE_END
@@ -0,0 +1,172 @@
+/*
+ * Copyright 2020-2022 F4PGA Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "sdc_reader.h"
+#include "../common/tcl_script.h"
+#include "kernel/register.h"
+#include <algorithm>
+#include <sstream>
+
+USING_YOSYS_NAMESPACE
+
+// Constraint commands of the plugin that are run without Tcl
+static const char *native_commands[] = {"create_clock", "set_false_path", "set_max_delay", "set_clock_groups", "propagate_clocks"};
+
+WireNameIndex::WireNameIndex(RTLIL::Design *design)
+{
+    int position = 0;
+    for (auto module : design->modules()) {
+        if (module->get_blackbox_attribute()) {
+            continue;
+        }
+        for (auto wire : module->wires()) {
+            if (wire->name.begins_with("\\")) {
+                wires_[wire->name.str().substr(1)].emplace_back(position, wire);
+            }
+            position++;
+        }
+    }
+}
+
+bool WireNameIndex::IsPlainName(const std::string &name)
+{
+    return !name.empty() && name[0] != '$' && name.find_first_of("*?[]\\:%/=") == std::string::npos;
+}
+
+std::vector<RTLIL::Wire *> WireNameIndex::Find(std::vector<std::string>::const_iterator begin, std::vector<std::string>::const_iterator end) const
+{
+    std::vector<std::pair<int, RTLIL::Wire *>> found;
+    for (auto name = begin; name != end; name++) {
+        auto it = wires_.find(*name);
+        if (it != wires_.end()) {
+            found.insert(found.end(), it->second.begin(), it->second.end());
+        }
+    }
+    std::sort(found.begin(), found.end());
+    found.erase(std::unique(found.begin(), found.end()), found.end());
+    std::vector<RTLIL::Wire *> wires;
+    wires.reserve(found.size());
+    for (auto &it : found) {
+        wires.push_back(it.second);
+    }
+    return wires;
+}
+
+SdcReader::SdcReader(Tcl_Interp *interp, RTLIL::Design *design) : interp_(interp), design_(design) {}
+
+bool SdcReader::IsTclCommand(const std::string &name) const
+{
+    Tcl_CmdInfo info;
+    return Tcl_GetCommandInfo(interp_, name.c_str(), &info) != 0;
+}
+
+bool SdcReader::Eval(const std::string &content)
+{
+    // Only run commands natively that the script could call through Tcl
+    pool<std::string> native;
+    for (auto name : native_commands) {
+        if (IsTclCommand(name)) {
+            native.insert(name);
+        }
+    }
+
+    std::string tcl_chunk;
+    auto flush = [&]() {
+        if (tcl_chunk.empty()) {
+            return true;
+        }
+        bool ok = Tcl_Eval(interp_, tcl_chunk.c_str()) == TCL_OK;
+        tcl_chunk.clear();
+        return ok;
+    };
+
+    std::istringstream lines(content);
+    std::string line;
+    std::string command;
+    std::vector<std::string> words;
+    while (std::getline(lines, line)) {
+        command += line;
+        command += '\n';
+        // Backslash-newline continues the command on the next line
+        if (!Tcl_CommandComplete(command.c_str()) || (!line.empty() && line.back() == '\\')) {
+            continue;
+        }
+        if (TclLiteralScanner::is_comment_or_empty(command)) {
+            // Empty line or comment
+        } else if (ParseLiteral(TclLiteralScanner::join_continued_lines(command), words) && native.count(words[0])) {
+            if (!flush()) {
+                return false;
+            }
+            Pass::call(design_, words);
+        } else {
+            tcl_chunk += command;
+        }
+        command.clear();
+    }
+    tcl_chunk += command;
+    return flush();
+}
+
+// Splits a command made of bare words, braced words without nesting and
+// "[get_ports NAME]" or "[get_nets NAME]" substitutions into words
+bool SdcReader::ParseLiteral(const std::string &command, std::vector<std::string> &words) const
+{
+    words.clear();
+    TclLiteralScanner scanner(command);
+    std::string text;
+    while (scanner.skip_spaces()) {
+        if (!scanner.consume('[')) {
+            if (!scanner.word(text)) {
+                return false;
+            }
+            words.push_back(text);
+            continue;
+        }
+        scanner.skip_spaces();
+        std::string getter;
+        if (!scanner.word(getter)) {
+            return false;
+        }
+        scanner.skip_spaces();
+        if (!scanner.word(text) || !ResolveObject(getter, text, text)) {
+            return false;
+        }
+        scanner.skip_spaces();
+        if (!scanner.consume(']')) {
+            return false;
+        }
+        words.push_back(text);
+    }
+    return !words.empty();
+}
+
+bool SdcReader::ResolveObject(const std::string &command, const std::string &name, std::string &result) const
+{
+    if ((command != "get_ports" && command != "get_nets") || !IsTclCommand(command)) {
+        return false;
+    }
+    RTLIL::Module *top_module = design_->top_module();
+    if (!top_module || !WireNameIndex::IsPlainName(name)) {
+        return false;
+    }
+    RTLIL::Wire *wire = top_module->wire(RTLIL::escape_id(name));
+    if (!wire || (command == "get_ports" && !wire->port_input && !wire->port_output)) {
+        return false;
+    }
+    result = name;
+    return true;
+}
@@ -0,0 +1,69 @@
+/*
+ * Copyright 2020-2022 F4PGA Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#ifndef _SDC_READER_H_
+#define _SDC_READER_H_
+
+#include "kernel/rtlil.h"
+#include <string>
+#include <utility>
+#include <vector>
+
+USING_YOSYS_NAMESPACE
+
+// Wires of all the non-blackbox modules by their unescaped name. Lets
+// commands resolve plain object names without evaluating a selection.
+class WireNameIndex
+{
+  public:
+    explicit WireNameIndex(RTLIL::Design *design);
+
+    // Check if the name can be resolved by the index, i.e. it is a public
+    // name without wildcards or other selection syntax
+    static bool IsPlainName(const std::string &name);
+
+    // Wires with any of the names, in the order a selection lists them
+    std::vector<RTLIL::Wire *> Find(std::vector<std::string>::const_iterator begin, std::vector<std::string>::const_iterator end) const;
+
+  private:
+    // Wires by name with their position in the design
+    dict<std::string, std::vector<std::pair<int, RTLIL::Wire *>>> wires_;
+};
+
+// Streams an SDC script, running the commands made of literal words
+// directly and passing everything else to the Tcl interpreter. Literal
+// "[get_ports NAME]" and "[get_nets NAME]" arguments naming a wire of the
+// top module are replaced with the name, as the commands would return it.
+class SdcReader
+{
+  public:
+    SdcReader(Tcl_Interp *interp, RTLIL::Design *design);
+
+    // Evaluates the content of a script. Returns false if Tcl reported an
+    // error, the message is left in the interpreter result.
+    bool Eval(const std::string &content);
+
+  private:
+    bool ParseLiteral(const std::string &command, std::vector<std::string> &words) const;
+    bool ResolveObject(const std::string &command, const std::string &name, std::string &result) const;
+    bool IsTclCommand(const std::string &name) const;
+
+    Tcl_Interp *interp_;
+    RTLIL::Design *design_;
+};
+
+#endif // _SDC_READER_H_
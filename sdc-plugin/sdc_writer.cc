@@ -16,15 +16,207 @@
  * SPDX-License-Identifier: Apache-2.0
  */
 #include "sdc_writer.h"
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
 
 USING_YOSYS_NAMESPACE
 
 const std::map<ClockGroups::ClockGroupRelation, std::string> ClockGroups::relation_name_map = {
   {NONE, ""}, {ASYNCHRONOUS, "asynchronous"}, {PHYSICALLY_EXCLUSIVE, "physically_exclusive"}, {LOGICALLY_EXCLUSIVE, "logically_exclusive"}};
 
-void SdcWriter::AddFalsePath(FalsePath false_path) { false_paths_.push_back(false_path); }
+SdcOutputBuffer &SdcOutputBuffer::operator<<(float value)
+{
+    char str[32];
+    int size = snprintf(str, sizeof(str), "%g", value);
+    buffer_.append(str, size);
+    return *this;
+}
 
-void SdcWriter::SetMaxDelay(TimingPath timing_path) { timing_paths_.push_back(timing_path); }
+void SdcOutputBuffer::EndLine()
+{
+    buffer_ += '\n';
+    if (buffer_.size() >= flush_size) {
+        Flush();
+    }
+}
+
+void SdcOutputBuffer::Flush()
+{
+    file_.write(buffer_.data(), buffer_.size());
+    buffer_.clear();
+}
+
+void SdcOutputs::SplitClockDomains(RTLIL::Design *design, const std::string &filename)
+{
+    size_t ext_pos = filename.rfind('.');
+    size_t dir_pos = filename.find_last_of("/\\");
+    if (ext_pos == std::string::npos || (dir_pos != std::string::npos && ext_pos < dir_pos)) {
+        ext_pos = filename.size();
+    }
+    filename_base_ = filename.substr(0, ext_pos);
+    filename_ext_ = filename.substr(ext_pos);
+    for (auto &clock : Clocks::GetClocks(design)) {
+        std::string domain(Clock::Name(clock.second));
+        domains_[domain] = domain;
+        domains_[clock.first] = domain;
+    }
+}
+
+SdcOutputBuffer &SdcOutputs::ForClock(RTLIL::Wire *clock_wire)
+{
+    if (domains_.empty()) {
+        return main_;
+    }
+    return ForDomain(Clock::Name(clock_wire));
+}
+
+SdcOutputBuffer &SdcOutputs::ForPins(std::initializer_list<const std::string *> pins)
+{
+    if (domains_.empty()) {
+        return main_;
+    }
+    const std::string *domain = nullptr;
+    for (auto pin : pins) {
+        size_t pos = 0;
+        while (pos < pin->size()) {
+            size_t begin = pin->find_first_not_of(" \t{}", pos);
+            if (begin == std::string::npos) {
+                break;
+            }
+            size_t end = pin->find_first_of(" \t{}", begin);
+            if (end == std::string::npos) {
+                end = pin->size();
+            }
+            auto it = domains_.find(pin->substr(begin, end - begin));
+            if (it != domains_.end()) {
+                if (domain && *domain != it->second) {
+                    return main_;
+                }
+                domain = &it->second;
+            }
+            pos = end;
+        }
+    }
+    return domain ? ForDomain(*domain) : main_;
+}
+
+SdcOutputBuffer &SdcOutputs::ForDomain(const std::string &domain)
+{
+    auto &buffer = domain_buffers_[domain];
+    if (!buffer) {
+        std::string suffix(domain);
+        std::replace_if(
+          suffix.begin(), suffix.end(), [](char c) { return !isalnum(static_cast<unsigned char>(c)) && c != '_' && c != '-'; }, '_');
+        std::string filename(filename_base_ + "_" + suffix + filename_ext_);
+        auto &file = domain_files_[domain];
+        file.reset(new std::ofstream(filename));
+        if (file->fail()) {
+            log_cmd_error("Can't open output file `%s' for writing: %s\n", filename.c_str(), strerror(errno));
+        }
+        log("Writing constraints of clock domain %s to %s\n", domain.c_str(), filename.c_str());
+        buffer.reset(new SdcOutputBuffer(*file));
+    }
+    return *buffer;
+}
+
+std::vector<std::string> SplitTclList(const std::string &list)
+{
+    Tcl_Interp *interp = yosys_get_tcl_interp();
+    int argc;
+    const char **argv;
+    if (Tcl_SplitList(interp, list.c_str(), &argc, &argv) != TCL_OK) {
+        log_cmd_error("Malformed list: %s\n", list.c_str());
+    }
+    std::vector<std::string> items(argv, argv + argc);
+    Tcl_Free(reinterpret_cast<char *>(argv));
+    return items;
+}
+
+int SdcWriter::InternPins(const std::string &pins)
+{
+    auto it = pin_list_ids_.find(pins);
+    if (it != pin_list_ids_.end()) {
+        return it->second;
+    }
+    // Pins are separated the same way SdcOutputs::ForPins splits them
+    std::vector<std::string> names;
+    size_t pos = 0;
+    while (pos < pins.size()) {
+        size_t begin = pins.find_first_not_of(" \t{}", pos);
+        if (begin == std::string::npos) {
+            break;
+        }
+        size_t end = pins.find_first_of(" \t{}", begin);
+        if (end == std::string::npos) {
+            end = pins.size();
+        }
+        names.push_back(pins.substr(begin, end - begin));
+        pos = end;
+    }
+    if (names.empty()) {
+        pin_list_ids_[pins] = 0;
+        return 0;
+    }
+    // The key is the set of pins, the written list keeps their order. It
+    // starts with a newline, which no pin list as given does.
+    std::vector<std::string> ordered;
+    for (auto &name : names) {
+        if (std::find(ordered.begin(), ordered.end(), name) == ordered.end()) {
+            ordered.push_back(name);
+        }
+    }
+    std::sort(names.begin(), names.end());
+    names.erase(std::unique(names.begin(), names.end()), names.end());
+    std::string key = "\n";
+    for (auto &name : names) {
+        key += " " + name;
+    }
+
+    auto key_it = pin_list_ids_.find(key);
+    int id;
+    if (key_it != pin_list_ids_.end()) {
+        id = key_it->second;
+    } else {
+        std::string list;
+        for (auto &name : ordered) {
+            list += (list.empty() ? "" : " ") + name;
+        }
+        if (ordered.size() > 1) {
+            list = "{" + list + "}";
+        }
+        id = pin_lists_.size();
+        pin_lists_.push_back(list);
+        pin_list_ids_[key] = id;
+    }
+    pin_list_ids_[pins] = id;
+    return id;
+}
+
+bool SdcWriter::AddFalsePath(const FalsePath &false_path)
+{
+    auto path = std::make_tuple(InternPins(false_path.from_pin), InternPins(false_path.through_pin), InternPins(false_path.to_pin));
+    if (!false_path_set_.insert(path).second) {
+        return false;
+    }
+    false_paths_.push_back(path);
+    return true;
+}
+
+bool SdcWriter::SetMaxDelay(const TimingPath &timing_path)
+{
+    auto path = std::make_pair(InternPins(timing_path.from_pin), InternPins(timing_path.to_pin));
+    auto it = max_delays_.find(path);
+    if (it != max_delays_.end()) {
+        it->second = timing_path.max_delay;
+        return false;
+    }
+    max_delays_[path] = timing_path.max_delay;
+    timing_paths_.push_back(path);
+    return true;
+}
 
 void SdcWriter::AddClockGroup(ClockGroups::ClockGroup clock_group, ClockGroups::ClockGroupRelation relation)
 {
@@ -33,13 +225,26 @@ void SdcWriter::AddClockGroup(ClockGroups::ClockGroup clock_group, ClockGroups::
 
 void SdcWriter::WriteSdc(RTLIL::Design *design, std::ostream &file, bool include_propagated)
 {
-    WriteClocks(design, file, include_propagated);
-    WriteFalsePaths(file);
-    WriteMaxDelay(file);
-    WriteClockGroups(file);
+    SdcOutputs outputs(file);
+    WriteSdc(design, outputs, include_propagated);
+}
+
+void SdcWriter::WriteSdcPerClockDomain(RTLIL::Design *design, std::ostream &file, const std::string &filename, bool include_propagated)
+{
+    SdcOutputs outputs(file);
+    outputs.SplitClockDomains(design, filename);
+    WriteSdc(design, outputs, include_propagated);
+}
+
+void SdcWriter::WriteSdc(RTLIL::Design *design, SdcOutputs &outputs, bool include_propagated)
+{
+    WriteClocks(design, outputs, include_propagated);
+    WriteFalsePaths(outputs);
+    WriteMaxDelay(outputs);
+    WriteClockGroups(outputs);
 }
 
-void SdcWriter::WriteClocks(RTLIL::Design *design, std::ostream &file, bool include_propagated)
+void SdcWriter::WriteClocks(RTLIL::Design *design, SdcOutputs &outputs, bool include_propagated)
 {
     for (auto &clock : Clocks::GetClocks(design)) {
         auto &clock_wire = clock.second;
@@ -51,61 +256,71 @@ void SdcWriter::WriteClocks(RTLIL::Design *design, std::ostream &file, bool incl
         if (Clock::IsPropagated(clock_wire) and !include_propagated) {
             continue;
         }
+        auto &file = outputs.ForClock(clock_wire);
         file << "create_clock -period " << Clock::Period(clock_wire);
         file << " -waveform {" << Clock::RisingEdge(clock_wire) << " " << Clock::FallingEdge(clock_wire) << "}";
         file << " " << Clock::SourceWireName(clock_wire);
-        file << std::endl;
+        file.EndLine();
     }
 }
 
-void SdcWriter::WriteFalsePaths(std::ostream &file)
+void SdcWriter::WriteFalsePaths(SdcOutputs &outputs)
 {
-    for (auto path : false_paths_) {
+    for (const auto &path : false_paths_) {
+        const std::string &from_pin = pin_lists_[std::get<0>(path)];
+        const std::string &through_pin = pin_lists_[std::get<1>(path)];
+        const std::string &to_pin = pin_lists_[std::get<2>(path)];
+        auto &file = outputs.ForPins({&from_pin, &through_pin, &to_pin});
         file << "set_false_path";
-        if (!path.from_pin.empty()) {
-            file << " -from " << path.from_pin;
+        if (!from_pin.empty()) {
+            file << " -from " << from_pin;
         }
-        if (!path.through_pin.empty()) {
-            file << " -through " << path.through_pin;
+        if (!through_pin.empty()) {
+            file << " -through " << through_pin;
         }
-        if (!path.to_pin.empty()) {
-            file << " -to " << path.to_pin;
+        if (!to_pin.empty()) {
+            file << " -to " << to_pin;
         }
-        file << std::endl;
+        file.EndLine();
     }
 }
 
-void SdcWriter::WriteMaxDelay(std::ostream &file)
+void SdcWriter::WriteMaxDelay(SdcOutputs &outputs)
 {
-    for (auto path : timing_paths_) {
-        file << "set_max_delay " << path.max_delay;
-        if (!path.from_pin.empty()) {
-            file << " -from " << path.from_pin;
+    for (const auto &path : timing_paths_) {
+        const std::string &from_pin = pin_lists_[path.first];
+        const std::string &to_pin = pin_lists_[path.second];
+        auto &file = outputs.ForPins({&from_pin, &to_pin});
+        file << "set_max_delay " << max_delays_.at(path);
+        if (!from_pin.empty()) {
+            file << " -from " << from_pin;
         }
-        if (!path.to_pin.empty()) {
-            file << " -to " << path.to_pin;
+        if (!to_pin.empty()) {
+            file << " -to " << to_pin;
         }
-        file << std::endl;
+        file.EndLine();
     }
 }
 
-void SdcWriter::WriteClockGroups(std::ostream &file)
+void SdcWriter::WriteClockGroups(SdcOutputs &outputs)
 {
+    // Clock groups relate several clocks so they always go to the main output
+    auto &file = outputs.Main();
     for (size_t relation = 0; relation <= ClockGroups::CLOCK_GROUP_RELATION_SIZE; relation++) {
-        auto clock_groups = clock_groups_.GetGroups(static_cast<ClockGroups::ClockGroupRelation>(relation));
+        auto &clock_groups = clock_groups_.GetGroups(static_cast<ClockGroups::ClockGroupRelation>(relation));
         if (clock_groups.size() == 0) {
             continue;
         }
         file << "create_clock_groups ";
-        for (auto group : clock_groups) {
+        for (const auto &group : clock_groups) {
             file << "-group ";
-            for (auto signal : group) {
+            for (const auto &signal : group) {
                 file << signal << " ";
             }
         }
         if (relation != ClockGroups::ClockGroupRelation::NONE) {
             file << "-" + ClockGroups::relation_name_map.at(static_cast<ClockGroups::ClockGroupRelation>(relation));
         }
-        file << std::endl;
+        file.EndLine();
     }
 }
@@ -18,7 +18,11 @@
 #ifndef _SDC_WRITER_H_
 #define _SDC_WRITER_H_
 #include "clocks.h"
+#include <fstream>
+#include <initializer_list>
 #include <map>
+#include <memory>
+#include <tuple>
 
 USING_YOSYS_NAMESPACE
 
@@ -34,18 +38,22 @@ struct TimingPath {
     float max_delay;
 };
 
+// Splits a Tcl list, e.g. the paths of a -batch argument
+std::vector<std::string> SplitTclList(const std::string &list);
+
 struct ClockGroups {
     enum ClockGroupRelation { NONE, ASYNCHRONOUS, PHYSICALLY_EXCLUSIVE, LOGICALLY_EXCLUSIVE, CLOCK_GROUP_RELATION_SIZE };
     using ClockGroup = std::vector<std::string>;
     static const std::map<ClockGroupRelation, std::string> relation_name_map;
 
     void Add(ClockGroup &group, ClockGroupRelation relation) { groups_[relation].push_back(group); }
-    std::vector<ClockGroup> GetGroups(ClockGroupRelation relation)
+    const std::vector<ClockGroup> &GetGroups(ClockGroupRelation relation)
     {
+        static const std::vector<ClockGroup> empty;
         if (groups_.count(relation)) {
             return groups_.at(relation);
         }
-        return std::vector<ClockGroup>();
+        return empty;
     }
     size_t size() { return groups_.size(); }
 
@@ -53,22 +61,95 @@ struct ClockGroups {
     std::map<ClockGroupRelation, std::vector<ClockGroup>> groups_;
 };
 
+// Collects formatted constraints and passes them to the output stream in
+// large blocks instead of one insertion per token. The buffer memory is
+// reused after each flush.
+class SdcOutputBuffer
+{
+  public:
+    explicit SdcOutputBuffer(std::ostream &file) : file_(file) { buffer_.reserve(flush_size); }
+    ~SdcOutputBuffer() { Flush(); }
+
+    SdcOutputBuffer &operator<<(const std::string &str)
+    {
+        buffer_.append(str);
+        return *this;
+    }
+    SdcOutputBuffer &operator<<(const char *str)
+    {
+        buffer_.append(str);
+        return *this;
+    }
+    // Floats are formatted the same way as std::ostream does by default
+    SdcOutputBuffer &operator<<(float value);
+    void EndLine();
+    void Flush();
+
+  private:
+    static const size_t flush_size = 1 << 20;
+    std::ostream &file_;
+    std::string buffer_;
+};
+
+// Routes the constraints to the main output or, when splitting is enabled,
+// to one output per clock domain. A constraint belongs to a clock domain if
+// all the clocks it refers to are in that domain.
+class SdcOutputs
+{
+  public:
+    explicit SdcOutputs(std::ostream &file) : main_(file) {}
+
+    void SplitClockDomains(RTLIL::Design *design, const std::string &filename);
+    SdcOutputBuffer &Main() { return main_; }
+    SdcOutputBuffer &ForClock(RTLIL::Wire *clock_wire);
+    SdcOutputBuffer &ForPins(std::initializer_list<const std::string *> pins);
+
+  private:
+    SdcOutputBuffer &ForDomain(const std::string &domain);
+
+    SdcOutputBuffer main_;
+    std::string filename_base_;
+    std::string filename_ext_;
+    // Clock and clock wire names to clock domain
+    dict<std::string, std::string> domains_;
+    std::map<std::string, std::unique_ptr<std::ofstream>> domain_files_;
+    std::map<std::string, std::unique_ptr<SdcOutputBuffer>> domain_buffers_;
+};
+
 class SdcWriter
 {
   public:
-    void AddFalsePath(FalsePath false_path);
-    void SetMaxDelay(TimingPath timing_path);
+    // Both return false when an equivalent path was added before, the
+    // delay of a repeated max delay path is updated to the new value
+    bool AddFalsePath(const FalsePath &false_path);
+    bool SetMaxDelay(const TimingPath &timing_path);
     void AddClockGroup(ClockGroups::ClockGroup clock_group, ClockGroups::ClockGroupRelation relation);
     void WriteSdc(RTLIL::Design *design, std::ostream &file, bool include_propagated);
+    // Write the constraints that refer to a single clock domain to separate
+    // files named after the main output file and the clock domain
+    void WriteSdcPerClockDomain(RTLIL::Design *design, std::ostream &file, const std::string &filename, bool include_propagated);
 
   private:
-    void WriteClocks(RTLIL::Design *design, std::ostream &file, bool include_propagated);
-    void WriteFalsePaths(std::ostream &file);
-    void WriteMaxDelay(std::ostream &file);
-    void WriteClockGroups(std::ostream &file);
+    void WriteSdc(RTLIL::Design *design, SdcOutputs &outputs, bool include_propagated);
+    void WriteClocks(RTLIL::Design *design, SdcOutputs &outputs, bool include_propagated);
+    void WriteFalsePaths(SdcOutputs &outputs);
+    void WriteMaxDelay(SdcOutputs &outputs);
+    void WriteClockGroups(SdcOutputs &outputs);
+
+    int InternPins(const std::string &pins);
 
-    std::vector<FalsePath> false_paths_;
-    std::vector<TimingPath> timing_paths_;
+    // Pin lists as written, in the order their pins were first seen and
+    // without duplicates. Lists with the same pins in any order share one
+    // id, the ids are looked up by the list as given and by its sorted
+    // pins. Id 0 is the empty list.
+    std::vector<std::string> pin_lists_{""};
+    dict<std::string, int> pin_list_ids_{{"", 0}};
+    // Paths as ids of their from, through and to pin lists, in the order
+    // they were first added
+    std::vector<std::tuple<int, int, int>> false_paths_;
+    pool<std::tuple<int, int, int>> false_path_set_;
+    std::vector<std::pair<int, int>> timing_paths_;
+    dict<std::pair<int, int>, float> max_delays_;
     ClockGroups clock_groups_;
 };
 
@@ -18,7 +18,6 @@
 #include "set_false_path.h"
 #include "kernel/log.h"
 #include "sdc_writer.h"
-#include <regex>
 
 USING_YOSYS_NAMESPACE
 
@@ -27,6 +26,7 @@ void SetFalsePath::help()
     //   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
     log("\n");
     log("   set_false_path [-quiet] [-from <net_name>] [-to <net_name>] \n");
+    log("   set_false_path -batch <paths>\n");
     log("\n");
     log("Set false path on the specified net\n");
     log("\n");
@@ -45,23 +45,20 @@ void SetFalsePath::help()
     log("    -through\n");
     log("        List of through points or clocks.\n");
     log("\n");
+    log("    -batch <paths>\n");
+    log("        Add many false paths in one call. <paths> is a Tcl list of the\n");
+    log("        arguments of single set_false_path commands, e.g.\n");
+    log("        set_false_path -batch {{-from clk -to out} {-through inter_wire}}\n");
+    log("\n");
+    log("Repeated paths, including ones whose pin lists only differ in order or\n");
+    log("duplicated pins, are written once.\n");
+    log("\n");
 }
 
-void SetFalsePath::execute(std::vector<std::string> args, RTLIL::Design *design)
+FalsePath SetFalsePath::ParsePath(const std::vector<std::string> &args, size_t argidx, bool &is_quiet)
 {
-    RTLIL::Module *top_module = design->top_module();
-    if (top_module == nullptr) {
-        log_cmd_error("No top module detected\n");
-    }
-
-    size_t argidx;
-    bool is_quiet = false;
-    std::string from_pin;
-    std::string to_pin;
-    std::string through_pin;
-
-    // Parse command arguments
-    for (argidx = 1; argidx < args.size(); argidx++) {
+    FalsePath path;
+    for (; argidx < args.size(); argidx++) {
         std::string arg = args[argidx];
         if (arg == "-quiet") {
             is_quiet = true;
@@ -69,17 +66,17 @@ void SetFalsePath::execute(std::vector<std::string> args, RTLIL::Design *design)
         }
 
         if (arg == "-from" and argidx + 1 < args.size()) {
-            from_pin = args[++argidx];
+            path.from_pin = args[++argidx];
             continue;
         }
 
         if (arg == "-to" and argidx + 1 < args.size()) {
-            to_pin = args[++argidx];
+            path.to_pin = args[++argidx];
             continue;
         }
 
         if (arg == "-through" and argidx + 1 < args.size()) {
-            through_pin = args[++argidx];
+            path.through_pin = args[++argidx];
             continue;
         }
 
@@ -89,11 +86,40 @@ void SetFalsePath::execute(std::vector<std::string> args, RTLIL::Design *design)
 
         break;
     }
+    return path;
+}
+
+void SetFalsePath::AddPath(const FalsePath &path, bool is_quiet)
+{
+    bool added = sdc_writer_.AddFalsePath(path);
     if (!is_quiet) {
-        std::string msg = (from_pin.empty()) ? "" : "-from " + from_pin;
-        msg += (through_pin.empty()) ? "" : " -through " + through_pin;
-        msg += (to_pin.empty()) ? "" : " -to " + to_pin;
-        log("Adding false path %s\n", msg.c_str());
+        std::string msg = (path.from_pin.empty()) ? "" : "-from " + path.from_pin;
+        msg += (path.through_pin.empty()) ? "" : " -through " + path.through_pin;
+        msg += (path.to_pin.empty()) ? "" : " -to " + path.to_pin;
+        log("%s false path %s\n", added ? "Adding" : "Skipping duplicate", msg.c_str());
     }
-    sdc_writer_.AddFalsePath(FalsePath{.from_pin = from_pin, .to_pin = to_pin, .through_pin = through_pin});
+}
+
+void SetFalsePath::execute(std::vector<std::string> args, RTLIL::Design *design)
+{
+    RTLIL::Module *top_module = design->top_module();
+    if (top_module == nullptr) {
+        log_cmd_error("No top module detected\n");
+    }
+
+    bool is_quiet = false;
+    if (args.size() > 1 and args[1] == "-batch") {
+        if (args.size() != 3) {
+            log_cmd_error("Usage: set_false_path -batch <paths>\n");
+        }
+        for (auto &path : SplitTclList(args[2])) {
+            bool is_path_quiet = false;
+            AddPath(ParsePath(SplitTclList(path), 0, is_path_quiet), is_path_quiet);
+        }
+        return;
+    }
+
+    // Parse command arguments
+    FalsePath path = ParsePath(args, 1, is_quiet);
+    AddPath(path, is_quiet);
 }
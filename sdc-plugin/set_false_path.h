@@ -31,6 +31,11 @@ struct SetFalsePath : public Pass {
 
     void execute(std::vector<std::string> args, RTLIL::Design *design) override;
 
+  private:
+    // Parses the path options starting at argidx
+    FalsePath ParsePath(const std::vector<std::string> &args, size_t argidx, bool &is_quiet);
+    void AddPath(const FalsePath &path, bool is_quiet);
+
     SdcWriter &sdc_writer_;
 };
 
@@ -26,6 +26,7 @@ void SetMaxDelay::help()
     //   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
     log("\n");
     log("   set_max_delay [-quiet] [-from <arg>] [-to <arg>] \n");
+    log("   set_max_delay -batch <paths>\n");
     log("\n");
     log("Specify maximum delay for timing paths\n");
     log("\n");
@@ -41,23 +42,20 @@ void SetMaxDelay::help()
     log("    -to\n");
     log("        List of end points or clocks.\n");
     log("\n");
+    log("    -batch <paths>\n");
+    log("        Set the delay of many paths in one call. <paths> is a Tcl list of\n");
+    log("        the arguments of single set_max_delay commands, e.g.\n");
+    log("        set_max_delay -batch {{1 -to inter_wire} {3 -from clk -to out}}\n");
+    log("\n");
+    log("A path that was given before, also with its pins in a different order,\n");
+    log("is written once with the delay that was set last.\n");
+    log("\n");
 }
 
-void SetMaxDelay::execute(std::vector<std::string> args, RTLIL::Design *design)
+TimingPath SetMaxDelay::ParsePath(const std::vector<std::string> &args, size_t argidx, bool &is_quiet)
 {
-    RTLIL::Module *top_module = design->top_module();
-    if (top_module == nullptr) {
-        log_cmd_error("No top module detected\n");
-    }
-
-    size_t argidx;
-    bool is_quiet = false;
-    std::string from_pin;
-    std::string to_pin;
-    float max_delay(0.0);
-
-    // Parse command arguments
-    for (argidx = 1; argidx < args.size(); argidx++) {
+    TimingPath path{.from_pin = "", .to_pin = "", .max_delay = 0.0};
+    for (; argidx < args.size(); argidx++) {
         std::string arg = args[argidx];
         if (arg == "-quiet") {
             is_quiet = true;
@@ -65,14 +63,14 @@ void SetMaxDelay::execute(std::vector<std::string> args, RTLIL::Design *design)
         }
 
         if (arg == "-from" and argidx + 1 < args.size()) {
-            from_pin = args[++argidx];
-            log("From: %s\n", from_pin.c_str());
+            path.from_pin = args[++argidx];
+            log("From: %s\n", path.from_pin.c_str());
             continue;
         }
 
         if (arg == "-to" and argidx + 1 < args.size()) {
-            to_pin = args[++argidx];
-            log("To: %s\n", to_pin.c_str());
+            path.to_pin = args[++argidx];
+            log("To: %s\n", path.to_pin.c_str());
             continue;
         }
 
@@ -80,13 +78,41 @@ void SetMaxDelay::execute(std::vector<std::string> args, RTLIL::Design *design)
             log_cmd_error("Unknown option %s.\n", arg.c_str());
         }
 
-        max_delay = std::stof(args[argidx]);
+        path.max_delay = std::stof(args[argidx]);
     }
+    return path;
+}
 
+void SetMaxDelay::AddPath(const TimingPath &path, bool is_quiet)
+{
+    bool added = sdc_writer_.SetMaxDelay(path);
     if (!is_quiet) {
-        std::string msg = (from_pin.empty()) ? "" : "-from " + from_pin;
-        msg += (to_pin.empty()) ? "" : " -to " + to_pin;
-        log("Adding max path delay of %f on path %s\n", max_delay, msg.c_str());
+        std::string msg = (path.from_pin.empty()) ? "" : "-from " + path.from_pin;
+        msg += (path.to_pin.empty()) ? "" : " -to " + path.to_pin;
+        log("%s max path delay of %f on path %s\n", added ? "Adding" : "Updating", path.max_delay, msg.c_str());
+    }
+}
+
+void SetMaxDelay::execute(std::vector<std::string> args, RTLIL::Design *design)
+{
+    RTLIL::Module *top_module = design->top_module();
+    if (top_module == nullptr) {
+        log_cmd_error("No top module detected\n");
     }
-    sdc_writer_.SetMaxDelay(TimingPath{.from_pin = from_pin, .to_pin = to_pin, .max_delay = max_delay});
+
+    bool is_quiet = false;
+    if (args.size() > 1 and args[1] == "-batch") {
+        if (args.size() != 3) {
+            log_cmd_error("Usage: set_max_delay -batch <paths>\n");
+        }
+        for (auto &path : SplitTclList(args[2])) {
+            bool is_path_quiet = false;
+            AddPath(ParsePath(SplitTclList(path), 0, is_path_quiet), is_path_quiet);
+        }
+        return;
+    }
+
+    // Parse command arguments
+    TimingPath path = ParsePath(args, 1, is_quiet);
+    AddPath(path, is_quiet);
 }
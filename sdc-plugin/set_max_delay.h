@@ -31,6 +31,11 @@ struct SetMaxDelay : public Pass {
 
     void execute(std::vector<std::string> args, RTLIL::Design *design) override;
 
+  private:
+    // Parses the delay and path options starting at argidx
+    TimingPath ParsePath(const std::vector<std::string> &args, size_t argidx, bool &is_quiet);
+    void AddPath(const TimingPath &path, bool is_quiet);
+
     SdcWriter &sdc_writer_;
 };
 
@@ -0,0 +1,15 @@
+yosys -import
+if { [info procs read_sdc] == {} } { plugin -i sdc }
+yosys -import  ;# ingest plugin commands
+
+read_verilog $::env(DESIGN_TOP).v
+synth -flatten -noabc -top top
+read_sdc $::env(DESIGN_TOP).input.sdc
+
+# map the logic of the clk1 and clk2 counters with their own delay targets
+abc9_clock_domains -lut 4
+
+# no gates are left and the partition modules are gone
+select -assert-none t:\$_*_ t:\$_DFF_* %d
+select -assert-min 2 t:\$lut
+select -assert-none top_abc9_*
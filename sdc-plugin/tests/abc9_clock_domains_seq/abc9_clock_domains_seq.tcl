@@ -0,0 +1,21 @@
+yosys -import
+if { [info procs read_sdc] == {} } { plugin -i sdc }
+yosys -import  ;# ingest plugin commands
+
+read_verilog $::env(DESIGN_TOP).v
+hierarchy -top top
+proc
+memory -nomap
+opt_clean
+# keep the memory as a $mem_v2 cell
+techmap t:\$mem_v2 %n
+opt_clean
+read_sdc $::env(DESIGN_TOP).input.sdc
+
+abc9_clock_domains -lut 4
+
+# the memory and the flip-flop on the unconstrained clk3 are not moved to a
+# partition module, flattening would have prefixed their names
+select -assert-count 1 t:\$mem_v2
+select -assert-min 5 t:\$_DFF_*
+select -assert-none t:\$mem_v2 t:\$_DFF_* %u n:*abc9_* %i
@@ -0,0 +1,45 @@
+// Copyright 2020-2022 F4PGA Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+module top (
+    input clk1,
+    clk3,
+    input [3:0] addr,
+    input [7:0] din,
+    input we,
+    output [7:0] dout,
+    output q3
+);
+
+  reg [7:0] mem[0:15];
+  reg [7:0] dout_r;
+  reg [3:0] counter1 = 0;
+  reg q3_r = 0;
+
+  always @(posedge clk1) begin
+    counter1 <= counter1 + 1;
+    if (we) mem[addr^counter1] <= din;
+    dout_r <= mem[addr];
+  end
+
+  // clk3 is not constrained
+  always @(posedge clk3) q3_r <= ^counter1;
+
+  assign dout = dout_r;
+  assign q3   = q3_r;
+
+endmodule
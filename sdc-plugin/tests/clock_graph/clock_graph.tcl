@@ -0,0 +1,27 @@
+yosys -import
+if { [info procs read_sdc] == {} } { plugin -i sdc }
+yosys -import  ;# ingest plugin commands
+
+read_verilog $::env(DESIGN_TOP).v
+read_verilog -specify -lib -D_EXPLICIT_CARRY +/xilinx/cells_sim.v
+read_verilog -lib +/xilinx/cells_xtra.v
+hierarchy -check -auto-top
+
+# Start flow after library reading
+synth_xilinx -flatten -abc9 -nosrl -nodsp -iopad -noclkbuf -run prepare:check
+
+# Read the design timing constraints
+read_sdc $::env(DESIGN_TOP).input.sdc
+
+# Propagate the clocks
+propagate_clocks
+
+# Query the clock graph
+set fh [open [test_output_path "clock_graph.txt"] w]
+puts $fh [get_clock_fanout clk_bufg_0]
+puts $fh [get_clock_fanout clk]
+puts $fh [get_clock_fanout -transitive clk]
+close $fh
+
+# Write out the clock graph
+write_clock_graph [test_output_path "clock_graph.json"]
@@ -0,0 +1,20 @@
+yosys -import
+if { [info procs read_sdc] == {} } { plugin -i sdc }
+yosys -import  ;# ingest plugin commands
+
+read_verilog $::env(DESIGN_TOP).v
+
+# Redefining a clock rewrites its attributes
+create_clock -period 10 clk1
+create_clock -period 20 -waveform {0 5} clk1
+select -assert-count 1 w:clk1 a:PERIOD=20.000000 %i
+select -assert-count 1 w:clk1 "a:WAVEFORM=0.000000 5.000000" %i
+
+# So does the propagation adding the same clocks again
+create_clock -period 30 clk2
+propagate_clocks
+create_clock -period 40 clk2
+propagate_clocks
+select -assert-count 1 w:clk2 a:PERIOD=40.000000 %i
+
+write_json [test_output_path $::env(DESIGN_TOP).json]
@@ -0,0 +1,41 @@
+/*
+ * Copyright 2020-2022 F4PGA Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ */
+#include <clocks.h>
+
+#include <benchmark/benchmark.h>
+
+// Typical wire name of a clock buffer output, nothing to escape
+static void BM_AddEscapingPlain(benchmark::State &state)
+{
+    std::string name("main_clkout0_bufg_o");
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(Clock::AddEscaping(name));
+    }
+}
+BENCHMARK(BM_AddEscapingPlain);
+
+// Auto-generated name with several dollar signs
+static void BM_AddEscapingAuto(benchmark::State &state)
+{
+    std::string name("$auto$clkbufmap.cc:247:execute$1234");
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(Clock::AddEscaping(name));
+    }
+}
+BENCHMARK(BM_AddEscapingAuto);
@@ -0,0 +1,79 @@
+// Copyright 2020-2022 F4PGA Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+module top (
+    input clk,
+    input cpu_reset,
+    input data_in,
+    output [2:0] data_out
+);
+
+  wire [2:0] data_out;
+  wire builder_mmcm_fb;
+  wire main_locked;
+
+  MMCME2_ADV #(
+      .CLKFBOUT_MULT_F(10.0),
+      .CLKIN1_PERIOD(10.0),
+      .CLKOUT0_DIVIDE_F(5.0),
+      .CLKOUT0_PHASE(0.0),
+      .CLKOUT1_DIVIDE(5'd20),
+      .CLKOUT1_PHASE(90.0),
+      .DIVCLK_DIVIDE(1'd1),
+      .STARTUP_WAIT("FALSE")
+  ) MMCME2_ADV (
+      .CLKFBIN(builder_mmcm_fb),
+      .CLKIN1(clk),
+      .RST(cpu_reset),
+      .CLKFBOUT(builder_mmcm_fb),
+      .CLKOUT0(mmcm_clkout0),
+      .CLKOUT1(mmcm_clkout1),
+      .LOCKED(main_locked)
+  );
+
+  BUFR #(
+      .BUFR_DIVIDE("4")
+  ) BUFR (
+      .I  (clk),
+      .CE (1'b1),
+      .CLR(1'b0),
+      .O  (bufr_out)
+  );
+
+  FDCE FDCE_MMCMx2 (
+      .D  (data_in),
+      .C  (mmcm_clkout0),
+      .CE (1'b1),
+      .CLR(1'b0),
+      .Q  (data_out[0])
+  );
+
+  FDCE FDCE_MMCMdiv2_PH90 (
+      .D  (data_in),
+      .C  (mmcm_clkout1),
+      .CE (1'b1),
+      .CLR(1'b0),
+      .Q  (data_out[1])
+  );
+
+  FDCE FDCE_BUFRdiv4 (
+      .D  (data_in),
+      .C  (bufr_out),
+      .CE (1'b1),
+      .CLR(1'b0),
+      .Q  (data_out[2])
+  );
+endmodule
@@ -0,0 +1,27 @@
+yosys -import
+if { [info procs read_sdc] == {} } { plugin -i sdc }
+yosys -import  ;# ingest plugin commands
+
+read_verilog $::env(DESIGN_TOP).v
+# Some of F4PGA expects eblifs with only one module.
+synth_xilinx -flatten -abc9 -nosrl -noclkbuf -nodsp
+
+set_false_path -from clk -to bottom_inst.I
+
+# repeated path is written once
+set_false_path -from clk -to bottom_inst.I
+
+# pin lists with duplicates or with the same pins in another order are
+# equivalent, the list is written as first seen
+set_false_path -batch {{-from {clk clk} -to bottom_inst.I} {-from {clk bottom_inst.I} -to inter_wire} {-from {bottom_inst.I clk} -to inter_wire}}
+
+set_max_delay 1 -to inter_wire
+set_max_delay 3 -from clk -to bottom_inst.I
+
+# repeated path keeps its place and takes the delay set last
+set_max_delay 4 -from clk -to bottom_inst.I
+
+# batch of paths
+set_max_delay -batch {{2 -to {inter_wire inter_wire}} {5 -from {clk bottom_inst.I}}}
+
+write_sdc [test_output_path "path_dedup.sdc"]
@@ -0,0 +1,27 @@
+yosys -import
+if { [info procs read_sdc] == {} } { plugin -i sdc }
+yosys -import  ;# ingest plugin commands
+
+read_verilog $::env(DESIGN_TOP).v
+read_verilog -specify -lib -D_EXPLICIT_CARRY +/xilinx/cells_sim.v
+read_verilog -lib +/xilinx/cells_xtra.v
+hierarchy -check -auto-top
+
+# Start flow after library reading
+synth_xilinx -flatten -abc9 -nosrl -nodsp -iopad -noclkbuf -run prepare:check
+
+# Read the design timing constraints
+read_sdc $::env(DESIGN_TOP).input.sdc
+
+# Thread counts that are not plain numbers are rejected
+foreach threads {-1 four 4x {}} {
+    if { ![catch {propagate_clocks -threads $threads}] } {
+        error "propagate_clocks accepted -threads '$threads'"
+    }
+}
+
+# Propagate the clocks, walking the buffer trees on several threads
+propagate_clocks -threads 4
+
+# Write out the SDC file after the clock propagation step
+write_sdc -include_propagated_clocks [test_output_path "propagate_threads.sdc"]
@@ -0,0 +1,56 @@
+// Copyright 2020-2022 F4PGA Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+module top (
+    input clk,
+    input data_in,
+    output [1:0] data_out
+);
+
+  wire clk_ibuf;
+  IBUF ibuf_clk (
+      .I(clk),
+      .O(clk_ibuf)
+  );
+
+  wire clk_bufg_0;
+  BUFG bufg_clk_0 (
+      .I(clk_ibuf),
+      .O(clk_bufg_0)
+  );
+
+  wire clk_bufg_1;
+  BUFG bufg_clk_1 (
+      .I(clk_ibuf),
+      .O(clk_bufg_1)
+  );
+
+  FDCE FDCE_0 (
+      .D  (data_in),
+      .C  (clk_bufg_0),
+      .CE (1'b1),
+      .CLR(1'b0),
+      .Q  (data_out[0])
+  );
+
+  FDCE FDCE_1 (
+      .D  (data_in),
+      .C  (clk_bufg_1),
+      .CE (1'b1),
+      .CLR(1'b0),
+      .Q  (data_out[1])
+  );
+endmodule
@@ -0,0 +1,14 @@
+yosys -import
+if { [info procs read_sdc] == {} } { plugin -i sdc }
+yosys -import  ;# ingest plugin commands
+
+read_verilog $::env(DESIGN_TOP).v
+hierarchy -top top
+
+# After a cd the clock names are looked up in the active module only
+yosys cd sub
+read_sdc $::env(DESIGN_TOP).input.sdc
+yosys cd
+
+select -assert-count 1 a:CLOCK_SIGNAL
+select -assert-count 1 sub/a:CLOCK_SIGNAL
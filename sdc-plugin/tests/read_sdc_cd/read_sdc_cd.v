@@ -0,0 +1,39 @@
+// Copyright 2020-2022 F4PGA Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+module sub (
+    input  wire clk,
+    input  wire d,
+    output reg  q
+);
+
+  always @(posedge clk) q <= d;
+
+endmodule
+
+module top (
+    input  wire clk,
+    input  wire d,
+    output wire q
+);
+
+  sub sub_inst (
+      .clk(clk),
+      .d(d),
+      .q(q)
+  );
+
+endmodule
@@ -0,0 +1,21 @@
+yosys -import
+if { [info procs read_sdc] == {} } { plugin -i sdc }
+yosys -import  ;# ingest plugin commands
+
+read_verilog $::env(DESIGN_TOP).v
+read_verilog -specify -lib -D_EXPLICIT_CARRY +/xilinx/cells_sim.v
+read_verilog -lib +/xilinx/cells_xtra.v
+hierarchy -check -auto-top
+synth_xilinx -flatten -abc9 -nosrl -noclkbuf -nodsp -run prepare:check
+
+create_clock -period 10 clk1_ibuf
+create_clock -period 4 clk2_ibuf
+
+# Single clock domain constraints
+set_false_path -from clk1_ibuf -to q1
+set_max_delay 3 -from clk2_ibuf
+
+# Constraint spanning both clock domains
+set_false_path -from clk1_ibuf -to clk2_ibuf
+
+write_sdc -split_clock_domains [test_output_path "split_clock_domains.sdc"]
@@ -0,0 +1,52 @@
+// Copyright 2020-2022 F4PGA Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+module top (
+    input clk1,
+    input clk2,
+    input data_in,
+    output q1,
+    output q2
+);
+
+  wire clk1_ibuf;
+  IBUF ibuf_clk1 (
+      .I(clk1),
+      .O(clk1_ibuf)
+  );
+
+  wire clk2_ibuf;
+  IBUF ibuf_clk2 (
+      .I(clk2),
+      .O(clk2_ibuf)
+  );
+
+  FDCE FDCE_1 (
+      .D  (data_in),
+      .C  (clk1_ibuf),
+      .CE (1'b1),
+      .CLR(1'b0),
+      .Q  (q1)
+  );
+
+  FDCE FDCE_2 (
+      .D  (q1),
+      .C  (clk2_ibuf),
+      .CE (1'b1),
+      .CLR(1'b0),
+      .Q  (q2)
+  );
+endmodule
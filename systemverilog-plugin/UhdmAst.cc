@@ -6,6 +6,8 @@
 #include <limits>
 #include <regex>
 #include <string>
+#include <string_view>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -59,6 +61,7 @@ static IdString is_simplified_wire;
 static IdString low_high_bound;
 static IdString is_type_parameter;
 static IdString is_elaborated_module;
+static IdString stream_op_slice_size;
 }; // namespace attr_id
 
 // TODO(mglb): use attr_id::* directly everywhere and remove those methods.
@@ -93,6 +96,7 @@ void attr_id_init()
     attr_id::low_high_bound = MAKE_INTERNAL_ID(low_high_bound);
     attr_id::is_type_parameter = MAKE_INTERNAL_ID(is_type_parameter);
     attr_id::is_elaborated_module = MAKE_INTERNAL_ID(is_elaborated_module);
+    attr_id::stream_op_slice_size = MAKE_INTERNAL_ID(stream_op_slice_size);
 }
 
 void attr_id_cleanup()
@@ -107,6 +111,7 @@ void attr_id_cleanup()
     attr_id::partial = IdString();
     attr_id::is_type_parameter = IdString();
     attr_id::is_elaborated_module = IdString();
+    attr_id::stream_op_slice_size = IdString();
     attr_id::already_initialized = false;
 }
 
@@ -149,7 +154,8 @@ static void delete_internal_attributes(AST::AstNode *node)
         return;
 
     for (auto &attr : {UhdmAst::partial(), UhdmAst::packed_ranges(), UhdmAst::unpacked_ranges(), UhdmAst::force_convert(), UhdmAst::is_imported(),
-                       UhdmAst::is_simplified_wire(), UhdmAst::low_high_bound(), attr_id::is_type_parameter, attr_id::is_elaborated_module}) {
+                       UhdmAst::is_simplified_wire(), UhdmAst::low_high_bound(), attr_id::is_type_parameter, attr_id::is_elaborated_module,
+                       attr_id::stream_op_slice_size}) {
         delete_attribute(node, attr);
     }
 }
@@ -174,9 +180,10 @@ static void sanitize_symbol_name(std::string &name)
 {
     if (!name.empty()) {
         auto pos = name.find_last_of('@');
-        name = name.substr(pos + 1);
+        // pos + 1 is 0 if there is no '@' in the name
+        name.erase(0, pos + 1);
         // symbol names must begin with '\'
-        name.insert(0, "\\");
+        name.insert(0, 1, '\\');
     }
 }
 
@@ -575,10 +582,44 @@ static void add_force_convert_attribute(AST::AstNode *wire_node, uint32_t val =
     }
 }
 
-static void check_memories(AST::AstNode *node, std::string scope, std::map<std::string, AST::AstNode *> &memories)
+// Memories of the whole design, found by a single pass of `check_memories`.
+// Scopes (modules, packages and generate blocks) are numbered and memories are keyed by
+// the scope number and their name, so no scope strings are built during the pass.
+struct MemoryScopes {
+    struct KeyHash {
+        size_t operator()(const std::pair<int, std::string_view> &key) const
+        {
+            return std::hash<std::string_view>()(key.second) * 31 + std::hash<int>()(key.first);
+        }
+    };
+
+    // Parent of each scope, -1 for the scope of a top level node
+    std::vector<int> parents;
+    // Names point to the `str` of the AST_WIRE nodes, which are not renamed during the pass
+    std::unordered_map<std::pair<int, std::string_view>, AST::AstNode *, KeyHash> memories;
+
+    int add_scope(int parent)
+    {
+        parents.push_back(parent);
+        return parents.size() - 1;
+    }
+};
+
+static void check_memories(AST::AstNode *node, int scope, MemoryScopes &scopes)
 {
-    for (auto *child : node->children) {
-        check_memories(child, node->type == AST::AST_GENBLOCK ? scope + "." + node->str : scope, memories);
+    if (node->type == AST::AST_GENBLOCK) {
+        // Every generate block node gets a scope of its own. Scopes used to be
+        // named "<parent>.<block name>", so blocks with the same name in one
+        // parent, e.g. unnamed blocks or branches of a generate if sharing a
+        // label, shared their memories. They no longer do.
+        const int genblock_scope = scopes.add_scope(scope);
+        for (auto *child : node->children) {
+            check_memories(child, genblock_scope, scopes);
+        }
+    } else {
+        for (auto *child : node->children) {
+            check_memories(child, scope, scopes);
+        }
     }
 
     if (node->str == "\\$readmemh") {
@@ -587,9 +628,8 @@ static void check_memories(AST::AstNode *node, std::string scope, std::map<std::
         }
         // TODO: Look for the memory in all other scope levels, like we do in case of AST::AST_IDENTIFIER,
         // as here the memory can also be defined before before the current scope.
-        std::string name = scope + "." + node->children[1]->str;
-        const auto iter = memories.find(name);
-        if (iter != memories.end()) {
+        const auto iter = scopes.memories.find({scope, node->children[1]->str});
+        if (iter != scopes.memories.end()) {
             add_force_convert_attribute(iter->second, 0);
         }
     }
@@ -601,65 +641,55 @@ static void check_memories(AST::AstNode *node, std::string scope, std::map<std::
           node->attributes.count(UhdmAst::unpacked_ranges()) ? node->attributes[UhdmAst::unpacked_ranges()]->children.size() : 0;
 
         if (packed_ranges_count == 1 && unpacked_ranges_count == 1) {
-            std::string name = scope + "." + node->str;
-            auto [iter, did_insert] = memories.insert_or_assign(std::move(name), node);
+            auto [iter, did_insert] = scopes.memories.insert_or_assign({scope, node->str}, node);
             log_assert(did_insert);
         }
         return;
     }
 
     if (node->type == AST::AST_IDENTIFIER) {
-        std::string full_id = scope;
-        std::size_t scope_end_pos = scope.size();
-
-        for (;;) {
-            full_id += "." + node->str;
-            const auto iter = memories.find(full_id);
-            if (iter != memories.end()) {
-                // Memory node found!
-                if (!iter->second->attributes.count(UhdmAst::force_convert())) {
-                    const bool is_full_memory_access = (node->children.size() == 0);
-                    const bool is_slice_memory_access = (node->children.size() == 1 && node->children[0]->children.size() != 1);
-                    // convert memory to list of registers
-                    // in case of access to whole memory
-                    // or slice of memory
-                    // e.g.
-                    // logic [3:0] mem [8:0];
-                    // always_ff @ (posedge clk) begin
-                    //   mem <= '{default:0};
-                    //   mem[7:1] <= mem[6:0];
-                    // end
-                    // don't convert in case of accessing
-                    // memory using address, e.g.
-                    // mem[0] <= '{default:0}
-                    if (is_full_memory_access || is_slice_memory_access) {
-                        add_force_convert_attribute(iter->second);
-                    }
-                }
-                break;
-            } else {
-                if (scope_end_pos == 0) {
-                    // We reached the top scope and the memory node wasn't found.
-                    break;
-                } else {
-                    // Memory node wasn't found.
-                    // Erase node name and last segment of the scope to check the previous scope.
-                    // FIXME: This doesn't work with escaped identifiers containing a dot.
-                    scope_end_pos = full_id.find_last_of('.', scope_end_pos - 1);
-                    if (scope_end_pos == std::string::npos) {
-                        scope_end_pos = 0;
-                    }
-                    full_id.erase(scope_end_pos);
+        // Look for the memory in the current scope and then in the enclosing ones
+        for (int id_scope = scope; id_scope >= 0; id_scope = scopes.parents[id_scope]) {
+            const auto iter = scopes.memories.find({id_scope, node->str});
+            if (iter == scopes.memories.end())
+                continue;
+            // Memory node found!
+            if (!iter->second->attributes.count(UhdmAst::force_convert())) {
+                const bool is_full_memory_access = (node->children.size() == 0);
+                const bool is_slice_memory_access = (node->children.size() == 1 && node->children[0]->children.size() != 1);
+                // convert memory to list of registers
+                // in case of access to whole memory
+                // or slice of memory
+                // e.g.
+                // logic [3:0] mem [8:0];
+                // always_ff @ (posedge clk) begin
+                //   mem <= '{default:0};
+                //   mem[7:1] <= mem[6:0];
+                // end
+                // don't convert in case of accessing
+                // memory using address, e.g.
+                // mem[0] <= '{default:0}
+                if (is_full_memory_access || is_slice_memory_access) {
+                    add_force_convert_attribute(iter->second);
                 }
             }
+            break;
         }
     }
 }
 
-static void check_memories(AST::AstNode *node)
+// Marks the memories to be converted to registers in all packages and elaborated modules with a single walk
+static void check_memories(const std::unordered_map<std::string, AST::AstNode *> &top_nodes)
 {
-    std::map<std::string, AST::AstNode *> memories;
-    check_memories(node, "", memories);
+    MemoryScopes scopes;
+    for (const auto &pair : top_nodes) {
+        if (!pair.second)
+            continue;
+        if (pair.second->type == AST::AST_PACKAGE || !pair.second->get_bool_attribute(UhdmAst::partial())) {
+            // Each top level node starts a new scope tree
+            check_memories(pair.second, scopes.add_scope(-1), scopes);
+        }
+    }
 }
 
 static void warn_start_range(const std::vector<AST::AstNode *> ranges)
@@ -801,12 +831,14 @@ void UhdmAst::uhdmast_assert_log(const char *expr_str, const char *func, const c
 static AST::AstNode *expand_dot(const AST::AstNode *current_struct, const AST::AstNode *search_node)
 {
     AST::AstNode *current_struct_elem = nullptr;
-    auto search_str = search_node->str.find("\\") == 0 ? search_node->str.substr(1) : search_node->str;
-    auto struct_elem_it =
-      std::find_if(current_struct->children.begin(), current_struct->children.end(), [&](AST::AstNode *node) { return node->str == search_str; });
+    // Member names are stored without the leading backslash
+    const std::string &search_str = search_node->str;
+    const size_t search_start = (!search_str.empty() && search_str[0] == '\\') ? 1 : 0;
+    auto struct_elem_it = std::find_if(current_struct->children.begin(), current_struct->children.end(),
+                                       [&](AST::AstNode *node) { return node->str.compare(0, std::string::npos, search_str, search_start) == 0; });
     if (struct_elem_it == current_struct->children.end()) {
         current_struct->dumpAst(NULL, "struct >");
-        log_error("Couldn't find search elem: %s in struct\n", search_str.c_str());
+        log_error("Couldn't find search elem: %s in struct\n", search_str.c_str() + search_start);
     }
     current_struct_elem = *struct_elem_it;
 
@@ -1004,7 +1036,7 @@ static AST::AstNode *convert_dot(AST::AstNode *wire_node, AST::AstNode *node, AS
     return expanded;
 }
 
-static void setup_current_scope(std::unordered_map<std::string, AST::AstNode *> top_nodes, AST::AstNode *current_top_node)
+static void setup_current_scope(const std::unordered_map<std::string, AST::AstNode *> &top_nodes, AST::AstNode *current_top_node)
 {
     for (auto it = top_nodes.begin(); it != top_nodes.end(); it++) {
         if (!it->second)
@@ -1182,17 +1214,20 @@ static int simplify_struct(AST::AstNode *snode, int base_offset, AST::AstNode *p
     return (is_union ? packed_width : offset);
 }
 
-static void add_members_to_scope_local(AST::AstNode *snode, std::string name)
+static void add_members_to_scope_local(AST::AstNode *snode, const std::string &name)
 {
     // add all the members in a struct or union to local scope
     // in case later referenced in assignments
     log_assert(snode->type == AST::AST_STRUCT || snode->type == AST::AST_UNION);
+    std::string member_name = name + ".";
+    const size_t prefix_size = member_name.size();
     for (auto *node : snode->children) {
-        auto member_name = name + "." + node->str;
+        member_name.resize(prefix_size);
+        member_name += node->str;
         AST_INTERNAL::current_scope[member_name] = node;
         if (node->type != AST::AST_STRUCT_ITEM) {
             // embedded struct or union
-            add_members_to_scope_local(node, name + "." + node->str);
+            add_members_to_scope_local(node, member_name);
         }
     }
 }
@@ -1250,6 +1285,83 @@ static void simplify_format_string(AST::AstNode *current_node)
     current_node->children[0] = AST::AstNode::mkconst_str(preformatted_string);
 }
 
+// Returns true if every identifier used in the expression is known in the current scope.
+static bool identifiers_in_scope(const AST::AstNode *node)
+{
+    if (node->type == AST::AST_IDENTIFIER && !AST_INTERNAL::current_scope.count(node->str)) {
+        return false;
+    }
+    return std::all_of(node->children.begin(), node->children.end(), identifiers_in_scope);
+}
+
+// Replaces the slice copying loop created by process_stream_op() with a single assignment of a concatenation of `src` slices to `dst`,
+// so that the number of nodes created for a stream operator scales with the number of slices and no loop needs to be unrolled.
+// The loop is kept when the width of the stream can't be evaluated yet, or when it isn't a multiple of the slice size.
+static void simplify_stream_op_loop(AST::AstNode *loop_node)
+{
+    const AST::AstNode *const slice_size_node = get_attribute(loop_node, attr_id::stream_op_slice_size);
+    log_assert(slice_size_node->type == AST::AST_CONSTANT);
+    const int slice_size = slice_size_node->integer;
+
+    // Loop layout, see process_stream_op(): init, condition (counter < width), iteration, body block with the slice assignment.
+    log_assert(loop_node->children.size() == 4);
+    const AST::AstNode *const width_ident = loop_node->children[1]->children[1];
+    const AST::AstNode *const slice_assign = loop_node->children[3]->children[0];
+    const std::string &dst_name = slice_assign->children[0]->str;
+    const std::string &src_name = slice_assign->children[1]->str;
+
+    if (!AST_INTERNAL::current_scope.count(width_ident->str)) {
+        return;
+    }
+    const AST::AstNode *const width_lp = AST_INTERNAL::current_scope[width_ident->str];
+    log_assert(width_lp->type == AST::AST_LOCALPARAM && !width_lp->children.empty());
+    if (!identifiers_in_scope(width_lp->children[0])) {
+        return;
+    }
+
+    AST::AstNode *width_node = width_lp->children[0]->clone();
+    while (simplify(width_node, true, false, false, 1, -1, false, false)) {
+    };
+    const bool is_const = (width_node->type == AST::AST_CONSTANT);
+    const int width = is_const ? width_node->integer : 0;
+    delete width_node;
+    if (!is_const || slice_size <= 0 || width <= 0 || width % slice_size != 0) {
+        return;
+    }
+
+    const auto make_node = [loop_node](AST::AstNodeType type) {
+        auto *node = new AST::AstNode(type);
+        node->filename = loop_node->filename;
+        node->location = loop_node->location;
+        return node;
+    };
+
+    // Children of AST_CONCAT go from the least significant part, dst[slice_size-1:0] gets src[slice_size-1:0] as in the loop body.
+    auto *concat = make_node(AST::AST_CONCAT);
+    concat->children.reserve(width / slice_size);
+    for (int i = 0; i < width; i += slice_size) {
+        auto *range = make_node(AST::AST_RANGE);
+        range->children.push_back(AST::AstNode::mkconst_int(i + slice_size - 1, true));
+        if (slice_size > 1) {
+            range->children.push_back(AST::AstNode::mkconst_int(i, true));
+        }
+        auto *slice = make_node(AST::AST_IDENTIFIER);
+        slice->str = src_name;
+        slice->children.push_back(range);
+        concat->children.push_back(slice);
+    }
+
+    auto *dst = make_node(AST::AST_IDENTIFIER);
+    dst->str = dst_name;
+
+    const AST::AstNodeType assign_type = slice_assign->type;
+    delete_children(loop_node);
+    delete_attribute(loop_node, attr_id::stream_op_slice_size);
+    loop_node->type = assign_type;
+    loop_node->str.clear();
+    loop_node->children = {dst, concat};
+}
+
 // A wrapper for Yosys simplify function.
 // Simplifies AST constructs specific to this plugin to a form understandable by Yosys' simplify and then calls the latter if necessary.
 // Since simplify from Yosys has been forked to this codebase, all new code should be added there instead.
@@ -1302,9 +1414,8 @@ static void simplify_sv(AST::AstNode *current_node, AST::AstNode *parent_node)
     }
     if (expanded) {
         delete_children(current_node);
-        current_node->children.push_back(expanded->clone());
+        current_node->children.push_back(expanded);
         current_node->basic_prep = true;
-        delete expanded;
         expanded = nullptr;
     }
     // First simplify children
@@ -1378,6 +1489,12 @@ static void simplify_sv(AST::AstNode *current_node, AST::AstNode *parent_node)
             };
         }
         break;
+    case AST::AST_FOR:
+    case AST::AST_GENFOR:
+        if (current_node->attributes.count(attr_id::stream_op_slice_size)) {
+            simplify_stream_op_loop(current_node);
+        }
+        break;
     case AST::AST_TCALL:
         if (current_node->str == "$display" || current_node->str == "$write")
             simplify_format_string(current_node);
@@ -1434,12 +1551,13 @@ static void clear_current_scope()
     AST_INTERNAL::current_ast_mod = nullptr;
 }
 
-void UhdmAst::visit_one_to_many(const std::vector<int> child_node_types, vpiHandle parent_handle, const std::function<void(AST::AstNode *)> &f)
+template <typename F> void UhdmAst::visit_one_to_many(std::initializer_list<int> child_node_types, vpiHandle parent_handle, F &&f)
 {
+    const std::string child_indent = indent + "  ";
     for (auto child : child_node_types) {
         vpiHandle itr = vpi_iterate(child, parent_handle);
         while (vpiHandle vpi_child_obj = vpi_scan(itr)) {
-            UhdmAst uhdm_ast(this, shared, indent + "  ");
+            UhdmAst uhdm_ast(this, shared, child_indent);
             auto *child_node = uhdm_ast.process_object(vpi_child_obj);
             f(child_node);
             vpi_release_handle(vpi_child_obj);
@@ -1448,12 +1566,13 @@ void UhdmAst::visit_one_to_many(const std::vector<int> child_node_types, vpiHand
     }
 }
 
-void UhdmAst::visit_one_to_one(const std::vector<int> child_node_types, vpiHandle parent_handle, const std::function<void(AST::AstNode *)> &f)
+template <typename F> void UhdmAst::visit_one_to_one(std::initializer_list<int> child_node_types, vpiHandle parent_handle, F &&f)
 {
+    const std::string child_indent = indent + "  ";
     for (auto child : child_node_types) {
         vpiHandle itr = vpi_handle(child, parent_handle);
         if (itr) {
-            UhdmAst uhdm_ast(this, shared, indent + "  ");
+            UhdmAst uhdm_ast(this, shared, child_indent);
             auto *child_node = uhdm_ast.process_object(itr);
             f(child_node);
         }
@@ -1461,7 +1580,7 @@ void UhdmAst::visit_one_to_one(const std::vector<int> child_node_types, vpiHandl
     }
 }
 
-void UhdmAst::visit_range(vpiHandle obj_h, const std::function<void(AST::AstNode *)> &f)
+template <typename F> void UhdmAst::visit_range(vpiHandle obj_h, F &&f)
 {
     std::vector<AST::AstNode *> range_nodes;
     visit_one_to_many({vpiRange}, obj_h, [&](AST::AstNode *node) { range_nodes.push_back(node); });
@@ -1769,21 +1888,31 @@ void UhdmAst::transform_breaks_continues(AST::AstNode *loop, AST::AstNode *decl_
 
 void UhdmAst::apply_location_from_current_obj(AST::AstNode &target_node) const
 {
-    if (auto filename = vpi_get_str(vpiFile, obj_h)) {
-        target_node.filename = filename;
+    // This runs for every created node, so the location is read straight from the UHDM object
+    // instead of through one vpi_get call per field
+    const UHDM::BaseClass *object = nullptr;
+    if (obj_h)
+        object = (const UHDM::BaseClass *)((const uhdm_handle *)obj_h)->object;
+    if (!object) {
+        target_node.location.last_line = target_node.location.first_line;
+        target_node.location.last_column = target_node.location.first_column;
+        return;
+    }
+    if (!object->VpiFile().empty()) {
+        target_node.filename = object->VpiFile();
     }
-    if (unsigned int first_line = vpi_get(vpiLineNo, obj_h)) {
+    if (unsigned int first_line = object->VpiLineNo()) {
         target_node.location.first_line = first_line;
     }
-    if (unsigned int last_line = vpi_get(vpiEndLineNo, obj_h)) {
+    if (unsigned int last_line = object->VpiEndLineNo()) {
         target_node.location.last_line = last_line;
     } else {
         target_node.location.last_line = target_node.location.first_line;
     }
-    if (unsigned int first_col = vpi_get(vpiColumnNo, obj_h)) {
+    if (unsigned int first_col = object->VpiColumnNo()) {
         target_node.location.first_column = first_col;
     }
-    if (unsigned int last_col = vpi_get(vpiEndColumnNo, obj_h)) {
+    if (unsigned int last_col = object->VpiEndColumnNo()) {
         target_node.location.last_column = last_col;
     } else {
         target_node.location.last_column = target_node.location.first_column;
@@ -1792,7 +1921,18 @@ void UhdmAst::apply_location_from_current_obj(AST::AstNode &target_node) const
 
 void UhdmAst::apply_name_from_current_obj(AST::AstNode &target_node, bool prefer_full_name) const
 {
-    target_node.str = get_name(obj_h, prefer_full_name);
+    if (obj_h) {
+        // The name only depends on the object and its parents, so it is computed once per object
+        const uhdm_handle *const handle = (const uhdm_handle *)obj_h;
+        const UHDM::BaseClass *const object = (const UHDM::BaseClass *)handle->object;
+        auto &names = prefer_full_name ? shared.object_full_names : shared.object_names;
+        auto [name_it, inserted] = names.try_emplace(object);
+        if (inserted)
+            name_it->second = get_name(obj_h, prefer_full_name);
+        target_node.str = name_it->second;
+    } else {
+        target_node.str = get_name(obj_h, prefer_full_name);
+    }
     auto it = node_renames.find(target_node.str);
     if (it != node_renames.end())
         target_node.str = it->second;
@@ -1834,7 +1974,7 @@ AST::AstNode *UhdmAst::make_ast_node(AST::AstNodeType type, std::vector<AST::Ast
     auto node = new AST::AstNode(type);
     apply_name_from_current_obj(*node, prefer_full_name);
     apply_location_from_current_obj(*node);
-    node->children = children;
+    node->children = std::move(children);
     return node;
 }
 
@@ -1868,7 +2008,7 @@ void UhdmAst::process_packed_array_typespec()
                 current_node->is_custom_type = true;
                 auto it = shared.param_types.find(current_node->str);
                 if (it == shared.param_types.end())
-                    shared.param_types.insert(std::make_pair(current_node->str, node->clone()));
+                    shared.param_types.insert(std::make_pair(current_node->str, node));
             }
         }
     });
@@ -1892,19 +2032,21 @@ static void add_or_replace_child(AST::AstNode *parent, AST::AstNode *child)
             child->is_signed = child->is_signed || (*it)->is_signed;
             if (!(*it)->children.empty() && child->children.empty()) {
                 // This is a bit ugly, but if the child we're replacing has children and
-                // our node doesn't, we copy its children to not lose any information
+                // our node doesn't, we move its children to not lose any information
                 for (auto grandchild : (*it)->children) {
-                    child->children.push_back(grandchild->clone());
+                    child->children.push_back(grandchild);
                     if (child->type == AST::AST_WIRE && grandchild->type == AST::AST_WIRETYPE)
                         child->is_custom_type = true;
                 }
+                (*it)->children.clear();
             }
             if ((*it)->attributes.count(UhdmAst::packed_ranges()) && child->attributes.count(UhdmAst::packed_ranges())) {
                 if ((!(*it)->attributes[UhdmAst::packed_ranges()]->children.empty() &&
                      child->attributes[UhdmAst::packed_ranges()]->children.empty())) {
 
                     delete_attribute(child, UhdmAst::packed_ranges());
-                    child->attributes[UhdmAst::packed_ranges()] = (*it)->attributes[UhdmAst::packed_ranges()]->clone();
+                    child->attributes[UhdmAst::packed_ranges()] = (*it)->attributes[UhdmAst::packed_ranges()];
+                    (*it)->attributes.erase(UhdmAst::packed_ranges());
                 }
             }
             if ((*it)->attributes.count(UhdmAst::unpacked_ranges()) && child->attributes.count(UhdmAst::unpacked_ranges())) {
@@ -1912,7 +2054,8 @@ static void add_or_replace_child(AST::AstNode *parent, AST::AstNode *child)
                      child->attributes[UhdmAst::unpacked_ranges()]->children.empty())) {
 
                     delete_attribute(child, UhdmAst::unpacked_ranges());
-                    child->attributes[UhdmAst::unpacked_ranges()] = (*it)->attributes[UhdmAst::unpacked_ranges()]->clone();
+                    child->attributes[UhdmAst::unpacked_ranges()] = (*it)->attributes[UhdmAst::unpacked_ranges()];
+                    (*it)->attributes.erase(UhdmAst::unpacked_ranges());
                 }
             }
             // Surelog doesn't report correct sign value for param_assign nodes
@@ -1949,13 +2092,12 @@ static void add_or_replace_child(AST::AstNode *parent, AST::AstNode *child)
             AST::AstNode *block_node = initial_node->children[0];
             AST::AstNode *child_block_node = child->children[0];
 
-            // Place the contents of child block node inside parent block
-            for (auto child_block_child : child_block_node->children)
-                block_node->children.push_back(child_block_child->clone());
-            // Place the remaining contents of child initial node inside the parent initial
-            for (auto initial_child = child->children.begin() + 1; initial_child != child->children.end(); ++initial_child) {
-                initial_node->children.push_back((*initial_child)->clone());
-            }
+            // Move the contents of child block node inside parent block
+            block_node->children.insert(block_node->children.end(), child_block_node->children.begin(), child_block_node->children.end());
+            child_block_node->children.clear();
+            // Move the remaining contents of child initial node inside the parent initial
+            initial_node->children.insert(initial_node->children.end(), child->children.begin() + 1, child->children.end());
+            child->children.resize(1);
             delete child;
         } else {
             // Parent AST_INITIAL does not exist
@@ -2063,12 +2205,12 @@ void UhdmAst::move_type_to_new_typedef(AST::AstNode *current_node, AST::AstNode
     }
 }
 
-AST::AstNode *UhdmAst::find_ancestor(const std::unordered_set<AST::AstNodeType> &types)
+AST::AstNode *UhdmAst::find_ancestor(std::initializer_list<AST::AstNodeType> types)
 {
     auto searched_node = this;
     while (searched_node) {
         if (searched_node->current_node) {
-            if (types.find(searched_node->current_node->type) != types.end()) {
+            if (std::find(types.begin(), types.end(), searched_node->current_node->type) != types.end()) {
                 return searched_node->current_node;
             }
         }
@@ -2098,13 +2240,14 @@ void UhdmAst::process_design()
         if (node)
             move_type_to_new_typedef(current_node, node);
     });
+    shared.profile.begin_phase("simplify_sv");
+    check_memories(shared.top_nodes);
     // Add top level typedefs and params to scope
     setup_current_scope(shared.top_nodes, current_node);
     for (auto pair : shared.top_nodes) {
         if (!pair.second)
             continue;
         if (pair.second->type == AST::AST_PACKAGE) {
-            check_memories(pair.second);
             clear_current_scope();
             setup_current_scope(shared.top_nodes, pair.second);
             simplify_sv(pair.second, nullptr);
@@ -2120,7 +2263,6 @@ void UhdmAst::process_design()
             if (pair.second->type == AST::AST_PACKAGE)
                 current_node->children.insert(current_node->children.begin(), pair.second);
             else {
-                check_memories(pair.second);
                 setup_current_scope(shared.top_nodes, pair.second);
                 simplify_sv(pair.second, nullptr);
                 clear_current_scope();
@@ -2134,6 +2276,7 @@ void UhdmAst::process_design()
             pair.second = nullptr;
         }
     }
+    shared.profile.end_phase();
 }
 
 void UhdmAst::simplify_parameter(AST::AstNode *parameter, AST::AstNode *module_node)
@@ -2293,21 +2436,30 @@ void UhdmAst::process_module()
             delete node;
         });
 
+        // Parameter assignments are converted and reduced once, the nodes are reused
+        // below if the module has to be elaborated with these parameters.
+        // They are reduced in the scope of the module specialized so far: the generic
+        // module, overridden by the values this instance assigns to the preceding
+        // parameters. The scope node only borrows its children.
+        std::vector<AST::AstNode *> param_assigns;
+        auto param_scope = new AST::AstNode(AST::AST_MODULE);
+        if (shared.top_nodes.count(type) && shared.top_nodes[type])
+            param_scope->children.push_back(shared.top_nodes[type]);
         visit_one_to_many({vpiParamAssign}, obj_h, [&](AST::AstNode *node) {
             if (node && node->type == AST::AST_PARAMETER) {
                 log_assert(!node->children.empty());
                 if (node->children[0]->type != AST::AST_CONSTANT) {
-                    if (shared.top_nodes.count(type)) {
-                        simplify_parameter(node, shared.top_nodes[type]);
-                    } else {
-                        simplify_parameter(node, nullptr);
-                    }
+                    simplify_parameter(node, param_scope);
                 }
                 log_assert(node->children[0]->type == AST::AST_CONSTANT || node->children[0]->type == AST::AST_REALVALUE);
                 parameters.push_back(std::make_pair(node->str, node->children[0]->asParaConst()));
+                param_scope->children.push_back(node);
             }
-            delete node;
+            if (node)
+                param_assigns.push_back(node);
         });
+        param_scope->children.clear();
+        delete param_scope;
         // We need to rename module to prevent name collision with the same module, but with different parameters
         std::string module_name = !parameters.empty() ? AST::derived_module_name(type, parameters).c_str() : type;
         auto module_node = shared.top_nodes[module_name];
@@ -2330,29 +2482,30 @@ void UhdmAst::process_module()
             }
         } else if (auto attribute = get_attribute(module_node, attr_id::is_elaborated_module); attribute && attribute->integer == 1) {
             // we already processed module with this parameters, just create cell node
+            for (auto *node : param_assigns)
+                delete node;
             make_cell(obj_h, current_node, module_node);
             return;
         }
         shared.top_nodes[module_node->str] = module_node;
-        visit_one_to_many({vpiParamAssign}, obj_h, [&](AST::AstNode *node) {
-            if (node) {
-                if (node->children[0]->type != AST::AST_CONSTANT) {
-                    if (shared.top_nodes[type]) {
-                        simplify_parameter(node, module_node);
-                        log_assert(node->children[0]->type == AST::AST_CONSTANT || node->children[0]->type == AST::AST_REALVALUE);
-                    }
-                }
-                // if module is primitive
-                // Surelog doesn't have definition of this module,
-                // so we need to left setting of parameters to yosys
-                if (isPrimitive) {
-                    node->type = AST::AST_PARASET;
-                    current_node->children.push_back(node);
-                } else {
-                    add_or_replace_child(module_node, node);
+        for (auto *node : param_assigns) {
+            // Parameters have been reduced to constants above, what is left are the localparams
+            if (node->children[0]->type != AST::AST_CONSTANT) {
+                if (shared.top_nodes[type]) {
+                    simplify_parameter(node, module_node);
+                    log_assert(node->children[0]->type == AST::AST_CONSTANT || node->children[0]->type == AST::AST_REALVALUE);
                 }
             }
-        });
+            // if module is primitive
+            // Surelog doesn't have definition of this module,
+            // so we need to left setting of parameters to yosys
+            if (isPrimitive) {
+                node->type = AST::AST_PARASET;
+                current_node->children.push_back(node);
+            } else {
+                add_or_replace_child(module_node, node);
+            }
+        }
         module_node->children.insert(std::end(module_node->children), std::begin(parameter_typedefs), std::end(parameter_typedefs));
         if (module_node->attributes.count(UhdmAst::partial())) {
             AST::AstNode *attr = module_node->attributes.at(UhdmAst::partial());
@@ -2902,10 +3055,12 @@ void UhdmAst::process_param_assign()
             // but we want to skip actual value, as it is set in rhs
             for (auto *c : node->children) {
                 if (c->type != AST::AST_CONSTANT) {
-                    current_node->children.push_back(c->clone());
+                    current_node->children.push_back(c);
+                } else {
+                    delete c;
                 }
             }
-            delete_children(node);
+            node->children.clear();
             copy_packed_unpacked_attribute(node, current_node);
             current_node->is_custom_type = node->is_custom_type;
             auto it = shared.param_types.find(current_node->str);
@@ -2954,10 +3109,10 @@ void UhdmAst::process_cont_assign_net()
             if (node->type == AST::AST_WIRE || node->type == AST::AST_PARAMETER || node->type == AST::AST_LOCALPARAM) {
                 current_node->children.push_back(new AST::AstNode(AST::AST_IDENTIFIER));
                 current_node->children.back()->str = node->str;
+                delete node;
             } else {
-                current_node->children.push_back(node->clone());
+                current_node->children.push_back(node);
             }
-            delete node;
         }
     });
 }
@@ -3089,8 +3244,10 @@ void UhdmAst::process_packed_array_net()
     std::vector<AST::AstNode *> unpacked_ranges;
     current_node = make_ast_node(AST::AST_WIRE);
     visit_one_to_many({vpiElement}, obj_h, [&](AST::AstNode *node) {
-        if (node && GetSize(node->children) == 1)
-            current_node->children.push_back(node->children[0]->clone());
+        if (node && GetSize(node->children) == 1) {
+            current_node->children.push_back(node->children[0]);
+            node->children.clear();
+        }
         current_node->is_custom_type = node->is_custom_type;
         delete node;
     });
@@ -3240,18 +3397,17 @@ void UhdmAst::process_io_decl()
                 current_node->is_custom_type = true;
             } else {
                 // anonymous typedef, just move children
-                for (auto child : node->children) {
-                    current_node->children.push_back(child->clone());
-                }
+                current_node->children.insert(current_node->children.end(), node->children.begin(), node->children.end());
+                node->children.clear();
                 if (node->attributes.count(UhdmAst::packed_ranges())) {
-                    for (auto r : node->attributes[UhdmAst::packed_ranges()]->children) {
-                        packed_ranges.push_back(r->clone());
-                    }
+                    auto &ranges = node->attributes[UhdmAst::packed_ranges()]->children;
+                    packed_ranges.insert(packed_ranges.end(), ranges.begin(), ranges.end());
+                    ranges.clear();
                 }
                 if (node->attributes.count(UhdmAst::unpacked_ranges())) {
-                    for (auto r : node->attributes[UhdmAst::unpacked_ranges()]->children) {
-                        unpacked_ranges.push_back(r->clone());
-                    }
+                    auto &ranges = node->attributes[UhdmAst::unpacked_ranges()]->children;
+                    unpacked_ranges.insert(unpacked_ranges.end(), ranges.begin(), ranges.end());
+                    ranges.clear();
                 }
                 current_node->is_logic = node->is_logic;
                 current_node->is_reg = node->is_reg;
@@ -3835,6 +3991,8 @@ void UhdmAst::process_stream_op()
           }),
         }),
       });
+    // Lets simplify_sv() replace the loop with a single concatenation once the width is known.
+    set_attribute(for_loop, attr_id::stream_op_slice_size, for_loop->children[2]->children[1]->children[1]->clone());
 
     stmt_list_node->children.insert(stmt_list_node->children.end(), {
                                                                       stream_concat_width_lp,
@@ -3908,6 +4066,8 @@ void UhdmAst::process_assignment_pattern_op()
     current_node = make_ast_node(AST::AST_CONCAT);
     if (auto param_node = find_ancestor({AST::AST_PARAMETER, AST::AST_LOCALPARAM})) {
         std::map<size_t, AST::AstNode *> ordered_children;
+        // Positions of the members of the parameter type, built on first use so that large patterns don't search the type for every key.
+        std::unordered_map<std::string, size_t> member_positions;
         visit_one_to_many({vpiOperand}, obj_h, [&](AST::AstNode *node) {
             if (node->type == AST::AST_ASSIGN || node->type == AST::AST_ASSIGN_EQ || node->type == AST::AST_ASSIGN_LE) {
                 // Get the name of the parameter or it's child, to which the pattern is assigned.
@@ -3924,12 +4084,17 @@ void UhdmAst::process_assignment_pattern_op()
                 if (!param_type) {
                     log_error("Couldn't find parameter type for node: %s\n", param_node->str.c_str());
                 }
+                if (member_positions.empty()) {
+                    for (size_t i = param_type->children.size(); i-- > 0;) {
+                        member_positions[param_type->children[i]->str] = i;
+                    }
+                }
                 // Place the child node holding the value assigned in the pattern, in the right order,
                 // so the overall value of the param_node is correct.
-                size_t pos =
-                  std::find_if(param_type->children.begin(), param_type->children.end(), [key](AST::AstNode *child) { return child->str == key; }) -
-                  param_type->children.begin();
-                ordered_children.insert(std::make_pair(pos, node->children[1]->clone()));
+                auto pos_it = member_positions.find(key);
+                size_t pos = (pos_it != member_positions.end()) ? pos_it->second : param_type->children.size();
+                ordered_children.insert(std::make_pair(pos, node->children[1]));
+                node->children.erase(node->children.begin() + 1);
                 delete node;
             } else {
                 current_node->children.push_back(node);
@@ -5089,6 +5254,12 @@ AST::AstNode *UhdmAst::process_object(vpiHandle obj_handle)
     if (shared.debug_flag) {
         std::cout << indent << "Object '" << object->VpiName() << "' of type '" << UHDM::VpiTypeName(obj_h) << '\'' << std::endl;
     }
+    if (shared.report.collect_unhandled) {
+        shared.report.mark_visited(object);
+    }
+    if (shared.profile.enabled) {
+        shared.profile.begin_object(object_type, obj_h);
+    }
 
     switch (object_type) {
     case vpiDesign:
@@ -5353,6 +5524,10 @@ AST::AstNode *UhdmAst::process_object(vpiHandle obj_handle)
         break;
     }
 
+    if (shared.profile.enabled) {
+        shared.profile.end_object();
+    }
+
     // Check if we initialized the node in switch-case
     if (current_node) {
         if (current_node->type != AST::AST_NONE) {
@@ -5380,6 +5555,8 @@ AST::AstNode *UhdmAst::visit_designs(const std::vector<vpiHandle> &designs)
         delete node;
     }
     shared.param_types.clear();
+    shared.object_names.clear();
+    shared.object_full_names.clear();
 
     // Remove all internal attributes from the AST.
     visitEachDescendant(current_node, delete_internal_attributes);
@@ -2,6 +2,7 @@
 #define _UHDM_AST_H_ 1
 
 #include "frontends/ast/ast.h"
+#include <initializer_list>
 #include <vector>
 #undef cover
 
@@ -23,15 +24,17 @@ class UhdmAst
     // Walks through one-to-many relationships from given parent
     // node through the VPI interface, visiting child nodes belonging to
     // ChildrenNodeTypes that are present in the given object.
-    void visit_one_to_many(const std::vector<int> child_node_types, vpiHandle parent_handle, const std::function<void(::Yosys::AST::AstNode *)> &f);
+    // `f` is called with each created node, it is a template parameter
+    // so the callback is not wrapped in a std::function on this hot path.
+    template <typename F> void visit_one_to_many(std::initializer_list<int> child_node_types, vpiHandle parent_handle, F &&f);
 
     // Walks through one-to-one relationships from given parent
     // node through the VPI interface, visiting child nodes belonging to
     // ChildrenNodeTypes that are present in the given object.
-    void visit_one_to_one(const std::vector<int> child_node_types, vpiHandle parent_handle, const std::function<void(::Yosys::AST::AstNode *)> &f);
+    template <typename F> void visit_one_to_one(std::initializer_list<int> child_node_types, vpiHandle parent_handle, F &&f);
 
     // Visit children of type vpiRange that belong to the given parent node.
-    void visit_range(vpiHandle obj_h, const std::function<void(::Yosys::AST::AstNode *)> &f);
+    template <typename F> void visit_range(vpiHandle obj_h, F &&f);
 
     // Visit the default expression assigned to a variable.
     void visit_default_expr(vpiHandle obj_h);
@@ -69,7 +72,7 @@ class UhdmAst
     void move_type_to_new_typedef(::Yosys::AST::AstNode *current_node, ::Yosys::AST::AstNode *type_node);
 
     // Go up the UhdmAst to find a parent node of the specified type
-    ::Yosys::AST::AstNode *find_ancestor(const std::unordered_set<::Yosys::AST::AstNodeType> &types);
+    ::Yosys::AST::AstNode *find_ancestor(std::initializer_list<::Yosys::AST::AstNodeType> types);
 
     // Reports that something went wrong with reading the UHDM file
     void report_error(const char *format, ...) const;
@@ -300,6 +303,7 @@ class AstNodeBuilder
         node->integer = v;
         node->is_signed = is_signed;
         // `AstNode::mkconst_int` does this too.
+        node->bits.reserve(width);
         for (int i = 0; i < width; i++) {
             node->bits.push_back((v & 1) ? Yosys::RTLIL::State::S1 : Yosys::RTLIL::State::S0);
             v = v >> 1;
@@ -0,0 +1,24 @@
+yosys -import
+if { [info procs read_uhdm] == {} } { plugin -i systemverilog }
+yosys -import  ;# ingest plugin commands
+
+set TMP_DIR $::env(TEST_OUTPUT_PREFIX)/tmp
+file mkdir $TMP_DIR
+
+# Queue the files and compile them with a single Surelog run
+read_systemverilog -odir $TMP_DIR -batch $::env(DESIGN_TOP)-pkg.sv
+read_systemverilog -odir $TMP_DIR -batch $::env(DESIGN_TOP)-buf.sv
+read_systemverilog -odir $TMP_DIR -batch $::env(DESIGN_TOP).v
+read_systemverilog -odir $TMP_DIR -link
+hierarchy -check -top top
+select -assert-count 1 top/bufgctrl
+write_verilog $TMP_DIR/batch.v
+design -reset
+
+# The same files compiled separately and linked must give the same design
+read_systemverilog -odir $TMP_DIR -defer $::env(DESIGN_TOP)-pkg.sv
+read_systemverilog -odir $TMP_DIR -defer $::env(DESIGN_TOP)-buf.sv
+read_systemverilog -odir $TMP_DIR -defer $::env(DESIGN_TOP).v
+read_systemverilog -odir $TMP_DIR -link
+hierarchy -check -top top
+write_verilog $TMP_DIR/separate.v
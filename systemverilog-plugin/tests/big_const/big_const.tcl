@@ -0,0 +1,12 @@
+yosys -import
+if { [info procs read_uhdm] == {} } { plugin -i systemverilog }
+yosys -import  ;# ingest plugin commands
+
+set TMP_DIR $::env(TEST_OUTPUT_PREFIX)/tmp
+file mkdir $TMP_DIR
+
+# Testing conversion of wide constants
+read_systemverilog -o $TMP_DIR $::env(DESIGN_TOP).v
+hierarchy -top top
+proc
+sat -verify -prove out_dec 97'h18ee90ff6c373e0ee4e3f0ad2 -prove out_hex 100'd123456789012345678901234567890 -prove out_bin 12'ha5c -prove out_zero 0
@@ -0,0 +1,27 @@
+// Copyright 2020-2022 F4PGA Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+module top (
+    output [ 96:0] out_dec,
+    output [ 99:0] out_hex,
+    output [ 11:0] out_bin,
+    output [ 31:0] out_zero
+);
+  assign out_dec = 97'd123456789012345678901234567890;
+  assign out_hex = 100'h18ee90ff6c373e0ee4e3f0ad2;
+  assign out_bin = 12'b1010_0101_1100;
+  assign out_zero = 32'd0;
+endmodule
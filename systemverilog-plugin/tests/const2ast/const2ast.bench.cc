@@ -0,0 +1,53 @@
+/*
+ * Copyright 2020-2022 F4PGA Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ */
+#include "third_party/yosys/const2ast.h"
+
+#include "kernel/yosys.h"
+
+#include <benchmark/benchmark.h>
+
+#include <string>
+
+// A sized literal of the given base with a number of digits
+static std::string makeLiteral(char a_Base, int a_Digits)
+{
+    std::string digits;
+    for (int i = 0; i < a_Digits; ++i) {
+        digits += a_Base == 'd' ? static_cast<char>('0' + (i * 7 + 3) % 10) : "0123456789abcdef"[(i * 7 + 3) % 16];
+    }
+    int bits = a_Base == 'd' ? a_Digits * 10 / 3 + 1 : a_Digits * 4;
+    return std::to_string(bits) + "'" + a_Base + digits;
+}
+
+static void benchConst2Ast(benchmark::State &state, char a_Base)
+{
+    std::string literal = makeLiteral(a_Base, state.range(0));
+    for (auto _ : state) {
+        Yosys::AST::AstNode *node = systemverilog_plugin::const2ast(literal);
+        benchmark::DoNotOptimize(node->bits.data());
+        delete node;
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+static void BM_Const2AstDecimal(benchmark::State &state) { benchConst2Ast(state, 'd'); }
+BENCHMARK(BM_Const2AstDecimal)->RangeMultiplier(8)->Range(8, 1 << 12);
+
+static void BM_Const2AstHex(benchmark::State &state) { benchConst2Ast(state, 'h'); }
+BENCHMARK(BM_Const2AstHex)->RangeMultiplier(8)->Range(8, 1 << 12);
@@ -0,0 +1,13 @@
+yosys -import
+if { [info procs read_uhdm] == {} } { plugin -i systemverilog }
+yosys -import  ;# ingest plugin commands
+
+set TMP_DIR $::env(TEST_OUTPUT_PREFIX)/tmp
+file mkdir $TMP_DIR
+
+# Testing slices of constant tables indexed in a generate loop
+read_systemverilog -o $TMP_DIR $::env(DESIGN_TOP).v
+hierarchy -top top
+proc
+flatten
+sat -verify -prove out 32'h67452301 -prove out_upto 8'h12
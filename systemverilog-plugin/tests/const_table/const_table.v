@@ -0,0 +1,29 @@
+// Copyright 2020-2022 F4PGA Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+module top (
+    output [31:0] out,
+    output [ 7:0] out_upto
+);
+  localparam [63:0] TABLE = 64'h0123456789abcdef;
+  localparam [0:15] TABLE_UPTO = 16'h1234;
+
+  for (genvar i = 0; i < 4; i++) begin : gen_bytes
+    assign out[i*8+:8] = TABLE[(7-i)*8+:8];
+  end
+
+  assign out_upto = TABLE_UPTO[0:7];
+endmodule
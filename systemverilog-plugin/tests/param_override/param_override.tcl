@@ -0,0 +1,13 @@
+yosys -import
+if { [info procs read_uhdm] == {} } { plugin -i systemverilog }
+yosys -import  ;# ingest plugin commands
+
+set TMP_DIR $::env(TEST_OUTPUT_PREFIX)/tmp
+file mkdir $TMP_DIR
+
+# Testing a parameter derived from an overridden one
+read_systemverilog -o $TMP_DIR $::env(DESIGN_TOP).v
+hierarchy -top top
+proc
+flatten
+sat -verify -prove out_default 16'd8 -prove out_override 16'd16
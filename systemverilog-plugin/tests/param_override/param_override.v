@@ -0,0 +1,32 @@
+// Copyright 2020-2022 F4PGA Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+module sub #(
+    parameter W = 4,
+    parameter D = W * 2
+) (
+    output [15:0] out
+);
+  assign out = D;
+endmodule
+
+module top (
+    output [15:0] out_default,
+    output [15:0] out_override
+);
+  sub s0 (.out(out_default));
+  sub #(.W(8)) s1 (.out(out_override));
+endmodule
@@ -0,0 +1,10 @@
+yosys -import
+if { [info procs read_uhdm] == {} } { plugin -i systemverilog }
+yosys -import  ;# ingest plugin commands
+
+set TMP_DIR $::env(TEST_OUTPUT_PREFIX)/tmp
+file mkdir $TMP_DIR
+
+# Testing the coverage summary, together with the full report
+read_systemverilog -report $TMP_DIR/report -report_summary $TMP_DIR/summary.csv -o $TMP_DIR $::env(DESIGN_TOP).v
+write_verilog
@@ -0,0 +1,13 @@
+yosys -import
+if { [info procs read_uhdm] == {} } { plugin -i systemverilog }
+yosys -import  ;# ingest plugin commands
+
+set TMP_DIR $::env(TEST_OUTPUT_PREFIX)/tmp
+file mkdir $TMP_DIR
+
+# Testing lowering of streaming concatenations, in continuous assignments and procedural context.
+# The AST dump lets the test check that no slice copying loop is left for Yosys to unroll.
+read_systemverilog -dump_ast1 -o $TMP_DIR $::env(DESIGN_TOP).v
+hierarchy -top top
+proc
+sat -verify -prove out_bytes 32'h78563412 -prove out_bits 8'b0101_0011 -prove out_wide 128'heeff_ccdd_aabb_8899_6677_4455_2233_0011 -prove out_proc 16'hDCBA
@@ -0,0 +1,32 @@
+// Copyright 2020-2022 F4PGA Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+module top (
+    output [ 31:0] out_bytes,
+    output [  7:0] out_bits,
+    output [127:0] out_wide,
+    output logic [15:0] out_proc
+);
+  wire [ 31:0] in_bytes = 32'h12345678;
+  wire [  7:0] in_bits = 8'b1100_1010;
+  wire [127:0] in_wide = 128'h00112233_44556677_8899aabb_ccddeeff;
+
+  assign out_bytes = {<<8{in_bytes}};
+  assign out_bits = {<<{in_bits}};
+  assign out_wide = {<<16{in_wide}};
+
+  always_comb out_proc = {<<4{16'hABCD}};
+endmodule
@@ -0,0 +1,15 @@
+yosys -import
+if { [info procs read_uhdm] == {} } { plugin -i systemverilog }
+yosys -import  ;# ingest plugin commands
+
+set TMP_DIR $::env(TEST_OUTPUT_PREFIX)/tmp
+file mkdir $TMP_DIR
+
+# Read the design with a single Surelog thread
+read_systemverilog -o $TMP_DIR $::env(DESIGN_TOP).v
+write_verilog $TMP_DIR/serial.v
+design -reset
+
+# Testing parsing with several Surelog threads, the result must not change
+read_systemverilog -threads 2 -o $TMP_DIR $::env(DESIGN_TOP).v
+write_verilog $TMP_DIR/threads.v
@@ -0,0 +1,32 @@
+yosys -import
+if { [info procs read_uhdm] == {} } { plugin -i systemverilog }
+yosys -import  ;# ingest plugin commands
+
+set TMP_DIR $::env(TEST_OUTPUT_PREFIX)/tmp
+file delete -force $TMP_DIR/cache
+file mkdir $TMP_DIR
+
+# The headers are written here so that the nested one can be changed below
+set INC_DIR $TMP_DIR/inc
+file mkdir $INC_DIR/nested
+proc write_header { name text } {
+    set file [open $name w]
+    puts $file $text
+    close $file
+}
+write_header $INC_DIR/uhdm_cache.svh "`include \"nested/bits.svh\""
+write_header $INC_DIR/nested/bits.svh "`define BITS 4"
+
+# The first read runs Surelog and fills the cache
+read_systemverilog -uhdm_cache $TMP_DIR/cache -o $TMP_DIR -I$INC_DIR $::env(DESIGN_TOP).v
+write_verilog -noattr $TMP_DIR/uncached.v
+design -reset
+
+# The second read restores the design from the cache
+read_systemverilog -uhdm_cache $TMP_DIR/cache -o $TMP_DIR -I$INC_DIR $::env(DESIGN_TOP).v
+write_verilog -noattr $TMP_DIR/cached.v
+design -reset
+
+# A change of the nested header, which is not directly in the include directory, runs Surelog again
+write_header $INC_DIR/nested/bits.svh "// changed\n`define BITS 4"
+read_systemverilog -uhdm_cache $TMP_DIR/cache -o $TMP_DIR -I$INC_DIR $::env(DESIGN_TOP).v
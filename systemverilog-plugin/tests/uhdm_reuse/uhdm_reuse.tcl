@@ -0,0 +1,21 @@
+yosys -import
+if { [info procs read_uhdm] == {} } { plugin -i systemverilog }
+yosys -import  ;# ingest plugin commands
+
+set TMP_DIR $::env(TEST_OUTPUT_PREFIX)/tmp
+file delete -force $TMP_DIR/cache
+file mkdir $TMP_DIR
+
+# Store the UHDM database of the design
+read_systemverilog -uhdm_cache $TMP_DIR/cache -o $TMP_DIR $::env(DESIGN_TOP).v
+design -reset
+set UHDM_FILE [lindex [glob $TMP_DIR/cache/*.uhdm] 0]
+
+# The first read converts the database and keeps the AST
+read_uhdm -reuse $UHDM_FILE
+write_verilog -noattr $TMP_DIR/converted.v
+design -reset
+
+# The second read uses the kept AST
+read_uhdm -reuse $UHDM_FILE
+write_verilog -noattr $TMP_DIR/reused.v
@@ -42,27 +42,66 @@
 #include "frontends/ast/ast.h"
 #include "kernel/log.h"
 
+#include <algorithm>
 #include <string>
 #include <cmath>
+#include <cstring>
 #include <vector>
 
 using namespace Yosys;
 using namespace Yosys::AST;
 
-// divide an arbitrary length decimal number by two and return the rest
-static int my_decimal_div_by_two(std::vector<uint8_t> &digits)
+// convert an arbitrary length decimal number (MSB at index 0) to binary (LSB first) without leading zeros,
+// the number is accumulated in 32-bit words taking up to 9 decimal digits at a time
+static void my_decimal_to_bin(std::vector<RTLIL::State> &data, const std::vector<uint8_t> &digits)
 {
-	int carry = 0;
-	for (size_t i = 0; i < digits.size(); i++) {
-		if (digits[i] >= 10)
+	for (auto digit : digits)
+		if (digit >= 10)
 			log_file_error(current_filename, get_line_num(), "Invalid use of [a-fxz?] in decimal constant.\n");
-		digits[i] += carry * 10;
-		carry = digits[i] % 2;
-		digits[i] /= 2;
+	if (digits.empty())
+		return;
+
+	std::vector<uint32_t> words;
+	words.reserve(digits.size() / 9 + 1);
+	for (size_t i = 0; i < digits.size();) {
+		uint32_t chunk = 0, scale = 1;
+		for (int n = 0; n < 9 && i < digits.size(); n++, i++) {
+			chunk = chunk * 10 + digits[i];
+			scale *= 10;
+		}
+		uint64_t carry = chunk;
+		for (auto &word : words) {
+			uint64_t value = uint64_t(word) * scale + carry;
+			word = uint32_t(value);
+			carry = value >> 32;
+		}
+		if (carry)
+			words.push_back(uint32_t(carry));
+	}
+
+	if (words.empty()) {
+		data.push_back(State::S0);
+		return;
 	}
-	while (!digits.empty() && !digits.front())
-		digits.erase(digits.begin());
-	return carry;
+	data.reserve(words.size() * 32);
+	for (size_t w = 0; w < words.size(); w++) {
+		for (int i = 0; i < 32; i++) {
+			if (w + 1 == words.size() && (words[w] >> i) == 0)
+				break;
+			data.push_back(((words[w] >> i) & 1) ? State::S1 : State::S0);
+		}
+	}
+}
+
+// same as AstNode::mkconst_bits, but takes over the storage of `data` instead of copying it
+static AstNode *mkconst_bits_move(std::vector<RTLIL::State> &&data, bool is_signed, bool is_unsized = false)
+{
+	// the first 32 bits are enough to set up the node, the rest is moved in
+	std::vector<RTLIL::State> head(data.begin(), data.begin() + std::min<size_t>(data.size(), 32));
+	AstNode *node = AstNode::mkconst_bits(head, is_signed, is_unsized);
+	node->bits = std::move(data);
+	node->range_left = GetSize(node->bits) - 1;
+	return node;
 }
 
 // find the number of significant bits in a binary number (not including the sign bit)
@@ -81,6 +120,7 @@ static void my_strtobin(std::vector<RTLIL::State> &data, const char *str, int le
 {
 	// all digits in string (MSB at index 0)
 	std::vector<uint8_t> digits;
+	digits.reserve(strlen(str));
 
 	while (*str) {
 		if ('0' <= *str && *str <= '9')
@@ -102,23 +142,25 @@ static void my_strtobin(std::vector<RTLIL::State> &data, const char *str, int le
 	data.clear();
 
 	if (base == 10) {
-		while (!digits.empty())
-			data.push_back(my_decimal_div_by_two(digits) ? State::S1 : State::S0);
+		my_decimal_to_bin(data, digits);
 	} else {
+		// the size is known upfront, write the bits of each digit in place
 		int bits_per_digit = my_ilog2(base-1);
+		RTLIL::State x_state = case_type == 'x' ? RTLIL::Sa : RTLIL::Sx;
+		RTLIL::State z_state = case_type == 'x' || case_type == 'z' ? RTLIL::Sa : RTLIL::Sz;
+		data.resize(digits.size() * bits_per_digit);
+		auto out = data.begin();
 		for (auto it = digits.rbegin(), e = digits.rend(); it != e; it++) {
 			if (*it > (base-1) && *it < 0xf0)
 				log_file_error(current_filename, get_line_num(), "Digit larger than %d used in in base-%d constant.\n",
 					       base-1, base);
-			for (int i = 0; i < bits_per_digit; i++) {
-				int bitmask = 1 << i;
-				if (*it == 0xf0)
-					data.push_back(case_type == 'x' ? RTLIL::Sa : RTLIL::Sx);
-				else if (*it == 0xf1)
-					data.push_back(case_type == 'x' || case_type == 'z' ? RTLIL::Sa : RTLIL::Sz);
-				else
-					data.push_back((*it & bitmask) ? State::S1 : State::S0);
-			}
+			if (*it == 0xf0)
+				out = std::fill_n(out, bits_per_digit, x_state);
+			else if (*it == 0xf1)
+				out = std::fill_n(out, bits_per_digit, z_state);
+			else
+				for (int i = 0; i < bits_per_digit; i++)
+					*out++ = ((*it >> i) & 1) ? State::S1 : State::S0;
 		}
 	}
 
@@ -178,14 +220,14 @@ AstNode *systemverilog_plugin::const2ast(std::string code, char case_type, bool
 				ch = ch >> 1;
 			}
 		}
-		AstNode *ast = AstNode::mkconst_bits(data, false);
+		AstNode *ast = mkconst_bits_move(std::move(data), false);
 		ast->str = code;
 		return ast;
 	}
 
-	for (size_t i = 0; i < code.size(); i++)
-		if (code[i] == '_' || code[i] == ' ' || code[i] == '\t' || code[i] == '\r' || code[i] == '\n')
-			code.erase(code.begin()+(i--));
+	code.erase(std::remove_if(code.begin(), code.end(), [](char c) {
+		return c == '_' || c == ' ' || c == '\t' || c == '\r' || c == '\n';
+	}), code.end());
 	str = code.c_str();
 
 	char *endptr;
@@ -197,7 +239,7 @@ AstNode *systemverilog_plugin::const2ast(std::string code, char case_type, bool
 		my_strtobin(data, str, -1, 10, case_type, false);
 		if (data.back() == State::S1)
 			data.push_back(State::S0);
-		return AstNode::mkconst_bits(data, true);
+		return mkconst_bits_move(std::move(data), true);
 	}
 
 	// unsized constant
@@ -245,7 +287,7 @@ AstNode *systemverilog_plugin::const2ast(std::string code, char case_type, bool
 			if (is_signed && data.back() == State::S1)
 				data.push_back(State::S0);
 		}
-		return AstNode::mkconst_bits(data, is_signed, is_unsized);
+		return mkconst_bits_move(std::move(data), is_signed, is_unsized);
 	}
 
 	return NULL;
@@ -687,6 +687,14 @@ bool simplify(Yosys::AST::AstNode *ast_node, bool const_fold, bool at_zero, bool
 
 	Yosys::AST::current_filename = ast_node->filename;
 
+	// constant leaves are already folded and none of the code below changes them,
+	// skip it (large constant tables in generate loops create many of them)
+	if ((ast_node->type == Yosys::AST::AST_CONSTANT || ast_node->type == Yosys::AST::AST_REALVALUE) && ast_node->children.empty() && ast_node->attributes.empty()) {
+		ast_node->basic_prep = true;
+		recursion_counter--;
+		return false;
+	}
+
 	// we do not look inside a task or function
 	// (but as soon as a task or function is instantiated we process the generated AST as usual)
 	if (ast_node->type == Yosys::AST::AST_FUNCTION || ast_node->type == Yosys::AST::AST_TASK) {
@@ -737,8 +745,11 @@ bool simplify(Yosys::AST::AstNode *ast_node, bool const_fold, bool at_zero, bool
 	// activate const folding if this is anything that must be evaluated statically (ranges, parameters, attributes, etc.)
 	if (ast_node->type == Yosys::AST::AST_WIRE || ast_node->type == Yosys::AST::AST_PARAMETER || ast_node->type == Yosys::AST::AST_LOCALPARAM || ast_node->type == Yosys::AST::AST_ENUM_ITEM || ast_node->type == Yosys::AST::AST_DEFPARAM || ast_node->type == Yosys::AST::AST_PARASET || ast_node->type == Yosys::AST::AST_RANGE || ast_node->type == Yosys::AST::AST_PREFIX || ast_node->type == Yosys::AST::AST_TYPEDEF)
 		const_fold = true;
-	if (ast_node->type == Yosys::AST::AST_IDENTIFIER && current_scope.count(ast_node->str) > 0 && (current_scope[ast_node->str]->type == Yosys::AST::AST_PARAMETER || current_scope[ast_node->str]->type == Yosys::AST::AST_LOCALPARAM || current_scope[ast_node->str]->type == Yosys::AST::AST_ENUM_ITEM))
-		const_fold = true;
+	if (ast_node->type == Yosys::AST::AST_IDENTIFIER) {
+		auto it = current_scope.find(ast_node->str);
+		if (it != current_scope.end() && (it->second->type == Yosys::AST::AST_PARAMETER || it->second->type == Yosys::AST::AST_LOCALPARAM || it->second->type == Yosys::AST::AST_ENUM_ITEM))
+			const_fold = true;
+	}
 
 	// in certain cases a function must be evaluated constant. this is what in_param controls.
 	if (ast_node->type == Yosys::AST::AST_PARAMETER || ast_node->type == Yosys::AST::AST_LOCALPARAM || ast_node->type == Yosys::AST::AST_DEFPARAM || ast_node->type == Yosys::AST::AST_PARASET || ast_node->type == Yosys::AST::AST_PREFIX)
@@ -3800,14 +3811,18 @@ replace_fcall_later:;
 		switch (ast_node->type)
 		{
 		case Yosys::AST::AST_IDENTIFIER:
-			if (current_scope.count(ast_node->str) > 0 && (current_scope[ast_node->str]->type == Yosys::AST::AST_PARAMETER || current_scope[ast_node->str]->type == Yosys::AST::AST_LOCALPARAM || current_scope[ast_node->str]->type == Yosys::AST::AST_ENUM_ITEM)) {
-				if (current_scope[ast_node->str]->children[0]->type == Yosys::AST::AST_CONSTANT) {
+		{
+			// look the identifier up once, constant tables are indexed in every generate iteration
+			auto scope_it = current_scope.find(ast_node->str);
+			Yosys::AST::AstNode *decl = scope_it != current_scope.end() ? scope_it->second : nullptr;
+			if (decl && (decl->type == Yosys::AST::AST_PARAMETER || decl->type == Yosys::AST::AST_LOCALPARAM || decl->type == Yosys::AST::AST_ENUM_ITEM)) {
+				const Yosys::AST::AstNode *value = decl->children[0];
+				if (value->type == Yosys::AST::AST_CONSTANT) {
 					if (ast_node->children.size() != 0 && ast_node->children[0]->type == Yosys::AST::AST_RANGE && ast_node->children[0]->range_valid) {
-						std::vector<RTLIL::State> data;
-						bool param_upto = current_scope[ast_node->str]->range_valid && current_scope[ast_node->str]->range_swapped;
-						int param_offset = current_scope[ast_node->str]->range_valid ? current_scope[ast_node->str]->range_right : 0;
-						int param_width = current_scope[ast_node->str]->range_valid ? current_scope[ast_node->str]->range_left - current_scope[ast_node->str]->range_right + 1 :
-								GetSize(current_scope[ast_node->str]->children[0]->bits);
+						bool param_upto = decl->range_valid && decl->range_swapped;
+						int param_offset = decl->range_valid ? decl->range_right : 0;
+						int param_width = decl->range_valid ? decl->range_left - decl->range_right + 1 :
+								GetSize(value->bits);
 						int tmp_range_left = ast_node->children[0]->range_left, tmp_range_right = ast_node->children[0]->range_right;
 						if (param_upto) {
 							tmp_range_left = (param_width + 2*param_offset) - ast_node->children[0]->range_right - 1;
@@ -3816,27 +3831,27 @@ replace_fcall_later:;
 						Yosys::AST::AstNode *member_node = systemverilog_plugin::get_struct_member(ast_node);
 						int chunk_offset = member_node ? member_node->range_right : 0;
 						log_assert(!(chunk_offset && param_upto));
-						for (int i = tmp_range_right; i <= tmp_range_left; i++) {
-							int index = i - param_offset;
-							if (0 <= index && index < param_width)
-								data.push_back(current_scope[ast_node->str]->children[0]->bits[chunk_offset + index]);
-							else
-								data.push_back(RTLIL::State::Sx);
-						}
+						// copy the in-range part of the slice at once, pad the rest with x
+						std::vector<RTLIL::State> data(std::max(tmp_range_left - tmp_range_right + 1, 0), RTLIL::State::Sx);
+						int first = std::max(tmp_range_right - param_offset, 0);
+						int last = std::min(tmp_range_left - param_offset, param_width - 1);
+						if (first <= last)
+							std::copy(value->bits.begin() + chunk_offset + first, value->bits.begin() + chunk_offset + last + 1,
+									data.begin() + (first + param_offset - tmp_range_right));
 						newNode = Yosys::AST::AstNode::mkconst_bits(data, false);
 					} else
 					if (ast_node->children.size() == 0)
-						newNode = current_scope[ast_node->str]->children[0]->clone();
+						newNode = value->clone();
 				} else
-				if (current_scope[ast_node->str]->children[0]->isConst())
-					newNode = current_scope[ast_node->str]->children[0]->clone();
+				if (value->isConst())
+					newNode = value->clone();
 			}
-			else if (at_zero && current_scope.count(ast_node->str) > 0) {
-				Yosys::AST::AstNode *node = current_scope[ast_node->str];
-				if (node->type == Yosys::AST::AST_WIRE || node->type == Yosys::AST::AST_AUTOWIRE || node->type == Yosys::AST::AST_MEMORY)
-					newNode = node->mkconst_int(0, sign_hint, width_hint);
+			else if (at_zero && decl) {
+				if (decl->type == Yosys::AST::AST_WIRE || decl->type == Yosys::AST::AST_AUTOWIRE || decl->type == Yosys::AST::AST_MEMORY)
+					newNode = decl->mkconst_int(0, sign_hint, width_hint);
 			}
 			break;
+		}
 		case Yosys::AST::AST_MEMRD:
 			if (at_zero) {
 				newNode = Yosys::AST::AstNode::mkconst_int(0, sign_hint, width_hint);
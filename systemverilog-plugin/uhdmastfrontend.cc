@@ -19,13 +19,29 @@
 
 #include "uhdm/uhdm-version.h" // UHDM_VERSION define
 #include "uhdm/vpi_visitor.h"  // visit_object
+#include "libs/sha1/sha1.h"
 #include "uhdmcommonfrontend.h"
+#include <fstream>
+#include <map>
 
 namespace systemverilog_plugin
 {
 
 using namespace ::Yosys;
 
+// ASTs converted from the files read with -reuse, by filename,
+// together with the hash of the file contents and of the options they were converted with
+static std::map<std::string, std::pair<std::string, AST::AstNode *>> reused_asts;
+
+static std::string get_reuse_hash(const std::string &filename, const UhdmAstShared &shared)
+{
+    SHA1 sha1;
+    sha1.update(stringf("UHDM %d formal %d no_assert %d stop_on_error %d\n", UHDM_VERSION, shared.formal, shared.no_assert, shared.stop_on_error));
+    std::ifstream file(filename, std::ios::binary);
+    sha1.update(file);
+    return sha1.final();
+}
+
 struct UhdmAstFrontend : public UhdmCommonFrontend {
     UhdmAstFrontend() : UhdmCommonFrontend("uhdm", "read UHDM file") {}
     void help() override
@@ -40,32 +56,60 @@ struct UhdmAstFrontend : public UhdmCommonFrontend {
     }
     AST::AstNode *parse(std::string filename) override
     {
+        std::string reuse_hash;
+        if (this->reuse) {
+            if (this->shared.debug_flag || this->report_enabled()) {
+                log_warning("Ignoring -reuse, as -debug and -report need the UHDM database.\n");
+            } else {
+                reuse_hash = get_reuse_hash(filename, this->shared);
+                auto it = reused_asts.find(filename);
+                if (it != reused_asts.end() && it->second.first == reuse_hash) {
+                    log("Reusing the AST of unchanged file `%s'.\n", filename.c_str());
+                    return it->second.second->clone();
+                }
+            }
+        }
+
         UHDM::Serializer serializer;
 
+        this->shared.profile.begin_phase("uhdm_restore");
         std::vector<vpiHandle> restoredDesigns = serializer.Restore(filename);
+        this->shared.profile.end_phase();
+        this->shared.profile.begin_phase("synth_subset");
         UHDM::SynthSubset *synthSubset =
           make_new_object_with_optional_extra_true_arg<UHDM::SynthSubset>(&serializer, this->shared.nonSynthesizableObjects, false);
         synthSubset->listenDesigns(restoredDesigns);
         delete synthSubset;
-        if (this->shared.debug_flag || !this->report_directory.empty()) {
-            for (auto design : restoredDesigns) {
-                std::ofstream null_stream;
+        this->shared.profile.end_phase();
 #if UHDM_VERSION > 1057
-                UHDM::visit_object(design, this->shared.debug_flag ? std::cout : null_stream);
+        // This version of visit_object only prints the design, unhandled objects are collected by UhdmAst
+        this->shared.report.collect_unhandled = this->report_enabled();
+        if (this->shared.debug_flag) {
+            for (auto design : restoredDesigns)
+                UHDM::visit_object(design, std::cout);
+        }
 #else
+        if (this->shared.debug_flag || this->report_enabled()) {
+            for (auto design : restoredDesigns) {
+                std::ofstream null_stream;
                 UHDM::visit_object(design, 1, "", &this->shared.report.unhandled, this->shared.debug_flag ? std::cout : null_stream);
-#endif
             }
         }
+#endif
         UhdmAst uhdm_ast(this->shared);
+        this->shared.profile.begin_phase("uhdm_to_ast");
         AST::AstNode *current_ast = uhdm_ast.visit_designs(restoredDesigns);
-        if (!this->report_directory.empty()) {
-            this->shared.report.write(this->report_directory);
-        }
+        this->shared.profile.end_phase();
+        this->write_report();
         for (auto design : restoredDesigns)
             vpi_release_handle(design);
 
         serializer.Purge();
+        if (!reuse_hash.empty() && current_ast) {
+            auto &reused = reused_asts[filename];
+            delete reused.second;
+            reused = std::make_pair(reuse_hash, current_ast->clone());
+        }
         return current_ast;
     }
     void call_log_header(RTLIL::Design *design) override { log_header(design, "Executing UHDM frontend.\n"); }
@@ -0,0 +1,155 @@
+/*
+ * Copyright 2020-2022 F4PGA Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ */
+
+#include "uhdmastprofile.h"
+#include <algorithm>
+#include <fstream>
+#include <uhdm/vpi_visitor.h>
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+namespace systemverilog_plugin
+{
+
+using namespace ::Yosys;
+
+// Peak resident set size of the process in KiB (0 if not available)
+static long get_peak_rss_kb()
+{
+#ifndef _WIN32
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+#ifdef __APPLE__
+        return usage.ru_maxrss / 1024;
+#else
+        return usage.ru_maxrss;
+#endif
+    }
+#endif
+    return 0;
+}
+
+static std::string quote_json(const std::string &str)
+{
+    std::string quoted = "\"";
+    for (char c : str) {
+        if (c == '"' || c == '\\') {
+            quoted += '\\';
+            quoted += c;
+        } else if ((unsigned char)c < 0x20) {
+            quoted += stringf("\\u%04x", c);
+        } else {
+            quoted += c;
+        }
+    }
+    return quoted + "\"";
+}
+
+void UhdmAstProfile::begin_phase(const std::string &name)
+{
+    if (!enabled)
+        return;
+    auto it = std::find_if(phases.begin(), phases.end(), [&](const Phase &phase) { return phase.name == name; });
+    if (it == phases.end()) {
+        phases.emplace_back();
+        phases.back().name = name;
+        if (!phase_stack.empty())
+            phases.back().parent = phases[phase_stack.back().first].name;
+        it = phases.end() - 1;
+    }
+    phase_stack.emplace_back(it - phases.begin(), clock::now());
+}
+
+void UhdmAstProfile::end_phase()
+{
+    if (!enabled)
+        return;
+    log_assert(!phase_stack.empty());
+    auto &phase = phases[phase_stack.back().first];
+    phase.seconds += std::chrono::duration<double>(clock::now() - phase_stack.back().second).count();
+    phase.peak_rss_kb = get_peak_rss_kb();
+    phase.count++;
+    phase_stack.pop_back();
+}
+
+void UhdmAstProfile::begin_object(int type, vpiHandle obj_h)
+{
+    auto &object_type = object_types[type];
+    if (object_type.name.empty())
+        object_type.name = UHDM::VpiTypeName(obj_h);
+    object_stack.push_back({type, clock::now(), 0.0});
+}
+
+void UhdmAstProfile::end_object()
+{
+    log_assert(!object_stack.empty());
+    const auto frame = object_stack.back();
+    object_stack.pop_back();
+    const double seconds = std::chrono::duration<double>(clock::now() - frame.start).count();
+    auto &object_type = object_types[frame.type];
+    object_type.calls++;
+    object_type.self_seconds += seconds - frame.children_seconds;
+    // Time of recursive conversions of the same type is only counted once
+    if (std::none_of(object_stack.begin(), object_stack.end(), [&](const ObjectFrame &parent) { return parent.type == frame.type; }))
+        object_type.seconds += seconds;
+    if (!object_stack.empty())
+        object_stack.back().children_seconds += seconds;
+}
+
+void UhdmAstProfile::clear()
+{
+    phases.clear();
+    phase_stack.clear();
+    object_types.clear();
+    object_stack.clear();
+}
+
+void UhdmAstProfile::write(const std::string &filename) const
+{
+    std::ofstream file(filename);
+    if (!file)
+        log_error("Cannot open file '%s' for writing!\n", filename.c_str());
+
+    file << "{\n  \"phases\": [\n";
+    for (size_t i = 0; i < phases.size(); ++i) {
+        const auto &phase = phases[i];
+        file << "    {\"name\": " << quote_json(phase.name) << ", \"parent\": " << quote_json(phase.parent) << ", \"count\": " << phase.count
+             << ", \"seconds\": " << stringf("%.6f", phase.seconds) << ", \"peak_rss_kb\": " << phase.peak_rss_kb << "}"
+             << ((i + 1 < phases.size()) ? ",\n" : "\n");
+    }
+
+    // Most expensive object types first
+    std::vector<const ObjectType *> sorted;
+    for (const auto &it : object_types)
+        sorted.push_back(&it.second);
+    std::stable_sort(sorted.begin(), sorted.end(), [](const ObjectType *a, const ObjectType *b) { return a->self_seconds > b->self_seconds; });
+
+    file << "  ],\n  \"objects\": [\n";
+    for (size_t i = 0; i < sorted.size(); ++i) {
+        const auto *object_type = sorted[i];
+        file << "    {\"type\": " << quote_json(object_type->name) << ", \"calls\": " << object_type->calls
+             << ", \"seconds\": " << stringf("%.6f", object_type->seconds) << ", \"self_seconds\": " << stringf("%.6f", object_type->self_seconds)
+             << "}" << ((i + 1 < sorted.size()) ? ",\n" : "\n");
+    }
+    file << "  ]\n}\n";
+}
+
+} // namespace systemverilog_plugin
@@ -0,0 +1,98 @@
+/*
+ * Copyright 2020-2022 F4PGA Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ */
+
+#ifndef _UHDM_AST_PROFILE_H_
+#define _UHDM_AST_PROFILE_H_ 1
+
+#include "kernel/yosys.h"
+#include <chrono>
+#include <map>
+#include <string>
+#include <vector>
+#undef cover
+#include <uhdm/uhdm.h>
+
+namespace systemverilog_plugin
+{
+
+// Time and peak memory of the frontend phases and of the conversion
+// of UHDM objects, per object type, written as JSON
+class UhdmAstProfile
+{
+  private:
+    using clock = std::chrono::steady_clock;
+
+    struct Phase {
+        std::string name;
+        std::string parent;
+        double seconds = 0.0;
+        long peak_rss_kb = 0;
+        unsigned count = 0;
+    };
+
+    struct ObjectType {
+        std::string name;
+        unsigned calls = 0;
+        double seconds = 0.0;
+        double self_seconds = 0.0;
+    };
+
+    // Phases in the order of their first start
+    std::vector<Phase> phases;
+
+    // Stack of started phases (indexes into `phases`) and their start times
+    std::vector<std::pair<size_t, clock::time_point>> phase_stack;
+
+    // Statistics per vpiType
+    std::map<int, ObjectType> object_types;
+
+    // Stack of objects being converted, with their start times and the time spent in their children
+    struct ObjectFrame {
+        int type;
+        clock::time_point start;
+        double children_seconds;
+    };
+    std::vector<ObjectFrame> object_stack;
+
+  public:
+    // Whether statistics are collected
+    bool enabled = false;
+
+    // Starts a phase, phases with the same name are accumulated
+    void begin_phase(const std::string &name);
+
+    // Ends the phase started last
+    void end_phase();
+
+    // Starts the conversion of an object of the specified vpiType
+    void begin_object(int type, vpiHandle obj_h);
+
+    // Ends the conversion of the object started last
+    void end_object();
+
+    // Removes all collected statistics
+    void clear();
+
+    // Writes the statistics to the specified JSON file
+    void write(const std::string &filename) const;
+};
+
+} // namespace systemverilog_plugin
+
+#endif
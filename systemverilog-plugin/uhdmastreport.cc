@@ -1,7 +1,11 @@
 #include "uhdmastreport.h"
 #include "frontends/ast/ast.h"
+#include <algorithm>
+#include <atomic>
 #include <fstream>
+#include <sstream>
 #include <sys/stat.h>
+#include <thread>
 #include <uhdm/BaseClass.h>
 #include <unordered_set>
 
@@ -10,12 +14,19 @@ namespace systemverilog_plugin
 
 using namespace ::Yosys;
 
+void UhdmAstReport::mark_visited(const UHDM::BaseClass *object)
+{
+    if (!handled.count(object))
+        unhandled.insert(object);
+}
+
 void UhdmAstReport::mark_handled(const UHDM::BaseClass *object)
 {
     handled_count_per_file.insert(std::make_pair(object->VpiFile(), 0));
     auto it = unhandled.find(object);
     if (it != unhandled.end()) {
         unhandled.erase(it);
+        handled.insert(object);
         handled_count_per_file.at(std::string(object->VpiFile()))++;
     }
 }
@@ -37,54 +48,153 @@ static std::string replace_in_string(std::string str, const std::string &to_find
     return str;
 }
 
-void UhdmAstReport::write(const std::string &directory)
+static float get_coverage(unsigned handled_count, unsigned unhandled_count)
+{
+    if (handled_count + unhandled_count == 0)
+        return 100.f;
+    return handled_count * 100.f / (handled_count + unhandled_count);
+}
+
+std::vector<UhdmAstReport::FileCoverage> UhdmAstReport::get_coverage_per_file(float &coverage)
 {
     std::unordered_map<std::string, std::unordered_set<unsigned>> unhandled_per_file;
     for (auto object : unhandled) {
         if (!object->VpiFile().empty() && object->VpiFile() != AST::current_filename) {
-            unhandled_per_file.insert(std::make_pair(object->VpiFile(), std::unordered_set<unsigned>()));
-            unhandled_per_file.at(std::string(object->VpiFile())).insert(object->VpiLineNo());
+            unhandled_per_file[std::string(object->VpiFile())].insert(object->VpiLineNo());
             handled_count_per_file.insert(std::make_pair(object->VpiFile(), 0));
         }
     }
     unsigned total_handled = 0;
+    std::vector<FileCoverage> files;
     for (auto &hc : handled_count_per_file) {
         if (!hc.first.empty() && hc.first != AST::current_filename) {
-            unhandled_per_file.insert(std::make_pair(hc.first, std::unordered_set<unsigned>()));
             total_handled += hc.second;
+            files.emplace_back();
+            auto &file = files.back();
+            file.filename = hc.first;
+            file.handled_count = hc.second;
+            auto it = unhandled_per_file.find(hc.first);
+            if (it != unhandled_per_file.end())
+                file.unhandled_lines = std::move(it->second);
+            file.coverage = get_coverage(file.handled_count, file.unhandled_lines.size());
+        }
+    }
+    std::sort(files.begin(), files.end(), [](const FileCoverage &a, const FileCoverage &b) { return a.filename < b.filename; });
+    coverage = get_coverage(total_handled, unhandled.size());
+    return files;
+}
+
+static std::string get_report_filename(const std::string &filename) { return replace_in_string(filename, "/", ".") + ".html"; }
+
+// Writes the annotated source of a single file, the whole report is built in memory and written at once
+static void write_file_report(const std::string &directory, const std::string &filename, const std::unordered_set<unsigned> &unhandled_lines,
+                              float coverage)
+{
+    std::ostringstream report;
+    report << "<!DOCTYPE html>\n<html>\n<head>\n<style>\nbody{font-size:12px;}pre{display:inline}</style>\n</head><body>\n";
+    report << "<h2>" << filename << " | Coverage: " << coverage << "%</h2>\n";
+    std::ifstream source_file(filename); // Read the source code
+    unsigned line_number = 1;
+    std::string line;
+    while (std::getline(source_file, line)) {
+        if (unhandled_lines.find(line_number) == unhandled_lines.end()) {
+            report << line_number << "<pre> " << line << "</pre><br>\n";
+        } else {
+            report << line_number << "<pre style=\"background-color: #FFB6C1;\"> " << line << "</pre><br>\n";
         }
+        ++line_number;
     }
-    float coverage = total_handled * 100.f / (total_handled + unhandled.size());
+    report << "</body>\n</html>\n";
+    std::ofstream report_file(directory + '/' + get_report_filename(filename));
+    report_file << report.str();
+}
+
+void UhdmAstReport::write(const std::string &directory)
+{
+    float coverage;
+    const auto files = get_coverage_per_file(coverage);
     mkdir(directory.c_str(), 0777);
+    std::ostringstream index;
+    index << "<!DOCTYPE html>\n<html>\n<head>\n<style>h3{margin:0;padding:10}</style>\n</head><body>\n";
+    index << "<h2>Overall coverage: " << coverage << "%</h2>\n";
+    for (auto &file : files) {
+        index << "<h3>Cov: " << file.coverage << "%<a href=\"" << get_report_filename(file.filename) << "\">" << file.filename << "</a></h3><br>\n";
+    }
+    index << "</body>\n</html>\n";
     std::ofstream index_file(directory + "/index.html");
-    index_file << "<!DOCTYPE html>\n<html>\n<head>\n<style>h3{margin:0;padding:10}</style>\n</head><body>" << std::endl;
-    index_file << "<h2>Overall coverage: " << coverage << "%</h2>" << std::endl;
-    for (auto &unhandled_in_file : unhandled_per_file) {
-        // Calculate coverage in file
-        unsigned handled_count = handled_count_per_file.at(unhandled_in_file.first);
-        unsigned unhandled_count = unhandled_in_file.second.size();
-        float coverage = handled_count * 100.f / (handled_count + unhandled_count);
-        // Add to the index file
-        std::string report_filename = replace_in_string(unhandled_in_file.first, "/", ".") + ".html";
-        index_file << "<h3>Cov: " << coverage << "%<a href=\"" << report_filename << "\">" << unhandled_in_file.first << "</a></h3><br>" << std::endl;
-        // Write the report file
-        std::ofstream report_file(directory + '/' + report_filename);
-        report_file << "<!DOCTYPE html>\n<html>\n<head>\n<style>\nbody{font-size:12px;}pre{display:inline}</style>\n</head><body>" << std::endl;
-        report_file << "<h2>" << unhandled_in_file.first << " | Coverage: " << coverage << "%</h2>" << std::endl;
-        std::ifstream source_file(unhandled_in_file.first); // Read the source code
-        unsigned line_number = 1;
-        std::string line;
-        while (std::getline(source_file, line)) {
-            if (unhandled_in_file.second.find(line_number) == unhandled_in_file.second.end()) {
-                report_file << line_number << "<pre> " << line << "</pre><br>" << std::endl;
-            } else {
-                report_file << line_number << "<pre style=\"background-color: #FFB6C1;\"> " << line << "</pre><br>" << std::endl;
-            }
-            ++line_number;
+    index_file << index.str();
+
+    // The file reports only read the source files and the data computed above,
+    // so they are written in parallel
+    std::atomic<size_t> next_file(0);
+    auto worker = [&]() {
+        for (size_t i = next_file++; i < files.size(); i = next_file++) {
+            write_file_report(directory, files[i].filename, files[i].unhandled_lines, files[i].coverage);
+        }
+    };
+    size_t num_threads = std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()), files.size());
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < num_threads; i++) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto &thread : threads) {
+        thread.join();
+    }
+}
+
+static std::string quote_json(const std::string &str)
+{
+    std::string quoted = "\"";
+    for (char c : str) {
+        if (c == '"' || c == '\\') {
+            quoted += '\\';
+            quoted += c;
+        } else if ((unsigned char)c < 0x20) {
+            quoted += stringf("\\u%04x", c);
+        } else {
+            quoted += c;
+        }
+    }
+    return quoted + "\"";
+}
+
+static std::string quote_csv(const std::string &str)
+{
+    if (str.find_first_of(",\"\n") == std::string::npos)
+        return str;
+    std::string quoted = "\"";
+    for (char c : str) {
+        if (c == '"')
+            quoted += '"';
+        quoted += c;
+    }
+    return quoted + "\"";
+}
+
+void UhdmAstReport::write_summary(const std::string &filename)
+{
+    float coverage;
+    const auto files = get_coverage_per_file(coverage);
+    std::ofstream file(filename);
+    if (!file) {
+        log_error("Cannot open file '%s' for writing!\n", filename.c_str());
+    }
+    bool csv = filename.size() >= 4 && filename.compare(filename.size() - 4, 4, ".csv") == 0;
+    if (csv) {
+        file << "file,handled,unhandled_lines,coverage\n";
+        for (auto &f : files) {
+            file << quote_csv(f.filename) << "," << f.handled_count << "," << f.unhandled_lines.size() << "," << stringf("%.2f", f.coverage) << "\n";
         }
-        report_file << "</body>\n</html>" << std::endl;
+        return;
+    }
+    file << "{\n  \"coverage\": " << stringf("%.2f", coverage) << ",\n  \"unhandled\": " << unhandled.size() << ",\n  \"files\": [\n";
+    for (size_t i = 0; i < files.size(); i++) {
+        auto &f = files[i];
+        file << "    {\"file\": " << quote_json(f.filename) << ", \"handled\": " << f.handled_count << ", \"unhandled_lines\": " << f.unhandled_lines.size()
+             << ", \"coverage\": " << stringf("%.2f", f.coverage) << "}" << ((i + 1 < files.size()) ? ",\n" : "\n");
     }
-    index_file << "</body>\n</html>" << std::endl;
+    file << "  ]\n}\n";
 }
 
 } // namespace systemverilog_plugin
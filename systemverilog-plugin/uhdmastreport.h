@@ -5,6 +5,8 @@
 #include <map>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
+#include <vector>
 #undef cover
 #include <uhdm/uhdm.h>
 
@@ -17,10 +19,31 @@ class UhdmAstReport
     // Maps a filename to the number of objects being handled by the frontend
     std::unordered_map<std::string, unsigned> handled_count_per_file;
 
+    // Objects already counted as handled
+    std::unordered_set<const UHDM::BaseClass *> handled;
+
+    struct FileCoverage {
+        std::string filename;
+        unsigned handled_count = 0;
+        std::unordered_set<unsigned> unhandled_lines;
+        float coverage = 0.f;
+    };
+
+    // Computes the coverage of each source file, sorted by filename, and the overall coverage
+    std::vector<FileCoverage> get_coverage_per_file(float &coverage);
+
   public:
     // Objects not being handled by the frontend
     std::set<const UHDM::BaseClass *> unhandled;
 
+    // Collect the unhandled objects while the design is converted,
+    // instead of filling `unhandled` with a separate UHDM::visit_object walk
+    bool collect_unhandled = false;
+
+    // Marks the specified object as visited by the frontend,
+    // it stays unhandled until it is marked as handled
+    void mark_visited(const UHDM::BaseClass *object);
+
     // Marks the specified object as being handled by the frontend
     void mark_handled(const UHDM::BaseClass *object);
 
@@ -29,6 +52,10 @@ class UhdmAstReport
 
     // Write the coverage report to the specified path
     void write(const std::string &directory);
+
+    // Write only the coverage of each source file to the specified file,
+    // as CSV if the filename ends with ".csv" and as JSON otherwise
+    void write_summary(const std::string &filename);
 };
 
 } // namespace systemverilog_plugin
@@ -3,6 +3,7 @@
 
 #include "frontends/ast/ast.h"
 
+#include "uhdmastprofile.h"
 #include "uhdmastreport.h"
 #include <string>
 #include <unordered_map>
@@ -72,6 +73,10 @@ class UhdmAstShared
     // applies only to read_systemverilog command
     bool link = false;
 
+    // Flag that determines whether we should only queue the sources for the next link
+    // applies only to read_systemverilog command
+    bool batch = false;
+
     // Flag equivalent to read_verilog -formal
     // Defines FORMAL, undefines SYNTHESIS
     // Allows verification constructs in Surelog
@@ -83,6 +88,9 @@ class UhdmAstShared
     // UHDM node coverage report
     UhdmAstReport report;
 
+    // Frontend time and memory profile
+    UhdmAstProfile profile;
+
     // Map from AST param nodes to their types (used for params with struct types)
     std::unordered_map<std::string, ::Yosys::AST::AstNode *> param_types;
 
@@ -93,6 +101,11 @@ class UhdmAstShared
 
     // Map of anonymous enum types to generated typedefs
     std::unordered_map<const UHDM::enum_typespec *, std::string> anonymous_enums;
+
+    // Sanitized names of the UHDM objects already visited
+    // (`object_full_names` holds the names created with the full name preferred)
+    std::unordered_map<const UHDM::BaseClass *, std::string> object_names;
+    std::unordered_map<const UHDM::BaseClass *, std::string> object_full_names;
 };
 
 } // namespace systemverilog_plugin
@@ -19,11 +19,26 @@
 
 #include "uhdmcommonfrontend.h"
 
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
 namespace systemverilog_plugin
 {
 
 using namespace ::Yosys;
 
+// Return the heap memory freed by the UHDM database and the AST to the operating system.
+// Without it the pages stay in the resident set for the rest of the synthesis flow.
+// The UHDM objects can only be freed all at once: they are owned by the factories of
+// the Serializer, which has no way of releasing a single subtree.
+static void trim_heap()
+{
+#if defined(__GLIBC__)
+    malloc_trim(0);
+#endif
+}
+
 /* Stub for AST::process */
 static void set_line_num(int) {}
 
@@ -59,6 +74,11 @@ void UhdmCommonFrontend::print_read_options()
     log("    -report [directory]\n");
     log("        write a coverage report for the UHDM file\n");
     log("\n");
+    log("    -report_summary <file>\n");
+    log("        write only the coverage of each source file to the given file, as CSV\n");
+    log("        if its name ends with .csv and as JSON otherwise. Unlike -report\n");
+    log("        it doesn't annotate the sources and keeps errors fatal.\n");
+    log("\n");
     log("    -defer\n");
     log("        only read the abstract syntax tree and defer actual compilation\n");
     log("        to a later 'hierarchy' command. Useful in cases where the default\n");
@@ -68,23 +88,78 @@ void UhdmCommonFrontend::print_read_options()
     log("\n");
     log("    -link\n");
     log("        performs linking and elaboration of the files read with -defer\n");
+    log("        or compiles and elaborates the files queued with -batch\n");
+    log("\n");
+    log("    -batch\n");
+    log("        this parameter only applies to read_systemverilog command,\n");
+    log("        it only queues the files and options, which are compiled by a single\n");
+    log("        Surelog run on the next read_systemverilog -link. Unlike -defer, the\n");
+    log("        queued files are compiled together, so Surelog is started once for\n");
+    log("        all of them (see also -threads). The global defaults and defines\n");
+    log("        in effect when -link is called apply to all queued files.\n");
     log("\n");
     log("    -parse-only\n");
     log("        this parameter only applies to read_systemverilog command,\n");
     log("        it runs only Surelog to parse design, but doesn't load generated\n");
     log("        tree into Yosys.\n");
     log("\n");
+    log("    -threads <N>\n");
+    log("        this parameter only applies to read_systemverilog command,\n");
+    log("        it lets Surelog parse and compile the design using N threads.\n");
+    log("        0 uses one thread per hardware thread. Only Surelog is threaded,\n");
+    log("        the conversion of the resulting UHDM tree into the Yosys AST and\n");
+    log("        the AST processing always run serially.\n");
+    log("\n");
+    log("    -uhdm_cache <directory>\n");
+    log("        this parameter only applies to read_systemverilog command,\n");
+    log("        it stores the elaborated UHDM database in the given directory, keyed\n");
+    log("        by a hash of the arguments and of the contents of the source files,\n");
+    log("        of the files they `include, also through other included files, and\n");
+    log("        of the files in the include directories. A later run with the same\n");
+    log("        inputs reads the database from the cache instead of running Surelog.\n");
+    log("        Files listed in -f files and includes named by a macro that are not\n");
+    log("        directly in an include directory are not part of the key.\n");
+    log("        Not used together with -defer, -link or -parse-only.\n");
+    log("\n");
+    log("    -reuse\n");
+    log("        this parameter only applies to read_uhdm command,\n");
+    log("        it keeps the AST converted from the file in memory, and a later\n");
+    log("        read_uhdm -reuse of the same file with the same contents and options\n");
+    log("        in the same session uses a copy of it instead of restoring and\n");
+    log("        converting the UHDM database again. Ignored with -debug and -report.\n");
+    log("\n");
+    log("    -profile <file>\n");
+    log("        write the time and peak memory of the frontend phases (Surelog,\n");
+    log("        SynthSubset, UHDM to AST conversion, simplify_sv and AST::process)\n");
+    log("        and the number of conversions and the time spent per UHDM object\n");
+    log("        type to the given JSON file\n");
+    log("\n");
     log("    -formal\n");
     log("        enable support for SystemVerilog assertions and some Yosys extensions\n");
     log("        replace the implicit -D SYNTHESIS with -D FORMAL\n");
     log("\n");
 }
 
+void UhdmCommonFrontend::write_report()
+{
+    if (!this->report_directory.empty()) {
+        this->shared.report.write(this->report_directory);
+    }
+    if (!this->report_summary_file.empty()) {
+        this->shared.report.write_summary(this->report_summary_file);
+    }
+}
+
 void UhdmCommonFrontend::execute(std::istream *&f, std::string filename, std::vector<std::string> args, RTLIL::Design *design)
 {
     this->call_log_header(design);
     this->args = args;
 
+    this->cache_directory.clear();
+    this->report_summary_file.clear();
+    this->reuse = false;
+    this->shared.batch = false;
+
     bool defer = false;
     bool dump_ast1 = false;
     bool dump_ast2 = false;
@@ -92,6 +167,7 @@ void UhdmCommonFrontend::execute(std::istream *&f, std::string filename, std::ve
     bool dump_vlog2 = false;
     bool no_dump_ptr = false;
     bool dump_rtlil = false;
+    std::string profile_file;
     std::vector<std::string> unhandled_args;
 
     for (size_t i = 0; i < args.size(); i++) {
@@ -104,10 +180,20 @@ void UhdmCommonFrontend::execute(std::istream *&f, std::string filename, std::ve
         } else if (args[i] == "-report" && ++i < args.size()) {
             this->report_directory = args[i];
             this->shared.stop_on_error = false;
+        } else if (args[i] == "-report_summary" && ++i < args.size()) {
+            this->report_summary_file = args[i];
+        } else if (args[i] == "-profile" && ++i < args.size()) {
+            profile_file = args[i];
+        } else if (args[i] == "-uhdm_cache" && ++i < args.size()) {
+            this->cache_directory = args[i];
+        } else if (args[i] == "-reuse") {
+            this->reuse = true;
         } else if (args[i] == "-noassert") {
             this->shared.no_assert = true;
         } else if (args[i] == "-defer") {
             this->shared.defer = true;
+        } else if (args[i] == "-batch") {
+            this->shared.batch = true;
         } else if (args[i] == "-dump_ast1") {
             dump_ast1 = true;
         } else if (args[i] == "-dump_ast2") {
@@ -126,6 +212,13 @@ void UhdmCommonFrontend::execute(std::istream *&f, std::string filename, std::ve
             this->shared.link = true;
             // Surelog needs it in the command line to link correctly
             unhandled_args.push_back(args[i]);
+        } else if (args[i] == "-threads" && ++i < args.size()) {
+            if (args[i].empty() || args[i].find_first_not_of("0123456789") != std::string::npos)
+                log_cmd_error("Invalid number of threads: '%s'\n", args[i].c_str());
+            int threads = atoi(args[i].c_str());
+            // Surelog takes the thread count through its -mt option
+            unhandled_args.push_back("-mt");
+            unhandled_args.push_back(threads == 0 ? std::string("max") : std::to_string(threads));
         } else if (args[i] == "-formal") {
             this->shared.formal = true;
             // Surelog needs it in the command line to annotate UHDM
@@ -151,12 +244,26 @@ void UhdmCommonFrontend::execute(std::istream *&f, std::string filename, std::ve
     bool dont_redefine = false;
     bool default_nettype_wire = true;
 
+    this->shared.profile.clear();
+    this->shared.profile.enabled = !profile_file.empty();
+
     AST::AstNode *current_ast = parse(filename);
+    // The UHDM database has been released by `parse`
+    trim_heap();
 
     if (current_ast) {
+        this->shared.profile.begin_phase("ast_process");
         AST::process(design, current_ast, dump_ast1, dump_ast2, no_dump_ptr, dump_vlog1, dump_vlog2, dump_rtlil, false, false, false, false, false,
                      false, false, false, false, false, dont_redefine, false, defer, default_nettype_wire);
         delete current_ast;
+        trim_heap();
+        this->shared.profile.end_phase();
+    }
+
+    if (!profile_file.empty()) {
+        this->shared.profile.write(profile_file);
+        this->shared.profile.clear();
+        this->shared.profile.enabled = false;
     }
 }
 
@@ -49,12 +49,17 @@ static inline ObjT *make_new_object_with_optional_extra_true_arg(ArgN &&... arg_
 struct UhdmCommonFrontend : public ::Yosys::Frontend {
     UhdmAstShared shared;
     std::string report_directory;
+    std::string report_summary_file;
+    std::string cache_directory;
+    bool reuse = false;
     std::vector<std::string> args;
     UhdmCommonFrontend(std::string name, std::string short_help) : Frontend(name, short_help) {}
     virtual void print_read_options();
     virtual void help() = 0;
     virtual ::Yosys::AST::AstNode *parse(std::string filename) = 0;
     virtual void call_log_header(::Yosys::RTLIL::Design *design) = 0;
+    bool report_enabled() const { return !report_directory.empty() || !report_summary_file.empty(); }
+    void write_report();
     void execute(std::istream *&f, std::string filename, std::vector<std::string> args, ::Yosys::RTLIL::Design *design);
 };
 
@@ -29,7 +29,10 @@
 #include <sys/param.h>
 #include <unistd.h>
 #endif
+#include <algorithm>
+#include <filesystem>
 #include <memory>
+#include <set>
 
 #include <list>
 
@@ -37,6 +40,7 @@
 #include "Surelog/CommandLine/CommandLineParser.h"
 #include "Surelog/ErrorReporting/ErrorContainer.h"
 #include "Surelog/SourceCompile/SymbolTable.h"
+#include "libs/sha1/sha1.h"
 #include "uhdm/uhdm-version.h" // UHDM_VERSION define
 #include "uhdm/vpi_visitor.h"  // visit_object
 
@@ -52,6 +56,10 @@ static std::list<std::vector<std::string>> systemverilog_defaults_stack;
 // Store global definitions for top-level defines
 static std::vector<std::string> systemverilog_defines;
 
+// Store sources and options queued with read_systemverilog -batch,
+// they are compiled together by the next read_systemverilog -link
+static std::vector<std::string> systemverilog_batch;
+
 // SURELOG::scompiler wrapper.
 // Owns UHDM/VPI resources used by designs returned from `execute`
 class Compiler
@@ -113,6 +121,100 @@ class Compiler
     std::vector<vpiHandle> designs = {};
 };
 
+// Adds the files pulled in by `include "file" lines of a source file, and theirs, to `closure`.
+// Every place Surelog may resolve an include to is taken: the name as given, next to the including
+// file and in each include directory, so the set errs on the side of too many files. Includes whose
+// name comes from a macro are not seen.
+static void add_include_closure(const std::filesystem::path &file, const std::vector<std::filesystem::path> &include_dirs,
+                                std::set<std::filesystem::path> &closure)
+{
+    namespace fs = std::filesystem;
+    std::error_code ec;
+    std::ifstream stream(file);
+    std::string line;
+    while (std::getline(stream, line)) {
+        const size_t pos = line.find("`include");
+        const size_t first = pos == std::string::npos ? pos : line.find('"', pos);
+        const size_t last = first == std::string::npos ? first : line.find('"', first + 1);
+        if (last == std::string::npos)
+            continue;
+
+        const fs::path name = line.substr(first + 1, last - first - 1);
+        std::vector<fs::path> candidates = {name};
+        if (name.is_relative()) {
+            candidates.push_back(file.parent_path() / name);
+            for (const auto &dir : include_dirs)
+                candidates.push_back(dir / name);
+        }
+        for (const auto &candidate : candidates) {
+            if (fs::is_regular_file(candidate, ec) && closure.insert(candidate.lexically_normal()).second)
+                add_include_closure(candidate, include_dirs, closure);
+        }
+    }
+}
+
+// Returns the path of the cached UHDM database for the given Surelog arguments.
+// The key covers the arguments themselves, the contents of the files named in them, of the files
+// they include, directly or through other includes, and of the files found directly in the include
+// directories, which also covers most includes named by a macro.
+static std::string get_uhdm_cache_file(const std::string &cache_directory, const std::vector<const char *> &cstrings)
+{
+    namespace fs = std::filesystem;
+    std::error_code ec;
+    SHA1 sha1;
+    sha1.update(stringf("UHDM %d\n", UHDM_VERSION));
+    auto hash_file = [&](const fs::path &path) {
+        std::ifstream file(path, std::ios::binary);
+        sha1.update(path.string() + "\n");
+        sha1.update(file);
+    };
+    std::vector<fs::path> include_dirs;
+    std::vector<fs::path> sources;
+    for (auto cstring : cstrings) {
+        std::string arg = cstring;
+        sha1.update(arg + "\n");
+        if (arg.compare(0, 2, "-I") == 0) {
+            include_dirs.push_back(arg.substr(2));
+            std::vector<fs::path> headers;
+            for (const auto &entry : fs::directory_iterator(arg.substr(2), ec)) {
+                if (entry.is_regular_file(ec))
+                    headers.push_back(entry.path());
+            }
+            std::sort(headers.begin(), headers.end());
+            for (const auto &header : headers)
+                hash_file(header);
+        } else if (!arg.empty() && arg[0] != '-' && fs::is_regular_file(arg, ec)) {
+            hash_file(arg);
+            sources.push_back(arg);
+        }
+    }
+    // Include directories may follow the sources on the command line, so the includes are resolved afterwards
+    std::set<fs::path> closure;
+    for (const auto &source : sources)
+        add_include_closure(source, include_dirs, closure);
+    for (const auto &include : closure)
+        hash_file(include);
+    return cache_directory + "/" + sha1.final() + ".uhdm";
+}
+
+// Stores the UHDM database owning the given design in the cache.
+static void save_uhdm_cache_file(const std::string &cache_directory, const std::string &cache_file, vpiHandle design)
+{
+    namespace fs = std::filesystem;
+    std::error_code ec;
+    fs::create_directories(cache_directory, ec);
+    const uhdm_handle *const handle = (const uhdm_handle *)design;
+    const UHDM::BaseClass *const object = (const UHDM::BaseClass *)handle->object;
+    // Write to a temporary file first, so an interrupted run never leaves a truncated database behind
+    const std::string tmp_file = cache_file + ".tmp";
+    object->GetSerializer()->Save(tmp_file);
+    fs::rename(tmp_file, cache_file, ec);
+    if (ec) {
+        log_warning("Could not store UHDM database in cache `%s': %s\n", cache_file.c_str(), ec.message().c_str());
+        fs::remove(tmp_file, ec);
+    }
+}
+
 struct UhdmSurelogAstFrontend : public UhdmCommonFrontend {
     UhdmSurelogAstFrontend(std::string name, std::string short_help) : UhdmCommonFrontend(name, short_help) {}
     UhdmSurelogAstFrontend() : UhdmCommonFrontend("verilog_with_uhdm", "generate/read UHDM file") {}
@@ -130,6 +232,25 @@ struct UhdmSurelogAstFrontend : public UhdmCommonFrontend {
 
     AST::AstNode *parse(std::string filename) override
     {
+        if (this->shared.batch) {
+            // Skip the command name, and the include paths and defines already queued
+            for (size_t i = 1; i < this->args.size(); ++i) {
+                const auto &arg = this->args[i];
+                bool is_path_or_define = arg.compare(0, 2, "-I") == 0 || arg.compare(0, 2, "-D") == 0;
+                if (is_path_or_define && std::find(systemverilog_batch.begin(), systemverilog_batch.end(), arg) != systemverilog_batch.end())
+                    continue;
+                systemverilog_batch.push_back(arg);
+            }
+            log("Queued %zu arguments, compilation is deferred to read_systemverilog -link.\n", this->args.size() - 1);
+            return nullptr;
+        }
+
+        // Sources queued with -batch are compiled by a single Surelog run, not linked
+        std::vector<std::string> batch;
+        if (this->shared.link)
+            batch.swap(systemverilog_batch);
+        const bool batch_link = !batch.empty();
+
         std::vector<const char *> cstrings;
         bool link = false;
         if (this->shared.formal) {
@@ -137,12 +258,17 @@ struct UhdmSurelogAstFrontend : public UhdmCommonFrontend {
         } else {
             systemverilog_defines.push_back("-DSYNTHESIS=1");
         }
-        cstrings.reserve(this->args.size() + systemverilog_defaults.size() + systemverilog_defines.size());
+        cstrings.reserve(this->args.size() + batch.size() + systemverilog_defaults.size() + systemverilog_defines.size());
         for (size_t i = 0; i < this->args.size(); ++i) {
-            cstrings.push_back(const_cast<char *>(this->args[i].c_str()));
-            if (this->args[i] == "-link")
+            if (this->args[i] == "-link") {
+                if (batch_link)
+                    continue;
                 link = true;
+            }
+            cstrings.push_back(const_cast<char *>(this->args[i].c_str()));
         }
+        for (const auto &arg : batch)
+            cstrings.push_back(const_cast<char *>(arg.c_str()));
 
         if (!link) {
             // Add systemverilog defaults args
@@ -173,7 +299,7 @@ struct UhdmSurelogAstFrontend : public UhdmCommonFrontend {
         clp->fullSVMode(true);
         clp->setCacheAllowed(true);
         clp->setReportNonSynthesizable(true);
-        if (this->shared.defer) {
+        if (this->shared.defer && !batch_link) {
             clp->setCompile(false);
             clp->setElaborate(false);
             clp->setSepComp(true);
@@ -181,23 +307,49 @@ struct UhdmSurelogAstFrontend : public UhdmCommonFrontend {
             clp->setCompile(true);
             clp->setElaborate(true);
         }
-        if (this->shared.link) {
+        if (this->shared.link && !batch_link) {
             clp->setLink(true);
         }
 
+        // The cache holds elaborated designs only
+        std::string cache_file;
+        if (!this->cache_directory.empty() && !this->shared.defer && !this->shared.link && !this->shared.parse_only)
+            cache_file = get_uhdm_cache_file(this->cache_directory, cstrings);
+
         Compiler compiler;
-        const auto &uhdm_designs = compiler.execute(std::move(errors), std::move(clp));
+        UHDM::Serializer cache_serializer;
+        std::vector<vpiHandle> uhdm_designs;
+        bool from_cache = !cache_file.empty() && check_file_exists(cache_file);
+        if (from_cache) {
+            log("Reading cached UHDM database `%s'.\n", cache_file.c_str());
+            this->shared.profile.begin_phase("uhdm_restore");
+            uhdm_designs = cache_serializer.Restore(cache_file);
+            this->shared.profile.end_phase();
+        } else {
+            this->shared.profile.begin_phase("surelog");
+            uhdm_designs = compiler.execute(std::move(errors), std::move(clp));
+            this->shared.profile.end_phase();
+            if (!cache_file.empty() && !uhdm_designs.empty() && uhdm_designs[0]) {
+                log("Storing UHDM database in cache `%s'.\n", cache_file.c_str());
+                save_uhdm_cache_file(this->cache_directory, cache_file, uhdm_designs[0]);
+            }
+        }
 
-        if (this->shared.debug_flag || !this->report_directory.empty()) {
-            for (auto design : uhdm_designs) {
-                std::ofstream null_stream;
 #if UHDM_VERSION > 1057
-                UHDM::visit_object(design, this->shared.debug_flag ? std::cout : null_stream);
+        // This version of visit_object only prints the design, unhandled objects are collected by UhdmAst
+        this->shared.report.collect_unhandled = this->report_enabled();
+        if (this->shared.debug_flag) {
+            for (auto design : uhdm_designs)
+                UHDM::visit_object(design, std::cout);
+        }
 #else
+        if (this->shared.debug_flag || this->report_enabled()) {
+            for (auto design : uhdm_designs) {
+                std::ofstream null_stream;
                 UHDM::visit_object(design, 1, "", &this->shared.report.unhandled, this->shared.debug_flag ? std::cout : null_stream);
-#endif
             }
         }
+#endif
 
         // on parse_only mode, don't try to load design
         // into yosys
@@ -210,18 +362,27 @@ struct UhdmSurelogAstFrontend : public UhdmCommonFrontend {
         // FIXME: SynthSubset annotation is incompatible with separate compilation
         // `-defer` turns elaboration off, so check for it
         // Should be called 1. for normal flow 2. after finishing with `-link`
-        if (!this->shared.defer) {
+        // 3. after compiling sources queued with `-batch`
+        if (!this->shared.defer || batch_link) {
             UHDM::Serializer serializer;
             UHDM::SynthSubset *synthSubset =
               make_new_object_with_optional_extra_true_arg<UHDM::SynthSubset>(&serializer, this->shared.nonSynthesizableObjects, false);
+            this->shared.profile.begin_phase("synth_subset");
             synthSubset->listenDesigns(uhdm_designs);
             delete synthSubset;
+            this->shared.profile.end_phase();
         }
 
         UhdmAst uhdm_ast(this->shared);
+        this->shared.profile.begin_phase("uhdm_to_ast");
         AST::AstNode *current_ast = uhdm_ast.visit_designs(uhdm_designs);
-        if (!this->report_directory.empty()) {
-            this->shared.report.write(this->report_directory);
+        this->shared.profile.end_phase();
+        this->write_report();
+
+        if (from_cache) {
+            for (auto design : uhdm_designs)
+                vpi_release_handle(design);
+            cache_serializer.Purge();
         }
 
         // FIXME: Check and reset remaining shared data
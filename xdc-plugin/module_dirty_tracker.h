@@ -0,0 +1,109 @@
+/*
+ * Copyright 2020-2022 F4PGA Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ */
+#ifndef _MODULE_DIRTY_TRACKER_H_
+#define _MODULE_DIRTY_TRACKER_H_
+
+#include "kernel/rtlil.h"
+
+#include <vector>
+
+USING_YOSYS_NAMESPACE
+
+/// Tracks which modules of a design changed, through the RTLIL::Monitor
+/// interface, so that the IO cell index of the XDC commands can be kept
+/// between commands. Only a dirty flag per module is kept, the individual
+/// changes are not recorded.
+///
+/// A module is clean once markClean() was called for it and stays clean until
+/// a connection of the module or of one of its cells changes, or the module
+/// is removed or blacked out. Adding and removing cells goes through their
+/// port connections and is seen as well. Passes that edit 'connections_'
+/// directly or add unconnected objects bypass the monitors, so the number of
+/// cells, wires and connections is also compared against the state recorded
+/// by markClean().
+class ModuleDirtyTracker : public RTLIL::Monitor
+{
+  public:
+    /// Starts monitoring a design, all modules are dirty until marked clean
+    void attach(RTLIL::Design *a_Design)
+    {
+        detach();
+        m_Design = a_Design;
+        m_Design->monitors.insert(this);
+    }
+
+    /// Stops monitoring, must be called while the design still exists. The
+    /// destructor does not detach since a tracker may outlive its design.
+    void detach()
+    {
+        if (m_Design != nullptr) {
+            m_Design->monitors.erase(this);
+            m_Design = nullptr;
+        }
+        reset();
+    }
+
+    RTLIL::Design *design() const { return m_Design; }
+
+    /// Forgets all clean modules
+    void reset() { m_Clean.clear(); }
+
+    /// Returns true if the module changed since it was last marked clean
+    bool isDirty(const RTLIL::Module *a_Module) const
+    {
+        auto it = m_Clean.find(const_cast<RTLIL::Module *>(a_Module));
+        return it == m_Clean.end() || !(it->second == Snapshot(a_Module));
+    }
+
+    /// Marks a module as clean, to be called after the index of the module
+    /// was brought up to date
+    void markClean(RTLIL::Module *a_Module) { m_Clean[a_Module] = Snapshot(a_Module); }
+
+    void notify_module_add(RTLIL::Module *a_Module) override { m_Clean.erase(a_Module); }
+    void notify_module_del(RTLIL::Module *a_Module) override { m_Clean.erase(a_Module); }
+    void notify_blackout(RTLIL::Module *a_Module) override { m_Clean.erase(a_Module); }
+
+    void notify_connect(RTLIL::Cell *a_Cell, const RTLIL::IdString &, const RTLIL::SigSpec &, const RTLIL::SigSpec &) override
+    {
+        m_Clean.erase(a_Cell->module);
+    }
+    void notify_connect(RTLIL::Module *a_Module, const RTLIL::SigSig &) override { m_Clean.erase(a_Module); }
+    void notify_connect(RTLIL::Module *a_Module, const std::vector<RTLIL::SigSig> &) override { m_Clean.erase(a_Module); }
+
+  private:
+    /// Object counts of a module when it was marked clean
+    struct Snapshot {
+        size_t cells;
+        size_t wires;
+        size_t connections;
+
+        explicit Snapshot(const RTLIL::Module *a_Module = nullptr)
+            : cells(a_Module ? a_Module->cells_.size() : 0), wires(a_Module ? a_Module->wires_.size() : 0),
+              connections(a_Module ? a_Module->connections_.size() : 0)
+        {
+        }
+
+        bool operator==(const Snapshot &ref) const { return cells == ref.cells && wires == ref.wires && connections == ref.connections; }
+    };
+
+    RTLIL::Design *m_Design = nullptr;
+    dict<RTLIL::Module *, Snapshot> m_Clean;
+};
+
+#endif // _MODULE_DIRTY_TRACKER_H_
@@ -0,0 +1,68 @@
+/*
+ * Copyright 2020-2022 F4PGA Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ */
+#include "../common/bank_tiles.h"
+
+#include <benchmark/benchmark.h>
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+// Writes a part JSON file with the given number of tiles listed ahead of
+// the IO banks, like the members preceding them in real part files
+static std::string writePartJson(int a_Tiles)
+{
+    std::string fileName = "bank_tiles/bench_" + std::to_string(a_Tiles) + ".json";
+    std::ofstream file(fileName);
+    file << "{\n    \"tiles\": {\n";
+    for (int i = 0; i < a_Tiles; ++i) {
+        file << "        \"CLBLL_L_X" << i % 128 << "Y" << i / 128 << "\": {\"type\": \"CLBLL_L\", \"sites\": [\"SLICE_X" << i << "\"]}";
+        file << (i + 1 < a_Tiles ? ",\n" : "\n");
+    }
+    file << "    },\n    \"iobanks\": {\n";
+    for (int bank = 0; bank < 16; ++bank) {
+        file << "        \"" << 13 + bank << "\": \"X1Y" << 26 + 52 * bank << "\"" << (bank + 1 < 16 ? ",\n" : "\n");
+    }
+    file << "    }\n}\n";
+    return fileName;
+}
+
+static void BM_ParseBankTiles(benchmark::State &state)
+{
+    std::string fileName = writePartJson(state.range(0));
+    for (auto _ : state) {
+        std::ifstream file(fileName);
+        benchmark::DoNotOptimize(parse_bank_tiles(file, fileName));
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    std::remove(fileName.c_str());
+}
+BENCHMARK(BM_ParseBankTiles)->RangeMultiplier(8)->Range(1 << 6, 1 << 15);
+
+// Later calls of get_bank_tiles() for the same file hit the cache
+static void BM_GetBankTilesCached(benchmark::State &state)
+{
+    std::string fileName = writePartJson(state.range(0));
+    get_bank_tiles(fileName);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(get_bank_tiles(fileName).size());
+    }
+    std::remove(fileName.c_str());
+}
+BENCHMARK(BM_GetBankTilesCached)->Arg(1 << 15);
@@ -0,0 +1,127 @@
+/*
+ * Copyright 2020-2022 F4PGA Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ */
+#include "module_dirty_tracker.h"
+
+#include "kernel/yosys.h"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+
+class YosysEnvironment : public ::testing::Environment
+{
+  public:
+    void SetUp() override { Yosys::yosys_setup(); }
+    void TearDown() override { Yosys::yosys_shutdown(); }
+};
+
+static ::testing::Environment *const yosys_environment = ::testing::AddGlobalTestEnvironment(new YosysEnvironment);
+
+class ModuleDirtyTrackerTest : public ::testing::Test
+{
+  protected:
+    void SetUp() override
+    {
+        design.reset(new RTLIL::Design);
+        top = design->addModule(ID(top));
+        other = design->addModule(ID(other));
+        a = top->addWire(ID(a));
+        y = top->addWire(ID(y));
+        inverter = top->addNotGate(ID(inv), a, y);
+        tracker.attach(design.get());
+    }
+
+    void TearDown() override { tracker.detach(); }
+
+    std::unique_ptr<RTLIL::Design> design;
+    RTLIL::Module *top;
+    RTLIL::Module *other;
+    RTLIL::Wire *a;
+    RTLIL::Wire *y;
+    RTLIL::Cell *inverter;
+    ModuleDirtyTracker tracker;
+};
+
+TEST_F(ModuleDirtyTrackerTest, DirtyUntilMarkedClean)
+{
+    EXPECT_TRUE(tracker.isDirty(top));
+    tracker.markClean(top);
+    EXPECT_FALSE(tracker.isDirty(top));
+    EXPECT_TRUE(tracker.isDirty(other));
+}
+
+TEST_F(ModuleDirtyTrackerTest, CellConnectionChange)
+{
+    tracker.markClean(top);
+    tracker.markClean(other);
+    inverter->setPort(ID::A, y);
+    EXPECT_TRUE(tracker.isDirty(top));
+    EXPECT_FALSE(tracker.isDirty(other));
+}
+
+TEST_F(ModuleDirtyTrackerTest, ModuleConnectionChange)
+{
+    tracker.markClean(top);
+    top->connect(a, y);
+    EXPECT_TRUE(tracker.isDirty(top));
+}
+
+TEST_F(ModuleDirtyTrackerTest, CellRemoval)
+{
+    tracker.markClean(top);
+    top->remove(inverter);
+    EXPECT_TRUE(tracker.isDirty(top));
+}
+
+TEST_F(ModuleDirtyTrackerTest, Blackout)
+{
+    tracker.markClean(top);
+    top->makeblackbox();
+    EXPECT_TRUE(tracker.isDirty(top));
+}
+
+// Changes that bypass the monitors are caught by the snapshot
+TEST_F(ModuleDirtyTrackerTest, UnmonitoredChanges)
+{
+    tracker.markClean(top);
+    top->addWire(ID(b));
+    EXPECT_TRUE(tracker.isDirty(top));
+
+    tracker.markClean(top);
+    top->connections_.push_back(RTLIL::SigSig(a, y));
+    EXPECT_TRUE(tracker.isDirty(top));
+
+    tracker.markClean(top);
+    top->addCell(ID(unconnected), ID($not));
+    EXPECT_TRUE(tracker.isDirty(top));
+}
+
+TEST_F(ModuleDirtyTrackerTest, Detach)
+{
+    tracker.markClean(top);
+    tracker.detach();
+    EXPECT_EQ(tracker.design(), nullptr);
+    EXPECT_EQ(design->monitors.count(&tracker), 0u);
+    EXPECT_TRUE(tracker.isDirty(top));
+
+    // Changes are no longer seen once detached
+    tracker.markClean(top);
+    inverter->setPort(ID::A, y);
+    EXPECT_FALSE(tracker.isDirty(top));
+}
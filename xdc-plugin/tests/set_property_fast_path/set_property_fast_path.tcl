@@ -0,0 +1,29 @@
+yosys -import
+if { [info procs get_ports] == {} } { plugin -i design_introspection }
+if { [info procs read_xdc] == {} } { plugin -i xdc }
+yosys -import  ;# ingest plugin commands
+
+read_verilog $::env(DESIGN_TOP).v
+synth_xilinx -flatten -abc9 -nosrl -noclkbuf -nodsp
+
+set part_json [file dirname $::env(DESIGN_TOP)]/../xc7a35tcsg324-1.json
+
+# A failing set_property leaves the interpreter as it was
+set script [info script]
+if { ![catch { read_xdc -part_json $part_json $::env(DESIGN_TOP)_error.xdc }] } {
+    error "read_xdc did not fail"
+}
+if { [info script] != $script } {
+    error "\[info script\] was not restored"
+}
+if { [info procs _original_unknown] != {} } {
+    error "the 'unknown' command was not restored"
+}
+
+# A standalone set_property does not use the index of the failed read
+set_property DRIVE 12 [get_ports {led[0]}]
+
+read_xdc -part_json $part_json $::env(DESIGN_TOP).xdc
+select -assert-count 1 t:OBUF r:IOSTANDARD=SSTL135 %i r:DRIVE=12 %i
+select -assert-count 1 t:OBUF r:SLEW=FAST %i r:DRIVE=8 %i
+select -assert-count 1 t:OBUF r:SLEW=SLOW %i
@@ -26,7 +26,9 @@
  *   Tcl interpreter.
  */
 #include "../common/bank_tiles.h"
+#include "../common/tcl_script.h"
 #include "../common/utils.h"
+#include "module_dirty_tracker.h"
 #include "kernel/log.h"
 #include "kernel/register.h"
 #include "kernel/rtlil.h"
@@ -92,7 +94,7 @@ struct GetIOBanks : public Pass {
         if (args.size() < 2) {
             log_cmd_error("%s: Missing bank number.\n", pass_name.c_str());
         }
-        auto bank_tiles = get_bank_tiles();
+        const auto &bank_tiles = get_bank_tiles();
         if (bank_tiles.count(std::atoi(args[1].c_str())) == 0) {
             log_cmd_error("%s:Bank number %s is not present in the target device.\n", args[1].c_str(), pass_name.c_str());
         }
@@ -105,6 +107,65 @@ struct GetIOBanks : public Pass {
     std::function<const BankTilesMap &()> get_bank_tiles;
 };
 
+// Index of the top module connectivity used to resolve the IO buffer driven
+// by a port. It is rebuilt lazily whenever the top module reports a change.
+struct IoCellIndex {
+    IoCellIndex(RTLIL::Design *design) : design(design) { tracker.attach(design); }
+    ~IoCellIndex() { tracker.detach(); }
+
+    void update()
+    {
+        if (module == design->top_module() && !tracker.isDirty(module)) {
+            return;
+        }
+        module = design->top_module();
+        drivers.clear();
+        io_cells.clear();
+
+        // The first wire driving each bit of a connection destination
+        for (auto &connection : module->connections_) {
+            if (!connection.first.is_chunk()) {
+                continue;
+            }
+            auto chunk = connection.first.as_chunk();
+            if (!chunk.wire) {
+                continue;
+            }
+            for (int i = 0; i < chunk.width; i++) {
+                RTLIL::SigBit src = connection.second[i];
+                if (src.wire) {
+                    drivers.emplace(std::make_pair(chunk.wire->name, chunk.offset + i), src);
+                }
+            }
+        }
+
+        // Supported IO cells by the first bit of each single chunk connection,
+        // one entry per connection in cell order
+        for (auto &cell_obj : module->cells_) {
+            RTLIL::Cell *cell = cell_obj.second;
+            if (supported_primitive_parameters.count(RTLIL::unescape_id(cell->type.str())) == 0) {
+                continue;
+            }
+            for (auto &connection : cell->connections_) {
+                if (!connection.second.is_chunk()) {
+                    continue;
+                }
+                auto chunk = connection.second.as_chunk();
+                if (chunk.wire) {
+                    io_cells[std::make_pair(chunk.wire->name, chunk.offset)].push_back(cell);
+                }
+            }
+        }
+        tracker.markClean(module);
+    }
+
+    RTLIL::Design *design;
+    RTLIL::Module *module = nullptr;
+    ModuleDirtyTracker tracker;
+    dict<std::pair<RTLIL::IdString, int>, RTLIL::SigBit> drivers;
+    dict<std::pair<RTLIL::IdString, int>, std::vector<RTLIL::Cell *>> io_cells;
+};
+
 struct SetProperty : public Pass {
     SetProperty(std::function<const BankTilesMap &()> get_bank_tiles) : Pass("set_property", "Set a given property"), get_bank_tiles(get_bank_tiles)
     {
@@ -134,10 +195,8 @@ struct SetProperty : public Pass {
             std::stringstream args_stream(dict_args);
             std::vector<std::string> tokens;
             std::string intermediate;
-            while (getline(args_stream, intermediate, ' ')) {
-                if (intermediate != "\0") {
-                    tokens.push_back(intermediate);
-                }
+            while (args_stream >> intermediate) {
+                tokens.push_back(intermediate);
             }
             if (tokens.size() % 2 != 0) {
                 log_cmd_error("Invalid number of dict parameters: %lu.\n", tokens.size());
@@ -190,7 +249,7 @@ struct SetProperty : public Pass {
             log_error("set_property INTERNAL_VREF: Incorrect number of arguments.\n");
         }
         int iobank = std::atoi(args[1].c_str());
-        auto bank_tiles = get_bank_tiles();
+        const auto &bank_tiles = get_bank_tiles();
         if (bank_tiles.count(iobank) == 0) {
             log_cmd_error("set_property INTERNAL_VREF: Invalid IO bank.\n");
         }
@@ -251,75 +310,65 @@ struct SetProperty : public Pass {
             log_error("Incorrect top port index %d in port %s\n", port_bit, port_name.c_str());
         }
 
+        // XDC files are read with an index shared by all set_property calls,
+        // a standalone call builds its own
+        std::unique_ptr<IoCellIndex> local_index;
+        IoCellIndex *index = io_cell_index;
+        if (index == nullptr) {
+            local_index.reset(new IoCellIndex(design));
+            index = local_index.get();
+        }
+        index->update();
+
         // Traverse the port wire
-        traverse_wire(port_name, design->top_module());
+        traverse_wire(port_name, *index);
 
         RTLIL::IdString parameter_id(RTLIL::escape_id(parameter));
-        for (auto cell_obj : design->top_module()->cells_) {
-            RTLIL::IdString cell_id = cell_obj.first;
-            RTLIL::Cell *cell = cell_obj.second;
-
-            // Check if the cell is of the type we are looking for
-            auto cell_type_str = RTLIL::unescape_id(cell->type.str());
-            auto primitive_parameters_iter = supported_primitive_parameters.find(cell_type_str);
-            if (primitive_parameters_iter == supported_primitive_parameters.end()) {
-                continue;
+        for (auto cell : get_io_cells(port_name, design->top_module(), *index)) {
+            auto primitive_parameters = supported_primitive_parameters.at(RTLIL::unescape_id(cell->type.str()));
+            // Check if the attribute is allowed for this module
+            if (std::find(primitive_parameters.begin(), primitive_parameters.end(), parameter) == primitive_parameters.end()) {
+                log_error("Cell %s of type %s doesn't support the %s attribute\n", cell->name.c_str(), cell->type.c_str(), parameter_id.c_str());
             }
-
-            // Set the parameter on the cell connected to the selected port
-            for (auto connection : cell->connections_) {
-                RTLIL::SigSpec cell_signal = connection.second;
-                if (is_signal_port(cell_signal, port_name)) {
-                    // Check if the attribute is allowed for this module
-                    auto primitive_parameters = primitive_parameters_iter->second;
-                    if (std::find(primitive_parameters.begin(), primitive_parameters.end(), parameter) == primitive_parameters.end()) {
-                        log_error("Cell %s of type %s doesn't support the %s attribute\n", cell->name.c_str(), cell->type.c_str(),
-                                  parameter_id.c_str());
-                    }
-                    if (parameter_id == ID(IO_LOC_PAIRS) and cell->hasParam(parameter_id)) {
-                        std::string cur_value(cell->getParam(parameter_id).decode_string());
-                        value = cur_value + "," + value;
-                    }
-                    cell->setParam(parameter_id, RTLIL::Const(value));
-                    log("Setting parameter %s to value %s on cell %s \n", parameter_id.c_str(), value.c_str(), cell_obj.first.c_str());
-                }
+            if (parameter_id == ID(IO_LOC_PAIRS) and cell->hasParam(parameter_id)) {
+                std::string cur_value(cell->getParam(parameter_id).decode_string());
+                value = cur_value + "," + value;
             }
+            cell->setParam(parameter_id, RTLIL::Const(value));
+            log("Setting parameter %s to value %s on cell %s \n", parameter_id.c_str(), value.c_str(), cell->name.c_str());
         }
         log("\n");
     }
 
-    // Search module's connections for the specified destination port
+    // Look up the module connection driving the specified destination port
     // and traverse from the specified destination wire to the source wire
-    void traverse_wire(std::string &port_name, RTLIL::Module *module)
+    void traverse_wire(std::string &port_name, const IoCellIndex &index)
     {
         auto port_signal = extract_signal(port_name);
-        std::string signal_name(port_signal.first);
-        auto signal_name_idstr = RTLIL::IdString(RTLIL::escape_id(signal_name));
-        int port_bit = port_signal.second;
-        for (auto connection : module->connections_) {
-            auto dst_sig = connection.first;
-            auto src_sig = connection.second;
-            if (dst_sig.is_chunk()) {
-                auto chunk = dst_sig.as_chunk();
-                if (chunk.wire) {
-                    if (chunk.wire->name != signal_name_idstr) {
-                        continue;
-                    }
-                    if (port_bit < chunk.offset || port_bit >= (chunk.offset + chunk.width)) {
-                        continue;
-                    }
-                    auto src_wires = src_sig.to_sigbit_vector();
-                    auto src_wire_sigbit = src_wires.at(port_bit - chunk.offset);
-                    if (src_wire_sigbit.wire) {
-                        port_name = src_wires.at(port_bit - chunk.offset).wire->name.str();
-                        if (src_wire_sigbit.offset > 0) {
-                            port_name += "[" + std::to_string(src_wire_sigbit.offset) + "]";
-                        }
-                        return;
-                    }
-                }
-            }
+        auto driver = index.drivers.find(std::make_pair(RTLIL::IdString(RTLIL::escape_id(port_signal.first)), port_signal.second));
+        if (driver == index.drivers.end()) {
+            return;
+        }
+        port_name = driver->second.wire->name.str();
+        if (driver->second.offset > 0) {
+            port_name += "[" + std::to_string(driver->second.offset) + "]";
+        }
+    }
+
+    // Returns the supported IO cells connected to the specified port bit, once
+    // per connection. chunk.offset is always indexed from 0, so port_bit has to be
+    // corrected with the start_offset of the port wire in case it is not 0-indexed.
+    const std::vector<RTLIL::Cell *> &get_io_cells(const std::string &port_name, RTLIL::Module *module, const IoCellIndex &index)
+    {
+        static const std::vector<RTLIL::Cell *> no_cells;
+        auto port_signal = extract_signal(port_name);
+        RTLIL::IdString port_id(RTLIL::escape_id(port_signal.first));
+        RTLIL::Wire *wire = module->wire(port_id);
+        if (wire == nullptr) {
+            return no_cells;
         }
+        auto it = index.io_cells.find(std::make_pair(port_id, port_signal.second - wire->start_offset));
+        return it == index.io_cells.end() ? no_cells : it->second;
     }
 
     // Extract signal name and port bit information from port name
@@ -332,26 +381,8 @@ struct SetProperty : public Pass {
         return std::make_pair(port_str, port_bit);
     }
 
-    // Check if the specified port name is part of the provided connection signal
-    bool is_signal_port(RTLIL::SigSpec signal, const std::string &port_name)
-    {
-        auto port_signal = extract_signal(port_name);
-        std::string port(port_signal.first);
-        int port_bit = port_signal.second;
-        if (signal.is_chunk()) {
-            auto chunk = signal.as_chunk();
-            if (chunk.wire) {
-                // chunk.offset is always indexed from 0. Because of that port_bit must be
-                // corrected with the chunk.wire->start_offset of the port wire in case it is not 0-indexed.
-                // Not doing this would cause lack of some properties (e.g. IO_LOC_PAIRS) for
-                // non-0-indexed ports in final eblif file
-                return (chunk.wire->name == RTLIL::IdString(RTLIL::escape_id(port))) && ((port_bit - chunk.wire->start_offset) == chunk.offset);
-            }
-        }
-        return false;
-    }
-
     std::function<const BankTilesMap &()> get_bank_tiles;
+    IoCellIndex *io_cell_index = nullptr;
 };
 
 struct ReadXdc : public Frontend {
@@ -371,7 +402,7 @@ struct ReadXdc : public Frontend {
         log("\n");
     }
 
-    void execute(std::istream *&f, std::string filename, std::vector<std::string> args, RTLIL::Design *) override
+    void execute(std::istream *&f, std::string filename, std::vector<std::string> args, RTLIL::Design *design) override
     {
         if (args.size() < 2) {
             log_cmd_error("Missing script file.\n");
@@ -408,14 +439,148 @@ struct ReadXdc : public Frontend {
         // string.
         //
         Tcl_Interp *interp = yosys_get_tcl_interp();
-        Tcl_Eval(interp, "rename unknown _original_unknown");
-        Tcl_Eval(interp, "proc unknown args { return \\[[lindex $args 0]\\] }");
-        if (Tcl_EvalFile(interp, args[argidx].c_str()) != TCL_OK) {
-            log_cmd_error("TCL interpreter returned an error: %s\n", Tcl_GetStringResult(interp));
+        bool ok;
+        std::string error;
+        {
+            // Share one port to IO cell index between all set_property calls of the file
+            IoCellIndex io_cell_index(design);
+            ReadScope scope(interp, args[argidx], SetProperty, io_cell_index);
+            ok = eval_xdc(interp, content, design);
+            error = ok ? "" : Tcl_GetStringResult(interp);
+        }
+        if (!ok) {
+            log_cmd_error("TCL interpreter returned an error: %s\n", error.c_str());
         }
-        Tcl_Eval(interp, "rename unknown \"\"");
-        Tcl_Eval(interp, "rename _original_unknown unknown");
     }
+
+    // Installs the 'unknown' handler, the [info script] path and the shared
+    // IO cell index while a file is read. Everything is put back also when
+    // a set_property applied without Tcl throws.
+    struct ReadScope {
+        ReadScope(Tcl_Interp *interp, const std::string &path, struct SetProperty &set_property, IoCellIndex &io_cell_index)
+            : interp(interp), set_property(set_property), info_script(interp, path)
+        {
+            Tcl_Eval(interp, "rename unknown _original_unknown");
+            Tcl_Eval(interp, "proc unknown args { return \\[[lindex $args 0]\\] }");
+            set_property.io_cell_index = &io_cell_index;
+        }
+        ~ReadScope()
+        {
+            set_property.io_cell_index = nullptr;
+            Tcl_Eval(interp, "rename unknown \"\"");
+            Tcl_Eval(interp, "rename _original_unknown unknown");
+        }
+
+        Tcl_Interp *interp;
+        struct SetProperty &set_property;
+        // Let scripts still refer to their own location with [info script]
+        TclInfoScriptGuard info_script;
+    };
+
+    // Generated pinout files mostly consist of literal "set_property ... [get_ports ...]"
+    // lines. Those are applied directly, everything else is collected into
+    // chunks of complete commands and evaluated by the Tcl interpreter, keeping
+    // the order of the file.
+    bool eval_xdc(Tcl_Interp *interp, const std::string &content, RTLIL::Design *design)
+    {
+        Tcl_CmdInfo get_ports_info;
+        bool has_get_ports = Tcl_GetCommandInfo(interp, "get_ports", &get_ports_info) != 0;
+
+        std::string tcl_chunk;
+        auto flush = [&]() {
+            if (tcl_chunk.empty()) {
+                return true;
+            }
+            bool ok = Tcl_Eval(interp, tcl_chunk.c_str()) == TCL_OK;
+            tcl_chunk.clear();
+            return ok;
+        };
+
+        std::istringstream lines(content);
+        std::string line;
+        std::string command;
+        std::vector<std::string> words;
+        while (std::getline(lines, line)) {
+            command += line;
+            command += '\n';
+            // Backslash-newline continues the command on the next line
+            if (!Tcl_CommandComplete(command.c_str()) || (!line.empty() && line.back() == '\\')) {
+                continue;
+            }
+            if (has_get_ports && parse_literal_set_property(command, words) && is_top_port(words.back(), design)) {
+                if (!flush()) {
+                    return false;
+                }
+                SetProperty.execute(words, design);
+            } else if (!TclLiteralScanner::is_comment_or_empty(command)) {
+                tcl_chunk += command;
+            }
+            command.clear();
+        }
+        tcl_chunk += command;
+        return flush();
+    }
+
+    // Recognizes "set_property PROPERTY VALUE [get_ports PORT]" and
+    // "set_property -dict {...} [get_ports PORT]" made of literal words only,
+    // i.e. bare words and braced words without nesting. On success words holds
+    // the arguments of the set_property command with the port name last.
+    static bool parse_literal_set_property(const std::string &command, std::vector<std::string> &words)
+    {
+        words.clear();
+        TclLiteralScanner scanner(command);
+        std::string text;
+        for (int i = 0; i < 3; i++) {
+            scanner.skip_spaces();
+            if (!scanner.word(text)) {
+                return false;
+            }
+            words.push_back(text);
+        }
+        if (words[0] != "set_property") {
+            return false;
+        }
+
+        scanner.skip_spaces();
+        if (!scanner.consume('[')) {
+            return false;
+        }
+        scanner.skip_spaces();
+        if (!scanner.word(text) || text != "get_ports") {
+            return false;
+        }
+        scanner.skip_spaces();
+        if (!scanner.word(text, true)) {
+            return false;
+        }
+        trim(text);
+        words.push_back(text);
+        scanner.skip_spaces();
+        if (!scanner.consume(']')) {
+            return false;
+        }
+        return !scanner.skip_spaces();
+    }
+
+    // Same check as get_ports does before returning the port name, anything
+    // else goes through Tcl to report the problem the usual way
+    static bool is_top_port(std::string port_name, RTLIL::Design *design)
+    {
+        RTLIL::Module *top = design->top_module();
+        if (top == nullptr) {
+            return false;
+        }
+        trim(port_name);
+        std::string port_str(port_name.size(), '\0');
+        int bit(0);
+        if (!sscanf(port_name.c_str(), "%[^[][%d]", &port_str[0], &bit)) {
+            return false;
+        }
+        port_str.resize(strlen(port_str.c_str()));
+        RTLIL::Wire *wire = top->wire(RTLIL::escape_id(port_str));
+        return wire != nullptr && (wire->port_input || wire->port_output) && bit >= wire->start_offset && bit < wire->start_offset + wire->width;
+    }
+
     const BankTilesMap &get_bank_tiles() { return bank_tiles; }
 
     BankTilesMap bank_tiles;
@@ -442,7 +607,7 @@ struct GetBankTiles : public Pass {
             log_cmd_error("Missing JSON file.\n");
         }
         // Check if the part has the specified bank
-        auto bank_tiles = get_bank_tiles(args[1]);
+        const auto &bank_tiles = get_bank_tiles(args[1]);
         if (bank_tiles.size()) {
             log("Available bank tiles:\n");
             for (auto bank : bank_tiles) {